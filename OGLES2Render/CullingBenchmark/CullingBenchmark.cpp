@@ -0,0 +1,1361 @@
+﻿/******************************************************************************
+
+@File         CullingBenchmark.cpp
+
+@Title        CullingBenchmark
+
+@Version
+
+@Copyright    Copyright (c) Imagination Technologies Limited.
+
+@Platform     Independent
+
+@Description  Headless micro-benchmarks for the culling code in mFunctionTools.
+No GL context is created, every test runs on CPU side data only.
+With -scene=... it runs the scene harness instead: synthetic scenes, a
+scripted camera path through mSceneManager and a CSV/JSON report.
+
+******************************************************************************/
+
+#include "PVRShell.h"
+#include "OGLES2Tools.h"
+#include "..\mFunctionTools\mFunctions.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+using namespace std;
+
+/******************************************************************************
+Constants
+******************************************************************************/
+const float g_fCamNear = 1.0f;
+const float g_fCamFar = 10000.0;
+const float g_fCamFOV = PVRT_PI / 3.0f;
+const float g_fAspect = 16.0f / 9.0f;
+
+const float g_fTileSize = 100.0f;
+const int g_iDefaultHalfGrid = 22;			// 45x45 tiles, same as WaterFileScale 20
+const int g_iDefaultFrames = 360;
+
+// Scene bounds and tree depth used by the scene index benchmarks
+const float g_fSceneHalfSize = 2250.0f;
+const float g_fSceneHalfHeight = 500.0f;
+const float g_fSmallModelSize = 10.0f;
+const int g_iDefaultTreeDepth = 6;
+const unsigned int g_uiMaxPointerTreeModels = 100000;	// makeQuadNode is O(n^2) above this
+const unsigned int g_uiDefaultMovingModels = 5000;
+const float g_fMaxSpeed = 20.0f;				// units per frame
+const unsigned int g_uiDefaultMultiViewModels = 200000;
+const unsigned int g_uiDefaultOcclusionModels = 100000;
+const int g_iOcclusionWidth = 320;				// depth buffer, same aspect as the camera
+const int g_iOcclusionHeight = 180;
+const int g_iOccluderCount = 8;
+const unsigned int g_uiDefaultBVHModels = 100000;
+const int g_iClusterCount = 32;					// towers of the clustered scene
+const float g_fClusterRadius = 40.0f;
+const int g_iRaysPerFrame = 20;
+const int g_iHeightFieldSize = 180;				// quads per side, same as the water plane
+const unsigned int g_uiDefaultBoundsVertices = 1000000;
+const int g_iWaterPlaneStride = 32;				// position, normal, uv
+const unsigned int g_uiDefaultSceneModels = 100000;
+const int g_iStackFloors = 16;					// models per column of the stacked scene
+const float g_fStackFloorHeight = 40.0f;
+const int g_iWarmupFrames = 5;					// queried before the timed frames, not reported
+const float g_fOccluderRing = 400.0f;			// distance of the occluder centers from the camera
+const float g_fOccluderHalfSize = 100.0f;
+const int g_iDefaultClipmapLevels = 8;
+const float g_fClipmapSpacing = 5.0f;			// quad size of the WaterPlane files
+const float g_fClipmapFlySpeed = 37.0f;			// units per frame, not a multiple of the spacing
+const int g_iWaterTiles = 81;					// WaterFileScale 100: 9x9 tiles
+const unsigned int g_uiWaterTileVertices = 101 * 101;
+const float g_fWaterTilesEdge = 2250.0f;
+
+/******************************************************************************
+Helpers
+******************************************************************************/
+class BenchTimer
+{
+public:
+	void Start(){ m_Start = chrono::high_resolution_clock::now(); }
+	double StopMs(){
+		return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - m_Start).count();
+	}
+private:
+	chrono::high_resolution_clock::time_point m_Start;
+};
+
+/*!****************************************************************************
+@Function		CreateTileGrid
+@Input			halfGrid		tiles from the center to the edge
+@Output		tiles			one mModel per tile with its SuroundBox ready
+@Description	Lays out water tiles the same way InitView does, without a POD.
+******************************************************************************/
+static void CreateTileGrid(int halfGrid, vector<mModel> & tiles)
+{
+	float h = g_fTileSize * 0.5f;
+	GLfloat corners[] = {
+		-h, 0.0f, -h,
+		h, 0.0f, -h,
+		-h, 0.0f, h,
+		h, 0.0f, h
+	};
+	mModel tile;
+	tile.SurrondBox.UpdateBoxModel(4, (PVRTuint8*)corners, sizeof(GLfloat) * 3);
+
+	tiles.clear();
+	tiles.reserve((2 * halfGrid + 1) * (2 * halfGrid + 1));
+	for (int i = -halfGrid; i <= halfGrid; i++){
+		for (int j = -halfGrid; j <= halfGrid; j++){
+			tile.SetPosition(i * g_fTileSize, 0.0f, j * g_fTileSize);
+			tiles.push_back(tile);
+		}
+	}
+}
+
+/*!****************************************************************************
+@Function		CreateRandomModels
+@Input			count			number of models
+@Output		models			small boxes scattered uniformly over the scene
+@Description	Deterministic, every run with the same count gives the same scene.
+******************************************************************************/
+static void CreateRandomModels(unsigned int count, vector<mModel> & models)
+{
+	float h = g_fSmallModelSize * 0.5f;
+	GLfloat corners[] = {
+		-h, -h, -h,
+		h, h, h
+	};
+	mModel prototype;
+	prototype.SurrondBox.UpdateBoxModel(2, (PVRTuint8*)corners, sizeof(GLfloat) * 3);
+
+	srand(1);
+	float range = 2.0f * (g_fSceneHalfSize - g_fSmallModelSize);
+	models.clear();
+	models.reserve(count);
+	for (unsigned int i = 0; i < count; ++i){
+		float x = (rand() / (float)RAND_MAX - 0.5f) * range;
+		float z = (rand() / (float)RAND_MAX - 0.5f) * range;
+		prototype.SetPosition(x, 0.0f, z);
+		models.push_back(prototype);
+	}
+}
+
+/*!****************************************************************************
+@Function		CreateClusteredModels
+@Input			count			number of models
+@Output		models			small boxes stacked in a few narrow towers
+@Description	The towers span the whole scene height, so a leaf cell of the
+XZ quadtrees holds a full tower.
+******************************************************************************/
+static void CreateClusteredModels(unsigned int count, vector<mModel> & models)
+{
+	float h = g_fSmallModelSize * 0.5f;
+	GLfloat corners[] = {
+		-h, -h, -h,
+		h, h, h
+	};
+	mModel prototype;
+	prototype.SurrondBox.UpdateBoxModel(2, (PVRTuint8*)corners, sizeof(GLfloat) * 3);
+
+	srand(2);
+	float range = 2.0f * (g_fSceneHalfSize - g_fClusterRadius - g_fSmallModelSize);
+	float height = 2.0f * (g_fSceneHalfHeight - g_fSmallModelSize);
+	vector<PVRTVec3> towers(g_iClusterCount);
+	for (int c = 0; c < g_iClusterCount; ++c){
+		towers[c].x = (rand() / (float)RAND_MAX - 0.5f) * range;
+		towers[c].z = (rand() / (float)RAND_MAX - 0.5f) * range;
+	}
+	models.clear();
+	models.reserve(count);
+	for (unsigned int i = 0; i < count; ++i){
+		PVRTVec3 & tower = towers[i % g_iClusterCount];
+		float x = tower.x + (rand() / (float)RAND_MAX - 0.5f) * 2.0f * g_fClusterRadius;
+		float y = (rand() / (float)RAND_MAX - 0.5f) * height;
+		float z = tower.z + (rand() / (float)RAND_MAX - 0.5f) * 2.0f * g_fClusterRadius;
+		prototype.SetPosition(x, y, z);
+		models.push_back(prototype);
+	}
+}
+
+/*!****************************************************************************
+@Function		CreateStackedModels
+@Input			count			number of models
+@Output		models			small boxes in columns of g_iStackFloors floors
+@Description	Columns on a regular XZ grid, like floors of buildings. Every
+quadtree leaf holds whole columns, the BVH can split them in height.
+******************************************************************************/
+static void CreateStackedModels(unsigned int count, vector<mModel> & models)
+{
+	float h = g_fSmallModelSize * 0.5f;
+	GLfloat corners[] = {
+		-h, -h, -h,
+		h, h, h
+	};
+	mModel prototype;
+	prototype.SurrondBox.UpdateBoxModel(2, (PVRTuint8*)corners, sizeof(GLfloat) * 3);
+
+	unsigned int columns = (count + g_iStackFloors - 1) / g_iStackFloors;
+	unsigned int side = (unsigned int)ceil(sqrt((double)columns));
+	float spacing = 2.0f * (g_fSceneHalfSize - g_fSmallModelSize) / PVRT_MAX(side, 1u);
+	models.clear();
+	models.reserve(count);
+	for (unsigned int i = 0; i < count; ++i){
+		unsigned int column = i / g_iStackFloors, floor = i % g_iStackFloors;
+		float x = -g_fSceneHalfSize + g_fSmallModelSize + ((column % side) + 0.5f) * spacing;
+		float z = -g_fSceneHalfSize + g_fSmallModelSize + ((column / side) + 0.5f) * spacing;
+		prototype.SetPosition(x, floor * g_fStackFloorHeight, z);
+		models.push_back(prototype);
+	}
+}
+
+static Camera CreateCamera()
+{
+	return Camera(PVRTVec3(0.0, 100.0f, 0.0),
+		PVRTVec3(0.0, 0.0, 0.0),
+		g_fCamFOV,
+		g_fAspect,
+		g_fCamNear,
+		g_fCamFar,
+		PVRTMat4::OGL,
+		false);
+}
+
+/*!****************************************************************************
+@Function		BenchBoxCuller
+@Description	Compares the per-model MVP test RenderScene used to run, the
+per-model test on the camera's cached frustum and the SoA culler on
+every compiled in path. The MVP test is the reference. Paths that are not
+compiled in are listed but not timed, they would only run the scalar code.
+******************************************************************************/
+static void BenchBoxCuller(int halfGrid, int frames)
+{
+	vector<mModel> tiles;
+	CreateTileGrid(halfGrid, tiles);
+
+	mBoxCuller culler;
+	for (unsigned int i = 0; i < tiles.size(); ++i){
+		culler.addModel(&tiles[i]);
+	}
+
+	const char * pathNames[] = { "Auto", "Scalar", "SSE", "AVX", "NEON" };
+	int paths[] = { CullPathScalar, CullPathSSE, CullPathAVX, CullPathNEON };
+	double pathMs[4] = { 0.0, 0.0, 0.0, 0.0 };
+	unsigned int pathMismatch[4] = { 0, 0, 0, 0 };
+	double perModelMs = 0.0, frustumMs = 0.0;
+	unsigned int frustumMismatch = 0;
+	unsigned int visibleTotal = 0;
+
+	Camera camera = CreateCamera();
+	vector<char> reference(tiles.size());
+	BenchTimer timer;
+
+	for (int frame = 0; frame < frames; ++frame){
+		camera.setEulerAngle(-10.0f, frame * 360.0f / frames, 0.0f);
+		PVRTMat4 VP = camera.getVPMatrix();
+
+		timer.Start();
+		for (unsigned int i = 0; i < tiles.size(); ++i){
+			PVRTMat4 mMVP = VP * tiles[i].GetModelMatrix();
+			reference[i] = !tiles[i].SurrondBox.NeedClipFromObjSpace(mMVP);
+		}
+		perModelMs += timer.StopMs();
+
+		// the frustum is rebuilt by the first getFrustum after the camera moved
+		timer.Start();
+		mFrustum & frustum = camera.getFrustum();
+		for (unsigned int i = 0; i < tiles.size(); ++i){
+			bool visible = !tiles[i].NeedClip(frustum);
+			if (visible != (reference[i] != 0)) frustumMismatch++;
+		}
+		frustumMs += timer.StopMs();
+
+		for (int p = 0; p < 4; ++p){
+			if (!mBoxCuller::HasPath(paths[p])) continue;
+			timer.Start();
+			culler.Cull(frustum, paths[p]);
+			pathMs[p] += timer.StopMs();
+
+			for (unsigned int i = 0; i < tiles.size(); ++i){
+				if (culler.IsVisible(i) != (reference[i] != 0)) pathMismatch[p]++;
+			}
+		}
+		visibleTotal += culler.VisibleCount();
+	}
+
+	printf("BoxCuller: %u boxes, %i frames, %.1f visible per frame, auto path %s\n",
+		(unsigned int)tiles.size(), frames, (float)visibleTotal / frames, pathNames[mBoxCuller::BestPath()]);
+	printf("  %-10s %10.4f ms/frame\n", "PerModel", perModelMs / frames);
+	printf("  %-10s %10.4f ms/frame  x%-6.1f mismatches %u\n", "Frustum", frustumMs / frames,
+		frustumMs > 0.0 ? perModelMs / frustumMs : 0.0, frustumMismatch);
+	for (int p = 0; p < 4; ++p){
+		if (!mBoxCuller::HasPath(paths[p])){
+			printf("  %-10s not compiled in\n", pathNames[paths[p]]);
+			continue;
+		}
+		printf("  %-10s %10.4f ms/frame  x%-6.1f mismatches %u\n", pathNames[paths[p]], pathMs[p] / frames,
+			pathMs[p] > 0.0 ? perModelMs / pathMs[p] : 0.0, pathMismatch[p]);
+	}
+}
+
+/*!****************************************************************************
+@Function		BenchSceneIndex
+@Description	Build and query cost of the QuadNode tree against the linear
+quadtree, both driven through mSceneManager::ModelsNeedRender.
+******************************************************************************/
+static void BenchSceneIndex(unsigned int modelCount, int depth, int frames, bool forcePointerTree)
+{
+	vector<mModel> models;
+	CreateRandomModels(modelCount, models);
+
+	mSceneManager pointerTree(depth, -g_fSceneHalfSize, g_fSceneHalfSize, -g_fSceneHalfHeight, g_fSceneHalfHeight, -g_fSceneHalfSize, g_fSceneHalfSize);
+	mSceneManager linearTree(depth, -g_fSceneHalfSize, g_fSceneHalfSize, -g_fSceneHalfHeight, g_fSceneHalfHeight, -g_fSceneHalfSize, g_fSceneHalfSize);
+	for (unsigned int i = 0; i < models.size(); ++i){
+		pointerTree.addModel(&models[i]);
+		linearTree.addModel(&models[i]);
+	}
+
+	BenchTimer timer;
+	bool runPointerTree = forcePointerTree || modelCount <= g_uiMaxPointerTreeModels;
+	double pointerBuildMs = 0.0, linearBuildMs = 0.0;
+	if (runPointerTree){
+		timer.Start();
+		pointerTree.makeQuadTree();
+		pointerBuildMs = timer.StopMs();
+	}
+	timer.Start();
+	linearTree.makeLinearQuadTree();
+	linearBuildMs = timer.StopMs();
+
+	double pointerQueryMs = 0.0, linearQueryMs = 0.0;
+	double pointerVisible = 0.0, linearVisible = 0.0;
+	double pointerNodes = 0.0, linearNodes = 0.0;
+	double pointerTests = 0.0, linearTests = 0.0;
+	double pointerAccepted = 0.0, linearAccepted = 0.0;
+	Camera camera = CreateCamera();
+	for (int frame = 0; frame < frames; ++frame){
+		camera.setEulerAngle(-10.0f, frame * 360.0f / frames, 0.0f);
+
+		if (runPointerTree){
+			timer.Start();
+			vector<mModel*> visible = pointerTree.ModelsNeedRender(camera.getFrustum());
+			pointerQueryMs += timer.StopMs();
+			pointerVisible += visible.size();
+			pointerNodes += pointerTree.Count;
+			pointerTests += pointerTree.PlaneTests;
+			pointerAccepted += pointerTree.NodesAccepted;
+		}
+
+		timer.Start();
+		vector<mModel*> visible = linearTree.ModelsNeedRender(camera.getFrustum());
+		linearQueryMs += timer.StopMs();
+		linearVisible += visible.size();
+		linearNodes += linearTree.Count;
+		linearTests += linearTree.PlaneTests;
+		linearAccepted += linearTree.NodesAccepted;
+	}
+
+	printf("SceneIndex: %u models, depth %i, %i frames\n", modelCount, depth, frames);
+	if (runPointerTree){
+		printf("  %-12s build %10.2f ms  query %8.4f ms/frame  nodes %8.1f  visible %10.1f  plane tests %8.1f  accepted %8.1f\n", "QuadNode",
+			pointerBuildMs, pointerQueryMs / frames, pointerNodes / frames, pointerVisible / frames, pointerTests / frames, pointerAccepted / frames);
+	}
+	else{
+		printf("  %-12s skipped above %u models, use -forcepointertree\n", "QuadNode", g_uiMaxPointerTreeModels);
+	}
+	printf("  %-12s build %10.2f ms  query %8.4f ms/frame  nodes %8.1f  visible %10.1f  plane tests %8.1f  accepted %8.1f\n", "Linear",
+		linearBuildMs, linearQueryMs / frames, linearNodes / frames, linearVisible / frames, linearTests / frames, linearAccepted / frames);
+
+	pointerTree.Destroy();
+	linearTree.Destroy();
+}
+
+/*!****************************************************************************
+@Function		BenchMovingModels
+@Description	Every model moves each frame and bounces on the scene edges.
+The loose quadtree follows through mModel::SetPosition, the linear tree
+has to be rebuilt every frame to stay correct. Neither may miss a model
+that a brute force test of every model finds visible; extra models are
+leaf cells the linear tree accepts as a whole.
+******************************************************************************/
+static void BenchMovingModels(unsigned int modelCount, int depth, int frames)
+{
+	vector<mModel> models;
+	CreateRandomModels(modelCount, models);
+
+	vector<PVRTVec3> velocity(modelCount);
+	for (unsigned int i = 0; i < modelCount; ++i){
+		velocity[i].x = (rand() / (float)RAND_MAX - 0.5f) * 2.0f * g_fMaxSpeed;
+		velocity[i].y = 0.0f;
+		velocity[i].z = (rand() / (float)RAND_MAX - 0.5f) * 2.0f * g_fMaxSpeed;
+	}
+
+	mSceneManager looseTree(depth, -g_fSceneHalfSize, g_fSceneHalfSize, -g_fSceneHalfHeight, g_fSceneHalfHeight, -g_fSceneHalfSize, g_fSceneHalfSize);
+	mSceneManager linearTree(depth, -g_fSceneHalfSize, g_fSceneHalfSize, -g_fSceneHalfHeight, g_fSceneHalfHeight, -g_fSceneHalfSize, g_fSceneHalfSize);
+	for (unsigned int i = 0; i < models.size(); ++i){
+		looseTree.addModel(&models[i]);
+		linearTree.addModel(&models[i]);
+	}
+	looseTree.makeLooseQuadTree();
+
+	BenchTimer timer;
+	double moveMs = 0.0, looseQueryMs = 0.0, linearBuildMs = 0.0, linearQueryMs = 0.0;
+	double looseVisible = 0.0, linearVisible = 0.0, looseNodes = 0.0, looseTests = 0.0;
+	unsigned int looseMissed = 0, looseExtra = 0, linearMissed = 0, linearExtra = 0;
+	float limit = g_fSceneHalfSize - g_fSmallModelSize;
+	Camera camera = CreateCamera();
+	mBoxCuller reference;
+	for (unsigned int i = 0; i < models.size(); ++i){
+		reference.addModel(&models[i]);
+	}
+
+	for (int frame = 0; frame < frames; ++frame){
+		// move includes the loose tree update done by SetPosition
+		timer.Start();
+		for (unsigned int i = 0; i < modelCount; ++i){
+			PVRTVec3 position = models[i].GetPosition() + velocity[i];
+			if (position.x < -limit || position.x > limit) velocity[i].x = -velocity[i].x;
+			if (position.z < -limit || position.z > limit) velocity[i].z = -velocity[i].z;
+			position.x = PVRT_CLAMP(position.x, -limit, limit);
+			position.z = PVRT_CLAMP(position.z, -limit, limit);
+			models[i].SetPosition(position);
+		}
+		moveMs += timer.StopMs();
+
+		camera.setEulerAngle(-10.0f, frame * 360.0f / frames, 0.0f);
+
+		for (unsigned int i = 0; i < modelCount; ++i) models[i].needRender = false;
+		timer.Start();
+		vector<mModel*> visible = looseTree.ModelsNeedRender(camera.getFrustum());
+		looseQueryMs += timer.StopMs();
+		looseVisible += visible.size();
+		looseNodes += looseTree.Count;
+		looseTests += looseTree.PlaneTests;
+
+		for (unsigned int i = 0; i < modelCount; ++i) reference.updateModel(i);
+		reference.Cull(camera.getFrustum());
+		for (unsigned int i = 0; i < modelCount; ++i){
+			if (reference.IsVisible(i) && !models[i].needRender) looseMissed++;
+			if (!reference.IsVisible(i) && models[i].needRender) looseExtra++;
+		}
+
+		for (unsigned int i = 0; i < modelCount; ++i) models[i].needRender = false;
+		timer.Start();
+		linearTree.makeLinearQuadTree();
+		linearBuildMs += timer.StopMs();
+		timer.Start();
+		visible = linearTree.ModelsNeedRender(camera.getFrustum());
+		linearQueryMs += timer.StopMs();
+		linearVisible += visible.size();
+		for (unsigned int i = 0; i < modelCount; ++i){
+			if (reference.IsVisible(i) && !models[i].needRender) linearMissed++;
+			if (!reference.IsVisible(i) && models[i].needRender) linearExtra++;
+		}
+	}
+
+	printf("MovingModels: %u models, depth %i, %i frames\n", modelCount, depth, frames);
+	printf("  %-12s move+update %8.4f ms/frame  query %8.4f ms/frame  nodes %8.1f  plane tests %8.1f  visible %8.1f  missed %u  extra %u\n", "Loose",
+		moveMs / frames, looseQueryMs / frames, looseNodes / frames, looseTests / frames, looseVisible / frames, looseMissed, looseExtra);
+	printf("  %-12s rebuild     %8.4f ms/frame  query %8.4f ms/frame  visible %8.1f  missed %u  extra %u\n", "Linear",
+		linearBuildMs / frames, linearQueryMs / frames, linearVisible / frames, linearMissed, linearExtra);
+
+	looseTree.Destroy();
+	linearTree.Destroy();
+}
+
+/*!****************************************************************************
+@Function		BenchMultiView
+@Description	Main, reflection and refraction views like RenderScene sets them
+up, culled through mCullingService on the calling thread only and then
+on the worker pool. Both runs must give the same visible lists.
+******************************************************************************/
+static void BenchMultiView(unsigned int modelCount, int depth, int frames, int threads)
+{
+	vector<mModel> models;
+	CreateRandomModels(modelCount, models);
+	mSceneManager scene(depth, -g_fSceneHalfSize, g_fSceneHalfSize, -g_fSceneHalfHeight, g_fSceneHalfHeight, -g_fSceneHalfSize, g_fSceneHalfSize);
+	for (unsigned int i = 0; i < models.size(); ++i){
+		scene.addModel(&models[i]);
+	}
+	scene.makeLinearQuadTree();
+
+	mCullingService serial, parallel;
+	serial.Init(0);
+	parallel.Init(threads);
+	for (int v = 0; v < 3; ++v){
+		serial.addView();
+		parallel.addView();
+	}
+
+	Camera mainCamera = CreateCamera();
+	Camera reflectionCamera = CreateCamera();
+	BenchTimer timer;
+	double serialMs = 0.0, parallelMs = 0.0;
+	double visible[3] = { 0.0, 0.0, 0.0 };
+	unsigned int mismatch = 0;
+	for (int frame = 0; frame < frames; ++frame){
+		mainCamera.setEulerAngle(-10.0f, frame * 360.0f / frames, 0.0f);
+		reflectionCamera.setPosition(mainCamera.getPosition().x, -mainCamera.getPosition().y, mainCamera.getPosition().z);
+		reflectionCamera.setEulerAngle(-mainCamera.getEulerAngle().x, mainCamera.getEulerAngle().y, mainCamera.getEulerAngle().z);
+
+		mCullingService * services[2] = { &serial, &parallel };
+		double * times[2] = { &serialMs, &parallelMs };
+		for (int s = 0; s < 2; ++s){
+			services[s]->setView(0, mainCamera);
+			services[s]->setView(1, reflectionCamera, PVRTVec4(0.0f, 1.0f, 0.0f, 3.0f));
+			services[s]->setView(2, mainCamera, PVRTVec4(0.0f, -1.0f, 0.0f, 3.0f));
+			timer.Start();
+			services[s]->Cull(scene);
+			*times[s] += timer.StopMs();
+		}
+		for (int v = 0; v < 3; ++v){
+			visible[v] += serial.VisibleModels(v).size();
+			if (serial.VisibleModels(v) != parallel.VisibleModels(v)) mismatch++;
+		}
+	}
+
+	printf("MultiView: %u models, 3 views, %i frames, %i threads, visible main %.1f reflection %.1f refraction %.1f\n",
+		modelCount, frames, parallel.ThreadCount(), visible[0] / frames, visible[1] / frames, visible[2] / frames);
+	printf("  %-12s %8.4f ms/frame\n", "Serial", serialMs / frames);
+	printf("  %-12s %8.4f ms/frame  x%-6.1f mismatches %u\n", "Parallel", parallelMs / frames,
+		parallelMs > 0.0 ? serialMs / parallelMs : 0.0, mismatch);
+
+	serial.Destroy();
+	parallel.Destroy();
+	scene.Destroy();
+}
+
+/*!****************************************************************************
+@Function		IsSampleVisible
+@Description	Reference for BenchOcclusion: a point is visible when it is in
+the frustum and no occluder box cuts the segment from the eye to it.
+******************************************************************************/
+static bool IsSampleVisible(PVRTVec3 eye, PVRTVec3 point, PVRTMat4 & VP_Matrix, vector<PVRTVec3> & occluderMin, vector<PVRTVec3> & occluderMax)
+{
+	PVRTVec4 clip = VP_Matrix * PVRTVec4(point, 1.0f);
+	if (clip.w <= 0.0f || fabs(clip.x) > clip.w || fabs(clip.y) > clip.w || fabs(clip.z) > clip.w) return false;
+
+	PVRTVec3 dir = point - eye;
+	for (unsigned int o = 0; o < occluderMin.size(); ++o){
+		float tNear = 0.0f, tFar = 1.0f - 1e-4f;
+		for (int a = 0; a < 3 && tNear <= tFar; ++a){
+			float origin = (&eye.x)[a], d = (&dir.x)[a];
+			float lo = (&occluderMin[o].x)[a], hi = (&occluderMax[o].x)[a];
+			if (fabs(d) < 1e-8f){
+				if (origin < lo || origin > hi) tNear = 2.0f;
+				continue;
+			}
+			float t0 = (lo - origin) / d, t1 = (hi - origin) / d;
+			if (t0 > t1) swap(t0, t1);
+			tNear = PVRT_MAX(tNear, t0);
+			tFar = PVRT_MIN(tFar, t1);
+		}
+		if (tNear <= tFar) return false;
+	}
+	return true;
+}
+
+/*!****************************************************************************
+@Function		BenchOcclusion
+@Description	Random small models behind a ring of big boxes around the
+camera. Every frame the boxes are rasterized into mOcclusionCuller and
+the linear quadtree query is run without and with the occlusion pass,
+which tests the tree nodes. Testing every model of the frustum list is
+timed too, it is what the pass would cost without the tree. Every model
+the pass removes is checked against the boxes with 27 rays, a model with
+any visible sample is a false occlusion.
+******************************************************************************/
+static void BenchOcclusion(unsigned int modelCount, int depth, int frames)
+{
+	vector<mModel> models;
+	CreateRandomModels(modelCount, models);
+	mSceneManager scene(depth, -g_fSceneHalfSize, g_fSceneHalfSize, -g_fSceneHalfHeight, g_fSceneHalfHeight, -g_fSceneHalfSize, g_fSceneHalfSize);
+	for (unsigned int i = 0; i < models.size(); ++i){
+		scene.addModel(&models[i]);
+	}
+	scene.makeLinearQuadTree();
+
+	// 8 corners and 12 triangles per occluder, in world space
+	vector<PVRTVec3> occluderMin, occluderMax;
+	vector<GLfloat> occluderVertices;
+	const PVRTuint16 boxIndices[36] = {
+		0, 1, 3, 0, 3, 2,  4, 6, 7, 4, 7, 5,
+		0, 4, 5, 0, 5, 1,  2, 3, 7, 2, 7, 6,
+		0, 2, 6, 0, 6, 4,  1, 5, 7, 1, 7, 3
+	};
+	for (int o = 0; o < g_iOccluderCount; ++o){
+		float angle = o * 2.0f * PVRT_PI / g_iOccluderCount;
+		PVRTVec3 center(cos(angle) * g_fOccluderRing, 0.0f, sin(angle) * g_fOccluderRing);
+		occluderMin.push_back(PVRTVec3(center.x - g_fOccluderHalfSize, -10.0f, center.z - g_fOccluderHalfSize));
+		occluderMax.push_back(PVRTVec3(center.x + g_fOccluderHalfSize, 200.0f, center.z + g_fOccluderHalfSize));
+		for (int c = 0; c < 8; ++c){
+			occluderVertices.push_back((c & 1) ? occluderMax.back().x : occluderMin.back().x);
+			occluderVertices.push_back((c & 2) ? occluderMax.back().y : occluderMin.back().y);
+			occluderVertices.push_back((c & 4) ? occluderMax.back().z : occluderMin.back().z);
+		}
+	}
+
+	mOcclusionCuller occlusion;
+	occlusion.Init(g_iOcclusionWidth, g_iOcclusionHeight);
+	PVRTMat4 identity = PVRTMat4::Identity();
+	Camera camera = CreateCamera();
+	BenchTimer timer;
+	double frustumMs = 0.0, rasterMs = 0.0, occlusionMs = 0.0, perModelMs = 0.0;
+	double frustumVisible = 0.0, occlusionVisible = 0.0, perModelVisible = 0.0, nodesOccluded = 0.0;
+	unsigned int falseOcclusions = 0;
+	int triangles = 0, skipped = 0;
+	for (int frame = 0; frame < frames; ++frame){
+		camera.setEulerAngle(-10.0f, frame * 360.0f / frames, 0.0f);
+		mFrustum & frustum = camera.getFrustum();
+
+		scene.Occlusion = nullptr;
+		timer.Start();
+		vector<mModel*> frustumList = scene.ModelsNeedRender(frustum);
+		frustumMs += timer.StopMs();
+		frustumVisible += frustumList.size();
+
+		timer.Start();
+		occlusion.Begin(camera);
+		for (int o = 0; o < g_iOccluderCount; ++o){
+			occlusion.addOccluderTriangles((PVRTuint8*)&occluderVertices[o * 24], sizeof(GLfloat) * 3, 8, boxIndices, 12, identity);
+		}
+		occlusion.End();
+		rasterMs += timer.StopMs();
+		triangles += occlusion.TrianglesRasterized;
+		skipped += occlusion.TrianglesSkipped;
+
+		timer.Start();
+		unsigned int kept = 0;
+		for (unsigned int i = 0; i < frustumList.size(); ++i){
+			if (!occlusion.IsOccluded(frustumList[i])) kept++;
+		}
+		perModelMs += timer.StopMs();
+		perModelVisible += kept;
+
+		// hidden subtrees are skipped, not unmarked, so the flags start clean
+		for (unsigned int i = 0; i < frustumList.size(); ++i) frustumList[i]->needRender = false;
+		scene.Occlusion = &occlusion;
+		timer.Start();
+		vector<mModel*> occlusionList = scene.ModelsNeedRender(frustum);
+		occlusionMs += timer.StopMs();
+		occlusionVisible += occlusionList.size();
+		nodesOccluded += scene.NodesOccluded;
+
+		// models of the frustum list the occlusion pass took away
+		PVRTMat4 VP = camera.getVPMatrix();
+		PVRTVec3 eye = camera.getPosition();
+		for (unsigned int i = 0; i < frustumList.size(); ++i){
+			if (frustumList[i]->needRender) continue;
+			PVRTVec3 boxMin, boxMax;
+			frustumList[i]->SurrondBox.GetBoxWorld(boxMin, boxMax);
+			bool visible = false;
+			for (int sample = 0; sample < 27 && !visible; ++sample){
+				PVRTVec3 point(boxMin.x + (boxMax.x - boxMin.x) * (sample % 3) * 0.5f,
+					boxMin.y + (boxMax.y - boxMin.y) * (sample / 3 % 3) * 0.5f,
+					boxMin.z + (boxMax.z - boxMin.z) * (sample / 9) * 0.5f);
+				visible = IsSampleVisible(eye, point, VP, occluderMin, occluderMax);
+			}
+			if (visible) falseOcclusions++;
+		}
+	}
+
+	printf("Occlusion: %u models, %i occluders, %ix%i depth buffer, %i frames\n",
+		modelCount, g_iOccluderCount, occlusion.Width(), occlusion.Height(), frames);
+	printf("  %-12s %8.4f ms/frame  visible %.1f\n", "Frustum", frustumMs / frames, frustumVisible / frames);
+	printf("  %-12s %8.4f ms/frame  triangles %.1f skipped %.1f\n", "Rasterize", rasterMs / frames,
+		triangles / (double)frames, skipped / (double)frames);
+	printf("  %-12s %8.4f ms/frame  visible %.1f\n", "HiZ/model", perModelMs / frames, perModelVisible / frames);
+	printf("  %-12s %8.4f ms/frame  visible %.1f nodes occluded %.1f false occlusions %u\n", "Frustum+HiZ", occlusionMs / frames,
+		occlusionVisible / frames, nodesOccluded / frames, falseOcclusions);
+	printf("  %-12s %8.4f ms/frame  %s than frustum culling alone\n", "Total", (rasterMs + occlusionMs) / frames,
+		rasterMs + occlusionMs < frustumMs ? "faster" : "slower");
+
+	scene.Destroy();
+}
+
+/*!****************************************************************************
+@Function		BenchBVHScene
+@Description	Build, frustum query and ray cost of the linear quadtree
+against the BVH on one scene. Frustum results are checked against the
+SoA culler, the BVH must miss nothing. Rays are checked against the
+brute force mSceneManager::RayCast of a scene without BVH.
+******************************************************************************/
+static void BenchBVHScene(const char * name, vector<mModel> & models, int depth, int frames, mWorkerPool & pool)
+{
+	mSceneManager linearTree(depth, -g_fSceneHalfSize, g_fSceneHalfSize, -g_fSceneHalfHeight, g_fSceneHalfHeight, -g_fSceneHalfSize, g_fSceneHalfSize);
+	mSceneManager bvh(depth, -g_fSceneHalfSize, g_fSceneHalfSize, -g_fSceneHalfHeight, g_fSceneHalfHeight, -g_fSceneHalfSize, g_fSceneHalfSize);
+	mBoxCuller reference;
+	for (unsigned int i = 0; i < models.size(); ++i){
+		linearTree.addModel(&models[i]);
+		bvh.addModel(&models[i]);
+		reference.addModel(&models[i]);
+	}
+
+	BenchTimer timer;
+	timer.Start();
+	linearTree.makeLinearQuadTree();
+	double linearBuildMs = timer.StopMs();
+	timer.Start();
+	bvh.makeBVH();
+	double bvhBuildMs = timer.StopMs();
+	timer.Start();
+	bvh.makeBVH(&pool);
+	double bvhPoolBuildMs = timer.StopMs();
+
+	double linearQueryMs = 0.0, bvhQueryMs = 0.0, linearVisible = 0.0, bvhVisible = 0.0;
+	double linearTests = 0.0, bvhTests = 0.0, exactVisible = 0.0;
+	double bvhRayMs = 0.0, bruteRayMs = 0.0;
+	unsigned int bvhMissed = 0, linearMissed = 0, rayMismatch = 0, rayHits = 0;
+	Camera camera = CreateCamera();
+	srand(3);
+	for (int frame = 0; frame < frames; ++frame){
+		camera.setEulerAngle(-10.0f, frame * 360.0f / frames, 0.0f);
+		reference.Cull(camera.getFrustum());
+
+		for (unsigned int i = 0; i < models.size(); ++i) models[i].needRender = false;
+		timer.Start();
+		vector<mModel*> visible = linearTree.ModelsNeedRender(camera.getFrustum());
+		linearQueryMs += timer.StopMs();
+		linearVisible += visible.size();
+		linearTests += linearTree.PlaneTests;
+		for (unsigned int i = 0; i < models.size(); ++i){
+			if (reference.IsVisible(i) && !models[i].needRender) linearMissed++;
+		}
+
+		for (unsigned int i = 0; i < models.size(); ++i) models[i].needRender = false;
+		timer.Start();
+		visible = bvh.ModelsNeedRender(camera.getFrustum());
+		bvhQueryMs += timer.StopMs();
+		bvhVisible += visible.size();
+		bvhTests += bvh.PlaneTests;
+		for (unsigned int i = 0; i < models.size(); ++i){
+			if (reference.IsVisible(i)) exactVisible++;
+			if (reference.IsVisible(i) && !models[i].needRender) bvhMissed++;
+		}
+
+		// rays from above the scene down to random ground points, like picking
+		for (int r = 0; r < g_iRaysPerFrame; ++r){
+			PVRTVec3 origin((rand() / (float)RAND_MAX - 0.5f) * 2.0f * g_fSceneHalfSize, g_fSceneHalfHeight,
+				(rand() / (float)RAND_MAX - 0.5f) * 2.0f * g_fSceneHalfSize);
+			PVRTVec3 target((rand() / (float)RAND_MAX - 0.5f) * 2.0f * g_fSceneHalfSize, -g_fSceneHalfHeight,
+				(rand() / (float)RAND_MAX - 0.5f) * 2.0f * g_fSceneHalfSize);
+			float bvhDistance = 0.0f, bruteDistance = 0.0f;
+			timer.Start();
+			mModel * bvhHit = bvh.RayCast(origin, target - origin, g_fCamFar, bvhDistance);
+			bvhRayMs += timer.StopMs();
+			timer.Start();
+			mModel * bruteHit = linearTree.RayCast(origin, target - origin, g_fCamFar, bruteDistance);
+			bruteRayMs += timer.StopMs();
+			if (bvhHit) rayHits++;
+			if ((bvhHit == nullptr) != (bruteHit == nullptr) || (bvhHit && fabs(bvhDistance - bruteDistance) > 1e-3f)) rayMismatch++;
+		}
+	}
+
+	printf("BVH %s: %u models, %i frames, %i rays/frame, %i threads, exact visible %.1f\n", name, (unsigned int)models.size(),
+		frames, g_iRaysPerFrame, pool.ThreadCount(), exactVisible / frames);
+	printf("  %-12s build %10.2f ms  query %8.4f ms/frame  visible %10.1f  plane tests %8.1f  missed %u\n", "Linear",
+		linearBuildMs, linearQueryMs / frames, linearVisible / frames, linearTests / frames, linearMissed);
+	printf("  %-12s build %10.2f ms  query %8.4f ms/frame  visible %10.1f  plane tests %8.1f  missed %u\n", "BVH",
+		bvhBuildMs, bvhQueryMs / frames, bvhVisible / frames, bvhTests / frames, bvhMissed);
+	printf("  %-12s build %10.2f ms\n", "BVH pool", bvhPoolBuildMs);
+	printf("  %-12s %8.4f ms/frame  hits %.1f  x%-6.1f mismatches %u\n", "Rays BVH", bvhRayMs / frames, rayHits / (double)frames,
+		bvhRayMs > 0.0 ? bruteRayMs / bvhRayMs : 0.0, rayMismatch);
+	printf("  %-12s %8.4f ms/frame\n", "Rays brute", bruteRayMs / frames);
+
+	linearTree.Destroy();
+	bvh.Destroy();
+}
+
+/*!****************************************************************************
+@Function		BenchTriangleBVH
+@Description	Heightfield with as many quads as the water plane. Rays from
+above against mTriangleBVH and against every triangle, the nearest hit
+distance must agree.
+******************************************************************************/
+static void BenchTriangleBVH(int frames, mWorkerPool & pool)
+{
+	int n = g_iHeightFieldSize;
+	vector<GLfloat> vertices;
+	vector<PVRTuint16> indices;
+	for (int z = 0; z <= n; ++z){
+		for (int x = 0; x <= n; ++x){
+			vertices.push_back((GLfloat)x * 10.0f);
+			vertices.push_back((GLfloat)(sin(x * 0.2f) * cos(z * 0.3f) * 20.0f));
+			vertices.push_back((GLfloat)z * 10.0f);
+		}
+	}
+	for (int z = 0; z < n; ++z){
+		for (int x = 0; x < n; ++x){
+			PVRTuint16 i0 = (PVRTuint16)(z * (n + 1) + x), i1 = (PVRTuint16)(i0 + 1);
+			PVRTuint16 i2 = (PVRTuint16)(i0 + n + 1), i3 = (PVRTuint16)(i2 + 1);
+			PVRTuint16 quad[6] = { i0, i2, i1, i1, i2, i3 };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+	unsigned int vertexCount = (unsigned int)vertices.size() / 3, triangleCount = (unsigned int)indices.size() / 3;
+
+	mTriangleBVH meshBVH;
+	BenchTimer timer;
+	timer.Start();
+	meshBVH.Build((PVRTuint8*)&vertices[0], sizeof(GLfloat) * 3, vertexCount, &indices[0], triangleCount);
+	double buildMs = timer.StopMs();
+	timer.Start();
+	meshBVH.Build((PVRTuint8*)&vertices[0], sizeof(GLfloat) * 3, vertexCount, &indices[0], triangleCount, &pool);
+	double poolBuildMs = timer.StopMs();
+
+	double bvhRayMs = 0.0, bruteRayMs = 0.0, triangleTests = 0.0;
+	unsigned int mismatch = 0, hits = 0;
+	int rays = PVRT_MAX(1, frames / 10) * 100;
+	srand(4);
+	for (int r = 0; r < rays; ++r){
+		PVRTVec3 origin(rand() / (float)RAND_MAX * n * 10.0f, 100.0f, rand() / (float)RAND_MAX * n * 10.0f);
+		PVRTVec3 direction((rand() / (float)RAND_MAX - 0.5f), -1.0f, (rand() / (float)RAND_MAX - 0.5f));
+		float bvhDistance = 0.0f;
+		timer.Start();
+		bool bvhHit = meshBVH.RayCast(origin, direction, FLT_MAX, bvhDistance);
+		bvhRayMs += timer.StopMs();
+		triangleTests += meshBVH.RayTriangleTests;
+
+		timer.Start();
+		bool bruteHit = false;
+		float bruteDistance = FLT_MAX;
+		for (unsigned int t = 0; t < triangleCount; ++t){
+			PVRTVec3 v0(&vertices[indices[3 * t] * 3]);
+			PVRTVec3 edge1 = PVRTVec3(&vertices[indices[3 * t + 1] * 3]) - v0;
+			PVRTVec3 edge2 = PVRTVec3(&vertices[indices[3 * t + 2] * 3]) - v0;
+			PVRTVec3 p = direction.cross(edge2);
+			float det = edge1.dot(p);
+			if (fabs(det) < 1e-12f) continue;
+			PVRTVec3 s = origin - v0;
+			float u = s.dot(p) / det;
+			PVRTVec3 q = s.cross(edge1);
+			float v = direction.dot(q) / det;
+			float distance = edge2.dot(q) / det;
+			if (u < 0.0f || u > 1.0f || v < 0.0f || u + v > 1.0f || distance < 0.0f || distance > bruteDistance) continue;
+			bruteDistance = distance;
+			bruteHit = true;
+		}
+		bruteRayMs += timer.StopMs();
+		if (bvhHit) hits++;
+		if (bvhHit != bruteHit || (bvhHit && fabs(bvhDistance - bruteDistance) > 1e-3f * bruteDistance)) mismatch++;
+	}
+
+	printf("TriangleBVH: %u triangles, %i rays, %u nodes\n", triangleCount, rays, (unsigned int)meshBVH.Nodes.size());
+	printf("  %-12s build %10.2f ms  pool build %10.2f ms\n", "BVH", buildMs, poolBuildMs);
+	printf("  %-12s %8.4f ms/ray  triangle tests %.1f  hits %u  x%-8.1f mismatches %u\n", "Rays BVH", bvhRayMs / rays,
+		triangleTests / rays, hits, bvhRayMs > 0.0 ? bruteRayMs / bvhRayMs : 0.0, mismatch);
+	printf("  %-12s %8.4f ms/ray\n", "Rays brute", bruteRayMs / rays);
+}
+
+/*!****************************************************************************
+@Function		BenchBVH
+@Description	Water tile grid, uniformly scattered models and clustered towers.
+******************************************************************************/
+static void BenchBVH(unsigned int modelCount, int halfGrid, int depth, int frames, int threads)
+{
+	mWorkerPool pool;
+	pool.Init(threads);
+
+	vector<mModel> models;
+	CreateTileGrid(halfGrid, models);
+	BenchBVHScene("Grid", models, depth, frames, pool);
+	CreateRandomModels(modelCount, models);
+	BenchBVHScene("Uniform", models, depth, frames, pool);
+	CreateClusteredModels(modelCount, models);
+	BenchBVHScene("Clustered", models, depth, frames, pool);
+	BenchTriangleBVH(frames, pool);
+
+	pool.Destroy();
+}
+
+/*!****************************************************************************
+@Function		BenchBoundsMesh
+@Description	Scalar min/max loop against mBoundsEngine on one thread and on
+the pool. Every vertex must be inside the AABB, the sphere and the
+oriented box.
+******************************************************************************/
+static void BenchBoundsMesh(const char * name, vector<GLfloat> & vertices, unsigned int stride, int repeats, mWorkerPool & pool)
+{
+	const PVRTuint8 * positions = (const PVRTuint8*)&vertices[0];
+	unsigned int vertexCount = (unsigned int)(vertices.size() * sizeof(GLfloat) / stride);
+
+	BenchTimer timer;
+	PVRTVec3 referenceMin, referenceMax;
+	timer.Start();
+	for (int r = 0; r < repeats; ++r){
+		referenceMin = PVRTVec3(FLT_MAX, FLT_MAX, FLT_MAX);
+		referenceMax = PVRTVec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (unsigned int i = 0; i < vertexCount; ++i){
+			const GLfloat * p = (const GLfloat*)(positions + i * stride);
+			if (p[0] < referenceMin.x) referenceMin.x = p[0];
+			if (p[0] > referenceMax.x) referenceMax.x = p[0];
+			if (p[1] < referenceMin.y) referenceMin.y = p[1];
+			if (p[1] > referenceMax.y) referenceMax.y = p[1];
+			if (p[2] < referenceMin.z) referenceMin.z = p[2];
+			if (p[2] > referenceMax.z) referenceMax.z = p[2];
+		}
+	}
+	double scalarMs = timer.StopMs() / repeats;
+
+	PVRTVec3 boxMin, boxMax;
+	timer.Start();
+	for (int r = 0; r < repeats; ++r) mBoundsEngine::ComputeAABB(positions, stride, vertexCount, boxMin, boxMax);
+	double simdMs = timer.StopMs() / repeats;
+
+	mBoundsEngine engine;
+	mBounds bounds;
+	timer.Start();
+	for (int r = 0; r < repeats; ++r) engine.Compute(positions, stride, vertexCount, bounds);
+	double serialMs = timer.StopMs() / repeats;
+
+	engine.Pool = &pool;
+	engine.ComputeOrientedBox = true;
+	timer.Start();
+	for (int r = 0; r < repeats; ++r) engine.Compute(positions, stride, vertexCount, bounds);
+	double poolMs = timer.StopMs() / repeats;
+
+	unsigned int outside = 0;
+	float tolerance = 1e-4f * (referenceMax - referenceMin).length();
+	for (unsigned int i = 0; i < vertexCount; ++i){
+		PVRTVec3 p((const GLfloat*)(positions + i * stride));
+		if ((p - bounds.SphereCenter).length() > bounds.SphereRadius + tolerance) outside++;
+		for (int a = 0; a < 3; ++a){
+			if (fabs((p - bounds.BoxCenter).dot(bounds.BoxAxis[a])) > (&bounds.BoxHalfSize.x)[a] + tolerance){
+				outside++;
+				break;
+			}
+		}
+	}
+	bool same = boxMin == referenceMin && boxMax == referenceMax && bounds.Min == referenceMin && bounds.Max == referenceMax;
+	PVRTVec3 size = referenceMax - referenceMin;
+	float obbVolume = bounds.BoxHalfSize.x * bounds.BoxHalfSize.y * bounds.BoxHalfSize.z * 8.0f;
+
+	printf("Bounds %s: %u vertices, stride %u, %i threads\n", name, vertexCount, stride, pool.ThreadCount() + 1);
+	printf("  %-12s %8.3f ms\n", "Scalar AABB", scalarMs);
+	printf("  %-12s %8.3f ms  x%-6.2f same %s\n", "SIMD AABB", simdMs, simdMs > 0.0 ? scalarMs / simdMs : 0.0, same ? "yes" : "NO");
+	printf("  %-12s %8.3f ms  AABB + sphere\n", "Serial", serialMs);
+	printf("  %-12s %8.3f ms  AABB + sphere + OBB\n", "Pool", poolMs);
+	printf("  sphere radius %.2f (AABB half diagonal %.2f)  OBB volume %.4g (AABB %.4g)  outside %u\n",
+		bounds.SphereRadius, size.length() * 0.5f, obbVolume, size.x * size.y * size.z, outside);
+}
+
+/*!****************************************************************************
+@Function		BenchBounds
+@Description	The 180x180 water plane layout and a large tilted point cloud.
+******************************************************************************/
+static void BenchBounds(unsigned int vertexCount, int frames, int threads)
+{
+	mWorkerPool pool;
+	pool.Init(threads);
+	int repeats = PVRT_MAX(1, frames / 36);
+
+	int n = g_iHeightFieldSize;
+	unsigned int floats = g_iWaterPlaneStride / sizeof(GLfloat);
+	vector<GLfloat> water((n + 1) * (n + 1) * floats, 0.0f);
+	for (int z = 0; z <= n; ++z){
+		for (int x = 0; x <= n; ++x){
+			GLfloat * v = &water[(z * (n + 1) + x) * floats];
+			v[0] = (GLfloat)x * 10.0f;
+			v[1] = (GLfloat)(sin(x * 0.2f) * cos(z * 0.3f) * 20.0f);
+			v[2] = (GLfloat)z * 10.0f;
+			v[4] = 1.0f;
+		}
+	}
+	BenchBoundsMesh("Water", water, g_iWaterPlaneStride, repeats * 10, pool);
+
+	// ellipsoid stretched along a diagonal, the case the oriented box is for
+	PVRTMat4 rotation = PVRTMat4::RotationY(0.6f) * PVRTMat4::RotationZ(0.4f);
+	vector<GLfloat> cloud(vertexCount * 3);
+	srand(5);
+	for (unsigned int i = 0; i < vertexCount; ++i){
+		PVRTVec4 p(rand() / (float)RAND_MAX - 0.5f, rand() / (float)RAND_MAX - 0.5f, rand() / (float)RAND_MAX - 0.5f, 0.0f);
+		p.x *= 400.0f;
+		p.y *= 60.0f;
+		p.z *= 30.0f;
+		p = rotation * p;
+		cloud[3 * i] = p.x + 100.0f;
+		cloud[3 * i + 1] = p.y;
+		cloud[3 * i + 2] = p.z - 50.0f;
+	}
+	BenchBoundsMesh("Cloud", cloud, sizeof(GLfloat) * 3, repeats, pool);
+
+	pool.Destroy();
+}
+
+/*!****************************************************************************
+@Function		BenchClipmap
+@Description	Generation time and per frame budget of mWaterClipmap for a few
+grid sizes, with the camera flying a straight line across the water.
+The budget has to stay the same on every frame.
+******************************************************************************/
+static void BenchClipmap(int levels, int frames)
+{
+	const int gridSizes[] = { 32, 64, 128 };
+	int repeats = PVRT_MAX(1, frames / 36);
+
+	printf("Clipmap: %i levels, spacing %.1f, %i frames (tiles: %u vertices, edge at %.0f)\n", levels, g_fClipmapSpacing, frames,
+		g_iWaterTiles * g_uiWaterTileVertices, g_fWaterTilesEdge);
+	printf("  %-6s %9s %9s %10s %10s %10s %9s %11s %6s\n", "Grid", "Vertices", "Indices", "Generate", "Update", "Frame vtx", "Frame tri", "Edge", "Draws");
+	for (unsigned int g = 0; g < sizeof(gridSizes) / sizeof(gridSizes[0]); ++g){
+		mWaterClipmap clipmap;
+		BenchTimer timer;
+		timer.Start();
+		for (int r = 0; r < repeats; ++r){
+			if (!clipmap.Generate(gridSizes[g], levels, g_fClipmapSpacing)) break;
+		}
+		double generateMs = timer.StopMs() / repeats;
+		if (clipmap.LevelCount == 0){
+			printf("  %-6i not generated\n", gridSizes[g]);
+			continue;
+		}
+
+		unsigned int minVertices = UINT_MAX, maxVertices = 0, minTriangles = UINT_MAX, maxTriangles = 0;
+		timer.Start();
+		for (int f = 0; f < frames; ++f){
+			clipmap.Update(PVRTVec3(-8000.0f + f * g_fClipmapFlySpeed, 100.0f, 3000.0f - f * g_fClipmapFlySpeed * 0.6f));
+			minVertices = PVRT_MIN(minVertices, clipmap.FrameVertices);
+			maxVertices = PVRT_MAX(maxVertices, clipmap.FrameVertices);
+			minTriangles = PVRT_MIN(minTriangles, clipmap.FrameTriangles);
+			maxTriangles = PVRT_MAX(maxTriangles, clipmap.FrameTriangles);
+		}
+		double updateMs = timer.StopMs() / frames;
+
+		printf("  %-6i %9u %9u %7.3f ms %7.4f ms %10u %9u %11.0f %6u%s\n", gridSizes[g],
+			(unsigned int)(clipmap.Vertices.size() / c_uiClipmapVertexFloats), (unsigned int)clipmap.Indices.size(),
+			generateMs, updateMs, maxVertices, maxTriangles, clipmap.Extent(), (unsigned int)clipmap.Draws.size(),
+			minVertices == maxVertices && minTriangles == maxTriangles ? "" : "  budget NOT constant");
+		clipmap.Destroy();
+	}
+}
+
+/******************************************************************************
+Scene harness
+******************************************************************************/
+struct CameraKey
+{
+	float X, Y, Z;					// position, in scene half sizes
+	float Pitch, Yaw;				// degrees
+};
+
+// overview, dive to ground level, fly across, look up at the stacks, turn back
+const CameraKey g_CameraPath[] = {
+	{ 0.0f, 0.6f, -1.2f, -30.0f, 0.0f },
+	{ 0.0f, 0.15f, -0.8f, -10.0f, 20.0f },
+	{ -0.5f, 0.02f, -0.2f, 0.0f, 60.0f },
+	{ 0.2f, 0.02f, 0.4f, 25.0f, 120.0f },
+	{ 0.8f, 0.3f, 0.8f, -20.0f, 225.0f },
+	{ 0.0f, 0.6f, -1.2f, -30.0f, 360.0f }
+};
+const int g_iCameraKeys = sizeof(g_CameraPath) / sizeof(g_CameraPath[0]);
+
+struct SceneRun
+{
+	const char * Scene;
+	const char * Index;
+	unsigned int Models;
+	double BuildMs;
+	vector<double> FrameMs;
+	double NodesVisited;
+	double NodesNotCulled;
+	double PlaneTests;
+	double NodesAccepted;
+	double Visible;
+	unsigned int VisibleMax;
+};
+
+/*!****************************************************************************
+@Function		SetCameraOnPath
+@Input			t			0..1 along the whole path
+@Input			sceneMin	the path is scaled to the scene bounds
+@Input			sceneMax
+******************************************************************************/
+static void SetCameraOnPath(Camera & camera, float t, PVRTVec3 sceneMin, PVRTVec3 sceneMax)
+{
+	float position = PVRT_CLAMP(t, 0.0f, 1.0f) * (g_iCameraKeys - 1);
+	int key = PVRT_MIN((int)position, g_iCameraKeys - 2);
+	float blend = position - key;
+	const CameraKey & a = g_CameraPath[key];
+	const CameraKey & b = g_CameraPath[key + 1];
+	PVRTVec3 center = (sceneMin + sceneMax) * 0.5f;
+	PVRTVec3 half = (sceneMax - sceneMin) * 0.5f;
+	float horizontal = PVRT_MAX(half.x, half.z);
+	camera.setPosition(center.x + (a.X + (b.X - a.X) * blend) * horizontal,
+		sceneMin.y + (a.Y + (b.Y - a.Y) * blend) * horizontal,
+		center.z + (a.Z + (b.Z - a.Z) * blend) * horizontal);
+	camera.setEulerAngle(a.Pitch + (b.Pitch - a.Pitch) * blend, a.Yaw + (b.Yaw - a.Yaw) * blend, 0.0f);
+}
+
+/*!****************************************************************************
+@Function		Percentile
+@Input			sorted		ascending
+@Input			p			0..100, nearest rank
+******************************************************************************/
+static double Percentile(vector<double> & sorted, double p)
+{
+	if (sorted.empty()) return 0.0;
+	size_t rank = (size_t)ceil(p / 100.0 * sorted.size());
+	return sorted[PVRT_MIN(PVRT_MAX(rank, (size_t)1), sorted.size()) - 1];
+}
+
+/*!****************************************************************************
+@Function		RunScene
+@Description	Builds one index over the models and queries it along the
+camera path. Returns false when the index was skipped.
+******************************************************************************/
+static bool RunScene(const char * sceneName, const char * indexName, vector<mModel> & models, int depth, int frames, SceneRun & run)
+{
+	int mode;
+	if (strcmp(indexName, "quadnode") == 0) mode = SceneIndexQuadNode;
+	else if (strcmp(indexName, "linear") == 0) mode = SceneIndexLinear;
+	else if (strcmp(indexName, "loose") == 0) mode = SceneIndexLoose;
+	else if (strcmp(indexName, "bvh") == 0) mode = SceneIndexBVH;
+	else return false;
+	if (mode == SceneIndexQuadNode && models.size() > g_uiMaxPointerTreeModels){
+		printf("  %-10s skipped above %u models\n", indexName, g_uiMaxPointerTreeModels);
+		return false;
+	}
+
+	PVRTVec3 sceneMin(FLT_MAX, FLT_MAX, FLT_MAX), sceneMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (unsigned int i = 0; i < models.size(); ++i){
+		PVRTVec3 boxMin, boxMax;
+		models[i].SurrondBox.GetBoxWorld(boxMin, boxMax);
+		sceneMin = PVRTVec3(PVRT_MIN(sceneMin.x, boxMin.x), PVRT_MIN(sceneMin.y, boxMin.y), PVRT_MIN(sceneMin.z, boxMin.z));
+		sceneMax = PVRTVec3(PVRT_MAX(sceneMax.x, boxMax.x), PVRT_MAX(sceneMax.y, boxMax.y), PVRT_MAX(sceneMax.z, boxMax.z));
+	}
+
+	// models on the edge must be inside the root box, not crossing it
+	PVRTVec3 margin(g_fSmallModelSize, g_fSmallModelSize, g_fSmallModelSize);
+	sceneMin -= margin;
+	sceneMax += margin;
+	mSceneManager scene(depth, sceneMin.x, sceneMax.x, sceneMin.y, sceneMax.y, sceneMin.z, sceneMax.z);
+	for (unsigned int i = 0; i < models.size(); ++i){
+		scene.addModel(&models[i]);
+	}
+	BenchTimer timer;
+	timer.Start();
+	if (mode == SceneIndexQuadNode) scene.makeQuadTree();
+	else if (mode == SceneIndexLinear) scene.makeLinearQuadTree();
+	else if (mode == SceneIndexLoose) scene.makeLooseQuadTree();
+	else scene.makeBVH();
+
+	run.Scene = sceneName;
+	run.Index = indexName;
+	run.Models = (unsigned int)models.size();
+	run.BuildMs = timer.StopMs();
+	run.FrameMs.clear();
+	run.NodesVisited = run.NodesNotCulled = run.PlaneTests = run.NodesAccepted = run.Visible = 0.0;
+	run.VisibleMax = 0;
+
+	Camera camera = CreateCamera();
+	for (int frame = -g_iWarmupFrames; frame < frames; ++frame){
+		SetCameraOnPath(camera, PVRT_MAX(frame, 0) / (float)PVRT_MAX(frames - 1, 1), sceneMin, sceneMax);
+		timer.Start();
+		vector<mModel*> visible = scene.ModelsNeedRender(camera.getFrustum());
+		double ms = timer.StopMs();
+		if (frame < 0) continue;
+		run.FrameMs.push_back(ms);
+		run.NodesVisited += scene.NodesVisited;
+		run.NodesNotCulled += scene.Count;
+		run.PlaneTests += scene.PlaneTests;
+		run.NodesAccepted += scene.NodesAccepted;
+		run.Visible += visible.size();
+		run.VisibleMax = PVRT_MAX(run.VisibleMax, (unsigned int)visible.size());
+	}
+	run.NodesVisited /= frames;
+	run.NodesNotCulled /= frames;
+	run.PlaneTests /= frames;
+	run.NodesAccepted /= frames;
+	run.Visible /= frames;
+	sort(run.FrameMs.begin(), run.FrameMs.end());
+
+	scene.Destroy();
+	return true;
+}
+
+static double MeanMs(vector<double> & frameMs)
+{
+	double sum = 0.0;
+	for (unsigned int i = 0; i < frameMs.size(); ++i) sum += frameMs[i];
+	return frameMs.empty() ? 0.0 : sum / frameMs.size();
+}
+
+static void WriteCSV(const char * path, vector<SceneRun> & runs, int frames)
+{
+	FILE * file = fopen(path, "w");
+	if (file == NULL){
+		printf("Cannot write %s\n", path);
+		return;
+	}
+	fprintf(file, "scene,index,models,frames,build_ms,mean_ms,p50_ms,p90_ms,p95_ms,p99_ms,max_ms,nodes_visited,nodes_not_culled,plane_tests,nodes_accepted,visible,visible_max\n");
+	for (unsigned int i = 0; i < runs.size(); ++i){
+		SceneRun & r = runs[i];
+		fprintf(file, "%s,%s,%u,%i,%.4f,%.5f,%.5f,%.5f,%.5f,%.5f,%.5f,%.1f,%.1f,%.1f,%.1f,%.1f,%u\n", r.Scene, r.Index, r.Models, frames, r.BuildMs,
+			MeanMs(r.FrameMs), Percentile(r.FrameMs, 50.0), Percentile(r.FrameMs, 90.0), Percentile(r.FrameMs, 95.0), Percentile(r.FrameMs, 99.0),
+			Percentile(r.FrameMs, 100.0), r.NodesVisited, r.NodesNotCulled, r.PlaneTests, r.NodesAccepted, r.Visible, r.VisibleMax);
+	}
+	fclose(file);
+}
+
+static void WriteJSON(const char * path, vector<SceneRun> & runs, int frames, int depth)
+{
+	FILE * file = fopen(path, "w");
+	if (file == NULL){
+		printf("Cannot write %s\n", path);
+		return;
+	}
+	fprintf(file, "{\n  \"frames\": %i,\n  \"warmupFrames\": %i,\n  \"depth\": %i,\n  \"cameraKeys\": %i,\n  \"runs\": [\n", frames, g_iWarmupFrames, depth, g_iCameraKeys);
+	for (unsigned int i = 0; i < runs.size(); ++i){
+		SceneRun & r = runs[i];
+		fprintf(file, "    { \"scene\": \"%s\", \"index\": \"%s\", \"models\": %u, \"buildMs\": %.4f,\n", r.Scene, r.Index, r.Models, r.BuildMs);
+		fprintf(file, "      \"frameMs\": { \"mean\": %.5f, \"p50\": %.5f, \"p90\": %.5f, \"p95\": %.5f, \"p99\": %.5f, \"max\": %.5f },\n",
+			MeanMs(r.FrameMs), Percentile(r.FrameMs, 50.0), Percentile(r.FrameMs, 90.0), Percentile(r.FrameMs, 95.0), Percentile(r.FrameMs, 99.0), Percentile(r.FrameMs, 100.0));
+		fprintf(file, "      \"perFrame\": { \"nodesVisited\": %.1f, \"nodesNotCulled\": %.1f, \"planeTests\": %.1f, \"nodesAccepted\": %.1f, \"visible\": %.1f, \"visibleMax\": %u } }%s\n",
+			r.NodesVisited, r.NodesNotCulled, r.PlaneTests, r.NodesAccepted, r.Visible, r.VisibleMax, i + 1 < runs.size() ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+	fclose(file);
+}
+
+/*!****************************************************************************
+@Function		ListHas
+@Description	True when the comma separated list holds name, or is "all".
+******************************************************************************/
+static bool ListHas(const char * list, const char * name)
+{
+	if (strcmp(list, "all") == 0) return true;
+	size_t length = strlen(name);
+	for (const char * p = list; *p;){
+		const char * end = strchr(p, ',');
+		size_t itemLength = end ? (size_t)(end - p) : strlen(p);
+		if (itemLength == length && strncmp(p, name, length) == 0) return true;
+		if (end == NULL) break;
+		p = end + 1;
+	}
+	return false;
+}
+
+/*!****************************************************************************
+@Function		BenchScenes
+@Input			sceneList		grid, uniform, clustered, stacked or all
+@Input			indexList		quadnode, linear, loose, bvh or all
+@Input			modelCount		models of every scene, the grid is rounded to a square
+@Description	The grid is laid out like m_WaterGroup, the others use the
+model generators above. Frame times are single ModelsNeedRender calls.
+******************************************************************************/
+static void BenchScenes(const char * sceneList, const char * indexList, unsigned int modelCount, int depth, int frames,
+	const char * csvPath, const char * jsonPath)
+{
+	const char * scenes[] = { "grid", "uniform", "clustered", "stacked" };
+	const char * indices[] = { "quadnode", "linear", "loose", "bvh" };
+	vector<SceneRun> runs;
+	vector<mModel> models;
+	for (int s = 0; s < 4; ++s){
+		if (!ListHas(sceneList, scenes[s])) continue;
+		if (s == 0) CreateTileGrid(PVRT_MAX(1, (int)(sqrt((double)modelCount) - 1.0) / 2), models);
+		else if (s == 1) CreateRandomModels(modelCount, models);
+		else if (s == 2) CreateClusteredModels(modelCount, models);
+		else CreateStackedModels(modelCount, models);
+
+		printf("Scene %s: %u models, depth %i, %i frames\n", scenes[s], (unsigned int)models.size(), depth, frames);
+		for (int i = 0; i < 4; ++i){
+			if (!ListHas(indexList, indices[i])) continue;
+			SceneRun run;
+			if (!RunScene(scenes[s], indices[i], models, depth, frames, run)) continue;
+			printf("  %-10s build %9.2f ms  mean %8.4f  p50 %8.4f  p90 %8.4f  p99 %8.4f  max %8.4f ms  nodes %8.1f  plane tests %9.1f  visible %9.1f\n",
+				run.Index, run.BuildMs, MeanMs(run.FrameMs), Percentile(run.FrameMs, 50.0), Percentile(run.FrameMs, 90.0),
+				Percentile(run.FrameMs, 99.0), Percentile(run.FrameMs, 100.0), run.NodesVisited, run.PlaneTests, run.Visible);
+			runs.push_back(run);
+		}
+	}
+	if (csvPath) WriteCSV(csvPath, runs, frames);
+	if (jsonPath) WriteJSON(jsonPath, runs, frames, depth);
+}
+
+/*!****************************************************************************
+@Function		ReadOption
+@Description	Returns the value of -name=value, or NULL when not present.
+******************************************************************************/
+static const char * ReadOption(int argc, char ** argv, const char * name)
+{
+	size_t length = strlen(name);
+	for (int i = 1; i < argc; ++i){
+		if (argv[i][0] == '-' && strncmp(argv[i] + 1, name, length) == 0){
+			if (argv[i][length + 1] == '=') return argv[i] + length + 2;
+			if (argv[i][length + 1] == 0) return "";
+		}
+	}
+	return NULL;
+}
+
+/*!****************************************************************************
+@Function		main
+@Description	CullingBenchmark [-grid=halfGrid] [-frames=N] [-depth=N]
+[-models=10000,100000,1000000] [-forcepointertree] [-moving=N] [-multiview=N] [-threads=N]
+[-occlusion=N] [-bvh=N] [-bounds=N] [-clipmap=levels]
+Scene harness: -scene=grid,uniform,clustered,stacked|all [-index=quadnode,linear,loose,bvh|all]
+[-count=N] [-csv=file] [-json=file], with -frames and -depth as above
+******************************************************************************/
+int main(int argc, char ** argv)
+{
+	int halfGrid = g_iDefaultHalfGrid;
+	int frames = g_iDefaultFrames;
+	int depth = g_iDefaultTreeDepth;
+	const char * modelCounts = "10000,100000,1000000";
+	const char * value;
+	if ((value = ReadOption(argc, argv, "grid")) != NULL) halfGrid = atoi(value);
+	if ((value = ReadOption(argc, argv, "frames")) != NULL) frames = atoi(value);
+	if ((value = ReadOption(argc, argv, "depth")) != NULL) depth = atoi(value);
+	if ((value = ReadOption(argc, argv, "models")) != NULL) modelCounts = value;
+	bool forcePointerTree = ReadOption(argc, argv, "forcepointertree") != NULL;
+	unsigned int movingModels = g_uiDefaultMovingModels;
+	if ((value = ReadOption(argc, argv, "moving")) != NULL) movingModels = (unsigned int)atoi(value);
+	unsigned int multiViewModels = g_uiDefaultMultiViewModels;
+	if ((value = ReadOption(argc, argv, "multiview")) != NULL) multiViewModels = (unsigned int)atoi(value);
+	int threads = -1;
+	if ((value = ReadOption(argc, argv, "threads")) != NULL) threads = atoi(value);
+	unsigned int occlusionModels = g_uiDefaultOcclusionModels;
+	if ((value = ReadOption(argc, argv, "occlusion")) != NULL) occlusionModels = (unsigned int)atoi(value);
+	unsigned int bvhModels = g_uiDefaultBVHModels;
+	if ((value = ReadOption(argc, argv, "bvh")) != NULL) bvhModels = (unsigned int)atoi(value);
+	unsigned int boundsVertices = g_uiDefaultBoundsVertices;
+	if ((value = ReadOption(argc, argv, "bounds")) != NULL) boundsVertices = (unsigned int)atoi(value);
+	int clipmapLevels = g_iDefaultClipmapLevels;
+	if ((value = ReadOption(argc, argv, "clipmap")) != NULL) clipmapLevels = atoi(value);
+	if (halfGrid < 1) halfGrid = 1;
+	if (frames < 1) frames = 1;
+
+	const char * sceneList = ReadOption(argc, argv, "scene");
+	if (sceneList != NULL){
+		const char * indexList = ReadOption(argc, argv, "index");
+		unsigned int sceneModels = g_uiDefaultSceneModels;
+		if ((value = ReadOption(argc, argv, "count")) != NULL) sceneModels = (unsigned int)atoi(value);
+		BenchScenes(*sceneList ? sceneList : "all", indexList && *indexList ? indexList : "all", sceneModels, depth, frames,
+			ReadOption(argc, argv, "csv"), ReadOption(argc, argv, "json"));
+		return 0;
+	}
+
+	BenchBoxCuller(halfGrid, frames);
+
+	for (const char * p = modelCounts; *p;){
+		unsigned int count = (unsigned int)strtoul(p, (char**)&p, 10);
+		if (count > 0) BenchSceneIndex(count, depth, frames, forcePointerTree);
+		while (*p == ',') p++;
+		if (*p && (*p < '0' || *p > '9')) break;
+	}
+
+	if (movingModels > 0) BenchMovingModels(movingModels, depth, frames);
+	if (multiViewModels > 0) BenchMultiView(multiViewModels, depth, frames, threads);
+	if (occlusionModels > 0) BenchOcclusion(occlusionModels, depth, frames);
+	if (bvhModels > 0) BenchBVH(bvhModels, halfGrid, depth, frames, threads);
+	if (boundsVertices > 0) BenchBounds(boundsVertices, frames, threads);
+	if (clipmapLevels > 0) BenchClipmap(clipmapLevels, frames);
+	return 0;
+}
+
+/******************************************************************************
+End of file (CullingBenchmark.cpp)
+******************************************************************************/
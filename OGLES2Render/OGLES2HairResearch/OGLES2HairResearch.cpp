@@ -17,8 +17,10 @@ halves of the scene to a single rectangular texture.
 
 #include "PVRShell.h"
 #include "OGLES2Tools.h"
+#include "..\mFunctionTools\Include\mRenderQueue.h"
 #include <iostream>
 #include <limits.h>
+#include <vector>
 
 
 /******************************************************************************
@@ -54,6 +56,34 @@ const char* g_aszUniformNames[] =
 	"MVPMatrix", "MVMatrix", "MMatrix", "MMatrix_I", "MMatrix_IT", "MVMatrix_IT", "InvVPMatrix", "LightDir", "EyePos", "Pass", "diffuseColor"
 };
 
+// Ids of the draws in m_RenderQueue, the hair passes keep their order
+enum ERenderPass
+{
+	ePassOpaque, ePassHairOpaque, ePassHairBackFaces, ePassHairFrontFaces, eNumRenderPasses
+};
+enum ERenderProgram
+{
+	eProgramBlinnPhong, eProgramHair
+};
+enum ERenderTextures
+{
+	eTexturesHead, eTexturesHair
+};
+enum ERenderMesh
+{
+	eMeshBall, eMeshHead, eMeshHair
+};
+
+// One queued draw, Item of its mRenderItem
+struct SceneDraw
+{
+	enum EType{ eBall, eHead, eHair };
+	EType Type;
+	PVRTMat4 Model;
+	PVRTVec3 DiffuseColor;
+	int HairPass;
+};
+
 /******************************************************************************
 Content file names
 ******************************************************************************/
@@ -139,6 +169,13 @@ class OGLES2Glass : public PVRShell
 
 	int m_iEffect;
 
+	// Draws of a frame, sorted by state
+	mRenderQueue m_RenderQueue;
+	vector<SceneDraw> m_SceneDraws;
+
+	// Shadow of the GL bindings, drops redundant state calls
+	CPVRTStateCache m_StateCache;
+
 public:
 	virtual bool InitApplication();
 	virtual bool InitView();
@@ -154,11 +191,21 @@ private:
 	void UpdateScene();
 
 	void DrawMesh(int i32NodeIndex, CPVRTModelPOD* pod, GLuint** ppuiVbos, GLuint** ppuiIbos, int i32NumAttributes);
-
-	void DrawBall(PVRTVec3 position, PVRTVec3 diffuseColor);
+	void SetMeshAttribs(int i32NodeIndex, CPVRTModelPOD* pod, GLuint** ppuiVbos, GLuint** ppuiIbos);
+	void DrawMeshElements(int i32NodeIndex, CPVRTModelPOD* pod, GLuint** ppuiIbos);
+
+	void SubmitDraw(int pass, int program, int textureSet, int mesh, PVRTMat4 & model, SceneDraw & draw);
+	void ExecuteRenderQueue();
+	void BindRenderPass(int pass);
+	void BindRenderTextures(int textureSet);
+	void BindRenderMesh(int mesh);
+	void DrawRenderItem(PVRTuint32 item);
+	PVRTMat4 HeadModelMatrix();
+
+	void SubmitBall(PVRTVec3 position, PVRTVec3 diffuseColor);
 	void DrawCube();
-	void DrawHair(int pass);
-	void DrawHead();
+	void SubmitHair(int pass);
+	void SubmitHead();
 };
 
 /*!****************************************************************************
@@ -467,6 +514,12 @@ bool OGLES2Glass::InitApplication()
 
 	m_iEffect = 0;
 
+	m_RenderQueue.SetPassBlended(ePassOpaque, false);
+	m_RenderQueue.SetPassBlended(ePassHairOpaque, false);
+	m_RenderQueue.SetPassBlended(ePassHairBackFaces, true);
+	m_RenderQueue.SetPassBlended(ePassHairFrontFaces, true);
+	m_RenderQueue.SetDepthRange(g_fCamNear, g_fCamFar);
+
 	//ʼ۲
 	m_mView = PVRTMat4::LookAtRH(m_globalViewPos, PVRTVec3(0, 0, 0), PVRTVec3(0, 1, 0));
 
@@ -568,6 +621,9 @@ bool OGLES2Glass::InitView()
 	glClearColor(0.6f, 0.8f, 1.0f, 0.0f);
 	//glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
+	// loading bound buffers, textures and programs behind the cache
+	m_StateCache.Invalidate();
+
 	return true;
 }
 
@@ -629,6 +685,8 @@ these events through an abstraction layer provided by PVRShell.
 ******************************************************************************/
 bool OGLES2Glass::RenderScene()
 {
+	m_StateCache.NewFrame();
+
 	if (PVRShellIsKeyPressed(PVRShellKeyNameUP)){
 		m_mView *= PVRTMat4::RotationX(10.0f / 180.0f * PVRT_PI);
 		//m_mView *= PVRTMat4::Translation(0.0, 0.0, -1.0);
@@ -656,67 +714,30 @@ bool OGLES2Glass::RenderScene()
 	// Clear the color
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	glEnable(GL_DEPTH_TEST);
-	glDepthFunc(GL_LESS);
-	DrawHead();
-	glDisable(GL_DEPTH_TEST);
+	SubmitHead();
 
 	//Draw Hair
-	//1
-	glEnable(GL_DEPTH_TEST); //Z test
-	glDepthFunc(GL_LEQUAL);
-
-	DrawHair(1); //ȫ͸
+	SubmitHair(1);
+	SubmitHair(2);
+	SubmitHair(3);
 
-	glDisable(GL_DEPTH_TEST);
-
-	//////2
-	glEnable(GL_DEPTH_TEST); //Z test
-	glEnable(GL_BLEND);//ϣư͸
-	glEnable(GL_CULL_FACE);
-
-	glDepthFunc(GL_LESS);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glFrontFace(GL_CW);
-	glCullFace(GL_FRONT);//޳
-
-	DrawHair(2);
-
-	glDisable(GL_CULL_FACE);
-	glDisable(GL_BLEND);
-	glDisable(GL_DEPTH_TEST);
-
-	/////3
-	glEnable(GL_DEPTH_TEST); //Z test
-	glEnable(GL_BLEND);//ϣư͸
-	glEnable(GL_CULL_FACE);
-
-	glDepthFunc(GL_LESS);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glFrontFace(GL_CW);
-	glCullFace(GL_BACK);//޳
-
-	DrawHair(3);
-
-	glDisable(GL_CULL_FACE);
-	glDisable(GL_BLEND);
-	glDisable(GL_DEPTH_TEST);
-
-	//////
-	glEnable(GL_DEPTH_TEST);
-	glDepthFunc(GL_LESS);
 	// Draw the ball
-	DrawBall(PVRTVec3(0, 0, 0), PVRTVec3(0, 0, 0));
-	DrawBall(PVRTVec3(10, 0, 0), PVRTVec3(1, 0, 0));
-	DrawBall(PVRTVec3(0, 10, 0), PVRTVec3(0, 1, 0));
-	DrawBall(PVRTVec3(0, 0, 10), PVRTVec3(0, 0, 1));
+	SubmitBall(PVRTVec3(0, 0, 0), PVRTVec3(0, 0, 0));
+	SubmitBall(PVRTVec3(10, 0, 0), PVRTVec3(1, 0, 0));
+	SubmitBall(PVRTVec3(0, 10, 0), PVRTVec3(0, 1, 0));
+	SubmitBall(PVRTVec3(0, 0, 10), PVRTVec3(0, 0, 1));
+
+	ExecuteRenderQueue();
 
-	glDisable(GL_DEPTH_TEST);
-	
-	
 	// Displays the demo name using the tools. For a detailed explanation, see the training course IntroducingPVRTools
 	//m_Print3D.DisplayDefaultTitle("Glass", "123", ePVRTPrint3DSDKLogo);
-	//m_Print3D.Flush();
+	m_Print3D.Print3D(0.0, 5.0, 1.0, PVRTRGBA(255, 255, 255, 255), "StateChanges:%u of %u, unsorted %u",
+		m_RenderQueue.Stats.Binds, m_RenderQueue.Stats.NaiveBinds, m_RenderQueue.Stats.UnsortedBinds);
+	m_Print3D.Print3D(0.0, 10.0, 1.0, PVRTRGBA(255, 255, 255, 255), "GLCalls:%u issued %u filtered",
+		m_StateCache.m_sLastFrame.Issued(), m_StateCache.m_sLastFrame.Filtered());
+	m_Print3D.Flush();
+	// Print3D sets and restores its own state without the cache
+	m_StateCache.Invalidate();
 
 	return true;
 }
@@ -765,17 +786,33 @@ i32NumAttributes	Number of vertex attributes to activate
 the meterial prepared.
 ******************************************************************************/
 void OGLES2Glass::DrawMesh(int i32NodeIndex, CPVRTModelPOD* pod, GLuint** ppuiVbos, GLuint** ppuiIbos, int i32NumAttributes)
+{
+	SetMeshAttribs(i32NodeIndex, pod, ppuiVbos, ppuiIbos);
+
+	// Enable the vertex attribute arrays, the ones of the previous mesh stay enabled when they are shared
+	m_StateCache.EnableVertexAttribArrays(i32NumAttributes);
+
+	DrawMeshElements(i32NodeIndex, pod, ppuiIbos);
+}
+
+/*!****************************************************************************
+@Function		SetMeshAttribs
+@Input			i32NodeIndex		Node index of the mesh
+pod					POD containing the node
+ppuiVbos			VBO to bind to
+ppuiIbos			IBO to bind to
+@Description	Binds the buffers of a SPODMesh and sets the vertex attribute
+offsets, the attribute arrays are enabled by the caller.
+******************************************************************************/
+void OGLES2Glass::SetMeshAttribs(int i32NodeIndex, CPVRTModelPOD* pod, GLuint** ppuiVbos, GLuint** ppuiIbos)
 {
 	int i32MeshIndex = pod->pNode[i32NodeIndex].nIdx;
 	SPODMesh* pMesh = &pod->pMesh[i32MeshIndex];
 
 	// bind the VBO for the mesh
-	glBindBuffer(GL_ARRAY_BUFFER, (*ppuiVbos)[i32MeshIndex]);
+	m_StateCache.BindBuffer(GL_ARRAY_BUFFER, (*ppuiVbos)[i32MeshIndex]);
 	// bind the index buffer, won't hurt if the handle is 0
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (*ppuiIbos)[i32MeshIndex]);
-
-	// Enable the vertex attribute arrays
-	for (int i = 0; i < i32NumAttributes; ++i) { glEnableVertexAttribArray(i); }
+	m_StateCache.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, (*ppuiIbos)[i32MeshIndex]);
 
 	// Set the vertex attribute offsets
 	glVertexAttribPointer(VERTEX_ARRAY, 3, GL_FLOAT, GL_FALSE, pMesh->sVertex.nStride, pMesh->sVertex.pData);
@@ -786,6 +823,19 @@ void OGLES2Glass::DrawMesh(int i32NodeIndex, CPVRTModelPOD* pod, GLuint** ppuiVb
 		glVertexAttribPointer(TEXCOORD_ARRAY1, 2, GL_FLOAT, GL_FALSE, pMesh->psUVW[0].nStride, pMesh->psUVW[0].pData);
 		//glVertexAttribPointer(TEXCOORD_ARRAY2, 2, GL_FLOAT, GL_FALSE, pMesh->psUVW[1].nStride, pMesh->psUVW[1].pData);
 	}
+}
+
+/*!****************************************************************************
+@Function		DrawMeshElements
+@Input			i32NodeIndex		Node index of the mesh to draw
+pod					POD containing the node to draw
+ppuiIbos			IBO the mesh was bound with
+@Description	Draws a SPODMesh bound by SetMeshAttribs.
+******************************************************************************/
+void OGLES2Glass::DrawMeshElements(int i32NodeIndex, CPVRTModelPOD* pod, GLuint** ppuiIbos)
+{
+	int i32MeshIndex = pod->pNode[i32NodeIndex].nIdx;
+	SPODMesh* pMesh = &pod->pMesh[i32MeshIndex];
 
 	/*
 	The geometry can be exported in 4 ways:
@@ -825,55 +875,156 @@ void OGLES2Glass::DrawMesh(int i32NodeIndex, CPVRTModelPOD* pod, GLuint** ppuiVb
 			offset += pMesh->pnStripLength[i] + 2;
 		}
 	}
-
-	// Safely disable the vertex attribute arrays
-	for (int i = 0; i < i32NumAttributes; ++i) { glDisableVertexAttribArray(i); }
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
+/*!****************************************************************************
+@Function		SubmitDraw
+@Input			model		model matrix, its distance to the eye sorts the draw
+@Input			draw		stored in m_SceneDraws, its index is the queue item
+******************************************************************************/
+void OGLES2Glass::SubmitDraw(int pass, int program, int textureSet, int mesh, PVRTMat4 & model, SceneDraw & draw)
+{
+	PVRTVec4 vEyePos = m_mView.inverse() * PVRTVec4(0, 0, 0, 1);
+	PVRTVec3 vToModel(model.f[12] - vEyePos.x, model.f[13] - vEyePos.y, model.f[14] - vEyePos.z);
 
+	draw.Model = model;
+	m_SceneDraws.push_back(draw);
+	m_RenderQueue.Submit(pass, program, textureSet, mesh, vToModel.length(), (PVRTuint32)(m_SceneDraws.size() - 1));
+}
 
 /*!****************************************************************************
-@Function		DrawBall
-@Description	Draws the reflective and refractive ball onto the screen.
+@Function		ExecuteRenderQueue
+@Description	Sorts and draws the frame's queue. Only the state that differs
+from the previous draw is bound.
 ******************************************************************************/
-void OGLES2Glass::DrawBall(PVRTVec3 position, PVRTVec3 diffuseColor)
+void OGLES2Glass::ExecuteRenderQueue()
 {
-	// Set model view projection matrix
-	PVRTMat4 mModel, mModelView, mMVP;
+	mRenderBinder binder;
+	binder.BindPass = [this](int pass) { BindRenderPass(pass); };
+	binder.BindProgram = [this](int program) { m_StateCache.UseProgram(program == eProgramHair ? m_DefaultProgram.uiId : m_BlinnPhongProgram.uiId); };
+	binder.BindTextures = [this](int textureSet) { BindRenderTextures(textureSet); };
+	binder.BindMesh = [this](int mesh) { BindRenderMesh(mesh); };
+	binder.Draw = [this](PVRTuint32 item) { DrawRenderItem(item); };
 
-	mModel = PVRTMat4::Identity();
-	mModel *= PVRTMat4::Translation(position);
-	mModel *= PVRTMat4::Scale(2, 2, 2);
+	m_RenderQueue.Sort();
+	m_RenderQueue.Execute(binder);
 
-	mModelView = m_mView * mModel;
-	mMVP = m_mProjection * mModelView;
+	// Print3D draws from client memory with its own attributes
+	m_StateCache.EnableVertexAttribArrays(0);
 
-	// Use shader program
-	glUseProgram(m_BlinnPhongProgram.uiId);
+	m_StateCache.Disable(GL_CULL_FACE);
+	m_StateCache.Disable(GL_BLEND);
+	m_StateCache.Disable(GL_DEPTH_TEST);
+
+	m_RenderQueue.Clear();
+	m_SceneDraws.clear();
+}
+
+/*!****************************************************************************
+@Function		BindRenderPass
+@Description	Depth, blend and cull state of an ERenderPass. The hair is
+drawn opaque first, then blended with the back faces and the front faces.
+******************************************************************************/
+void OGLES2Glass::BindRenderPass(int pass)
+{
+	m_StateCache.Enable(GL_DEPTH_TEST); //Z test
+	switch (pass)
+	{
+	case ePassHairOpaque:
+		m_StateCache.DepthFunc(GL_LEQUAL);
+		m_StateCache.Disable(GL_BLEND);
+		m_StateCache.Disable(GL_CULL_FACE);
+		break;
+	case ePassHairBackFaces:
+	case ePassHairFrontFaces:
+		m_StateCache.DepthFunc(GL_LESS);
+		m_StateCache.Enable(GL_BLEND);
+		m_StateCache.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		m_StateCache.Enable(GL_CULL_FACE);
+		m_StateCache.FrontFace(GL_CW);
+		m_StateCache.CullFace(pass == ePassHairBackFaces ? GL_FRONT : GL_BACK);
+		break;
+	default:
+		m_StateCache.DepthFunc(GL_LESS);
+		m_StateCache.Disable(GL_BLEND);
+		m_StateCache.Disable(GL_CULL_FACE);
+		break;
+	}
+}
 
-	// Bind textures
+void OGLES2Glass::BindRenderTextures(int textureSet)
+{
+	if (textureSet == eTexturesHead){
+		m_StateCache.BindTexture(0, GL_TEXTURE_2D, m_uiHeadDiffTex);
+	}
+	else{
+		m_StateCache.BindTexture(0, GL_TEXTURE_2D, m_uiHairDiffWhiteTex);
+		m_StateCache.BindTexture(1, GL_TEXTURE_2D, m_uiHairNMTex);
+		m_StateCache.BindTexture(2, GL_TEXTURE_2D, m_uiHairFlowT2Tex);
+	}
+}
 
+void OGLES2Glass::BindRenderMesh(int mesh)
+{
+	switch (mesh)
+	{
+	case eMeshBall:
+		SetMeshAttribs(0, &m_Ball, &m_puiBallVbo, &m_puiBallIndexVbo);
+		m_StateCache.EnableVertexAttribArrays(2);
+		break;
+	case eMeshHead:
+		SetMeshAttribs(0, &m_HeadModel, &m_puiHeadVbo, &m_puiHeadIndexVbo);
+		m_StateCache.EnableVertexAttribArrays(5);
+		break;
+	default:
+		SetMeshAttribs(0, &m_HairModel, &m_puiHairModelVbo, &m_puiHairModelIndexVbo);
+		m_StateCache.EnableVertexAttribArrays(5);
+		break;
+	}
+}
 
-	glUniformMatrix4fv(m_BlinnPhongProgram.auiLoc[eMVPMatrix], 1, GL_FALSE, mMVP.ptr());
+/*!****************************************************************************
+@Function		DrawRenderItem
+@Input			item		index in m_SceneDraws
+@Description	Sets the per draw uniforms and draws, the rest of the state was
+bound by the render queue.
+******************************************************************************/
+void OGLES2Glass::DrawRenderItem(PVRTuint32 item)
+{
+	SceneDraw & draw = m_SceneDraws[item];
+	Program & program = draw.Type == SceneDraw::eHair ? m_DefaultProgram : m_BlinnPhongProgram;
 
+	PVRTMat4 mModelView = m_mView * draw.Model;
+	PVRTMat4 mMVP = m_mProjection * mModelView;
+	glUniformMatrix4fv(program.auiLoc[eMVPMatrix], 1, GL_FALSE, mMVP.ptr());
+
+	if (draw.Type == SceneDraw::eHair){
+		glUniform1f(program.auiLoc[ePass], (GLfloat)draw.HairPass);
+	}
 
 	// Set eye position in model space
 	PVRTVec4 vEyePosModel;
 	vEyePosModel = mModelView.inverse() * PVRTVec4(0, 0, 0, 1);
-	glUniform3fv(m_BlinnPhongProgram.auiLoc[eEyePos], 1, &vEyePosModel.x);
+	glUniform3fv(program.auiLoc[eEyePos], 1, &vEyePosModel.x);
 
 	// Calculate and set the model space light direction
-	PVRTVec3 vLightDir = mModel.inverse() * m_globalLightDir;
+	PVRTVec3 vLightDir = draw.Model.inverse() * m_globalLightDir;
 	vLightDir = vLightDir.normalize();
-	glUniform3fv(m_BlinnPhongProgram.auiLoc[eLightDir], 1, vLightDir.ptr());
+	glUniform3fv(program.auiLoc[eLightDir], 1, vLightDir.ptr());
 
-	glUniform3fv(m_BlinnPhongProgram.auiLoc[eDiffuseColor], 1, diffuseColor.ptr());
-
-	// Now that the uniforms are set, call another function to actually draw the mesh
-	DrawMesh(0, &m_Ball, &m_puiBallVbo, &m_puiBallIndexVbo, 2);
+	switch (draw.Type)
+	{
+	case SceneDraw::eBall:
+		glUniform3fv(program.auiLoc[eDiffuseColor], 1, draw.DiffuseColor.ptr());
+		DrawMeshElements(0, &m_Ball, &m_puiBallIndexVbo);
+		break;
+	case SceneDraw::eHead:
+		DrawMeshElements(0, &m_HeadModel, &m_puiHeadIndexVbo);
+		break;
+	default:
+		DrawMeshElements(0, &m_HairModel, &m_puiHairModelIndexVbo);
+		break;
+	}
 }
 
 /*!****************************************************************************
@@ -890,7 +1041,7 @@ void OGLES2Glass::DrawCube(){
 	mMVP = m_mProjection * mModelView;
 
 	// Use shader program
-	glUseProgram(m_DefaultProgram.uiId);
+	m_StateCache.UseProgram(m_DefaultProgram.uiId);
 
 	glUniformMatrix4fv(m_DefaultProgram.auiLoc[eMVPMatrix], 1, GL_FALSE, mMVP.ptr());
 
@@ -913,86 +1064,65 @@ void OGLES2Glass::DrawCube(){
 }
 
 /*!****************************************************************************
-@Function		DrawPlane
-@Description	Draws your hair into the screen.
+@Function		HeadModelMatrix
+@Return		PVRTMat4		model matrix shared by the head and the hair
 ******************************************************************************/
-void OGLES2Glass::DrawHead(){
-	
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_uiHeadDiffTex);
-
-	PVRTMat4 mModel, mModelView, mMVP;
+PVRTMat4 OGLES2Glass::HeadModelMatrix()
+{
+	PVRTMat4 mModel;
 
-	mModel = PVRTMat4::Identity() * PVRTMat4::RotationY(PVRT_PI / 1.1f);;
+	mModel = PVRTMat4::Identity() * PVRTMat4::RotationY(PVRT_PI / 1.1f);
 	mModel *= PVRTMat4::RotationX(PVRT_PI / 2);
 	mModel *= PVRTMat4::Scale(0.5, 0.5, 0.5);
-
-	mModelView = m_mView * mModel;
-	mMVP = m_mProjection * mModelView;
-
-	// Use shader program
-	glUseProgram(m_BlinnPhongProgram.uiId);
-
-	glUniformMatrix4fv(m_BlinnPhongProgram.auiLoc[eMVPMatrix], 1, GL_FALSE, mMVP.ptr());
-
-	// Set eye position in model space
-	PVRTVec4 vEyePosModel;
-	vEyePosModel = mModelView.inverse() * PVRTVec4(0, 0, 0, 1);
-	glUniform3fv(m_BlinnPhongProgram.auiLoc[eEyePos], 1, &vEyePosModel.x);
-
-	// Calculate and set the model space light direction
-	PVRTVec3 vLightDir = mModel.inverse() * m_globalLightDir;
-	vLightDir = vLightDir.normalize();
-	glUniform3fv(m_BlinnPhongProgram.auiLoc[eLightDir], 1, vLightDir.ptr());
-
-	// Now that the uniforms are set, call another function to actually draw the mesh
-	DrawMesh(0, &m_HeadModel, &m_puiHeadVbo, &m_puiHeadIndexVbo, 5);
+	return mModel;
 }
 
 /*!****************************************************************************
-@Function		DrawHair
-@Description	Draws your hair into the screen.
+@Function		SubmitBall
+@Description	Queues a ball. It samples texture unit 0 like it did when it
+was drawn after the hair.
 ******************************************************************************/
-void OGLES2Glass::DrawHair(int pass){
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_uiHairDiffWhiteTex);
-
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, m_uiHairNMTex);
-
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_2D, m_uiHairFlowT2Tex);
-
-	PVRTMat4 mModel, mModelView, mMVP;
-
-	mModel = PVRTMat4::Identity() * PVRTMat4::RotationY(PVRT_PI / 1.1f);;
-	mModel *= PVRTMat4::RotationX(PVRT_PI / 2);
-	mModel *= PVRTMat4::Scale(0.5, 0.5, 0.5);
-
-	mModelView = m_mView * mModel;
-	mMVP = m_mProjection * mModelView;
-
-	// Use shader program
-	glUseProgram(m_DefaultProgram.uiId);
-
-	glUniformMatrix4fv(m_DefaultProgram.auiLoc[eMVPMatrix], 1, GL_FALSE, mMVP.ptr());
+void OGLES2Glass::SubmitBall(PVRTVec3 position, PVRTVec3 diffuseColor)
+{
+	PVRTMat4 mModel;
 
-	glUniform1f(m_DefaultProgram.auiLoc[ePass], (GLfloat)pass);
+	mModel = PVRTMat4::Identity();
+	mModel *= PVRTMat4::Translation(position);
+	mModel *= PVRTMat4::Scale(2, 2, 2);
 
-	// Set eye position in model space
-	PVRTVec4 vEyePosModel;
-	vEyePosModel = mModelView.inverse() * PVRTVec4(0, 0, 0, 1);
-	glUniform3fv(m_DefaultProgram.auiLoc[eEyePos], 1, &vEyePosModel.x);
+	SceneDraw draw;
+	draw.Type = SceneDraw::eBall;
+	draw.DiffuseColor = diffuseColor;
+	draw.HairPass = 0;
+	SubmitDraw(ePassOpaque, eProgramBlinnPhong, eTexturesHair, eMeshBall, mModel, draw);
+}
 
-	// Calculate and set the model space light direction
-	PVRTVec3 vLightDir = mModel.inverse() * m_globalLightDir;
-	vLightDir = vLightDir.normalize();
-	glUniform3fv(m_DefaultProgram.auiLoc[eLightDir], 1, vLightDir.ptr());
+/*!****************************************************************************
+@Function		SubmitHead
+@Description	Queues the head.
+******************************************************************************/
+void OGLES2Glass::SubmitHead(){
+	PVRTMat4 mModel = HeadModelMatrix();
 
+	SceneDraw draw;
+	draw.Type = SceneDraw::eHead;
+	draw.HairPass = 0;
+	SubmitDraw(ePassOpaque, eProgramBlinnPhong, eTexturesHead, eMeshHead, mModel, draw);
+}
 
-	// Now that the uniforms are set, call another function to actually draw the mesh
-	DrawMesh(0, &m_HairModel, &m_puiHairModelVbo, &m_puiHairModelIndexVbo, 5);
+/*!****************************************************************************
+@Function		SubmitHair
+@Input			pass		1 opaque, 2 blended back faces, 3 blended front faces
+@Description	Queues one pass of the hair.
+******************************************************************************/
+void OGLES2Glass::SubmitHair(int pass){
+	PVRTMat4 mModel = HeadModelMatrix();
+	int renderPass = pass == 1 ? ePassHairOpaque : (pass == 2 ? ePassHairBackFaces : ePassHairFrontFaces);
+
+	SceneDraw draw;
+	draw.Type = SceneDraw::eHair;
+	draw.HairPass = pass;
+	SubmitDraw(renderPass, eProgramHair, eTexturesHair, eMeshHair, mModel, draw);
 }
 
 
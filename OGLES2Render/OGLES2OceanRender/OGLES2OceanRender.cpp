@@ -109,6 +109,9 @@ class OGLES2OceanRender : public PVRShell
 	// Print3D class used to display text
 	CPVRTPrint3D m_Print3D;
 
+	// Shadow of the GL bindings, drops redundant state calls
+	CPVRTStateCache m_StateCache;
+
 	// 3D Models
 	CPVRTModelPOD m_Ball;
 	CPVRTModelPOD m_Cube;
@@ -686,6 +689,9 @@ bool OGLES2OceanRender::InitView()
 	glClearColor(0.6f, 0.8f, 1.0f, 0.0f);
 	//glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
+	// loading bound buffers, textures and programs behind the cache
+	m_StateCache.Invalidate();
+
 	return true;
 }
 
@@ -746,6 +752,7 @@ these events through an abstraction layer provided by PVRShell.
 ******************************************************************************/
 bool OGLES2OceanRender::RenderScene()
 {
+	m_StateCache.NewFrame();
 	ShowFPS();
 	if (PVRShellIsKeyPressed(PVRShellKeyNameUP)){
 		m_RotateAngelX += 10.0f / 180.0f *PVRT_PI;
@@ -778,7 +785,7 @@ bool OGLES2OceanRender::RenderScene()
 	// Clear the color
 
 
-	glEnable(GL_DEPTH_TEST);
+	m_StateCache.Enable(GL_DEPTH_TEST);
 	//DrawBall(PVRTVec3(0, 0, 0), PVRTVec3(0.0, 0.0, 0.0));
 	DrawBall(PVRTVec3(100, 0, 0), PVRTVec3(1.0, 0.0, 0.0));
 	DrawBall(PVRTVec3(0, 100, 0), PVRTVec3(0.0, 1.0, 0.0));
@@ -787,9 +794,15 @@ bool OGLES2OceanRender::RenderScene()
 
 	DrawSkybox();
 
-	glDisable(GL_DEPTH_TEST);
+	m_StateCache.Disable(GL_DEPTH_TEST);
+	// Print3D draws from client memory with its own attributes
+	m_StateCache.EnableVertexAttribArrays(0);
 
+	m_Print3D.Print3D(0.0, 5.0, 1.0, PVRTRGBA(255, 255, 255, 255), "GLCalls:%u issued %u filtered",
+		m_StateCache.m_sLastFrame.Issued(), m_StateCache.m_sLastFrame.Filtered());
 	m_Print3D.Flush();
+	// Print3D sets and restores its own state without the cache
+	m_StateCache.Invalidate();
 	return true;
 }
 
@@ -836,14 +849,14 @@ void OGLES2OceanRender::DrawMesh(int i32NodeIndex, CPVRTModelPOD* pod, GLuint**
 	SPODMesh* pMesh = &pod->pMesh[i32MeshIndex];
 
 	// bind the VBO for the mesh
-	glBindBuffer(GL_ARRAY_BUFFER, (*ppuiVbos)[i32MeshIndex]);
+	m_StateCache.BindBuffer(GL_ARRAY_BUFFER, (*ppuiVbos)[i32MeshIndex]);
 	// bind the index buffer, won't hurt if the handle is 0
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (*ppuiIbos)[i32MeshIndex]);
+	m_StateCache.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, (*ppuiIbos)[i32MeshIndex]);
 
 	int NumAttribute = sizeof(i32Attributes) / sizeof(i32Attributes[0]);
 
-	// Enable the vertex attribute arrays
-	for (int i = 0; i < NumAttribute; ++i) { glEnableVertexAttribArray(i); }
+	// Enable the vertex attribute arrays, the ones of the previous mesh stay enabled when they are shared
+	m_StateCache.EnableVertexAttribArrays(NumAttribute);
 
 	// Set the vertex attribute offsets
 	for (int i = 0; i < NumAttribute; i++){
@@ -896,12 +909,6 @@ void OGLES2OceanRender::DrawMesh(int i32NodeIndex, CPVRTModelPOD* pod, GLuint**
 			offset += pMesh->pnStripLength[i] + 2;
 		}
 	}
-
-	// Safely disable the vertex attribute arrays
-	for (int i = 0; i < NumAttribute; ++i) { glDisableVertexAttribArray(i); }
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 /*!****************************************************************************
@@ -910,10 +917,9 @@ void OGLES2OceanRender::DrawMesh(int i32NodeIndex, CPVRTModelPOD* pod, GLuint**
 ******************************************************************************/
 void OGLES2OceanRender::DrawSkybox()
 {
-	glUseProgram(m_SkyboxProgram.uiId);
+	m_StateCache.UseProgram(m_SkyboxProgram.uiId);
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_uiSkybox1_Tex);
+	m_StateCache.BindTexture(0, GL_TEXTURE_CUBE_MAP, m_uiSkybox1_Tex);
 
 	PVRTMat4 m_ViewSkybox = m_mViewRotation * PVRTMat4::LookAtRH(PVRTVec3(0.0, 0.0, 0.0), m_globalViewDir, m_globalViewUp);
 	PVRTMat4 mVP = m_mProjection * m_ViewSkybox;
@@ -933,14 +939,14 @@ void OGLES2OceanRender::DrawSkybox()
 
 
 
-	glDisable(GL_CULL_FACE);
+	m_StateCache.Disable(GL_CULL_FACE);
 
 	// bind the VBO for the mesh
-	glBindBuffer(GL_ARRAY_BUFFER, m_puiSkyboxVbo);
+	m_StateCache.BindBuffer(GL_ARRAY_BUFFER, m_puiSkyboxVbo);
 	glVertexAttribPointer(VERTEX_ARRAY, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 3, NULL);
 
 	// Enable the vertex attribute arrays
-	glEnableVertexAttribArray(VERTEX_ARRAY);
+	m_StateCache.EnableVertexAttribArrays(VERTEX_ARRAY + 1);
 
 	for (int i = 0; i < 6; ++i)
 	{
@@ -948,9 +954,6 @@ void OGLES2OceanRender::DrawSkybox()
 		glDrawArrays(GL_TRIANGLE_STRIP, i * 4, 4);
 	}
 
-	// Safely disable the vertex attribute arrays
-	glDisableVertexAttribArray(VERTEX_ARRAY);
-
 	//glEnable(GL_CULL_FACE);
 }
 
@@ -960,16 +963,11 @@ void OGLES2OceanRender::DrawSkybox()
 ******************************************************************************/
 void OGLES2OceanRender::DrawWaterPlane()
 {
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_uiLargeWaves_H_Tex);
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, m_uiLargeWaves_N_Tex);
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_2D, m_uiSmallWaves_N_Tex);
-	glActiveTexture(GL_TEXTURE3);
-	glBindTexture(GL_TEXTURE_2D, m_uiSeaFoam1_Tex);
-	glActiveTexture(GL_TEXTURE4);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_uiSkybox1_Tex);
+	m_StateCache.BindTexture(0, GL_TEXTURE_2D, m_uiLargeWaves_H_Tex);
+	m_StateCache.BindTexture(1, GL_TEXTURE_2D, m_uiLargeWaves_N_Tex);
+	m_StateCache.BindTexture(2, GL_TEXTURE_2D, m_uiSmallWaves_N_Tex);
+	m_StateCache.BindTexture(3, GL_TEXTURE_2D, m_uiSeaFoam1_Tex);
+	m_StateCache.BindTexture(4, GL_TEXTURE_CUBE_MAP, m_uiSkybox1_Tex);
 
 	// Set model view projection matrix
 	PVRTMat4 mModel, mModelView, mMVP;
@@ -981,7 +979,7 @@ void OGLES2OceanRender::DrawWaterPlane()
 	mMVP = m_mProjection * mModelView;
 
 	// Use shader program
-	glUseProgram(m_DefaultProgram.uiId);
+	m_StateCache.UseProgram(m_DefaultProgram.uiId);
 
 	glUniformMatrix4fv(m_DefaultProgram.auiLoc[m_DefaultProgram.eMVPMatrix], 1, GL_FALSE, mMVP.ptr());
 	glUniformMatrix4fv(m_DefaultProgram.auiLoc[m_DefaultProgram.eMMatrix], 1, GL_FALSE, mModel.ptr());
@@ -1030,7 +1028,7 @@ void OGLES2OceanRender::DrawBall(PVRTVec3 position, PVRTVec3 diffuseColor)
 	mMVP = m_mProjection * mModelView;
 
 	// Use shader program
-	glUseProgram(m_BlinnPhongProgram.uiId);
+	m_StateCache.UseProgram(m_BlinnPhongProgram.uiId);
 
 	// Bind textures
 
@@ -1069,7 +1067,7 @@ void OGLES2OceanRender::DrawCube(){
 	mMVP = m_mProjection * mModelView;
 
 	// Use shader program
-	glUseProgram(m_DefaultProgram.uiId);
+	m_StateCache.UseProgram(m_DefaultProgram.uiId);
 
 	glUniformMatrix4fv(m_DefaultProgram.auiLoc[m_BlinnPhongProgram.eMVPMatrix], 1, GL_FALSE, mMVP.ptr());
 
@@ -22,6 +22,7 @@ halves of the scene to a single rectangular texture.
 #include <limits.h>
 #include <vector>
 #include <queue>
+#include <chrono>
 
 using namespace std;
 /******************************************************************************
@@ -32,6 +33,22 @@ const float g_fCamNear = 1.0f;
 const float g_fCamFar = 10000.0;
 const float g_fCamFOV = PVRT_PI / 3.0f;
 
+// World space clip planes of the reflection and refraction passes
+const PVRTVec4 g_vReflectionClipPlane(0.0f, 1.0f, 0.0f, 3.0f);
+const PVRTVec4 g_vRefractionClipPlane(0.0f, -1.0f, 0.0f, 3.0f);
+
+// Views culled together by m_CullingService
+enum ECullView
+{
+	eMainView, eReflectionView, eRefractionView, eNumCullViews
+};
+
+// Buoys floating on the water, half above and half below it, so they show in
+// the reflection and in the refraction
+const int g_iBuoyCount = 8;
+const float g_fBuoyRingRadius = 600.0f;
+const PVRTVec3 g_avBuoyColors[2] = { PVRTVec3(1.0f, 0.3f, 0.0f), PVRTVec3(1.0f, 1.0f, 1.0f) };
+
 enum EVertexAttrib
 {
 	VERTEX_ARRAY, NORMAL_ARRAY, TANGENT_ARRAY, BINORMAL_ARRAY, TEXCOORD_ARRAY, eNumAttribs
@@ -41,14 +58,127 @@ const char* g_aszAttribNames[] =
 	"inVertex", "inNormal", "inTangent", "inBiNormal", "inTexCoords"
 };
 
+// Extra attributes of the instanced water program, the batch path only has the slot number
+enum EInstanceAttrib
+{
+	INSTANCE_ROW0_ARRAY = eNumAttribs, INSTANCE_ROW1_ARRAY, INSTANCE_ROW2_ARRAY, eNumInstanceAttribs
+};
+const int INSTANCE_INDEX_ARRAY = INSTANCE_ROW0_ARRAY;
+const char* g_aszInstancedAttribNames[] =
+{
+	"inVertex", "inNormal", "inTangent", "inBiNormal", "inTexCoords", "inInstanceRow0", "inInstanceRow1", "inInstanceRow2"
+};
+const char* g_aszBatchedAttribNames[] =
+{
+	"inVertex", "inNormal", "inTangent", "inBiNormal", "inTexCoords", "inInstanceIndex"
+};
+
+// Tiles per draw of the uniform batch path, also limited by GL_MAX_VERTEX_UNIFORM_VECTORS
+const unsigned int g_uiMaxInstanceBatch = 64;
+const int g_iReservedUniformVectors = 16;		// the water shader's other uniforms
+
+// Uniforms that are the same for every draw of a view, set once per view
+enum EViewConstant
+{
+	eViewVPMatrix, eViewEyePosWorld, eViewLightDirWorld, eViewTime, eViewFogColor, eViewFogDepthRatio, eNumViewConstants
+};
+const SPVRTUniformBlockMember g_asViewConstants[eNumViewConstants] =
+{
+	{ "VPMatrix", 16 }, { "EyePosWorld", 3 }, { "LightDirWorld", 3 }, { "_Time", 1 }, { "FogColor", 4 }, { "FogDepthRatio", 1 }
+};
+
+// How the TTP view fills the refraction texture, -refraction=render|copy|readpixels
+enum ERefractionCapture
+{
+	eRefractionRender,			// draws into the refraction render target
+	eRefractionCopy,			// draws into the back buffer, glCopyTexSubImage2D
+	eRefractionReadPixels,		// draws into the back buffer, glReadPixels and glTexSubImage2D, for comparison
+	eNumRefractionCaptures
+};
+const char* g_aszRefractionCaptureNames[eNumRefractionCaptures] = { "render", "copy", "readpixels" };
+const int g_iRefractionBenchWarmup = 30;		// frames after a switch that -refractionbench does not time
+
+// Profiled parts of the frame, -profile=file writes their statistics on exit
+enum EProfileSection
+{
+	eProfileCulling, eProfileReflection, eProfileRefraction, eProfileWater, eProfilePrint3D, eNumProfileSections
+};
+const char* g_aszProfileSectionNames[eNumProfileSections] = { "Culling", "Reflection", "Refraction", "Water", "Print3D" };
+const unsigned int g_uiProfileHistory = 300;	// frames the profiler keeps, -profilehistory=frames
+
+// -benchmark=summary.json plays -benchscript with a fixed time step and quits, see ParseBenchmarkStep
+const char* g_szBenchmarkScript = "main:model,main:quadtree,main:quadtree:tiles,main:quadtree:rt0.5,ttp:model,ttp:quadtree,ttp:quadtree:tiles:single";
+const unsigned int g_uiBenchmarkFrames = 120;		// timed frames per step, -benchframes=frames
+const unsigned int g_uiBenchmarkWarmup = 10;		// untimed frames before them, -benchwarmup=frames
+const unsigned int g_uiBenchmarkTimestep = 16;		// milliseconds per frame, -benchstep=ms
+enum EBenchmarkCounter
+{
+	eBenchRenderCount, eBenchGLCallsIssued, eBenchGLCallsFiltered, eBenchUniformBytes, eBenchTargetUpdates, eNumBenchCounters
+};
+const char* g_aszBenchmarkCounterNames[eNumBenchCounters] = { "RenderCount", "GLCallsIssued", "GLCallsFiltered", "UniformBytes", "TargetUpdates" };
+
+// What a benchmark step runs, every step starts from the command-line state
+struct BenchmarkMode
+{
+	bool TTP;
+	bool QuadTree;
+	bool Clipmap;
+	bool Instancing;
+	float ReflectionScale;
+	float RefractionScale;
+};
+
 struct DefaultProgram
 {
-	enum EUniform{ eMVPMatrix, eMMatrix, eMMatrix_IT, eLightDirModel, eEyePosModel, eTime, eFogColor, eFogDepthRatio, eNumUniforms };
+	enum EUniform{ eMVPMatrix, eMMatrix, eMMatrix_IT, eLightDirModel, eEyePosModel, eNumUniforms };
 	enum eUniformSampler{ eSmallWaves_NormalTex, eReflectionTex, eRefractionTex, eSkybox_Tex, eNumUniformSamplers };
 	GLuint uiId;
 	GLuint auiLoc[eNumUniforms];
 };
 
+// World space variant of DefaultProgram for many water tiles per draw
+struct WaterInstancedProgram
+{
+	enum EUniform{ eInstanceRows, eNumUniforms };
+	GLuint uiId;
+	GLuint auiLoc[eNumUniforms];
+};
+
+// How the water tiles in m_WaterRenderQueue are drawn
+enum EWaterTilePath
+{
+	eWaterTilesSingle, eWaterTilesInstanced, eWaterTilesBatched
+};
+
+// Ids of the main view's draws in m_RenderQueue
+enum ERenderPass
+{
+	ePassSkybox, ePassOpaque, ePassWater, eNumRenderPasses
+};
+enum ERenderProgram
+{
+	eProgramSkybox, eProgramBlinnPhong, eProgramWater, eProgramWaterInstanced
+};
+enum ERenderTextures
+{
+	eTexturesNone, eTexturesSkybox, eTexturesWater
+};
+enum ERenderMesh
+{
+	eMeshSkybox, eMeshBall, eMeshWaterFull, eMeshWaterClipmap, eMeshWaterInstances, eMeshWaterLOD		// + LOD level
+};
+
+// One queued draw, Item of its mRenderItem
+struct SceneDraw
+{
+	enum EType{ eSkybox, eBall, eWaterTile, eWaterClipmap, eWaterInstances };
+	EType Type;
+	mAffine Model;
+	mAffine ModelInverse;
+	PVRTVec3 DiffuseColor;
+	int Key;			// skybox fog, water tile mesh key or clipmap range
+};
+
 struct BlinnPhongProgram
 {
 	enum EUniform{ eMVPMatrix, eLightDirModel, eEyePosModel, eDiffuseColor, eNumUniforms };
@@ -98,6 +228,33 @@ const char c_szCube_testFile[] = "cube_test.pod";
 const int WaterFileScale = 100;
 const char c_szWaterPlaneFile[] = "WaterPlane100x100.pod";
 
+// Lower resolutions of the water plane, the ones dividing WaterFileScale are loaded as LOD levels
+struct WaterLODFile
+{
+	int Resolution;
+	const char * File;
+};
+const WaterLODFile c_WaterLODFiles[] = {
+	{ 5, "WaterPlane5x5.pod" },
+	{ 10, "WaterPlane10x10.pod" },
+	{ 20, "WaterPlane20x20.pod" },
+	{ 50, "WaterPlane50x50.pod" },
+	{ 75, "WaterPlane75x75.pod" },
+	{ 100, "WaterPlane100x100.pod" },
+	{ 110, "WaterPlane110x110.pod" },
+	{ 120, "WaterPlane120x120.pod" },
+	{ 130, "WaterPlane130x130.pod" },
+	{ 150, "WaterPlane150x150.pod" },
+	{ 180, "WaterPlane180x180.pod" },
+	{ 225, "WaterPlane225x225.pod" }
+};
+const int c_iWaterLODFiles = sizeof(c_WaterLODFiles) / sizeof(c_WaterLODFiles[0]);
+
+// Camera centered water, the finest quads match the WaterPlane files
+const int g_iClipmapGridSize = 64;
+const int g_iClipmapLevels = 8;
+const float g_fClipmapSpacing = 5.0f;
+
 
 /*!****************************************************************************
 Class implementing the PVRShell functions.
@@ -117,6 +274,34 @@ class OGLES2PeaceWaterRender : public PVRShell
 	vector<mModel> m_WaterGroup;
 	queue<mModel*> m_WaterRenderQueue;
 	vector<mModel*> m_WaterGroupFromSceneManager;
+	vector<mModel> m_Buoys;
+	vector<mModel*> m_ViewVisible[eNumCullViews];	// models CullScene found in each view
+	CPVRTModelPOD m_WaterLODPOD[c_iWaterLODFiles];
+	mWaterLOD m_WaterLOD;
+	unsigned int m_uiWaterVertices, m_uiWaterFullVertices;
+	mWaterClipmap m_WaterClipmap;
+
+	// Instanced water tiles
+	CPVRTgles2Ext m_Extensions;
+	EWaterTilePath m_eWaterTilePath;
+	WaterInstancedProgram m_WaterInstancedProgram;
+	GLuint m_uiWaterInstancedVertShader;
+	GLuint m_uiInstanceVBO;
+	vector<GLfloat> m_InstanceRows;
+	vector<pair<int, mModel*> > m_WaterDrawList;		// mesh key, tile
+	mInstanceBatch m_WaterBatches[c_iWaterMaxLevels];
+	mInstanceBatch m_WaterFullBatch;
+	unsigned int m_uiWaterDrawCalls;
+
+	// Main view draws, sorted by state
+	mRenderQueue m_RenderQueue;
+	vector<SceneDraw> m_SceneDraws;
+
+	// Shadow of the GL bindings, drops redundant state calls
+	CPVRTStateCache m_StateCache;
+	// Shadow of the uniform values and the per view uniforms of the water programs
+	CPVRTUniformCache m_UniformCache;
+	CPVRTUniformBlock m_ViewConstants;
 
 	// Projection, view and model matrices
 	float m_RotateAngleX, m_RotateAngleY, m_RotateAngleZ;
@@ -143,16 +328,19 @@ class OGLES2PeaceWaterRender : public PVRShell
 
 	//FBOs and renderTex
 	GLint m_iOriginalFBO;
-	GLuint m_auiReflectFBO;
-	GLuint m_uiReflectRenderTex;
-	GLuint m_auiReflectDepthBuffer;
-	GLuint m_auiRefractFBO;
-	GLuint m_uiRefractRenderTex;
-	GLuint m_auiRefractDepthBuffer;
+	// Reflection and refraction textures, when they are redrawn comes from
+	// -reflectionscale=f, -refractionscale=f, -rtinterval=frames, -rtmove=units and -rtturn=degrees
+	mRenderTargetPool m_RenderTargets;
+	int m_iReflectionTarget;
+	int m_iRefractionTarget;
+	mRenderTargetPolicy m_ReflectionPolicy;
+	mRenderTargetPolicy m_RefractionPolicy;
+	unsigned int m_uiFrameIndex;
 
 
 	//WorldSpace
 	PVRTVec4 m_globalLightDir;
+	mAffine m_ViewInverse;		// of the camera ExecuteRenderQueue draws for
 
 	// Group shader programs and their uniform locations together
 	DefaultProgram m_DefaultProgram;
@@ -164,15 +352,37 @@ class OGLES2PeaceWaterRender : public PVRShell
 	Camera WatchCameraTTP;
 	bool TTPmode;
 	bool FrustumClipOn;
+	bool WaterClipmapOn;
+	bool WaterInstancingOn;
+
+	// TTP refraction capture, and the frame times of -refractionbench=frames
+	ERefractionCapture m_eRefractionCapture;
+	bool m_bRefractionCopyOK;
+	vector<GLubyte> m_RefractionPixels;
+	int m_iRefractionBenchFrames;
+	int m_iRefractionBenchFrame;
+	double m_adRefractionBenchMs[eNumRefractionCaptures];
+	chrono::steady_clock::time_point m_RefractionBenchLast;
 	mSceneManager m_SceneManager;
+	mBoxCuller m_BoxCuller;
+	mCullingService m_CullingService;
 
 	// Current time in milliseconds
 	float m_ulTime;
 	unsigned long m_ulPreviousTime, m_ulCurrentTime;
 	float m_fElapsedTimeInSecs, m_fDeltaTime, m_fFrame, m_fCount;
 	unsigned int m_uiFrameCount;
-	vector<unsigned int> m_uiFPS;
-	int m_uiFpsOut;
+	unsigned int m_uiFps;
+
+	mProfiler m_Profiler;
+	unsigned int m_uiProfileHistory;
+	string m_ProfileReport;
+
+	mBenchmark m_Benchmark;
+	string m_BenchmarkSummary;
+	BenchmarkMode m_BenchmarkBase;
+	unsigned int m_uiBenchmarkTimestep;
+	unsigned int m_uiBenchmarkTargetUpdates;
 
 	float height, w;
 
@@ -189,6 +399,7 @@ private:
 	bool LoadDefaultShader(CPVRTString* pErrorStr);
 	bool LoadBlinnPhongShader(CPVRTString* pErrorStr);
 	bool LoadSkyboxShader(CPVRTString* pErrorStr);
+	bool InitWaterInstancing(CPVRTString* pErrorStr);
 
 
 	bool LoadModels(CPVRTString* pErrorStr);
@@ -196,17 +407,48 @@ private:
 	bool LoadShaders(CPVRTString* pErrorStr);
 
 	void ShowFPS();
+	void ShowProfile();
 
 	void RenderReflectionTex(Camera camera);
 	void RenderRefractionTex(Camera camera);
+	void CullViews(Camera & mainCamera, Camera & reflectionCamera, Camera & refractionCamera);
+	void CullScene(Camera & mainCamera, Camera & reflectionCamera, Camera & refractionCamera);
+	void SubmitMainView(Camera & camera);
+	void DrawOffscreenView(Camera & camera, int view);
+	void CaptureRefractionTTP(Camera & camera);
+	void UpdateRefractionBench();
+	bool ParseBenchmarkStep(const mBenchmarkStep & step, BenchmarkMode & mode);
+	void UpdateBenchmark();
+	void RecordBenchmark();
+	bool AcquireWaterTargets();
+	void BindRenderTarget(int target);
+	void ShowRenderTargets();
 
 	template<class T>
 	void DrawMesh(int i32NodeIndex, CPVRTModelPOD* pod, GLuint** ppuiVbos, GLuint** ppuiIbos, T & i32Attributes);
 
-	void DrawBall(Camera & camera, PVRTVec3 position, PVRTVec3 diffuseColor);
+	void SubmitDraw(int pass, int program, int textureSet, int mesh, float depth, SceneDraw & draw);
+	void ExecuteRenderQueue(Camera & camera);
+	void ShowRenderStats();
+	void BindRenderPass(int pass);
+	void BindRenderProgram(int program);
+	void BindRenderTextures(int textureSet);
+	void BindRenderMesh(int mesh);
+	void DrawRenderItem(Camera & camera, PVRTuint32 item);
+
+	void SubmitBall(Camera & camera, PVRTVec3 position, PVRTVec3 diffuseColor);
+	void SubmitBuoy(Camera & camera, mModel * buoy);
+	void SubmitSkybox(int bDrawFog);
+	void SubmitWater(Camera & camera);
 	void DrawCube(Camera & camera);
-	void DrawWaterPlanes(Camera & camera);
+	void BindWaterTextures();
+	void SetWaterUniforms(Camera & camera, const mAffine & model, const mAffine & modelInverse);
+	void DrawWaterTile(int level, int stitch);
+	void DrawWaterInstances(Camera & camera);
+	SPODMesh * WaterGroupMesh(int key, GLuint & vbo, GLuint & ibo, InstanceRange * ranges, int & rangeCount);
+	void SetWaterVertexAttribs(SPODMesh * mesh, GLsizei stride);
 	void DrawSkybox(Camera & camera, int bDrawFog);
+	void SetSkyboxUniforms(Camera & camera, int bDrawFog);
 };
 
 /*!****************************************************************************
@@ -225,24 +467,32 @@ bool OGLES2PeaceWaterRender::LoadModels(CPVRTString* const pErrorStr){
 	CPVRTResourceFile::SetLoadReleaseFunctions(PVRShellGet(prefLoadFileFunc), PVRShellGet(prefReleaseFileFunc));
 
 	// Load the ball
-	if (m_BallPOD.ReadFromFile(c_szBallFile) != PVR_SUCCESS)
+	if (m_BallPOD.ReadFromFileMapped(c_szBallFile) != PVR_SUCCESS)
 	{
 		*pErrorStr = "ERROR: Couldn't load the .pod file\n";
 		return false;
 	}
 
 	//Load the cube
-	if (m_CubePOD.ReadFromFile(c_szCube_testFile) != PVR_SUCCESS){
+	if (m_CubePOD.ReadFromFileMapped(c_szCube_testFile) != PVR_SUCCESS){
 		*pErrorStr = "ERROR: Couldn't load the Cube_test .pod file\n";
 		return false;
 	}
 
 	//Load the WaterPlane
-	if (m_WaterPlanePOD.ReadFromFile(c_szWaterPlaneFile) != PVR_SUCCESS){
+	if (m_WaterPlanePOD.ReadFromFileMapped(c_szWaterPlaneFile) != PVR_SUCCESS){
 		*pErrorStr = "ERROR: Couldn't load the WaterPlane.pod file\n";
 		return false;
 	}
 
+	//Load the lower resolutions for the LOD, a missing one is only a level less
+	m_WaterLOD.AddLevel(&m_WaterPlanePOD);
+	for (int i = 0; i < c_iWaterLODFiles; ++i){
+		if (c_WaterLODFiles[i].Resolution >= WaterFileScale || WaterFileScale % c_WaterLODFiles[i].Resolution != 0) continue;
+		if (m_WaterLODPOD[i].ReadFromFileMapped(c_WaterLODFiles[i].File) != PVR_SUCCESS) continue;
+		m_WaterLOD.AddLevel(&m_WaterLODPOD[i]);
+	}
+
 	return true;
 }
 
@@ -282,24 +532,6 @@ bool OGLES2PeaceWaterRender::LoadTextures(CPVRTString* const pErrorStr)
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-
-	//Reflection, Refraction Render Texture
-	glGenTextures(1, &m_uiReflectRenderTex);
-	glBindTexture(GL_TEXTURE_2D, m_uiReflectRenderTex);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, PVRShellGet(prefWidth), PVRShellGet(prefHeight), 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-	glGenTextures(1, &m_uiRefractRenderTex);
-	glBindTexture(GL_TEXTURE_2D, m_uiRefractRenderTex);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, PVRShellGet(prefWidth), PVRShellGet(prefHeight), 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
 	return true;
 }
 
@@ -417,7 +649,7 @@ bool OGLES2PeaceWaterRender::LoadDefaultShader(CPVRTString* pErrorStr)
 {
 	const char* g_aszUniformNames[] =
 	{
-		"MVPMatrix", "MMatrix", "MMatrix_IT", "LightDirModel", "EyePosModel", "_Time", "FogColor", "FogDepthRatio"
+		"MVPMatrix", "MMatrix", "MMatrix_IT", "LightDirModel", "EyePosModel"
 	};
 	const char* g_aszUniformSamplerNames[] =
 	{
@@ -464,6 +696,93 @@ bool OGLES2PeaceWaterRender::LoadDefaultShader(CPVRTString* pErrorStr)
 }
 
 
+/*!****************************************************************************
+@Function		InitWaterInstancing
+@Output		pErrorStr		A string describing the error on failure
+@Return		bool			true if no error occured
+@Description	Picks how the water tiles are drawn several per draw: instanced
+arrays when the context has them (OpenGL ES 3.0 or an instanced arrays
+extension), otherwise batches of tile copies that read their transform
+from a uniform array. Must run after the LOD levels are built.
+******************************************************************************/
+bool OGLES2PeaceWaterRender::InitWaterInstancing(CPVRTString* pErrorStr)
+{
+	m_eWaterTilePath = eWaterTilesSingle;
+
+	char szDefine[64];
+	if (m_Extensions.glDrawElementsInstancedEXT){
+		sprintf(szDefine, "INSTANCED_ARRAYS");
+		glGenBuffers(1, &m_uiInstanceVBO);
+	}
+	else{
+		GLint vectors = 0;
+		glGetIntegerv(GL_MAX_VERTEX_UNIFORM_VECTORS, &vectors);
+		unsigned int maxSlots = PVRT_MIN(g_uiMaxInstanceBatch, (unsigned int)PVRT_MAX(vectors - g_iReservedUniformVectors, 0) / 3);
+		if (maxSlots < 2) return true;
+
+		// every LOD level with its interior and ring ranges, or the full mesh
+		unsigned int slots = 0;
+		for (unsigned int l = 0; l < m_WaterLOD.LevelCount(); ++l){
+			WaterLODLevel & level = m_WaterLOD.Levels[l];
+			SPODMesh & mesh = level.POD->pMesh[0];
+			vector<InstanceRange> ranges;
+			InstanceRange range = { level.InteriorFirst, level.InteriorCount };
+			ranges.push_back(range);
+			for (int i = 0; i < c_iWaterStitchCombinations; ++i){
+				range.First = level.RingFirst[i];
+				range.Count = level.RingCount[i];
+				ranges.push_back(range);
+			}
+			if (!m_WaterBatches[l].Build(mesh.pInterleaved, mesh.sVertex.nStride, mesh.nNumVertex, &m_WaterLOD.Indices[0], ranges, maxSlots)) return true;
+			m_WaterBatches[l].LoadVBO();
+			slots = PVRT_MAX(slots, m_WaterBatches[l].Slots);
+		}
+		SPODMesh & mesh = m_WaterPlanePOD.pMesh[0];
+		vector<InstanceRange> ranges(1);
+		ranges[0].First = 0;
+		ranges[0].Count = mesh.nNumFaces * 3;
+		if (!m_WaterFullBatch.Build(mesh.pInterleaved, mesh.sVertex.nStride, mesh.nNumVertex, (const PVRTuint16*)mesh.sFaces.pData, ranges, maxSlots)) return true;
+		m_WaterFullBatch.LoadVBO();
+		slots = PVRT_MAX(slots, m_WaterFullBatch.Slots);
+		sprintf(szDefine, "INSTANCE_BATCH %u", slots);
+	}
+
+	const char* aszDefines[] = { szDefine };
+	if (PVRTShaderLoadFromFile(
+		NULL, c_szVertShaderSrcFile, GL_VERTEX_SHADER, GL_SGX_BINARY_IMG, &m_uiWaterInstancedVertShader,
+		pErrorStr, 0, aszDefines, 1) != PVR_SUCCESS)
+	{
+		return false;
+	}
+
+	bool bInstanced = m_Extensions.glDrawElementsInstancedEXT != 0;
+	if (PVRTCreateProgram(&m_WaterInstancedProgram.uiId, m_uiWaterInstancedVertShader, m_uiDefaultFragShader,
+		bInstanced ? g_aszInstancedAttribNames : g_aszBatchedAttribNames, bInstanced ? eNumInstanceAttribs : INSTANCE_INDEX_ARRAY + 1,
+		pErrorStr) != PVR_SUCCESS)
+	{
+		return false;
+	}
+
+	const char* g_aszUniformNames[] =
+	{
+		"InstanceRows"
+	};
+	const char* g_aszUniformSamplerNames[] =
+	{
+		"SmallWaves_NormalTex", "ReflectionTex", "RefractionTex", "Skybox_Tex"
+	};
+	for (int i = 0; i < m_WaterInstancedProgram.eNumUniforms; ++i)
+	{
+		m_WaterInstancedProgram.auiLoc[i] = glGetUniformLocation(m_WaterInstancedProgram.uiId, g_aszUniformNames[i]);
+	}
+	for (int i = 0; i < DefaultProgram::eNumUniformSamplers; i++){
+		glUniform1i(glGetUniformLocation(m_WaterInstancedProgram.uiId, g_aszUniformSamplerNames[i]), i);
+	}
+
+	m_eWaterTilePath = bInstanced ? eWaterTilesInstanced : eWaterTilesBatched;
+	return true;
+}
+
 /*!****************************************************************************
 @Function		LoadShaders
 @Output		pErrorStr		A string describing the error on failure
@@ -492,9 +811,9 @@ vertex buffer objects
 ******************************************************************************/
 void OGLES2PeaceWaterRender::LoadVbos()
 {
-	m_Ball.LoadVBO();
-	m_Cube.LoadVBO();
-	m_WaterPlane.LoadVBO();
+	m_Ball.LoadVBO(&m_Extensions);
+	m_Cube.LoadVBO(&m_Extensions);
+	m_WaterPlane.LoadVBO(&m_Extensions);
 
 	glGenBuffers(1, &m_puiSkyboxVbo);
 	glBindBuffer(GL_ARRAY_BUFFER, m_puiSkyboxVbo);
@@ -531,12 +850,13 @@ bool OGLES2PeaceWaterRender::InitApplication()
 	m_WaterPlane.SetPOD(&m_WaterPlanePOD);
 
 	m_ulTime = 0.0;
+	m_uiWaterVertices = m_uiWaterFullVertices = 0;
 
 	m_ulCurrentTime = PVRShellGetTime();
 	m_ulPreviousTime = m_ulCurrentTime;
 	m_fCount = 0;
 	m_uiFrameCount = 0;
-	m_uiFpsOut = 0;
+	m_uiFps = 0;
 
 	m_RotateAngleX = 0;
 	m_RotateAngleY = 0;
@@ -550,8 +870,107 @@ bool OGLES2PeaceWaterRender::InitApplication()
 
 	TTPmode = false;
 	FrustumClipOn = true;
+	WaterClipmapOn = true;
+	WaterInstancingOn = true;
+	m_eWaterTilePath = eWaterTilesSingle;
+	m_uiWaterDrawCalls = 0;
+	m_uiInstanceVBO = 0;
+	m_RenderQueue.SetPassBlended(ePassSkybox, false);
+	m_RenderQueue.SetPassBlended(ePassOpaque, false);
+	m_RenderQueue.SetPassBlended(ePassWater, false);
+	m_RenderQueue.SetDepthRange(g_fCamNear, g_fCamFar);
+
+	m_eRefractionCapture = eRefractionRender;
+	m_bRefractionCopyOK = false;
+	m_iRefractionBenchFrames = 0;
+	m_iRefractionBenchFrame = 0;
+	m_uiProfileHistory = g_uiProfileHistory;
+	m_uiBenchmarkTargetUpdates = 0;
+	const char * pszBenchmarkScript = g_szBenchmarkScript;
+	unsigned int uiBenchmarkFrames = g_uiBenchmarkFrames, uiBenchmarkWarmup = g_uiBenchmarkWarmup;
+	m_uiBenchmarkTimestep = g_uiBenchmarkTimestep;
+	const SCmdLineOpt * psOpts = (const SCmdLineOpt *)PVRShellGet(prefCommandLineOpts);
+	for (int i = 0; i < PVRShellGet(prefCommandLineOptNum); ++i){
+		if (!psOpts[i].pArg || !psOpts[i].pVal) continue;
+		if (strcmp(psOpts[i].pArg, "-refraction") == 0){
+			for (int c = 0; c < eNumRefractionCaptures; ++c){
+				if (strcmp(psOpts[i].pVal, g_aszRefractionCaptureNames[c]) == 0) m_eRefractionCapture = (ERefractionCapture)c;
+			}
+		}
+		else if (strcmp(psOpts[i].pArg, "-refractionbench") == 0){
+			m_iRefractionBenchFrames = PVRT_MAX(atoi(psOpts[i].pVal), 0);
+		}
+		else if (strcmp(psOpts[i].pArg, "-reflectionscale") == 0){
+			m_ReflectionPolicy.Scale = PVRT_CLAMP((float)atof(psOpts[i].pVal), 0.05f, 1.0f);
+		}
+		else if (strcmp(psOpts[i].pArg, "-refractionscale") == 0){
+			m_RefractionPolicy.Scale = PVRT_CLAMP((float)atof(psOpts[i].pVal), 0.05f, 1.0f);
+		}
+		else if (strcmp(psOpts[i].pArg, "-rtinterval") == 0){
+			m_ReflectionPolicy.Interval = m_RefractionPolicy.Interval = (unsigned int)PVRT_MAX(atoi(psOpts[i].pVal), 1);
+		}
+		else if (strcmp(psOpts[i].pArg, "-rtmove") == 0){
+			m_ReflectionPolicy.MoveThreshold = m_RefractionPolicy.MoveThreshold = PVRT_MAX((float)atof(psOpts[i].pVal), 0.0f);
+		}
+		else if (strcmp(psOpts[i].pArg, "-rtturn") == 0){
+			m_ReflectionPolicy.TurnThreshold = m_RefractionPolicy.TurnThreshold = PVRT_MAX((float)atof(psOpts[i].pVal), 0.0f);
+		}
+		else if (strcmp(psOpts[i].pArg, "-profile") == 0){
+			m_ProfileReport = psOpts[i].pVal;
+		}
+		else if (strcmp(psOpts[i].pArg, "-profilehistory") == 0){
+			m_uiProfileHistory = (unsigned int)PVRT_MAX(atoi(psOpts[i].pVal), 1);
+		}
+		else if (strcmp(psOpts[i].pArg, "-benchmark") == 0){
+			m_BenchmarkSummary = psOpts[i].pVal;
+		}
+		else if (strcmp(psOpts[i].pArg, "-benchscript") == 0){
+			pszBenchmarkScript = psOpts[i].pVal;
+		}
+		else if (strcmp(psOpts[i].pArg, "-benchframes") == 0){
+			uiBenchmarkFrames = (unsigned int)PVRT_MAX(atoi(psOpts[i].pVal), 1);
+		}
+		else if (strcmp(psOpts[i].pArg, "-benchwarmup") == 0){
+			uiBenchmarkWarmup = (unsigned int)PVRT_MAX(atoi(psOpts[i].pVal), 0);
+		}
+		else if (strcmp(psOpts[i].pArg, "-benchstep") == 0){
+			m_uiBenchmarkTimestep = (unsigned int)PVRT_MAX(atoi(psOpts[i].pVal), 1);
+		}
+	}
 
-	m_SceneManager = mSceneManager(4, -2250, 2250, -500, 500, -2250, 2250);
+	// The benchmark drives time, modes and the camera itself and quits when
+	// the script is done, one frame late so the last frame is timed
+	m_BenchmarkBase.TTP = TTPmode;
+	m_BenchmarkBase.QuadTree = !FrustumClipOn;
+	m_BenchmarkBase.Clipmap = WaterClipmapOn;
+	m_BenchmarkBase.Instancing = WaterInstancingOn;
+	m_BenchmarkBase.ReflectionScale = m_ReflectionPolicy.Scale;
+	m_BenchmarkBase.RefractionScale = m_RefractionPolicy.Scale;
+	if (!m_BenchmarkSummary.empty()){
+		BenchmarkMode mode;
+		bool bScriptOK = m_Benchmark.Init(pszBenchmarkScript, uiBenchmarkFrames, uiBenchmarkWarmup);
+		for (unsigned int i = 0; bScriptOK && i < m_Benchmark.Steps.size(); ++i) bScriptOK = ParseBenchmarkStep(m_Benchmark.Steps[i], mode);
+		if (!bScriptOK){
+			PVRShellSet(prefExitMessage, "ERROR: Cannot parse -benchscript\n");
+			return false;
+		}
+		for (int i = 0; i < eNumBenchCounters; ++i) m_Benchmark.AddCounter(g_aszBenchmarkCounterNames[i]);
+		m_iRefractionBenchFrames = 0;
+		PVRShellSet(prefForceFrameTime, true);
+		PVRShellSet(prefFrameTimeValue, (int)m_uiBenchmarkTimestep);
+		PVRShellSet(prefQuitAfterFrame, (int)m_Benchmark.TotalFrames());
+		PVRShellOutputDebug("Benchmark: %u steps of %u+%u frames at %u ms, summary to %s\n", (unsigned int)m_Benchmark.Steps.size(),
+			uiBenchmarkWarmup, uiBenchmarkFrames, m_uiBenchmarkTimestep, m_BenchmarkSummary.c_str());
+	}
+
+	// The clipmap is generated on the CPU, only its buffers depend on the context
+	if (!m_WaterClipmap.Generate(g_iClipmapGridSize, g_iClipmapLevels, g_fClipmapSpacing)){
+		PVRShellSet(prefExitMessage, "ERROR: Cannot generate the water clipmap\n");
+		return false;
+	}
+	PVRShellOutputDebug("Water clipmap: %u vertices, %u indices, %d levels, edge at %.0f, generated in %.3f ms\n",
+		(unsigned int)(m_WaterClipmap.Vertices.size() / c_uiClipmapVertexFloats), (unsigned int)m_WaterClipmap.Indices.size(),
+		m_WaterClipmap.LevelCount, m_WaterClipmap.Extent(), m_WaterClipmap.GenerateMs);
 
 	return true;
 }
@@ -566,11 +985,26 @@ not be called.
 ******************************************************************************/
 bool OGLES2PeaceWaterRender::QuitApplication()
 {
+	// Written once per run, a context release keeps the results for later
+	if (!m_BenchmarkSummary.empty()){
+		if (!m_Benchmark.Finished()) PVRShellOutputDebug("Benchmark stopped before the end of the script\n");
+		if (m_Benchmark.WriteSummary(m_BenchmarkSummary.c_str(), (float)m_uiBenchmarkTimestep)) PVRShellOutputDebug("Benchmark summary written to %s\n", m_BenchmarkSummary.c_str());
+		else PVRShellOutputDebug("Cannot write the benchmark summary to %s\n", m_BenchmarkSummary.c_str());
+	}
+	if (!m_ProfileReport.empty()){
+		if (m_Profiler.WriteReport(m_ProfileReport.c_str())) PVRShellOutputDebug("Profile written to %s\n", m_ProfileReport.c_str());
+		else PVRShellOutputDebug("Cannot write the profile to %s\n", m_ProfileReport.c_str());
+	}
+
 	// Free the memory allocated for the scene
 	m_Ball.Destroy();
 	m_Cube.Destroy();
 	m_WaterPlane.Destroy();
+	m_WaterLOD.Destroy();
+	m_WaterClipmap.Destroy();
+	for (int i = 0; i < c_iWaterLODFiles; ++i) m_WaterLODPOD[i].Destroy();
 	m_SceneManager.Destroy();
+	m_CullingService.Destroy();
 	delete[] m_SkyboxVertices;
 	delete[] m_SkyboxTexCoords;
 	return true;
@@ -590,6 +1024,10 @@ bool OGLES2PeaceWaterRender::InitView()
 
 	// Create the skybox
 	PVRTCreateSkybox(6000, true, 512, &m_SkyboxVertices, &m_SkyboxTexCoords);
+
+	// Vertex array objects and instancing
+	m_Extensions.LoadExtensions();
+
 	/*
 	Initialize VBO data
 	*/
@@ -629,36 +1067,45 @@ bool OGLES2PeaceWaterRender::InitView()
 	*/
 	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_iOriginalFBO);
 
-	glGenFramebuffers(1, &m_auiReflectFBO);
-	glBindFramebuffer(GL_FRAMEBUFFER, m_auiReflectFBO);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_uiReflectRenderTex, 0);
-
-	glGenRenderbuffers(1, &m_auiReflectDepthBuffer);
-	glBindRenderbuffer(GL_RENDERBUFFER, m_auiReflectDepthBuffer);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, PVRShellGet(prefWidth), PVRShellGet(prefHeight));
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_auiReflectDepthBuffer);
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-	{
-		PVRShellSet(prefExitMessage, "ERROR: Reflection Frame buffer did not set up correctly\n");
-		return false;
+	// glCopyTexSubImage2D into the RGBA refraction texture needs alpha in the back buffer
+	GLint iAlphaBits = 0;
+	glGetIntegerv(GL_ALPHA_BITS, &iAlphaBits);
+	m_bRefractionCopyOK = iAlphaBits > 0;
+	if (m_eRefractionCapture == eRefractionCopy && !m_bRefractionCopyOK){
+		PVRShellOutputDebug("Refraction: the back buffer has no alpha, rendering into the texture instead of copying\n");
+		m_eRefractionCapture = eRefractionRender;
 	}
 
-	glGenFramebuffers(1, &m_auiRefractFBO);
-	glBindFramebuffer(GL_FRAMEBUFFER, m_auiRefractFBO);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_uiRefractRenderTex, 0);
-
-	glGenRenderbuffers(1, &m_auiRefractDepthBuffer);
-	glBindRenderbuffer(GL_RENDERBUFFER, m_auiRefractDepthBuffer);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, PVRShellGet(prefWidth), PVRShellGet(prefHeight));
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_auiRefractDepthBuffer);
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	m_RenderTargets.Init(PVRShellGet(prefWidth), PVRShellGet(prefHeight));
+	m_iReflectionTarget = m_iRefractionTarget = -1;
+	m_uiFrameIndex = 0;
+	if (!AcquireWaterTargets())
 	{
-		PVRShellSet(prefExitMessage, "ERROR: Reflection Frame buffer did not set up correctly\n");
+		PVRShellSet(prefExitMessage, "ERROR: Reflection or refraction frame buffer did not set up correctly\n");
 		return false;
 	}
-
-	glBindFramebuffer(GL_FRAMEBUFFER, m_iOriginalFBO);
-
+	mRenderTargetStats targets = m_RenderTargets.GetStats();
+	PVRShellOutputDebug("Render targets: reflection %dx%d, refraction %dx%d, %u textures %u KB, %u depth buffers %u KB\n",
+		m_RenderTargets.Targets[m_iReflectionTarget].Desc.Width, m_RenderTargets.Targets[m_iReflectionTarget].Desc.Height,
+		m_RenderTargets.Targets[m_iRefractionTarget].Desc.Width, m_RenderTargets.Targets[m_iRefractionTarget].Desc.Height,
+		targets.Targets, targets.TextureBytes / 1024, targets.DepthBuffers, targets.DepthBytes / 1024);
+
+	m_Profiler.Init(&m_Extensions, m_uiProfileHistory);
+	for (int i = 0; i < eNumProfileSections; ++i) m_Profiler.AddSection(g_aszProfileSectionNames[i], i != eProfileCulling);
+	PVRShellOutputDebug("Profiler: %u frames of history, GPU timers %s\n", m_uiProfileHistory,
+		m_Profiler.HasGpuTimers() ? "on" : "off, no GL_EXT_disjoint_timer_query");
+
+
+	// InitView runs again after a context loss, the tiles and everything that
+	// points at them are rebuilt rather than added a second time
+	m_WaterGroup.clear();
+	m_WaterGroupFromSceneManager.clear();
+	m_Buoys.clear();
+	for (int i = 0; i < eNumCullViews; ++i) m_ViewVisible[i].clear();
+	m_BoxCuller.clear();
+	m_WaterLOD.ClearTiles();
+	m_SceneManager.Destroy();
+	m_SceneManager = mSceneManager(4, -2250, 2250, -500, 500, -2250, 2250);
 
 	//Prepare transform and camera
 	m_WaterPlane.CreateSuroundBox();
@@ -842,10 +1289,47 @@ bool OGLES2PeaceWaterRender::InitView()
 
 	for (unsigned int i = 0; i < m_WaterGroup.size(); ++i){
 		m_SceneManager.addModel(&m_WaterGroup[i]);
+		m_BoxCuller.addModel(&m_WaterGroup[i]);
 	}
-	m_SceneManager.makeQuadTree();
 
+	// the buoys share the ball's buffers, only their transforms differ
+	m_Ball.CreateSuroundBox();
 	m_Ball.SetScale(50.0, 50.0, 50.0);
+	for (int i = 0; i < g_iBuoyCount; ++i){
+		float angle = i * 2.0f * PVRT_PI / g_iBuoyCount;
+		m_Ball.SetPosition(PVRTVec3(cos(angle) * g_fBuoyRingRadius, 0.0f, sin(angle) * g_fBuoyRingRadius));
+		m_Buoys.push_back(m_Ball);
+	}
+	for (unsigned int i = 0; i < m_Buoys.size(); ++i){
+		m_SceneManager.addModel(&m_Buoys[i]);
+		m_BoxCuller.addModel(&m_Buoys[i]);
+	}
+
+	// every tile is one water plane wide, the LOD levels are stretched to it
+	if (m_WaterLOD.Build(m_WaterPlane.Bounds.Max.x - m_WaterPlane.Bounds.Min.x)){
+		for (unsigned int i = 0; i < m_WaterGroup.size(); ++i){
+			m_WaterLOD.AddTile(&m_WaterGroup[i]);
+		}
+		m_WaterLOD.LoadVBO();
+	}
+	m_WaterClipmap.LoadVBO();
+
+	if (!InitWaterInstancing(&ErrorStr)){
+		PVRShellSet(prefExitMessage, ErrorStr.c_str());
+		return false;
+	}
+	m_UniformCache.Invalidate();
+	m_ViewConstants.Init(m_Extensions, "ViewConstants", 0, g_asViewConstants, eNumViewConstants);
+	m_ViewConstants.AddProgram(m_DefaultProgram.uiId);
+	if (m_eWaterTilePath != eWaterTilesSingle) m_ViewConstants.AddProgram(m_WaterInstancedProgram.uiId);
+	m_SceneManager.makeQuadTree();
+	m_SceneManager.makeLinearQuadTree();
+
+	m_CullingService.Destroy();
+	m_CullingService.Init();
+	for (int i = 0; i < eNumCullViews; ++i){
+		m_CullingService.addView();
+	}
 
 	m_globalLightDir = PVRTVec4(0, 0, 0, 0) - PVRTVec4(0, -1, -5, 0);
 
@@ -882,6 +1366,9 @@ bool OGLES2PeaceWaterRender::InitView()
 
 	glClearColor(0.6f, 0.8f, 1.0f, 0.0f);
 
+	// loading bound buffers, textures and framebuffers behind the cache
+	m_StateCache.Invalidate();
+
 	return true;
 }
 
@@ -914,12 +1401,25 @@ bool OGLES2PeaceWaterRender::ReleaseView()
 	m_Ball.DeleteVBOs();
 	m_Cube.DeleteVBOs();
 	m_WaterPlane.DeleteVBOs();
+	m_WaterLOD.DeleteVBOs();
+	m_WaterClipmap.DeleteVBOs();
+	for (int i = 0; i < c_iWaterMaxLevels; ++i) m_WaterBatches[i].Destroy();
+	m_WaterFullBatch.Destroy();
+	if (m_uiInstanceVBO) glDeleteBuffers(1, &m_uiInstanceVBO);
+	m_uiInstanceVBO = 0;
+	if (m_eWaterTilePath != eWaterTilesSingle){
+		glDeleteProgram(m_WaterInstancedProgram.uiId);
+		glDeleteShader(m_uiWaterInstancedVertShader);
+	}
+	m_eWaterTilePath = eWaterTilesSingle;
+	m_ViewConstants.Release();
+	m_UniformCache.Invalidate();
 
-	// Delete renderbuffers
-	glDeleteRenderbuffers(1, &m_auiReflectDepthBuffer);
+	// Delete framebuffers and their textures
+	m_RenderTargets.Destroy();
+	m_iReflectionTarget = m_iRefractionTarget = -1;
 
-	// Delete framebuffers
-	glDeleteFramebuffers(1, &m_auiReflectFBO);
+	m_Profiler.Release();
 
 	// Release Print3D Textures
 	m_Print3D.ReleaseTextures();
@@ -939,16 +1439,32 @@ these events through an abstraction layer provided by PVRShell.
 ******************************************************************************/
 bool OGLES2PeaceWaterRender::RenderScene()
 {
+	m_Profiler.BeginFrame();
+	m_StateCache.NewFrame();
+	m_UniformCache.NewFrame();
+	m_ViewConstants.NewFrame();
 	ShowFPS();
+	if (m_iRefractionBenchFrames) UpdateRefractionBench();
+	if (!m_BenchmarkSummary.empty()) UpdateBenchmark();
+	if (!AcquireWaterTargets()){
+		PVRShellSet(prefExitMessage, "ERROR: Reflection or refraction frame buffer did not set up correctly\n");
+		return false;
+	}
+	m_uiFrameIndex++;
+	m_ulTime += m_fDeltaTime;
 	if (PVRShellIsKeyPressed(PVRShellKeyNameUP)){
 		//height += 0.5;
 		//m_RotateAngleX += 10.0f;
 		TTPmode = true;
+		m_ReflectionPolicy.Invalidate();
+		m_RefractionPolicy.Invalidate();
 	}
 	if (PVRShellIsKeyPressed(PVRShellKeyNameDOWN)){
 		//height -= 0.5;
 		//m_RotateAngleX += -10.0f;
 		TTPmode = false;
+		m_ReflectionPolicy.Invalidate();
+		m_RefractionPolicy.Invalidate();
 	}
 	if (PVRShellIsKeyPressed(PVRShellKeyNameLEFT)){
 		//w += 1.0;
@@ -960,6 +1476,12 @@ bool OGLES2PeaceWaterRender::RenderScene()
 		//m_RotateAngleY += -10.0f;
 		FrustumClipOn = false;
 	}
+	if (PVRShellIsKeyPressed(PVRShellKeyNameACTION1)){
+		WaterClipmapOn = !WaterClipmapOn;
+	}
+	if (PVRShellIsKeyPressed(PVRShellKeyNameACTION2)){
+		WaterInstancingOn = !WaterInstancingOn;
+	}
 
 	if (!TTPmode){
 		m_RotateAngleY -= 0.1f;
@@ -970,45 +1492,43 @@ bool OGLES2PeaceWaterRender::RenderScene()
 
 		ReflectionCamera.setPosition(MainCamera.getPosition().x, -MainCamera.getPosition().y, MainCamera.getPosition().z);
 		ReflectionCamera.setEulerAngle(-MainCamera.getEulerAngle().x, MainCamera.getEulerAngle().y, MainCamera.getEulerAngle().z);
+
+		// the offscreen passes draw what was culled for their views
+		m_Profiler.BeginSection(eProfileCulling);
+		if (FrustumClipOn){
+			CullScene(MainCamera, ReflectionCamera, MainCamera);
+		}
+		else{
+			Camera cullCamera = MainCamera;
+			cullCamera.setPosition(MainCamera.getPosition() + MainCamera.getForward() * (-1200.0));
+			CullScene(cullCamera, ReflectionCamera, MainCamera);
+		}
+		m_Profiler.EndSection(eProfileCulling);
+
 		RenderReflectionTex(ReflectionCamera);
 		RenderRefractionTex(MainCamera);
 
-		glEnable(GL_DEPTH_TEST);
+		m_StateCache.Enable(GL_DEPTH_TEST);
 
 		DrawSkybox(MainCamera, 0);
 
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		DrawSkybox(MainCamera, 1);
-
-		if (FrustumClipOn){
-			for (unsigned int i = 0; i < m_SceneManager.ModelInScene.size(); i++){
-				PVRTMat4 mModel, mModelView, mMVP;
-				mModel = m_SceneManager.ModelInScene[i]->GetModelMatrix();
-				mMVP = MainCamera.getVPMatrix() * mModel;
-				if (!m_SceneManager.ModelInScene[i]->NeedClip(mMVP)){
-					m_SceneManager.ModelInScene[i]->needRender = true;
-				}
-			}
-		}
-		else{
-			MainCamera.setPosition(MainCamera.getPosition() + MainCamera.getForward() * (-1200.0));
-			m_WaterGroupFromSceneManager = m_SceneManager.ModelsNeedRender(MainCamera.getVPMatrix());
-			MainCamera.setPosition(MainCamera.getPosition() + MainCamera.getForward() * (1200.0));
-		}
-
-		for (unsigned int i = 0; i < m_SceneManager.ModelInScene.size(); i++){
-			if (m_SceneManager.ModelInScene[i]->needRender){
-				m_WaterRenderQueue.push(m_SceneManager.ModelInScene[i]);
-			}
-		}
+		SubmitSkybox(1);
+		SubmitMainView(MainCamera);
 
 		m_Print3D.Print3D(0.0, 15.0, 1.0, PVRTRGBA(255, 255, 255, 255), "RenderCount:%i", m_WaterRenderQueue.size());
+		PVRTTRACE_COUNTER("RenderCount", m_WaterRenderQueue.size());
+		m_Benchmark.SetCounter(eBenchRenderCount, (double)m_WaterRenderQueue.size());
 		m_Print3D.Print3D(0.0, 20.0, 1.0, PVRTRGBA(255, 255, 255, 255), "CompareCountEachFor:%i", m_WaterGroup.size());
 		m_Print3D.Print3D(0.0, 25.0, 1.0, PVRTRGBA(255, 255, 255, 255), "CompareCountQuadTree:%i", m_SceneManager.Count);
 
-		DrawWaterPlanes(MainCamera);
+		m_Profiler.BeginSection(eProfileWater);
+		SubmitWater(MainCamera);
+		ExecuteRenderQueue(MainCamera);
+		ShowRenderStats();
+		m_Profiler.EndSection(eProfileWater);
 
-		glDisable(GL_DEPTH_TEST);
+		m_StateCache.Disable(GL_DEPTH_TEST);
 
 		if (FrustumClipOn){
 			m_Print3D.Print3D(0.0, 10.0, 1.0, PVRTRGBA(255, 255, 255, 255), "ForEachClip");
@@ -1027,50 +1547,43 @@ bool OGLES2PeaceWaterRender::RenderScene()
 
 		ReflectionCamera.setPosition(WatchCameraTTP.getPosition().x, -WatchCameraTTP.getPosition().y, WatchCameraTTP.getPosition().z);
 		ReflectionCamera.setEulerAngle(-WatchCameraTTP.getEulerAngle().x, WatchCameraTTP.getEulerAngle().y, WatchCameraTTP.getEulerAngle().z);
-		RenderReflectionTex(ReflectionCamera);
 
-		glEnable(GL_DEPTH_TEST);
+		m_Profiler.BeginSection(eProfileCulling);
+		if (FrustumClipOn){
+			CullScene(MainCamera, ReflectionCamera, WatchCameraTTP);
+		}
+		else{
+			Camera cullCamera = MainCamera;
+			cullCamera.setPosition(MainCamera.getPosition() + MainCamera.getForward() * (-100.0f));
+			CullScene(cullCamera, ReflectionCamera, WatchCameraTTP);
+		}
+		m_Profiler.EndSection(eProfileCulling);
+
+		RenderReflectionTex(ReflectionCamera);
 
-		DrawSkybox(WatchCameraTTP, 0);
+		m_StateCache.Enable(GL_DEPTH_TEST);
 
-		GLubyte * tempPixelsBuffer = (GLubyte*)malloc(PVRShellGet(prefWidth) * PVRShellGet(prefHeight) * 4);
-		glReadPixels(0, 0, PVRShellGet(prefWidth), PVRShellGet(prefHeight), GL_RGBA, GL_UNSIGNED_BYTE, tempPixelsBuffer);
-		glBindTexture(GL_TEXTURE_2D, m_uiRefractRenderTex);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, PVRShellGet(prefWidth), PVRShellGet(prefHeight), 0, GL_RGBA, GL_UNSIGNED_BYTE, tempPixelsBuffer);
+		CaptureRefractionTTP(WatchCameraTTP);
 
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		DrawSkybox(WatchCameraTTP, 1);
-		DrawBall(WatchCameraTTP, PVRTVec3(0, 100, 0), PVRTVec3(0.0, 0.0, 0.0));
-
-		DrawBall(WatchCameraTTP, PVRTMat4::RotationY(-m_RotateAngleY / 180.0f * PVRT_PI) * PVRTVec4(0.0f, 0.0f, 1.0f, 1.0f) * 500.0f + PVRTVec4(0.0f, 100.0f, 0.0f, 1.0f), PVRTVec3(1.0f, 1.0f, 0.0f));
-		DrawBall(WatchCameraTTP, MainCamera.getPosition() + MainCamera.getForward() * (1000.0f) + PVRTVec4(0.0f, 100.0f, 0.0f, 1.0f), PVRTVec3(1.0f, 0.0f, 0.0f));
+		SubmitSkybox(1);
+		SubmitBall(WatchCameraTTP, PVRTVec3(0, 100, 0), PVRTVec3(0.0, 0.0, 0.0));
 
-		if (FrustumClipOn){
-			for (unsigned int i = 0; i < m_WaterGroup.size(); i++){
-				PVRTMat4 mModel, mModelView, mMVP;
-				mModel = m_WaterGroup[i].GetModelMatrix();
-				mMVP = MainCamera.getVPMatrix() * mModel;
-				if (!m_WaterGroup[i].NeedClip(mMVP)){
-					m_WaterRenderQueue.push(&m_WaterGroup[i]);
-				}
-			}
-		}
-		else{
-			MainCamera.setPosition(MainCamera.getPosition() + MainCamera.getForward() * (-100.0f));
-			m_WaterGroupFromSceneManager = m_SceneManager.ModelsNeedRender(MainCamera.getVPMatrix());
-			for (unsigned int i = 0; i < m_SceneManager.ModelInScene.size(); i++){
-				if (m_SceneManager.ModelInScene[i]->needRender){
-					m_WaterRenderQueue.push(m_SceneManager.ModelInScene[i]);
-				}
-			}
-			MainCamera.setPosition(MainCamera.getPosition() + MainCamera.getForward() * (100.0));
-		}
+		SubmitBall(WatchCameraTTP, PVRTMat4::RotationY(-m_RotateAngleY / 180.0f * PVRT_PI) * PVRTVec4(0.0f, 0.0f, 1.0f, 1.0f) * 500.0f + PVRTVec4(0.0f, 100.0f, 0.0f, 1.0f), PVRTVec3(1.0f, 1.0f, 0.0f));
+		SubmitBall(WatchCameraTTP, MainCamera.getPosition() + MainCamera.getForward() * (1000.0f) + PVRTVec4(0.0f, 100.0f, 0.0f, 1.0f), PVRTVec3(1.0f, 0.0f, 0.0f));
+		SubmitMainView(WatchCameraTTP);
 		m_Print3D.Print3D(0.0, 15.0, 1.0, PVRTRGBA(255, 255, 255, 255), "RenderCount:%i", m_WaterRenderQueue.size());
+		PVRTTRACE_COUNTER("RenderCount", m_WaterRenderQueue.size());
+		m_Benchmark.SetCounter(eBenchRenderCount, (double)m_WaterRenderQueue.size());
 
-		DrawWaterPlanes(WatchCameraTTP);
+		m_Profiler.BeginSection(eProfileWater);
+		SubmitWater(WatchCameraTTP);
+		ExecuteRenderQueue(WatchCameraTTP);
+		ShowRenderStats();
+		m_Profiler.EndSection(eProfileWater);
 
 		//glDisable(GL_BLEND);
-		glDisable(GL_DEPTH_TEST);
+		m_StateCache.Disable(GL_DEPTH_TEST);
 
 		if (FrustumClipOn){
 			m_Print3D.Print3D(0.0, 10.0, 1.0, PVRTRGBA(255, 255, 255, 255), "ForEachClip");
@@ -1083,7 +1596,20 @@ bool OGLES2PeaceWaterRender::RenderScene()
 	for (unsigned int i = 0; i < m_SceneManager.ModelInScene.size(); i++){
 		m_SceneManager.ModelInScene[i]->needRender = false;
 	}
+	SPVRTStateCacheCounters & calls = m_StateCache.m_sLastFrame;
+	m_Print3D.Print3D(0.0, 55.0, 1.0, PVRTRGBA(255, 255, 255, 255), "GLCalls:%u issued %u filtered", calls.Issued(), calls.Filtered());
+	SPVRTUniformCacheCounters & uniforms = m_UniformCache.m_sLastFrame;
+	SPVRTUniformBlockCounters & view = m_ViewConstants.m_sLastFrame;
+	m_Print3D.Print3D(0.0, 60.0, 1.0, PVRTRGBA(255, 255, 255, 255), "Uniforms:%u issued %uB, %u filtered %uB, view block %u updates %u skipped",
+		uniforms.ui32Issued, uniforms.ui32IssuedBytes, uniforms.ui32Filtered, uniforms.ui32FilteredBytes, view.ui32Updates, view.ui32Skipped);
+	ShowRenderTargets();
+
+	m_Profiler.BeginSection(eProfilePrint3D);
 	m_Print3D.Flush();
+	m_Profiler.EndSection(eProfilePrint3D);
+	// Print3D sets and restores its own state without the cache
+	m_StateCache.Invalidate();
+	if (!m_BenchmarkSummary.empty()) RecordBenchmark();
 	return true;
 }
 
@@ -1105,24 +1631,38 @@ void OGLES2PeaceWaterRender::ShowFPS()
 
 	if (m_fCount >= 1.0f)			// Update FPS once a second
 	{
-		m_uiFPS.push_back(m_uiFrameCount);
+		m_uiFps = m_uiFrameCount;
 		m_uiFrameCount = 0;
 		m_fCount = 0;
 	}
 
-	if (m_uiFPS.size() == 30){
-		m_uiFpsOut = 0;
-		for (unsigned int i = 0; i < m_uiFPS.size(); i++){
-			m_uiFpsOut += m_uiFPS[i];
-		}
-		m_uiFpsOut /= m_uiFPS.size();
+	m_Print3D.Print3D(0.0, 0.0, 1.0, PVRTRGBA(255, 255, 255, 255), "FPS: %2i", m_uiFps);
+	ShowProfile();
+}
 
-		m_uiFPS.erase(m_uiFPS.begin());
+/*!****************************************************************************
+@Function		ShowProfile
+@Description	Frame time and the time of each profiled section over the
+profiler's history, in milliseconds. GPU times only show once the
+first timer queries came back.
+******************************************************************************/
+void OGLES2PeaceWaterRender::ShowProfile()
+{
+	mSampleStats frame = m_Profiler.FrameMs.Stats();
+	m_Print3D.Print3D(0.0, 5.0, 1.0, PVRTRGBA(255, 255, 255, 255), "Frame: avg %.2f p50 %.2f p95 %.2f p99 %.2f max %.2f ms",
+		frame.Avg, frame.P50, frame.P95, frame.P99, frame.Max);
+	for (unsigned int i = 0; i < m_Profiler.Sections.size(); ++i){
+		mProfilerSection & section = m_Profiler.Sections[i];
+		mSampleStats cpu = section.CpuMs.Stats();
+		if (section.GpuMs.Count){
+			mSampleStats gpu = section.GpuMs.Stats();
+			m_Print3D.Print3D(55.0, 5.0f * i, 1.0, PVRTRGBA(255, 255, 255, 255), "%s: cpu %.2f/%.2f gpu %.2f/%.2f",
+				section.Name.c_str(), cpu.Avg, cpu.P95, gpu.Avg, gpu.P95);
+		}
+		else{
+			m_Print3D.Print3D(55.0, 5.0f * i, 1.0, PVRTRGBA(255, 255, 255, 255), "%s: cpu %.2f/%.2f", section.Name.c_str(), cpu.Avg, cpu.P95);
+		}
 	}
-
-	m_Print3D.Print3D(0.0, 0.0, 1.0, PVRTRGBA(255, 255, 255, 255), "FPS: %2i", m_uiFPS[m_uiFPS.size() - 1]);
-	m_Print3D.Print3D(0.0, 5.0, 1.0, PVRTRGBA(255, 255, 255, 255), "FPSAvg: %2i", m_uiFpsOut);
-
 }
 
 /*!****************************************************************************
@@ -1142,14 +1682,14 @@ void OGLES2PeaceWaterRender::DrawMesh(int i32NodeIndex, CPVRTModelPOD* pod, GLui
 	SPODMesh* pMesh = &pod->pMesh[i32MeshIndex];
 
 	// bind the VBO for the mesh
-	glBindBuffer(GL_ARRAY_BUFFER, (*ppuiVbos)[i32MeshIndex]);
+	m_StateCache.BindBuffer(GL_ARRAY_BUFFER, (*ppuiVbos)[i32MeshIndex]);
 	// bind the index buffer, won't hurt if the handle is 0
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (*ppuiIbos)[i32MeshIndex]);
+	m_StateCache.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, (*ppuiIbos)[i32MeshIndex]);
 
 	int NumAttribute = sizeof(i32Attributes) / sizeof(i32Attributes[0]);
 
-	// Enable the vertex attribute arrays
-	for (int i = 0; i < NumAttribute; ++i) { glEnableVertexAttribArray(i); }
+	// Enable the vertex attribute arrays, the ones of the previous mesh stay enabled when they are shared
+	m_StateCache.EnableVertexAttribArrays(NumAttribute);
 
 	// Set the vertex attribute offsets
 	for (int i = 0; i < NumAttribute; i++){
@@ -1202,12 +1742,6 @@ void OGLES2PeaceWaterRender::DrawMesh(int i32NodeIndex, CPVRTModelPOD* pod, GLui
 			offset += pMesh->pnStripLength[i] + 2;
 		}
 	}
-
-	// Safely disable the vertex attribute arrays
-	for (int i = 0; i < NumAttribute; ++i) { glDisableVertexAttribArray(i); }
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 /******************************************************************************
@@ -1216,179 +1750,638 @@ void OGLES2PeaceWaterRender::DrawMesh(int i32NodeIndex, CPVRTModelPOD* pod, GLui
 *******************************************************************************/
 void OGLES2PeaceWaterRender::RenderReflectionTex(Camera camera)
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, m_auiReflectFBO);
+	if (!m_ReflectionPolicy.NeedsUpdate(m_uiFrameIndex, camera.getPosition(), camera.getForward())){
+		m_ReflectionPolicy.Skips++;
+		return;
+	}
+	m_ReflectionPolicy.Updated(m_uiFrameIndex, camera.getPosition(), camera.getForward());
+	mProfileScope profile(m_Profiler, eProfileReflection);
+	PVRTTRACE_SCOPE("RenderReflectionTex");
+	BindRenderTarget(m_iReflectionTarget);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 
-	glEnable(GL_DEPTH_TEST);
-
-	camera.ModifyProjectionForClipping(PVRTVec4(0.0, 1.0, 0.0, 3.0));
-
-	//DrawBall(PVRTVec3(0, 0, 0), PVRTVec3(0.0, 0.0, 0.0));
-	//DrawBall(camera, PVRTVec3(50, 100, 0), PVRTVec3(1.0, 0.0, 0.0));
-	//DrawBall(camera, PVRTVec3(0, 150, 0), PVRTVec3(0.0, 1.0, 0.0));
-	//DrawBall(camera, PVRTVec3(0, 100, 300), PVRTVec3(0.0, 0.0, 1.0));
+	m_StateCache.Enable(GL_DEPTH_TEST);
 
-	DrawSkybox(camera, 0);
+	camera.ModifyProjectionForClipping(g_vReflectionClipPlane);
+	DrawOffscreenView(camera, eReflectionView);
 
-	glDisable(GL_DEPTH_TEST);
+	m_StateCache.Disable(GL_DEPTH_TEST);
 
 
-	glBindFramebuffer(GL_FRAMEBUFFER, m_iOriginalFBO);
+	BindRenderTarget(-1);
 }
 
 void OGLES2PeaceWaterRender::RenderRefractionTex(Camera camera)
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, m_auiRefractFBO);
+	if (!m_RefractionPolicy.NeedsUpdate(m_uiFrameIndex, camera.getPosition(), camera.getForward())){
+		m_RefractionPolicy.Skips++;
+		return;
+	}
+	m_RefractionPolicy.Updated(m_uiFrameIndex, camera.getPosition(), camera.getForward());
+	mProfileScope profile(m_Profiler, eProfileRefraction);
+	PVRTTRACE_SCOPE("RenderRefractionTex");
+	BindRenderTarget(m_iRefractionTarget);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 
-	glEnable(GL_DEPTH_TEST);
-
-	camera.ModifyProjectionForClipping(PVRTVec4(0.0, -1.0, 0.0, 3.0));
+	m_StateCache.Enable(GL_DEPTH_TEST);
 
-	//DrawBall(PVRTVec3(0, 0, 0), PVRTVec3(0.0, 0.0, 0.0));
-	//DrawBall(camera, PVRTVec3(50, 100, 0), PVRTVec3(1.0, 0.0, 0.0));
-	//DrawBall(camera, PVRTVec3(0, 150, 0), PVRTVec3(0.0, 1.0, 0.0));
-	//DrawBall(camera, PVRTVec3(0, 100, 300), PVRTVec3(0.0, 0.0, 1.0));
+	camera.ModifyProjectionForClipping(g_vRefractionClipPlane);
+	DrawOffscreenView(camera, eRefractionView);
 
-	DrawSkybox(camera, 0);
+	m_StateCache.Disable(GL_DEPTH_TEST);
 
-	glDisable(GL_DEPTH_TEST);
 
+	BindRenderTarget(-1);
+}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, m_iOriginalFBO);
+/*!****************************************************************************
+@Function		CaptureRefractionTTP
+@Input			camera		TTP camera, the refraction clip plane is added here
+@Description	Fills the refraction texture with the skybox and the models
+CullScene found in the refraction view, seen by camera.
+The default path draws straight into the refraction target, the copy path
+draws into the back buffer and copies on the GPU. Only the readpixels
+path, kept to compare against, moves the pixels through the CPU. Frames
+m_RefractionPolicy skips keep the texture of the last capture.
+******************************************************************************/
+void OGLES2PeaceWaterRender::CaptureRefractionTTP(Camera & camera)
+{
+	if (!m_RefractionPolicy.NeedsUpdate(m_uiFrameIndex, camera.getPosition(), camera.getForward())){
+		m_RefractionPolicy.Skips++;
+		return;
+	}
+	m_RefractionPolicy.Updated(m_uiFrameIndex, camera.getPosition(), camera.getForward());
+	mProfileScope profile(m_Profiler, eProfileRefraction);
+	PVRTTRACE_SCOPE("CaptureRefractionTTP");
+
+	Camera clipCamera = camera;
+	clipCamera.ModifyProjectionForClipping(g_vRefractionClipPlane);
+	GLuint texture = m_RenderTargets.Targets[m_iRefractionTarget].Texture;
+	GLsizei width = PVRShellGet(prefWidth), height = PVRShellGet(prefHeight);
+	switch (m_eRefractionCapture)
+	{
+	case eRefractionCopy:
+		DrawOffscreenView(clipCamera, eRefractionView);
+		m_StateCache.BindTexture(GL_TEXTURE_2D, texture);
+		glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+		break;
+	case eRefractionReadPixels:
+		DrawOffscreenView(clipCamera, eRefractionView);
+		m_RefractionPixels.resize(width * height * 4);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &m_RefractionPixels[0]);
+		m_StateCache.BindTexture(GL_TEXTURE_2D, texture);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &m_RefractionPixels[0]);
+		break;
+	default:
+		BindRenderTarget(m_iRefractionTarget);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		DrawOffscreenView(clipCamera, eRefractionView);
+		BindRenderTarget(-1);
+		break;
+	}
 }
 
 /*!****************************************************************************
-@Function		DrawSkybox
-@Description	Draws the skybox onto the screen.
+@Function		AcquireWaterTargets
+@Return		bool		false if a frame buffer is not complete
+@Description	Gets the reflection and refraction targets from the pool at
+the size their policies ask for. The copy and readpixels captures fill the
+refraction texture from the back buffer, so it stays full size for them. A
+target that changes size is released to the pool, and redrawn next frame.
 ******************************************************************************/
-void OGLES2PeaceWaterRender::DrawSkybox(Camera & camera, int bDrawFog)
+bool OGLES2PeaceWaterRender::AcquireWaterTargets()
 {
-	glUseProgram(m_SkyboxProgram.uiId);
+	float refractionScale = m_eRefractionCapture == eRefractionRender ? m_RefractionPolicy.Scale : 1.0f;
+	mRenderTargetDesc reflection = m_RenderTargets.ScaledDesc(m_ReflectionPolicy.Scale);
+	mRenderTargetDesc refraction = m_RenderTargets.ScaledDesc(refractionScale);
+
+	if (m_iReflectionTarget < 0 || m_RenderTargets.Targets[m_iReflectionTarget].Desc != reflection){
+		m_RenderTargets.Release(m_iReflectionTarget);
+		m_iReflectionTarget = m_RenderTargets.Acquire(reflection);
+		m_ReflectionPolicy.Invalidate();
+	}
+	if (m_iRefractionTarget < 0 || m_RenderTargets.Targets[m_iRefractionTarget].Desc != refraction){
+		m_RenderTargets.Release(m_iRefractionTarget);
+		m_iRefractionTarget = m_RenderTargets.Acquire(refraction);
+		m_RefractionPolicy.Invalidate();
+	}
+	return m_iReflectionTarget >= 0 && m_iRefractionTarget >= 0;
+}
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_uiSkybox1_Tex);
+/*!****************************************************************************
+@Function		BindRenderTarget
+@Input			target		index in m_RenderTargets, -1 for the back buffer
+@Description	Binds the frame buffer and sets the viewport to its size.
+******************************************************************************/
+void OGLES2PeaceWaterRender::BindRenderTarget(int target)
+{
+	if (target < 0){
+		m_StateCache.BindFramebuffer(GL_FRAMEBUFFER, m_iOriginalFBO);
+		glViewport(0, 0, PVRShellGet(prefWidth), PVRShellGet(prefHeight));
+		return;
+	}
+	const mRenderTarget & renderTarget = m_RenderTargets.Targets[target];
+	m_StateCache.BindFramebuffer(GL_FRAMEBUFFER, renderTarget.FBO);
+	glViewport(0, 0, renderTarget.Desc.Width, renderTarget.Desc.Height);
+}
 
-	PVRTMat4 m_SkyboxLookAt = PVRTMat4::LookAtRH(PVRTVec3(0.0, 0.0, 0.0), PVRTVec3(0.0, 0.0, 1.0), PVRTVec3(0.0, 1.0, 0.0));
-	PVRTVec3 euler = camera.getEulerAngle();
-	PVRTMat4 m_ViewSkybox = PVRTMat4::RotationX(euler.x / 180.0f * PVRT_PI) * PVRTMat4::RotationY(euler.y / 180.0f * PVRT_PI) * PVRTMat4::RotationZ(euler.z / 180.0f * PVRT_PI) * m_SkyboxLookAt;
+/*!****************************************************************************
+@Function		ShowRenderTargets
+@Description	GPU memory of the pooled targets and how often the
+reflection and refraction were redrawn or kept.
+******************************************************************************/
+void OGLES2PeaceWaterRender::ShowRenderTargets()
+{
+	mRenderTargetStats stats = m_RenderTargets.GetStats();
+	m_Print3D.Print3D(0.0, 80.0, 1.0, PVRTRGBA(255, 255, 255, 255), "RenderTargets:%u/%u in use %uKB, depth %u %uKB",
+		stats.TargetsInUse, stats.Targets, stats.TextureBytes / 1024, stats.DepthBuffers, stats.DepthBytes / 1024);
+	m_Print3D.Print3D(0.0, 85.0, 1.0, PVRTRGBA(255, 255, 255, 255), "Reflection:%u drawn %u kept, Refraction:%u drawn %u kept",
+		m_ReflectionPolicy.Updates, m_ReflectionPolicy.Skips, m_RefractionPolicy.Updates, m_RefractionPolicy.Skips);
+}
 
-	PVRTMat4 CameraProjectionMatrix = camera.getProjectionMatrix();
+/*!****************************************************************************
+@Function		UpdateRefractionBench
+@Description	-refractionbench=frames: runs the TTP view with every
+refraction capture path in turn and times the frames. The time since the
+last call belongs to the previous frame. Each path gets
+g_iRefractionBenchWarmup untimed frames, then the mean of the timed ones
+is written to the debug output and shown once all paths ran. Start with
+-vsync=0 so the swap does not hide the difference.
+******************************************************************************/
+void OGLES2PeaceWaterRender::UpdateRefractionBench()
+{
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	double ms = chrono::duration<double, milli>(now - m_RefractionBenchLast).count();
+	m_RefractionBenchLast = now;
+
+	int span = g_iRefractionBenchWarmup + m_iRefractionBenchFrames;
+	if (m_iRefractionBenchFrame > 0){
+		int previous = m_iRefractionBenchFrame - 1;
+		int path = previous / span, frame = previous % span;
+		if (path < eNumRefractionCaptures && frame >= g_iRefractionBenchWarmup){
+			m_adRefractionBenchMs[path] += ms / m_iRefractionBenchFrames;
+			if (frame == span - 1){
+				PVRShellOutputDebug("Refraction %s: %.3f ms per frame over %d frames\n", g_aszRefractionCaptureNames[path],
+					m_adRefractionBenchMs[path], m_iRefractionBenchFrames);
+			}
+		}
+	}
+	else{
+		for (int i = 0; i < eNumRefractionCaptures; ++i) m_adRefractionBenchMs[i] = 0.0;
+	}
 
-	// Rotate and Translate the model matrix (if required)
-	PVRTMat4 mModel(PVRTMat4::Identity());
-	glUniformMatrix4fv(m_SkyboxProgram.auiLoc[m_SkyboxProgram.eMMatrix], 1, GL_FALSE, mModel.ptr());
+	// the copy path is skipped where it cannot run
+	if (m_iRefractionBenchFrame == eRefractionCopy * span && !m_bRefractionCopyOK) m_iRefractionBenchFrame += span;
 
-	// Set model view projection matrix
-	PVRTMat4 mModelView(m_ViewSkybox * mModel);
-	PVRTMat4 mMVP(CameraProjectionMatrix * mModelView);
-	glUniformMatrix4fv(m_SkyboxProgram.auiLoc[m_SkyboxProgram.eMVPMatrix], 1, GL_FALSE, mMVP.ptr());
+	int path = m_iRefractionBenchFrame / span;
+	if (path < eNumRefractionCaptures){
+		TTPmode = true;
+		m_eRefractionCapture = (ERefractionCapture)path;
+		m_Print3D.Print3D(0.0, 65.0, 1.0, PVRTRGBA(255, 255, 255, 255), "RefractionBench: %s %d/%d", g_aszRefractionCaptureNames[path],
+			m_iRefractionBenchFrame % span, span);
+		m_iRefractionBenchFrame++;
+		return;
+	}
+	for (int i = 0; i < eNumRefractionCaptures; ++i){
+		if (i == eRefractionCopy && !m_bRefractionCopyOK) continue;
+		m_Print3D.Print3D(0.0, 65.0f + 5.0f * i, 1.0, PVRTRGBA(255, 255, 255, 255), "Refraction %s: %.3f ms", g_aszRefractionCaptureNames[i], m_adRefractionBenchMs[i]);
+	}
+}
 
-	glUniform1i(m_SkyboxProgram.auiLoc[m_SkyboxProgram.ebDrawFog], bDrawFog);
-	glUniform4fv(m_SkyboxProgram.auiLoc[m_SkyboxProgram.eFogColor], 1, m_FogColor.ptr());
-	glUniform1f(m_SkyboxProgram.auiLoc[m_SkyboxProgram.eFogHeight], -100.0);
-	glUniform1f(m_SkyboxProgram.auiLoc[m_SkyboxProgram.eFogHeightRatio], m_FogHeightRatio * 2.0f);
+/*!****************************************************************************
+@Function		ParseBenchmarkStep
+@Input			step		tokens of one -benchscript step
+@Output		mode		m_BenchmarkBase changed by the tokens
+@Return		bool		false on an unknown token
+@Description	Tokens are main or ttp for the view, model or quadtree for
+per model or quadtree culling, clipmap or tiles for the water mesh,
+instanced or single for the water tile draws, and rt followed by a scale
+for the water reflection and refraction targets, e.g. ttp:quadtree:rt0.5.
+******************************************************************************/
+bool OGLES2PeaceWaterRender::ParseBenchmarkStep(const mBenchmarkStep & step, BenchmarkMode & mode)
+{
+	mode = m_BenchmarkBase;
+	for (unsigned int i = 0; i < step.Tokens.size(); ++i){
+		const char * token = step.Tokens[i].c_str();
+		if (strcmp(token, "main") == 0) mode.TTP = false;
+		else if (strcmp(token, "ttp") == 0) mode.TTP = true;
+		else if (strcmp(token, "model") == 0) mode.QuadTree = false;
+		else if (strcmp(token, "quadtree") == 0) mode.QuadTree = true;
+		else if (strcmp(token, "clipmap") == 0) mode.Clipmap = true;
+		else if (strcmp(token, "tiles") == 0) mode.Clipmap = false;
+		else if (strcmp(token, "instanced") == 0) mode.Instancing = true;
+		else if (strcmp(token, "single") == 0) mode.Instancing = false;
+		else if (strncmp(token, "rt", 2) == 0 && atof(token + 2) > 0.0){
+			mode.ReflectionScale = mode.RefractionScale = PVRT_CLAMP((float)atof(token + 2), 0.05f, 1.0f);
+		}
+		else{
+			PVRShellOutputDebug("Benchmark: unknown token '%s' in step '%s'\n", token, step.Name.c_str());
+			return false;
+		}
+	}
+	return true;
+}
 
+/*!****************************************************************************
+@Function		UpdateBenchmark
+@Description	-benchmark=summary.json: moves the script on, sets the modes
+of a step on its first frame and restarts the camera and the water
+animation, so every step plays the same frames. The time step is fixed,
+the shell's frame time is forced to it as well.
+******************************************************************************/
+void OGLES2PeaceWaterRender::UpdateBenchmark()
+{
+	int started = m_Benchmark.NextFrame();
+	if (started >= 0){
+		BenchmarkMode mode;
+		ParseBenchmarkStep(m_Benchmark.Steps[started], mode);
+		TTPmode = mode.TTP;
+		FrustumClipOn = !mode.QuadTree;
+		WaterClipmapOn = mode.Clipmap;
+		WaterInstancingOn = mode.Instancing;
+		m_ReflectionPolicy.Scale = mode.ReflectionScale;
+		m_RefractionPolicy.Scale = mode.RefractionScale;
+		m_ReflectionPolicy.Invalidate();
+		m_RefractionPolicy.Invalidate();
+		m_RotateAngleY = 0.0f;
+		m_ulTime = 0.0f;
+		PVRShellOutputDebug("Benchmark step %d: %s\n", started, m_Benchmark.Steps[started].Name.c_str());
+	}
+	m_fDeltaTime = m_uiBenchmarkTimestep * 0.001f;
+	if (m_Benchmark.Running()){
+		m_Print3D.Print3D(0.0, 90.0, 1.0, PVRTRGBA(255, 255, 255, 255), "Benchmark: %s", m_Benchmark.CurrentStep().Name.c_str());
+	}
+}
 
+// counters of the frame that just finished drawing
+void OGLES2PeaceWaterRender::RecordBenchmark()
+{
+	unsigned int updates = m_ReflectionPolicy.Updates + m_RefractionPolicy.Updates;
+	m_Benchmark.SetCounter(eBenchGLCallsIssued, m_StateCache.m_sFrame.Issued());
+	m_Benchmark.SetCounter(eBenchGLCallsFiltered, m_StateCache.m_sFrame.Filtered());
+	m_Benchmark.SetCounter(eBenchUniformBytes, m_UniformCache.m_sFrame.ui32IssuedBytes);
+	m_Benchmark.SetCounter(eBenchTargetUpdates, updates - m_uiBenchmarkTargetUpdates);
+	m_uiBenchmarkTargetUpdates = updates;
+}
 
-	glDisable(GL_CULL_FACE);
+/*!****************************************************************************
+@Function		CullViews
+@Description	Culls the scene index for the main, reflection and refraction
+views in one go on the worker pool. The main view result is marked with
+needRender, every view's list is copied to m_ViewVisible for its pass.
+******************************************************************************/
+void OGLES2PeaceWaterRender::CullViews(Camera & mainCamera, Camera & reflectionCamera, Camera & refractionCamera)
+{
+	PVRTTRACE_SCOPE("CullViews");
+	m_CullingService.setView(eMainView, mainCamera);
+	m_CullingService.setView(eReflectionView, reflectionCamera, g_vReflectionClipPlane);
+	m_CullingService.setView(eRefractionView, refractionCamera, g_vRefractionClipPlane);
+	m_CullingService.Cull(m_SceneManager);
+
+	m_WaterGroupFromSceneManager = m_CullingService.VisibleModels(eMainView);
+	for (unsigned int i = 0; i < m_WaterGroupFromSceneManager.size(); i++){
+		m_WaterGroupFromSceneManager[i]->needRender = true;
+	}
+	for (int i = 0; i < eNumCullViews; ++i){
+		m_ViewVisible[i] = m_CullingService.VisibleModels(i);
+	}
+}
 
-	// bind the VBO for the mesh
-	glBindBuffer(GL_ARRAY_BUFFER, m_puiSkyboxVbo);
-	glVertexAttribPointer(VERTEX_ARRAY, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 3, NULL);
+/*!****************************************************************************
+@Function		CullScene
+@Input			mainCamera			camera the main view is culled with
+@Input			reflectionCamera	mirrored camera, without its clip plane
+@Input			refractionCamera	camera of the refraction pass
+@Description	Fills m_ViewVisible before any pass draws. The quadtree mode
+culls all views with CullViews, the box culler runs once per view. Either
+way the main view's models get needRender.
+******************************************************************************/
+void OGLES2PeaceWaterRender::CullScene(Camera & mainCamera, Camera & reflectionCamera, Camera & refractionCamera)
+{
+	if (!FrustumClipOn){
+		CullViews(mainCamera, reflectionCamera, refractionCamera);
+	}
+	else{
+		Camera clipCameras[eNumCullViews] = { mainCamera, reflectionCamera, refractionCamera };
+		clipCameras[eReflectionView].ModifyProjectionForClipping(g_vReflectionClipPlane);
+		clipCameras[eRefractionView].ModifyProjectionForClipping(g_vRefractionClipPlane);
+		// the main view is culled last, MarkModelsNeedRender reads the last result
+		for (int view = eNumCullViews - 1; view >= 0; --view){
+			m_ViewVisible[view].clear();
+			m_BoxCuller.Cull(clipCameras[view].getFrustum());
+			for (unsigned int i = 0; i < m_BoxCuller.size(); i++){
+				if (m_BoxCuller.IsVisible(i)) m_ViewVisible[view].push_back(m_BoxCuller.Models[i]);
+			}
+		}
+		m_BoxCuller.MarkModelsNeedRender();
+	}
+	m_Print3D.Print3D(0.0, 30.0, 1.0, PVRTRGBA(255, 255, 255, 255), "ReflectionCount:%i", m_ViewVisible[eReflectionView].size());
+	m_Print3D.Print3D(0.0, 35.0, 1.0, PVRTRGBA(255, 255, 255, 255), "RefractionCount:%i", m_ViewVisible[eRefractionView].size());
+}
 
-	// Enable the vertex attribute arrays
-	glEnableVertexAttribArray(VERTEX_ARRAY);
+/*!****************************************************************************
+@Function		SubmitMainView
+@Input			camera		camera the main view is drawn with
+@Description	Queues the buoys of the main view and hands its water tiles to
+SubmitWater through m_WaterRenderQueue.
+******************************************************************************/
+void OGLES2PeaceWaterRender::SubmitMainView(Camera & camera)
+{
+	vector<mModel*> & visible = m_ViewVisible[eMainView];
+	for (unsigned int i = 0; i < visible.size(); i++){
+		if (visible[i]->ModelPOD == &m_BallPOD){
+			SubmitBuoy(camera, visible[i]);
+		}
+		else{
+			m_WaterRenderQueue.push(visible[i]);
+		}
+	}
+}
 
-	for (int i = 0; i < 6; ++i)
-	{
-		// Draw primitive
-		glDrawArrays(GL_TRIANGLE_STRIP, i * 4, 4);
+/*!****************************************************************************
+@Function		DrawOffscreenView
+@Input			camera		camera of the pass, its clip plane already applied
+@Input			view		ECullView whose list is drawn
+@Description	Draws the skybox and the buoys CullScene found in view. The
+water is left out, it samples the textures these passes fill.
+******************************************************************************/
+void OGLES2PeaceWaterRender::DrawOffscreenView(Camera & camera, int view)
+{
+	SubmitSkybox(0);
+	vector<mModel*> & visible = m_ViewVisible[view];
+	for (unsigned int i = 0; i < visible.size(); i++){
+		if (visible[i]->ModelPOD == &m_BallPOD) SubmitBuoy(camera, visible[i]);
 	}
+	ExecuteRenderQueue(camera);
+}
 
-	// Safely disable the vertex attribute arrays
-	glDisableVertexAttribArray(VERTEX_ARRAY);
+/*!****************************************************************************
+@Function		SubmitDraw
+@Input			draw		stored in m_SceneDraws, its index is the queue item
+@Description	Queues a draw of the main view, pass, program, textureSet and
+mesh are the ERender ids.
+******************************************************************************/
+void OGLES2PeaceWaterRender::SubmitDraw(int pass, int program, int textureSet, int mesh, float depth, SceneDraw & draw)
+{
+	m_SceneDraws.push_back(draw);
+	m_RenderQueue.Submit(pass, program, textureSet, mesh, depth, (PVRTuint32)(m_SceneDraws.size() - 1));
+}
 
-	//glEnable(GL_CULL_FACE);
+/*!****************************************************************************
+@Function		ExecuteRenderQueue
+@Input			camera		camera of the queued draws
+@Description	Sorts and draws the queue, then clears it. The offscreen passes
+run it too, ShowRenderStats prints the main view's numbers.
+******************************************************************************/
+void OGLES2PeaceWaterRender::ExecuteRenderQueue(Camera & camera)
+{
+	PVRTTRACE_SCOPE("ExecuteRenderQueue");
+	mRenderBinder binder;
+	binder.BindPass = [this](int pass) { BindRenderPass(pass); };
+	binder.BindProgram = [this](int program) { BindRenderProgram(program); };
+	binder.BindTextures = [this](int textureSet) { BindRenderTextures(textureSet); };
+	binder.BindMesh = [this](int mesh) { BindRenderMesh(mesh); };
+	binder.Draw = [this, &camera](PVRTuint32 item) { DrawRenderItem(camera, item); };
+
+	// the eye position of every draw comes from it, inverted once per queue
+	m_ViewInverse = mAffine(camera.getViewMatrix()).Inverse();
+
+	PVRTVec3 vLightDir = PVRTVec3(m_globalLightDir.x, m_globalLightDir.y, m_globalLightDir.z).normalize();
+	m_ViewConstants.Set(eViewVPMatrix, camera.getVPMatrix().ptr());
+	m_ViewConstants.Set(eViewEyePosWorld, camera.getPosition().ptr());
+	m_ViewConstants.Set(eViewLightDirWorld, vLightDir.ptr());
+	m_ViewConstants.Set(eViewTime, m_ulTime);
+	m_ViewConstants.Set(eViewFogColor, m_FogColor.ptr());
+	m_ViewConstants.Set(eViewFogDepthRatio, m_FogHeightRatio / 5.0f);
+
+	m_RenderQueue.Sort();
+	m_RenderQueue.Execute(binder);
+
+	// Print3D draws from client memory with its own attributes. VAOs are only
+	// bound inside the queue, the code outside draws with the default one.
+	m_StateCache.BindVertexArray(m_Extensions, 0);
+	m_StateCache.EnableVertexAttribArrays(0);
+
+	m_RenderQueue.Clear();
+	m_SceneDraws.clear();
 }
 
 /*!****************************************************************************
-@Function		DrawWaterPlanes
-@Description	Draws the reflective and refractive ball onto the screen.
+@Function		ShowRenderStats
+@Description	Shows how many state changes the sorting of the last queue
+saved, and the water counters once its draws ran.
 ******************************************************************************/
-void OGLES2PeaceWaterRender::DrawWaterPlanes(Camera & camera)
+void OGLES2PeaceWaterRender::ShowRenderStats()
 {
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_uiSmallWaves_N_Tex);
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, m_uiReflectRenderTex);
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_2D, m_uiRefractRenderTex);
-	glActiveTexture(GL_TEXTURE3);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_uiSkybox1_Tex);
+	mRenderQueueStats & stats = m_RenderQueue.Stats;
+	m_Print3D.Print3D(0.0, 50.0, 1.0, PVRTRGBA(255, 255, 255, 255), "StateChanges:%u of %u, unsorted %u", stats.Binds, stats.NaiveBinds, stats.UnsortedBinds);
 
-	// Set model view projection matrix
-	PVRTMat4 mModel, mModelView, mMVP;
+	// the water counters are complete once the draws ran
+	if (WaterClipmapOn){
+		m_Print3D.Print3D(0.0, 40.0, 1.0, PVRTRGBA(255, 255, 255, 255), "WaterVertices:%u Clipmap", m_WaterClipmap.FrameVertices);
+	}
+	else{
+		m_Print3D.Print3D(0.0, 40.0, 1.0, PVRTRGBA(255, 255, 255, 255), "WaterVertices:%u of %u", m_uiWaterVertices, m_uiWaterFullVertices);
+		const char* aszPaths[] = { "PerTile", "Instanced", "Batched" };
+		m_Print3D.Print3D(0.0, 45.0, 1.0, PVRTRGBA(255, 255, 255, 255), "WaterDraws:%u %s", m_uiWaterDrawCalls,
+			aszPaths[WaterInstancingOn ? m_eWaterTilePath : eWaterTilesSingle]);
+	}
+}
 
-	while (m_WaterRenderQueue.size()){
-		// Use shader program
-		glUseProgram(m_DefaultProgram.uiId);
+/*!****************************************************************************
+@Function		BindRenderPass
+@Description	Fixed function state of an ERenderPass.
+******************************************************************************/
+void OGLES2PeaceWaterRender::BindRenderPass(int pass)
+{
+	// every pass draws with the depth test, none of them blends
+	m_StateCache.Enable(GL_DEPTH_TEST);
+	m_StateCache.Disable(GL_BLEND);
+	if (pass == ePassSkybox) m_StateCache.Disable(GL_CULL_FACE);
+}
 
-		mModel = m_WaterRenderQueue.front()->GetModelMatrix();
-		mModelView = camera.getViewMatrix() * mModel;
-		mMVP = camera.getVPMatrix() * mModel;
+void OGLES2PeaceWaterRender::BindRenderProgram(int program)
+{
+	switch (program)
+	{
+	case eProgramSkybox: m_StateCache.UseProgram(m_SkyboxProgram.uiId); break;
+	case eProgramBlinnPhong: m_StateCache.UseProgram(m_BlinnPhongProgram.uiId); break;
+	case eProgramWater:
+		m_StateCache.UseProgram(m_DefaultProgram.uiId);
+		m_ViewConstants.Apply(m_UniformCache, m_DefaultProgram.uiId);
+		break;
+	case eProgramWaterInstanced:
+		m_StateCache.UseProgram(m_WaterInstancedProgram.uiId);
+		m_ViewConstants.Apply(m_UniformCache, m_WaterInstancedProgram.uiId);
+		break;
+	default:
+		break;
+	}
+}
 
-		glUniformMatrix4fv(m_DefaultProgram.auiLoc[m_DefaultProgram.eMVPMatrix], 1, GL_FALSE, mMVP.ptr());
-		glUniformMatrix4fv(m_DefaultProgram.auiLoc[m_DefaultProgram.eMMatrix], 1, GL_FALSE, mModel.ptr());
+void OGLES2PeaceWaterRender::BindRenderTextures(int textureSet)
+{
+	switch (textureSet)
+	{
+	case eTexturesSkybox: m_StateCache.BindTexture(0, GL_TEXTURE_CUBE_MAP, m_uiSkybox1_Tex); break;
+	case eTexturesWater: BindWaterTextures(); break;
+	default:
+		break;
+	}
+}
 
-		PVRTMat4 mModel_IT = mModel;
-		mModel_IT = mModel_IT.transpose();
-		mModel_IT = mModel_IT.inverse();
-		glUniformMatrix4fv(m_DefaultProgram.auiLoc[m_DefaultProgram.eMMatrix_IT], 1, GL_FALSE, mModel_IT.ptr());
+/*!****************************************************************************
+@Function		BindRenderMesh
+@Description	Binds the buffers of an ERenderMesh and points the vertex
+attributes at them. eMeshWaterInstances binds its own buffers per draw.
+The ball and the full water tile are mModels, with vertex array objects
+binding them is one call.
+******************************************************************************/
+void OGLES2PeaceWaterRender::BindRenderMesh(int mesh)
+{
+	if (mesh == eMeshBall && m_Ball.VAO){
+		m_StateCache.BindVertexArray(m_Extensions, m_Ball.VAO[m_Ball.ModelPOD->pNode[0].nIdx]);
+		return;
+	}
+	if (mesh == eMeshWaterFull && m_WaterPlane.VAO){
+		m_StateCache.BindVertexArray(m_Extensions, m_WaterPlane.VAO[0]);
+		return;
+	}
+	m_StateCache.BindVertexArray(m_Extensions, 0);
+
+	switch (mesh)
+	{
+	case eMeshSkybox:
+		m_StateCache.BindBuffer(GL_ARRAY_BUFFER, m_puiSkyboxVbo);
+		m_StateCache.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		m_StateCache.EnableVertexAttribArrays(VERTEX_ARRAY + 1);
+		glVertexAttribPointer(VERTEX_ARRAY, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 3, NULL);
+		break;
+	case eMeshBall:
+	{
+		int i32MeshIndex = m_Ball.ModelPOD->pNode[0].nIdx;
+		SPODMesh* pMesh = &m_Ball.ModelPOD->pMesh[i32MeshIndex];
+		m_StateCache.BindBuffer(GL_ARRAY_BUFFER, m_Ball.VBO[i32MeshIndex]);
+		m_StateCache.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Ball.IndexVBO[i32MeshIndex]);
+		m_StateCache.EnableVertexAttribArrays(NORMAL_ARRAY + 1);
+		glVertexAttribPointer(VERTEX_ARRAY, 3, GL_FLOAT, GL_FALSE, pMesh->sVertex.nStride, pMesh->sVertex.pData);
+		glVertexAttribPointer(NORMAL_ARRAY, 3, GL_FLOAT, GL_FALSE, pMesh->sNormals.nStride, pMesh->sNormals.pData);
+		break;
+	}
+	case eMeshWaterFull:
+		m_StateCache.BindBuffer(GL_ARRAY_BUFFER, m_WaterPlane.VBO[0]);
+		m_StateCache.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_WaterPlane.IndexVBO[0]);
+		m_StateCache.EnableVertexAttribArrays(eNumAttribs);
+		SetWaterVertexAttribs(&m_WaterPlanePOD.pMesh[0], m_WaterPlanePOD.pMesh[0].sVertex.nStride);
+		break;
+	case eMeshWaterClipmap:
+	{
+		m_StateCache.BindBuffer(GL_ARRAY_BUFFER, m_WaterClipmap.VBO);
+		m_StateCache.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_WaterClipmap.IndexVBO);
+		m_StateCache.EnableVertexAttribArrays(eNumAttribs);
+		GLsizei stride = c_uiClipmapVertexFloats * sizeof(GLfloat);
+		glVertexAttribPointer(VERTEX_ARRAY, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+		glVertexAttribPointer(NORMAL_ARRAY, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(GLfloat)));
+		glVertexAttribPointer(TANGENT_ARRAY, 3, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(GLfloat)));
+		glVertexAttribPointer(BINORMAL_ARRAY, 3, GL_FLOAT, GL_FALSE, stride, (void*)(9 * sizeof(GLfloat)));
+		glVertexAttribPointer(TEXCOORD_ARRAY, 2, GL_FLOAT, GL_FALSE, stride, (void*)(12 * sizeof(GLfloat)));
+		break;
+	}
+	case eMeshWaterInstances:
+		// DrawWaterInstances binds its own buffers and attributes
+		m_StateCache.EnableVertexAttribArrays(0);
+		break;
+	default:
+	{
+		WaterLODLevel & lod = m_WaterLOD.Levels[mesh - eMeshWaterLOD];
+		m_StateCache.BindBuffer(GL_ARRAY_BUFFER, lod.VBO);
+		m_StateCache.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_WaterLOD.IndexVBO);
+		m_StateCache.EnableVertexAttribArrays(eNumAttribs);
+		SetWaterVertexAttribs(&lod.POD->pMesh[0], lod.POD->pMesh[0].sVertex.nStride);
+		break;
+	}
+	}
+}
 
-		m_ulTime += 1 * m_fDeltaTime;
-		glUniform1f(m_DefaultProgram.auiLoc[m_DefaultProgram.eTime], m_ulTime);
+/*!****************************************************************************
+@Function		DrawRenderItem
+@Input			item		index in m_SceneDraws
+@Description	Sets the per draw uniforms and draws, the rest of the state was
+bound by the render queue.
+******************************************************************************/
+void OGLES2PeaceWaterRender::DrawRenderItem(Camera & camera, PVRTuint32 item)
+{
+	SceneDraw & draw = m_SceneDraws[item];
+	switch (draw.Type)
+	{
+	case SceneDraw::eSkybox:
+		SetSkyboxUniforms(camera, draw.Key);
+		for (int i = 0; i < 6; ++i)
+		{
+			glDrawArrays(GL_TRIANGLE_STRIP, i * 4, 4);
+		}
+		break;
+	case SceneDraw::eBall:
+	{
+		PVRTMat4 mMVP = camera.getVPMatrix() * draw.Model;
+		GLuint uiProgram = m_BlinnPhongProgram.uiId;
+		m_UniformCache.UniformMatrix4fv(uiProgram, m_BlinnPhongProgram.auiLoc[m_BlinnPhongProgram.eMVPMatrix], mMVP.ptr());
 
 		// Set eye position in model space
-		PVRTVec3 vEyePosModel;
-		vEyePosModel = mModelView.inverse() * PVRTVec4(camera.getPosition(), 1.0);
-		glUniform3fv(m_DefaultProgram.auiLoc[m_DefaultProgram.eEyePosModel], 1, vEyePosModel.ptr());
+		PVRTVec3 vEyePosModel = draw.ModelInverse.TransformPoint(m_ViewInverse.GetTranslation());
+		m_UniformCache.Uniform3fv(uiProgram, m_BlinnPhongProgram.auiLoc[m_BlinnPhongProgram.eEyePosModel], vEyePosModel.ptr());
 
 		// Calculate and set the model space light direction
-		PVRTVec3 vLightDir = mModel.inverse() * m_globalLightDir;
+		PVRTVec3 vLightDir = draw.ModelInverse.TransformVector(PVRTVec3(m_globalLightDir.x, m_globalLightDir.y, m_globalLightDir.z));
 		vLightDir = vLightDir.normalize();
-		glUniform3fv(m_DefaultProgram.auiLoc[m_DefaultProgram.eLightDirModel], 1, vLightDir.ptr());
+		m_UniformCache.Uniform3fv(uiProgram, m_BlinnPhongProgram.auiLoc[m_BlinnPhongProgram.eLightDirModel], vLightDir.ptr());
 
+		m_UniformCache.Uniform3fv(uiProgram, m_BlinnPhongProgram.auiLoc[m_BlinnPhongProgram.eDiffuseColor], draw.DiffuseColor.ptr());
 
-		glUniform4fv(m_DefaultProgram.auiLoc[m_DefaultProgram.eFogColor], 1, m_FogColor.ptr());
-		glUniform1f(m_DefaultProgram.auiLoc[m_DefaultProgram.eFogDepthRatio], m_FogHeightRatio / 5.0f);
-
-		// Now that the uniforms are set, call another function to actually draw the mesh
-		int attirbutes[] = { VERTEX_ARRAY, NORMAL_ARRAY, TANGENT_ARRAY, BINORMAL_ARRAY, TEXCOORD_ARRAY };
-		DrawMesh(0, m_WaterPlane.ModelPOD, &m_WaterPlane.VBO, &m_WaterPlane.IndexVBO, attirbutes);
-		m_WaterRenderQueue.pop();
+		// the ball is exported as an indexed triangle list
+		int i32MeshIndex = m_Ball.ModelPOD->pNode[0].nIdx;
+		glDrawElements(GL_TRIANGLES, m_Ball.ModelPOD->pMesh[i32MeshIndex].nNumFaces * 3, GL_UNSIGNED_SHORT, 0);
+		break;
+	}
+	case SceneDraw::eWaterTile:
+		SetWaterUniforms(camera, draw.Model, draw.ModelInverse);
+		if (draw.Key < 0){
+			glDrawElements(GL_TRIANGLES, m_WaterPlanePOD.pMesh[0].nNumFaces * 3, GL_UNSIGNED_SHORT, 0);
+			m_uiWaterVertices += m_WaterPlanePOD.pMesh[0].nNumVertex;
+			m_uiWaterDrawCalls++;
+		}
+		else{
+			DrawWaterTile(draw.Key / c_iWaterStitchCombinations, draw.Key % c_iWaterStitchCombinations);
+			m_uiWaterDrawCalls += 2;
+		}
+		break;
+	case SceneDraw::eWaterClipmap:
+	{
+		ClipmapRange & range = m_WaterClipmap.Ranges[draw.Key];
+		SetWaterUniforms(camera, draw.Model, draw.ModelInverse);
+		glDrawElements(GL_TRIANGLES, range.Count, GL_UNSIGNED_SHORT, (void*)(range.First * sizeof(GLushort)));
+		break;
+	}
+	case SceneDraw::eWaterInstances:
+		DrawWaterInstances(camera);
+		break;
+	default:
+		break;
 	}
 }
 
 /*!****************************************************************************
-@Function		DrawBall
-@Description	Draws the reflective and refractive ball onto the screen.
+@Function		SubmitBall
+@Description	Queues the reflective and refractive ball.
 ******************************************************************************/
-void OGLES2PeaceWaterRender::DrawBall(Camera & camera, PVRTVec3 position, PVRTVec3 diffuseColor)
+void OGLES2PeaceWaterRender::SubmitBall(Camera & camera, PVRTVec3 position, PVRTVec3 diffuseColor)
 {
-	// Set model view projection matrix
-	PVRTMat4 mModel, mModelView, mMVP;
-
 	m_Ball.SetPosition(position);
 
-	mModel = m_Ball.GetModelMatrix();
-	mModelView = camera.getViewMatrix() * mModel;
-	mMVP = camera.getProjectionMatrix() * mModelView;
-
 	if (diffuseColor == PVRTVec3(0.0, 0.0, 1.0)){
-		if (m_Ball.NeedClip(mMVP)){
+		if (m_Ball.NeedClip(camera.getFrustum())){
 			m_Print3D.Print3D(0.0, 10.0, 1.0, PVRTRGBA(255, 255, 255, 255), "ballcliped");
 		}
 		else
@@ -1397,30 +2390,368 @@ void OGLES2PeaceWaterRender::DrawBall(Camera & camera, PVRTVec3 position, PVRTVe
 		}
 	}
 
-	// Use shader program
-	glUseProgram(m_BlinnPhongProgram.uiId);
+	SceneDraw draw;
+	draw.Type = SceneDraw::eBall;
+	draw.Model = m_Ball.GetTransform();
+	draw.ModelInverse = m_Ball.GetInverseTransform();
+	draw.DiffuseColor = diffuseColor;
+	draw.Key = 0;
+	SubmitDraw(ePassOpaque, eProgramBlinnPhong, eTexturesNone, eMeshBall, (position - camera.getPosition()).length(), draw);
+}
 
-	// Bind textures
+/*!****************************************************************************
+@Function		SubmitBuoy
+@Input			buoy		one of m_Buoys
+@Description	Queues a buoy with its own transform, the colors alternate
+around the ring.
+******************************************************************************/
+void OGLES2PeaceWaterRender::SubmitBuoy(Camera & camera, mModel * buoy)
+{
+	SceneDraw draw;
+	draw.Type = SceneDraw::eBall;
+	draw.Model = buoy->GetTransform();
+	draw.ModelInverse = buoy->GetInverseTransform();
+	draw.DiffuseColor = g_avBuoyColors[(buoy - &m_Buoys[0]) % 2];
+	draw.Key = 0;
+	SubmitDraw(ePassOpaque, eProgramBlinnPhong, eTexturesNone, eMeshBall, (buoy->GetPosition() - camera.getPosition()).length(), draw);
+}
 
+/*!****************************************************************************
+@Function		SubmitSkybox
+@Input			bDrawFog	passed to the skybox shader
+******************************************************************************/
+void OGLES2PeaceWaterRender::SubmitSkybox(int bDrawFog)
+{
+	SceneDraw draw;
+	draw.Type = SceneDraw::eSkybox;
+	draw.Key = bDrawFog;
+	SubmitDraw(ePassSkybox, eProgramSkybox, eTexturesSkybox, eMeshSkybox, 0.0f, draw);
+}
 
-	glUniformMatrix4fv(m_BlinnPhongProgram.auiLoc[m_BlinnPhongProgram.eMVPMatrix], 1, GL_FALSE, mMVP.ptr());
+/*!****************************************************************************
+@Function		SubmitWater
+@Description	Queues the water seen by camera, either the clipmap around the
+main camera or the culled tiles in m_WaterRenderQueue. Tiles are queued
+one by one, except on the instanced paths where DrawWaterInstances
+groups them itself.
+******************************************************************************/
+void OGLES2PeaceWaterRender::SubmitWater(Camera & camera)
+{
+	PVRTTRACE_SCOPE("SubmitWater");
+	SceneDraw draw;
+	PVRTVec3 vEyePos = camera.getPosition();
+	if (WaterClipmapOn){
+		// the clipmap reaches the far plane, the culled tiles are not needed
+		while (m_WaterRenderQueue.size()) m_WaterRenderQueue.pop();
+		m_WaterClipmap.Update(MainCamera.getPosition());
+		draw.Type = SceneDraw::eWaterClipmap;
+		for (unsigned int i = 0; i < m_WaterClipmap.Draws.size(); ++i){
+			ClipmapDraw & clipmapDraw = m_WaterClipmap.Draws[i];
+			if (m_WaterClipmap.Ranges[clipmapDraw.Range].Count == 0) continue;
+			draw.Model = mAffine(clipmapDraw.Model);
+			draw.ModelInverse = draw.Model.Inverse();
+			draw.Key = clipmapDraw.Range;
+			// finer levels are nearer
+			float depth = m_WaterClipmap.Spacing * (float)(1 << clipmapDraw.Level);
+			SubmitDraw(ePassWater, eProgramWater, eTexturesWater, eMeshWaterClipmap, depth, draw);
+		}
+		return;
+	}
 
+	// water level of detail is always chosen for the main camera
+	m_WaterLOD.Select(MainCamera.getPosition(), PVRShellGet(prefHeight) / (2.0f * tan(g_fCamFOV * 0.5f)));
+	m_uiWaterVertices = m_uiWaterFullVertices = 0;
+	m_uiWaterDrawCalls = 0;
 
-	// Set eye position in model space
-	PVRTVec4 vEyePosModel;
-	vEyePosModel = mModelView.inverse() * PVRTVec4(0, 0, 0, 1);
-	glUniform3fv(m_BlinnPhongProgram.auiLoc[m_BlinnPhongProgram.eEyePosModel], 1, &vEyePosModel.x);
+	if (WaterInstancingOn && m_eWaterTilePath != eWaterTilesSingle){
+		draw.Type = SceneDraw::eWaterInstances;
+		draw.Key = 0;
+		SubmitDraw(ePassWater, eProgramWaterInstanced, eTexturesWater, eMeshWaterInstances, 0.0f, draw);
+		return;
+	}
+
+	draw.Type = SceneDraw::eWaterTile;
+	while (m_WaterRenderQueue.size()){
+		mModel * tile = m_WaterRenderQueue.front();
+		int level = 0, stitch = 0;
+		bool useLOD = m_WaterLOD.GetTile(tile, level, stitch);
+		if (useLOD){
+			draw.Model = m_WaterLOD.GetLevelTransform(tile, level, draw.ModelInverse);
+		}
+		else{
+			draw.Model = tile->GetTransform();
+			draw.ModelInverse = tile->GetInverseTransform();
+		}
+		draw.Key = useLOD ? level * c_iWaterStitchCombinations + stitch : -1;
+		m_uiWaterFullVertices += m_WaterPlanePOD.pMesh[0].nNumVertex;
+		SubmitDraw(ePassWater, eProgramWater, eTexturesWater, useLOD ? eMeshWaterLOD + level : eMeshWaterFull,
+			(tile->GetPosition() - vEyePos).length(), draw);
+		m_WaterRenderQueue.pop();
+	}
+}
+
+/*!****************************************************************************
+@Function		DrawSkybox
+@Description	Draws the skybox onto the screen.
+******************************************************************************/
+void OGLES2PeaceWaterRender::DrawSkybox(Camera & camera, int bDrawFog)
+{
+	PVRTTRACE_SCOPE("DrawSkybox");
+	m_StateCache.UseProgram(m_SkyboxProgram.uiId);
+
+	m_StateCache.BindTexture(0, GL_TEXTURE_CUBE_MAP, m_uiSkybox1_Tex);
+
+	SetSkyboxUniforms(camera, bDrawFog);
+
+	m_StateCache.Disable(GL_CULL_FACE);
+
+	// bind the VBO for the mesh
+	m_StateCache.BindBuffer(GL_ARRAY_BUFFER, m_puiSkyboxVbo);
+	glVertexAttribPointer(VERTEX_ARRAY, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 3, NULL);
+
+	// Enable the vertex attribute arrays
+	m_StateCache.EnableVertexAttribArrays(VERTEX_ARRAY + 1);
+
+	for (int i = 0; i < 6; ++i)
+	{
+		// Draw primitive
+		glDrawArrays(GL_TRIANGLE_STRIP, i * 4, 4);
+	}
+
+	//glEnable(GL_CULL_FACE);
+}
+
+/*!****************************************************************************
+@Function		SetSkyboxUniforms
+@Description	Sets the skybox shader's uniforms for camera, the program must
+be in use.
+******************************************************************************/
+void OGLES2PeaceWaterRender::SetSkyboxUniforms(Camera & camera, int bDrawFog)
+{
+	PVRTMat4 m_SkyboxLookAt = PVRTMat4::LookAtRH(PVRTVec3(0.0, 0.0, 0.0), PVRTVec3(0.0, 0.0, 1.0), PVRTVec3(0.0, 1.0, 0.0));
+	PVRTVec3 euler = camera.getEulerAngle();
+	PVRTMat4 m_ViewSkybox = PVRTMat4::RotationX(euler.x / 180.0f * PVRT_PI) * PVRTMat4::RotationY(euler.y / 180.0f * PVRT_PI) * PVRTMat4::RotationZ(euler.z / 180.0f * PVRT_PI) * m_SkyboxLookAt;
+
+	PVRTMat4 CameraProjectionMatrix = camera.getProjectionMatrix();
+
+	// Rotate and Translate the model matrix (if required)
+	PVRTMat4 mModel(PVRTMat4::Identity());
+	GLuint uiProgram = m_SkyboxProgram.uiId;
+	m_UniformCache.UniformMatrix4fv(uiProgram, m_SkyboxProgram.auiLoc[m_SkyboxProgram.eMMatrix], mModel.ptr());
+
+	// Set model view projection matrix
+	PVRTMat4 mModelView(m_ViewSkybox * mModel);
+	PVRTMat4 mMVP(CameraProjectionMatrix * mModelView);
+	m_UniformCache.UniformMatrix4fv(uiProgram, m_SkyboxProgram.auiLoc[m_SkyboxProgram.eMVPMatrix], mMVP.ptr());
+
+	m_UniformCache.Uniform1i(uiProgram, m_SkyboxProgram.auiLoc[m_SkyboxProgram.ebDrawFog], bDrawFog);
+	m_UniformCache.Uniform4fv(uiProgram, m_SkyboxProgram.auiLoc[m_SkyboxProgram.eFogColor], m_FogColor.ptr());
+	m_UniformCache.Uniform1f(uiProgram, m_SkyboxProgram.auiLoc[m_SkyboxProgram.eFogHeight], -100.0f);
+	m_UniformCache.Uniform1f(uiProgram, m_SkyboxProgram.auiLoc[m_SkyboxProgram.eFogHeightRatio], m_FogHeightRatio * 2.0f);
+}
+
+/*!****************************************************************************
+@Function		BindWaterTextures
+@Description	Binds the normal map, reflection, refraction and skybox
+textures of the water shader.
+******************************************************************************/
+void OGLES2PeaceWaterRender::BindWaterTextures()
+{
+	m_StateCache.BindTexture(0, GL_TEXTURE_2D, m_uiSmallWaves_N_Tex);
+	m_StateCache.BindTexture(1, GL_TEXTURE_2D, m_RenderTargets.Targets[m_iReflectionTarget].Texture);
+	m_StateCache.BindTexture(2, GL_TEXTURE_2D, m_RenderTargets.Targets[m_iRefractionTarget].Texture);
+	m_StateCache.BindTexture(3, GL_TEXTURE_CUBE_MAP, m_uiSkybox1_Tex);
+}
+
+/*!****************************************************************************
+@Function		SetWaterUniforms
+@Input			camera		camera the water is drawn for
+@Input			model		model transform of the water mesh
+@Input			modelInverse	its inverse, cached by the tile
+@Description	Sets the per draw uniforms of the water shader, the program
+must be in use. Nothing is inverted here, the inverses come with the draw
+and the view's with ExecuteRenderQueue. The per view uniforms are in
+m_ViewConstants.
+******************************************************************************/
+void OGLES2PeaceWaterRender::SetWaterUniforms(Camera & camera, const mAffine & model, const mAffine & modelInverse)
+{
+	// Set model view projection matrix
+	PVRTMat4 mMVP = camera.getVPMatrix() * model;
+	PVRTMat4 mModel = model.ToMat4();
+
+	GLuint uiProgram = m_DefaultProgram.uiId;
+	m_UniformCache.UniformMatrix4fv(uiProgram, m_DefaultProgram.auiLoc[m_DefaultProgram.eMVPMatrix], mMVP.ptr());
+	m_UniformCache.UniformMatrix4fv(uiProgram, m_DefaultProgram.auiLoc[m_DefaultProgram.eMMatrix], mModel.ptr());
+
+	PVRTMat4 mModel_IT = modelInverse.TransposedMat4();
+	m_UniformCache.UniformMatrix4fv(uiProgram, m_DefaultProgram.auiLoc[m_DefaultProgram.eMMatrix_IT], mModel_IT.ptr());
+
+	// Set eye position in model space, the world eye of the instanced path taken into the tile
+	PVRTVec3 vEyePosModel = modelInverse.TransformPoint(camera.getPosition());
+	m_UniformCache.Uniform3fv(uiProgram, m_DefaultProgram.auiLoc[m_DefaultProgram.eEyePosModel], vEyePosModel.ptr());
 
 	// Calculate and set the model space light direction
-	PVRTVec3 vLightDir = mModel.inverse() * m_globalLightDir;
+	PVRTVec3 vLightDir = modelInverse.TransformVector(PVRTVec3(m_globalLightDir.x, m_globalLightDir.y, m_globalLightDir.z));
 	vLightDir = vLightDir.normalize();
-	glUniform3fv(m_BlinnPhongProgram.auiLoc[m_BlinnPhongProgram.eLightDirModel], 1, vLightDir.ptr());
+	m_UniformCache.Uniform3fv(uiProgram, m_DefaultProgram.auiLoc[m_DefaultProgram.eLightDirModel], vLightDir.ptr());
+}
 
-	glUniform3fv(m_BlinnPhongProgram.auiLoc[m_BlinnPhongProgram.eDiffuseColor], 1, diffuseColor.ptr());
+/*!****************************************************************************
+@Function		DrawWaterTile
+@Input			level		LOD level chosen by m_WaterLOD.Select
+stitch		Edges that are stitched to a coarser neighbor
+@Description	Draws a water tile with a level of m_WaterLOD, the interior
+indices and then the ring variant for the stitch combination. The level's
+buffers are bound by BindRenderMesh.
+******************************************************************************/
+void OGLES2PeaceWaterRender::DrawWaterTile(int level, int stitch)
+{
+	WaterLODLevel & lod = m_WaterLOD.Levels[level];
 
-	// Now that the uniforms are set, call another function to actually draw the mesh
-	int attirbutes[] = { VERTEX_ARRAY, NORMAL_ARRAY };
-	DrawMesh(0, m_Ball.ModelPOD, &m_Ball.VBO, &m_Ball.IndexVBO, attirbutes);
+	if (lod.InteriorCount)
+		glDrawElements(GL_TRIANGLES, lod.InteriorCount, GL_UNSIGNED_SHORT, (void*)(lod.InteriorFirst * sizeof(GLushort)));
+	if (lod.RingCount[stitch])
+		glDrawElements(GL_TRIANGLES, lod.RingCount[stitch], GL_UNSIGNED_SHORT, (void*)(lod.RingFirst[stitch] * sizeof(GLushort)));
+
+	m_uiWaterVertices += lod.POD->pMesh[0].nNumVertex;
+}
+
+/*!****************************************************************************
+@Function		WaterGroupMesh
+@Input			key			-1 for the full mesh, else level * c_iWaterStitchCombinations + stitch
+@Output		vbo			vertex buffer of the mesh
+@Output		ibo			index buffer of the mesh
+@Output		ranges		index ranges to draw, at most two
+@Return		SPODMesh*	vertex layout of the mesh
+******************************************************************************/
+SPODMesh * OGLES2PeaceWaterRender::WaterGroupMesh(int key, GLuint & vbo, GLuint & ibo, InstanceRange * ranges, int & rangeCount)
+{
+	if (key < 0){
+		vbo = m_WaterPlane.VBO[0];
+		ibo = m_WaterPlane.IndexVBO[0];
+		ranges[0].First = 0;
+		ranges[0].Count = m_WaterPlanePOD.pMesh[0].nNumFaces * 3;
+		rangeCount = 1;
+		return &m_WaterPlanePOD.pMesh[0];
+	}
+	WaterLODLevel & level = m_WaterLOD.Levels[key / c_iWaterStitchCombinations];
+	int stitch = key % c_iWaterStitchCombinations;
+	vbo = level.VBO;
+	ibo = m_WaterLOD.IndexVBO;
+	ranges[0].First = level.InteriorFirst;
+	ranges[0].Count = level.InteriorCount;
+	ranges[1].First = level.RingFirst[stitch];
+	ranges[1].Count = level.RingCount[stitch];
+	rangeCount = 2;
+	return &level.POD->pMesh[0];
+}
+
+/*!****************************************************************************
+@Function		SetWaterVertexAttribs
+@Input			mesh		POD mesh giving the attribute offsets
+@Input			stride		vertex size of the bound buffer
+******************************************************************************/
+void OGLES2PeaceWaterRender::SetWaterVertexAttribs(SPODMesh * mesh, GLsizei stride)
+{
+	glVertexAttribPointer(VERTEX_ARRAY, 3, GL_FLOAT, GL_FALSE, stride, mesh->sVertex.pData);
+	glVertexAttribPointer(NORMAL_ARRAY, 3, GL_FLOAT, GL_FALSE, stride, mesh->sNormals.pData);
+	glVertexAttribPointer(TANGENT_ARRAY, 3, GL_FLOAT, GL_FALSE, stride, mesh->sTangents.pData);
+	glVertexAttribPointer(BINORMAL_ARRAY, 3, GL_FLOAT, GL_FALSE, stride, mesh->sBinormals.pData);
+	glVertexAttribPointer(TEXCOORD_ARRAY, 2, GL_FLOAT, GL_FALSE, stride, mesh->psUVW[0].pData);
+}
+
+/*!****************************************************************************
+@Function		DrawWaterInstances
+@Description	Draws m_WaterRenderQueue with one program and one set of
+uniforms. Tiles are sorted by mesh (LOD level and stitch) and every run
+of the same mesh is one instanced draw per index range, or one draw
+per range and m_WaterBatches slot count on the uniform batch path.
+The program and textures are bound by the render queue.
+******************************************************************************/
+void OGLES2PeaceWaterRender::DrawWaterInstances(Camera & camera)
+{
+	PVRTTRACE_SCOPE("DrawWaterInstances");
+	m_WaterDrawList.clear();
+	while (m_WaterRenderQueue.size()){
+		mModel * tile = m_WaterRenderQueue.front();
+		int level = 0, stitch = 0;
+		int key = m_WaterLOD.GetTile(tile, level, stitch) ? level * c_iWaterStitchCombinations + stitch : -1;
+		m_WaterDrawList.push_back(make_pair(key, tile));
+		m_WaterRenderQueue.pop();
+	}
+	if (m_WaterDrawList.empty()) return;
+	sort(m_WaterDrawList.begin(), m_WaterDrawList.end());
+
+	unsigned int count = (unsigned int)m_WaterDrawList.size();
+	m_InstanceRows.resize(count * c_uiInstanceRowFloats);
+	for (unsigned int i = 0; i < count; ++i){
+		int key = m_WaterDrawList[i].first;
+		mModel * tile = m_WaterDrawList[i].second;
+		mAffine inverse;
+		mAffine tileTransform = key < 0 ? tile->GetTransform() : m_WaterLOD.GetLevelTransform(tile, key / c_iWaterStitchCombinations, inverse);
+		mInstanceBatch::AffineRows(tileTransform, &m_InstanceRows[i * c_uiInstanceRowFloats]);
+		m_uiWaterFullVertices += m_WaterPlanePOD.pMesh[0].nNumVertex;
+		m_uiWaterVertices += key < 0 ? m_WaterPlanePOD.pMesh[0].nNumVertex : m_WaterLOD.Levels[key / c_iWaterStitchCombinations].POD->pMesh[0].nNumVertex;
+	}
+
+	// the other uniforms are in world space, the same for every tile and set with m_ViewConstants
+	bool bInstanced = m_eWaterTilePath == eWaterTilesInstanced;
+	int attributes = bInstanced ? eNumInstanceAttribs : INSTANCE_INDEX_ARRAY + 1;
+	m_StateCache.EnableVertexAttribArrays(attributes);
+
+	if (bInstanced){
+		m_StateCache.BindBuffer(GL_ARRAY_BUFFER, m_uiInstanceVBO);
+		glBufferData(GL_ARRAY_BUFFER, m_InstanceRows.size() * sizeof(GLfloat), &m_InstanceRows[0], GL_STREAM_DRAW);
+		for (int i = INSTANCE_ROW0_ARRAY; i <= INSTANCE_ROW2_ARRAY; ++i) { m_Extensions.glVertexAttribDivisorEXT(i, 1); }
+	}
+
+	for (unsigned int begin = 0, end = 0; begin < count; begin = end){
+		int key = m_WaterDrawList[begin].first;
+		for (end = begin + 1; end < count && m_WaterDrawList[end].first == key; ++end);
+
+		GLuint vbo, ibo;
+		InstanceRange ranges[2];
+		int rangeCount;
+		SPODMesh * pMesh = WaterGroupMesh(key, vbo, ibo, ranges, rangeCount);
+
+		if (bInstanced){
+			m_StateCache.BindBuffer(GL_ARRAY_BUFFER, vbo);
+			SetWaterVertexAttribs(pMesh, pMesh->sVertex.nStride);
+			m_StateCache.BindBuffer(GL_ARRAY_BUFFER, m_uiInstanceVBO);
+			GLsizei stride = c_uiInstanceRowFloats * sizeof(GLfloat);
+			for (int i = 0; i < 3; ++i){
+				glVertexAttribPointer(INSTANCE_ROW0_ARRAY + i, 4, GL_FLOAT, GL_FALSE, stride, (void*)((begin * c_uiInstanceRowFloats + i * 4) * sizeof(GLfloat)));
+			}
+			m_StateCache.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+			for (int r = 0; r < rangeCount; ++r){
+				if (ranges[r].Count == 0) continue;
+				m_Extensions.glDrawElementsInstancedEXT(GL_TRIANGLES, ranges[r].Count, GL_UNSIGNED_SHORT, (void*)(ranges[r].First * sizeof(GLushort)), end - begin);
+				m_uiWaterDrawCalls++;
+			}
+		}
+		else{
+			mInstanceBatch & batch = key < 0 ? m_WaterFullBatch : m_WaterBatches[key / c_iWaterStitchCombinations];
+			int batchRanges[2] = { 0, 1 + key % c_iWaterStitchCombinations };
+			m_StateCache.BindBuffer(GL_ARRAY_BUFFER, batch.VBO);
+			SetWaterVertexAttribs(pMesh, batch.Stride);
+			glVertexAttribPointer(INSTANCE_INDEX_ARRAY, 1, GL_FLOAT, GL_FALSE, batch.Stride, (void*)(size_t)batch.SlotOffset);
+			m_StateCache.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch.IndexVBO);
+			for (unsigned int first = begin; first < end; first += batch.Slots){
+				unsigned int instances = PVRT_MIN(batch.Slots, end - first);
+				m_UniformCache.Uniform4fv(m_WaterInstancedProgram.uiId, m_WaterInstancedProgram.auiLoc[m_WaterInstancedProgram.eInstanceRows], instances * 3, &m_InstanceRows[first * c_uiInstanceRowFloats]);
+				for (int r = 0; r < rangeCount; ++r){
+					InstanceRange & range = batch.Ranges[batchRanges[r]];
+					if (range.Count == 0) continue;
+					glDrawElements(GL_TRIANGLES, range.Count * instances, GL_UNSIGNED_SHORT, (void*)(range.First * sizeof(GLushort)));
+					m_uiWaterDrawCalls++;
+				}
+			}
+		}
+	}
+
+	if (bInstanced){
+		for (int i = INSTANCE_ROW0_ARRAY; i <= INSTANCE_ROW2_ARRAY; ++i) { m_Extensions.glVertexAttribDivisorEXT(i, 0); }
+	}
 }
 
 /*!****************************************************************************
@@ -1436,7 +2767,7 @@ void OGLES2PeaceWaterRender::DrawCube(Camera & camera){
 	mMVP = camera.getProjectionMatrix() * mModelView;
 
 	// Use shader program
-	glUseProgram(m_DefaultProgram.uiId);
+	m_StateCache.UseProgram(m_DefaultProgram.uiId);
 
 	glUniformMatrix4fv(m_DefaultProgram.auiLoc[m_BlinnPhongProgram.eMVPMatrix], 1, GL_FALSE, mMVP.ptr());
 
@@ -286,6 +286,16 @@ bool PVRShellInit::ApiInitAPI()
 			attrib_list[i++] = EGL_ALPHA_FORMAT;
 			attrib_list[i++] = EGL_ALPHA_FORMAT_PRE;
 		}
+#endif
+#if defined(BUILD_NULLGLES2)
+		// There is no window to take the size from, pass on -width and -height
+		if (m_pShell->m_pShellData->nShellDimX > 0 && m_pShell->m_pShellData->nShellDimY > 0)
+		{
+			attrib_list[i++] = EGL_WIDTH;
+			attrib_list[i++] = m_pShell->m_pShellData->nShellDimX;
+			attrib_list[i++] = EGL_HEIGHT;
+			attrib_list[i++] = m_pShell->m_pShellData->nShellDimY;
+		}
 #endif
 		// Terminate the attribute list with EGL_NONE
 		attrib_list[i] = EGL_NONE;
@@ -17,6 +17,7 @@
 #include "PVRShellOS.h"
 #include "PVRShellAPI.h"
 #include "PVRShellImpl.h"
+#include "../Tools/PVRTTrace.h"
 
 /*! This file simply defines a version string. It can be commented out. */
 #include "sdkver.h"
@@ -1553,6 +1554,22 @@ bool PVRShellInit::Run()
 			// Parse the command-line
 			m_CommandLine.Parse();
 
+			// Start tracing before InitApplication so that it is on the timeline
+			unsigned int ui32TraceEvents = PVRTTRACE_EVENTS_PER_THREAD;
+			m_pszTraceFile = NULL;
+			for(int i = 0; i < m_CommandLine.m_nOptLen; ++i)
+			{
+				const SCmdLineOpt &opt = m_CommandLine.m_pOpt[i];
+				if(!opt.pArg || !opt.pVal)
+					continue;
+				if(_stricmp(opt.pArg, "-trace") == 0)
+					m_pszTraceFile = opt.pVal;
+				else if(_stricmp(opt.pArg, "-traceevents") == 0)
+					ui32TraceEvents = (unsigned int)atoi(opt.pVal);
+			}
+			if(m_pszTraceFile && CPVRTTrace::Start(ui32TraceEvents))
+				CPVRTTrace::SetThreadName("PVRShell");
+
 #if defined(_DEBUG)
 			m_pShell->PVRShellOutputDebug("PVRShell command line: %d/%d\n", m_CommandLine.m_nOptLen, m_CommandLine.m_nOptMax);
 			for(int i = 0; i < m_CommandLine.m_nOptLen; ++i)
@@ -1563,7 +1580,10 @@ bool PVRShellInit::Run()
 			}
 #endif
 			// Call InitApplication
-			if(!m_pShell->InitApplication())
+			PVRTTRACE_BEGIN("InitApplication");
+			bool bInitApp = m_pShell->InitApplication();
+			PVRTTRACE_END("InitApplication");
+			if(!bInitApp)
 			{
 				m_eState = ePVRShellExit;
 				return true;
@@ -1579,8 +1599,13 @@ bool PVRShellInit::Run()
 			// Output non-api specific data if required
 			OutputInfo();
 
+			PVRTTRACE_SCOPE("InitInstance");
+
 			// Perform OS initialisation
-			if(!OsInitOS())
+			PVRTTRACE_BEGIN("OsInitOS");
+			bool bInitOS = OsInitOS();
+			PVRTTRACE_END("OsInitOS");
+			if(!bInitOS)
 			{
 				m_pShell->PVRShellOutputDebug("InitOS failed!\n");
 				m_eState = ePVRShellQuitApp;
@@ -1588,7 +1613,10 @@ bool PVRShellInit::Run()
 			}
 
 			// Initialize the 3D API
-			if(!OsDoInitAPI())
+			PVRTTRACE_BEGIN("OsDoInitAPI");
+			bool bInitAPI = OsDoInitAPI();
+			PVRTTRACE_END("OsDoInitAPI");
+			if(!bInitAPI)
 			{
 				m_pShell->PVRShellOutputDebug("InitAPI failed!\n");
 				m_eState = ePVRShellReleaseOS;
@@ -1600,7 +1628,10 @@ bool PVRShellInit::Run()
 			OutputAPIInfo();
 
 			// Initialise the app
-			if(!m_pShell->InitView())
+			PVRTTRACE_BEGIN("InitView");
+			bool bInitView = m_pShell->InitView();
+			PVRTTRACE_END("InitView");
+			if(!bInitView)
 			{
 				m_pShell->PVRShellOutputDebug("InitView failed!\n");
 				m_eState = ePVRShellReleaseAPI;
@@ -1618,12 +1649,22 @@ bool PVRShellInit::Run()
 		}
 	case ePVRShellRender:
 		{
+			PVRTTRACE_SCOPE("Frame");
+			PVRTTRACE_COUNTER("FrameNumber", m_pShell->m_pShellData->nShellCurFrameNum);
+
 			// Main message loop:
-			if(!m_pShell->RenderScene())
+			PVRTTRACE_BEGIN("RenderScene");
+			bool bRendered = m_pShell->RenderScene();
+			PVRTTRACE_END("RenderScene");
+			if(!bRendered)
 				break;
 
+			PVRTTRACE_BEGIN("ApiRenderComplete");
 			ApiRenderComplete();
+			PVRTTRACE_END("ApiRenderComplete");
+			PVRTTRACE_BEGIN("OsRenderComplete");
 			OsRenderComplete();
+			PVRTTRACE_END("OsRenderComplete");
 
 #ifdef PVRSHELL_FPS_OUTPUT
 			if(m_pShell->m_pShellData->bOutputFPS)
@@ -1669,13 +1710,19 @@ bool PVRShellInit::Run()
 		}
 
 	case ePVRShellReleaseView:
+		PVRTTRACE_BEGIN("ReleaseView");
 		m_pShell->ReleaseView();
+		PVRTTRACE_END("ReleaseView");
 
 	case ePVRShellReleaseAPI:
+		PVRTTRACE_BEGIN("OsDoReleaseAPI");
 		OsDoReleaseAPI();
+		PVRTTRACE_END("OsDoReleaseAPI");
 
 	case ePVRShellReleaseOS:
+		PVRTTRACE_BEGIN("OsReleaseOS");
 		OsReleaseOS();
+		PVRTTRACE_END("OsReleaseOS");
 
 		if(!gShellDone && m_pShell->m_pShellData->nInitRepeats)
 		{
@@ -1689,9 +1736,20 @@ bool PVRShellInit::Run()
 
 	case ePVRShellQuitApp:
 		// Final app tidy-up
+		PVRTTRACE_BEGIN("QuitApplication");
 		m_pShell->QuitApplication();
+		PVRTTRACE_END("QuitApplication");
 		m_eState = ePVRShellExit;
 
+		if(m_pszTraceFile && CPVRTTrace::IsEnabled())
+		{
+			CPVRTTrace::Stop();
+			if(CPVRTTrace::WriteJSON(m_pszTraceFile))
+				m_pShell->PVRShellOutputDebug("Trace: %u events written to %s, %u dropped\n", CPVRTTrace::GetEventCount(), m_pszTraceFile, CPVRTTrace::GetDroppedCount());
+			else
+				m_pShell->PVRShellOutputDebug("Trace: cannot write %s\n", m_pszTraceFile);
+		}
+
 	case ePVRShellExit:
 		OsExit();
 		StringCopy(m_pShell->m_pShellData->pszAppName, 0);
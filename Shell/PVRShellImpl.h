@@ -184,6 +184,9 @@ public:
 	int		m_i32FpsFrameCnt, m_i32FpsTimePrev;
 #endif
 
+	// Chrome trace written on exit, from -trace=file.json
+	const char	*m_pszTraceFile;		/*!< Points into m_CommandLine, NULL when not tracing */
+
 public:
 
 protected:
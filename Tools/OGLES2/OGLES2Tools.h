@@ -35,6 +35,10 @@
 #include "../PVRTMisc.h"
 #include "../PVRTBackground.h"
 #include "PVRTgles2Ext.h"
+#include "PVRTStateCache.h"
+#include "PVRTUniformCache.h"
+#include "PVRTUniformBlock.h"
+#include "PVRTNullGLES2.h"
 #include "../PVRTPrint3D.h"
 #include "../PVRTBoneBatch.h"
 #include "../PVRTModelPOD.h"
@@ -47,6 +51,8 @@
 #include "PVRTPFXSemantics.h"
 #include "../PVRTShadowVol.h"
 #include "../PVRTResourceFile.h"
+#include "../PVRTTrace.h"
+#include "../PVRTMappedFile.h"
 #include "../PVRTError.h"
 
 #endif /* _OGLES2TOOLS_H_ */
@@ -0,0 +1,1782 @@
+/******************************************************************************
+
+ @File         OGLES2/PVRTNullGLES2.cpp
+
+ @Title        OGLES2/PVRTNullGLES2
+
+ @Version
+
+ @Copyright    Copyright (c) Imagination Technologies Limited.
+
+ @Platform     Independent
+
+ @Description  Recording OpenGL ES 2.0 and EGL implementation without a GPU.
+               Only compiled with BUILD_NULLGLES2, see PVRTNullGLES2.h.
+
+******************************************************************************/
+#if defined(BUILD_NULLGLES2)
+
+#if defined(_WIN32)
+// The entry points are defined here instead of being imported from the DLLs
+#define GL_APICALL
+#define EGLAPI
+#endif
+
+#include <string.h>
+#include <vector>
+#include <map>
+#include <string>
+
+#include <EGL/egl.h>
+#include "PVRTContext.h"
+#include "PVRTNullGLES2.h"
+
+/****************************************************************************
+** Local code
+****************************************************************************/
+static const char* c_apszCallNames[ePVRTNullGLES2NumCalls] =
+{
+	"glActiveTexture", "glAttachShader", "glBindAttribLocation", "glBindBuffer",
+	"glBindFramebuffer", "glBindRenderbuffer", "glBindTexture", "glBlendColor",
+	"glBlendEquation", "glBlendEquationSeparate", "glBlendFunc", "glBlendFuncSeparate",
+	"glBufferData", "glBufferSubData", "glCheckFramebufferStatus", "glClear",
+	"glClearColor", "glClearDepthf", "glClearStencil", "glColorMask",
+	"glCompileShader", "glCompressedTexImage2D", "glCompressedTexSubImage2D", "glCopyTexImage2D",
+	"glCopyTexSubImage2D", "glCreateProgram", "glCreateShader", "glCullFace",
+	"glDeleteBuffers", "glDeleteFramebuffers", "glDeleteProgram", "glDeleteRenderbuffers",
+	"glDeleteShader", "glDeleteTextures", "glDepthFunc", "glDepthMask",
+	"glDepthRangef", "glDetachShader", "glDisable", "glDisableVertexAttribArray",
+	"glDrawArrays", "glDrawElements", "glEnable", "glEnableVertexAttribArray",
+	"glFinish", "glFlush", "glFramebufferRenderbuffer", "glFramebufferTexture2D",
+	"glFrontFace", "glGenBuffers", "glGenerateMipmap", "glGenFramebuffers",
+	"glGenRenderbuffers", "glGenTextures", "glGetActiveAttrib", "glGetActiveUniform",
+	"glGetAttachedShaders", "glGetAttribLocation", "glGetBooleanv", "glGetBufferParameteriv",
+	"glGetError", "glGetFloatv", "glGetFramebufferAttachmentParameteriv", "glGetIntegerv",
+	"glGetProgramiv", "glGetProgramInfoLog", "glGetRenderbufferParameteriv", "glGetShaderiv",
+	"glGetShaderInfoLog", "glGetShaderPrecisionFormat", "glGetShaderSource", "glGetString",
+	"glGetTexParameterfv", "glGetTexParameteriv", "glGetUniformfv", "glGetUniformiv",
+	"glGetUniformLocation", "glGetVertexAttribfv", "glGetVertexAttribiv", "glGetVertexAttribPointerv",
+	"glHint", "glIsBuffer", "glIsEnabled", "glIsFramebuffer",
+	"glIsProgram", "glIsRenderbuffer", "glIsShader", "glIsTexture",
+	"glLineWidth", "glLinkProgram", "glPixelStorei", "glPolygonOffset",
+	"glReadPixels", "glReleaseShaderCompiler", "glRenderbufferStorage", "glSampleCoverage",
+	"glScissor", "glShaderBinary", "glShaderSource", "glStencilFunc",
+	"glStencilFuncSeparate", "glStencilMask", "glStencilMaskSeparate", "glStencilOp",
+	"glStencilOpSeparate", "glTexImage2D", "glTexParameterf", "glTexParameterfv",
+	"glTexParameteri", "glTexParameteriv", "glTexSubImage2D", "glUniform1f",
+	"glUniform1fv", "glUniform1i", "glUniform1iv", "glUniform2f",
+	"glUniform2fv", "glUniform2i", "glUniform2iv", "glUniform3f",
+	"glUniform3fv", "glUniform3i", "glUniform3iv", "glUniform4f",
+	"glUniform4fv", "glUniform4i", "glUniform4iv", "glUniformMatrix2fv",
+	"glUniformMatrix3fv", "glUniformMatrix4fv", "glUseProgram", "glValidateProgram",
+	"glVertexAttrib1f", "glVertexAttrib1fv", "glVertexAttrib2f", "glVertexAttrib2fv",
+	"glVertexAttrib3f", "glVertexAttrib3fv", "glVertexAttrib4f", "glVertexAttrib4fv",
+	"glVertexAttribPointer", "glViewport",
+
+	"glDrawElementsInstancedEXT", "glVertexAttribDivisorEXT", "glDiscardFramebufferEXT",
+	"glBindVertexArrayOES", "glDeleteVertexArraysOES", "glGenVertexArraysOES", "glIsVertexArrayOES",
+
+	"eglSwapBuffers",
+};
+
+static const char c_szExtensions[] = "GL_EXT_instanced_arrays GL_EXT_discard_framebuffer GL_OES_vertex_array_object GL_OES_depth24 GL_OES_rgb8_rgba8";
+
+#define NULLGLES2_MAX_TEXTURE_UNITS	32
+#define NULLGLES2_MAX_ATTRIBS		16
+
+// Namespaces of the generated object names
+enum ENullObject
+{
+	eNullBuffer,
+	eNullTexture,
+	eNullFramebuffer,
+	eNullRenderbuffer,
+	eNullVertexArray,
+	eNullShader,			// shaders and programs share their names
+	eNullProgram,
+	eNullNumObjects
+};
+
+/*!***************************************************************************
+ @Struct		SNullGLES2
+ @Description	The one context and display of the implementation.
+*****************************************************************************/
+struct SNullGLES2
+{
+	SPVRTNullGLES2Counters	sTotal, sFrame, sLastFrame;
+	unsigned int			ui32Frames;
+	std::vector<PVRTuint32>	aStream, aLastStream;
+	bool					bRecording;
+	bool					bOverflow;
+
+	// Objects, the value is the ENullObject of a name or eNullNumObjects when it is not in use
+	std::vector<PVRTuint8>	aObjects[2];		// buffers, textures, framebuffers, renderbuffers and vertex arrays | shaders and programs
+	GLuint					auiNextName[2];
+	std::map<GLuint, std::vector<std::string> >	mUniforms, mAttribs;
+
+	// State the queries answer from
+	GLuint		uiProgram, uiArrayBuffer, uiElementBuffer, uiFramebuffer, uiRenderbuffer;
+	GLuint		uiVertexArray;
+	std::map<GLuint, GLuint>	mElementBuffers;	// element buffer of every vertex array object, 0 for the default
+	GLuint		uiActiveUnit;
+	GLuint		auiTextures[NULLGLES2_MAX_TEXTURE_UNITS][2];
+	GLenum		eCullFace, eFrontFace, eDepthFunc, eBlendSrc, eBlendDst;
+	GLboolean	bDepthMask;
+	GLint		ai32Viewport[4], ai32Scissor[4];
+	GLfloat		afClearColor[4];
+	GLboolean	abCaps[9];
+	GLenum		eError;
+
+	// EGL
+	EGLint		i32EGLError;
+	EGLint		i32Width, i32Height;
+	bool		bCurrent;
+
+	SNullGLES2()
+	{
+		sTotal.Reset();
+		sFrame.Reset();
+		sLastFrame.Reset();
+		ui32Frames = 0;
+		bRecording = true;
+		bOverflow = false;
+		auiNextName[0] = auiNextName[1] = 1;
+		i32Width = PVRTNULLGLES2_WIDTH;
+		i32Height = PVRTNULLGLES2_HEIGHT;
+		bCurrent = false;
+		i32EGLError = EGL_SUCCESS;
+		ResetState();
+	}
+
+	void ResetState()
+	{
+		uiProgram = uiArrayBuffer = uiElementBuffer = uiFramebuffer = uiRenderbuffer = 0;
+		uiVertexArray = 0;
+		mElementBuffers.clear();
+		uiActiveUnit = 0;
+		memset(auiTextures, 0, sizeof(auiTextures));
+		eCullFace = GL_BACK;
+		eFrontFace = GL_CCW;
+		eDepthFunc = GL_LESS;
+		eBlendSrc = GL_ONE;
+		eBlendDst = GL_ZERO;
+		bDepthMask = GL_TRUE;
+		ai32Viewport[0] = ai32Viewport[1] = ai32Scissor[0] = ai32Scissor[1] = 0;
+		ai32Viewport[2] = ai32Scissor[2] = i32Width;
+		ai32Viewport[3] = ai32Scissor[3] = i32Height;
+		memset(afClearColor, 0, sizeof(afClearColor));
+		memset(abCaps, GL_FALSE, sizeof(abCaps));
+		abCaps[capIndex(GL_DITHER)] = GL_TRUE;
+		eError = GL_NO_ERROR;
+	}
+
+	static int capIndex(GLenum cap)
+	{
+		switch(cap)
+		{
+		case GL_BLEND:						return 0;
+		case GL_CULL_FACE:					return 1;
+		case GL_DEPTH_TEST:					return 2;
+		case GL_DITHER:						return 3;
+		case GL_POLYGON_OFFSET_FILL:		return 4;
+		case GL_SAMPLE_ALPHA_TO_COVERAGE:	return 5;
+		case GL_SAMPLE_COVERAGE:			return 6;
+		case GL_SCISSOR_TEST:				return 7;
+		case GL_STENCIL_TEST:				return 8;
+		default:							return -1;
+		}
+	}
+
+	GLuint Generate(ENullObject eType)
+	{
+		int i32Space = eType >= eNullShader ? 1 : 0;
+		GLuint uiName = auiNextName[i32Space]++;
+		if(aObjects[i32Space].size() <= uiName)
+			aObjects[i32Space].resize(uiName + 1, (PVRTuint8)eNullNumObjects);
+		aObjects[i32Space][uiName] = (PVRTuint8)eType;
+		return uiName;
+	}
+
+	bool Is(ENullObject eType, GLuint uiName) const
+	{
+		int i32Space = eType >= eNullShader ? 1 : 0;
+		return uiName && uiName < aObjects[i32Space].size() && aObjects[i32Space][uiName] == eType;
+	}
+
+	void Delete(ENullObject eType, GLuint uiName)
+	{
+		if(Is(eType, uiName))
+			aObjects[eType >= eNullShader ? 1 : 0][uiName] = (PVRTuint8)eNullNumObjects;
+	}
+
+	void Add(PVRTuint64 SPVRTNullGLES2Counters::*pCounter, PVRTuint64 ui64Value)
+	{
+		sFrame.*pCounter += ui64Value;
+		sTotal.*pCounter += ui64Value;
+	}
+
+	void Draw(PVRTuint64 ui64Vertices)
+	{
+		sFrame.ui32DrawCalls++;
+		sTotal.ui32DrawCalls++;
+		Add(&SPVRTNullGLES2Counters::ui64Vertices, ui64Vertices);
+	}
+
+	void EndFrame()
+	{
+		sLastFrame = sFrame;
+		sFrame.Reset();
+		aLastStream.swap(aStream);
+		aStream.clear();
+		bOverflow = false;
+		ui32Frames++;
+	}
+};
+
+static SNullGLES2 g_sNull;
+
+/*!***************************************************************************
+ @Class			CNullCommand
+ @Description	Counts a call and appends it to the command stream. The
+				arguments are streamed in with <<, the header gets their count
+				when the command goes out of scope.
+*****************************************************************************/
+class CNullCommand
+{
+public:
+	CNullCommand(EPVRTNullGLES2Call eCall) : m_i32Header(-1)
+	{
+		g_sNull.sFrame.aui32Calls[eCall]++;
+		g_sNull.sTotal.aui32Calls[eCall]++;
+		if(!g_sNull.bRecording)
+			return;
+
+		// room for the longest command
+		if(g_sNull.aStream.size() + 16 > PVRTNULLGLES2_MAX_STREAM_WORDS)
+		{
+			g_sNull.bOverflow = true;
+			return;
+		}
+		m_i32Header = (int)g_sNull.aStream.size();
+		g_sNull.aStream.push_back((PVRTuint32)eCall);
+	}
+
+	CNullCommand(const CNullCommand& other) : m_i32Header(other.m_i32Header)
+	{
+		other.m_i32Header = -1;
+	}
+
+	~CNullCommand()
+	{
+		if(m_i32Header >= 0)
+			g_sNull.aStream[m_i32Header] |= (PVRTuint32)(g_sNull.aStream.size() - m_i32Header - 1) << 16;
+	}
+
+	CNullCommand& operator<<(GLuint v)		{ return word(v); }
+	CNullCommand& operator<<(GLint v)		{ return word((PVRTuint32)v); }
+	CNullCommand& operator<<(GLboolean v)	{ return word(v); }
+	CNullCommand& operator<<(GLfloat v)
+	{
+		PVRTuint32 ui32Bits;
+		memcpy(&ui32Bits, &v, sizeof(ui32Bits));
+		return word(ui32Bits);
+	}
+
+private:
+	CNullCommand& word(PVRTuint32 ui32Word)
+	{
+		if(m_i32Header >= 0)
+			g_sNull.aStream.push_back(ui32Word);
+		return *this;
+	}
+
+	CNullCommand& operator=(const CNullCommand&);
+
+	mutable int m_i32Header;
+};
+
+static CNullCommand record(EPVRTNullGLES2Call eCall)
+{
+	return CNullCommand(eCall);
+}
+
+static unsigned int componentCount(GLenum format)
+{
+	switch(format)
+	{
+	case GL_RGBA:				return 4;
+	case GL_RGB:				return 3;
+	case GL_LUMINANCE_ALPHA:	return 2;
+	default:					return 1;
+	}
+}
+
+static PVRTuint64 pixelBytes(GLsizei width, GLsizei height, GLenum format, GLenum type)
+{
+	unsigned int ui32Bytes;
+	switch(type)
+	{
+	case GL_UNSIGNED_SHORT_5_6_5:
+	case GL_UNSIGNED_SHORT_4_4_4_4:
+	case GL_UNSIGNED_SHORT_5_5_5_1:	ui32Bytes = 2; break;
+	case GL_UNSIGNED_SHORT:			ui32Bytes = 2 * componentCount(format); break;
+	case GL_UNSIGNED_INT:
+	case GL_FLOAT:					ui32Bytes = 4 * componentCount(format); break;
+	case GL_HALF_FLOAT_OES:			ui32Bytes = 2 * componentCount(format); break;
+	default:						ui32Bytes = componentCount(format); break;
+	}
+	return (PVRTuint64)width * height * ui32Bytes;
+}
+
+static void uniformBytes(GLsizei count, unsigned int ui32Size)
+{
+	g_sNull.Add(&SPVRTNullGLES2Counters::ui64UniformBytes, (PVRTuint64)count * ui32Size);
+}
+
+static GLint location(std::map<GLuint, std::vector<std::string> >& mNames, GLuint program, const GLchar* name)
+{
+	if(!g_sNull.Is(eNullProgram, program) || !name)
+		return -1;
+
+	std::vector<std::string>& aNames = mNames[program];
+	for(unsigned int i = 0; i < aNames.size(); ++i)
+	{
+		if(aNames[i] == name)
+			return (GLint)i;
+	}
+	aNames.push_back(name);
+	return (GLint)aNames.size() - 1;
+}
+
+static void copyString(const char* pszString, GLsizei bufSize, GLsizei* length, GLchar* buffer)
+{
+	GLsizei i32Length = 0;
+	if(buffer && bufSize > 0)
+	{
+		i32Length = (GLsizei)PVRT_MIN(strlen(pszString), (size_t)(bufSize - 1));
+		memcpy(buffer, pszString, i32Length);
+		buffer[i32Length] = 0;
+	}
+	if(length)
+		*length = i32Length;
+}
+
+/****************************************************************************
+** Struct: SPVRTNullGLES2Counters
+****************************************************************************/
+unsigned int SPVRTNullGLES2Counters::Calls() const
+{
+	unsigned int ui32Sum = 0;
+	for(int i = 0; i < ePVRTNullGLES2NumCalls; ++i)
+		ui32Sum += aui32Calls[i];
+	return ui32Sum;
+}
+
+PVRTuint64 SPVRTNullGLES2Counters::UploadBytes() const
+{
+	return ui64BufferBytes + ui64TextureBytes + ui64UniformBytes;
+}
+
+void SPVRTNullGLES2Counters::Reset()
+{
+	memset(this, 0, sizeof(*this));
+}
+
+/****************************************************************************
+** Recording interface
+****************************************************************************/
+const SPVRTNullGLES2Counters& PVRTNullGLES2Total()
+{
+	return g_sNull.sTotal;
+}
+
+const SPVRTNullGLES2Counters& PVRTNullGLES2LastFrame()
+{
+	return g_sNull.sLastFrame;
+}
+
+unsigned int PVRTNullGLES2Frames()
+{
+	return g_sNull.ui32Frames;
+}
+
+const PVRTuint32* PVRTNullGLES2Commands(unsigned int& ui32Words)
+{
+	ui32Words = (unsigned int)g_sNull.aLastStream.size();
+	return ui32Words ? &g_sNull.aLastStream[0] : NULL;
+}
+
+void PVRTNullGLES2SetRecording(bool bRecord)
+{
+	g_sNull.bRecording = bRecord;
+}
+
+const char* PVRTNullGLES2CallName(unsigned int ui32Call)
+{
+	return ui32Call < ePVRTNullGLES2NumCalls ? c_apszCallNames[ui32Call] : "";
+}
+
+void PVRTNullGLES2Report(FILE* pFile)
+{
+	const SPVRTNullGLES2Counters& sTotal = g_sNull.sTotal;
+	double dFrames = g_sNull.ui32Frames ? (double)g_sNull.ui32Frames : 1.0;
+
+	fprintf(pFile, "PVRTNullGLES2: %u frames\n", g_sNull.ui32Frames);
+	fprintf(pFile, "  calls          %10u  %12.1f per frame\n", sTotal.Calls(), sTotal.Calls() / dFrames);
+	fprintf(pFile, "  draw calls     %10u  %12.1f per frame\n", sTotal.ui32DrawCalls, sTotal.ui32DrawCalls / dFrames);
+	fprintf(pFile, "  vertices       %10llu  %12.1f per frame\n", (unsigned long long)sTotal.ui64Vertices, sTotal.ui64Vertices / dFrames);
+	fprintf(pFile, "  buffer bytes   %10llu  %12.1f per frame\n", (unsigned long long)sTotal.ui64BufferBytes, sTotal.ui64BufferBytes / dFrames);
+	fprintf(pFile, "  texture bytes  %10llu  %12.1f per frame\n", (unsigned long long)sTotal.ui64TextureBytes, sTotal.ui64TextureBytes / dFrames);
+	fprintf(pFile, "  uniform bytes  %10llu  %12.1f per frame\n", (unsigned long long)sTotal.ui64UniformBytes, sTotal.ui64UniformBytes / dFrames);
+	fprintf(pFile, "  read bytes     %10llu  %12.1f per frame\n", (unsigned long long)sTotal.ui64ReadBytes, sTotal.ui64ReadBytes / dFrames);
+	for(int i = 0; i < ePVRTNullGLES2NumCalls; ++i)
+	{
+		if(sTotal.aui32Calls[i])
+			fprintf(pFile, "  %-36s %10u  %12.1f per frame\n", c_apszCallNames[i], sTotal.aui32Calls[i], sTotal.aui32Calls[i] / dFrames);
+	}
+}
+
+/****************************************************************************
+** OpenGL ES 2.0
+****************************************************************************/
+extern "C" {
+
+GL_APICALL void GL_APIENTRY glActiveTexture(GLenum texture)
+{
+	record(ePVRTNull_glActiveTexture) << texture;
+	if(texture >= GL_TEXTURE0 && texture < GL_TEXTURE0 + NULLGLES2_MAX_TEXTURE_UNITS)
+		g_sNull.uiActiveUnit = texture - GL_TEXTURE0;
+	else
+		g_sNull.eError = GL_INVALID_ENUM;
+}
+
+GL_APICALL void GL_APIENTRY glAttachShader(GLuint program, GLuint shader)
+{
+	record(ePVRTNull_glAttachShader) << program << shader;
+}
+
+GL_APICALL void GL_APIENTRY glBindAttribLocation(GLuint program, GLuint index, const GLchar* name)
+{
+	record(ePVRTNull_glBindAttribLocation) << program << index;
+	if(!g_sNull.Is(eNullProgram, program) || !name)
+		return;
+
+	std::vector<std::string>& aNames = g_sNull.mAttribs[program];
+	if(aNames.size() <= index)
+		aNames.resize(index + 1);
+	aNames[index] = name;
+}
+
+GL_APICALL void GL_APIENTRY glBindBuffer(GLenum target, GLuint buffer)
+{
+	record(ePVRTNull_glBindBuffer) << target << buffer;
+	if(target == GL_ARRAY_BUFFER)
+		g_sNull.uiArrayBuffer = buffer;
+	else if(target == GL_ELEMENT_ARRAY_BUFFER)
+		g_sNull.uiElementBuffer = buffer;
+}
+
+GL_APICALL void GL_APIENTRY glBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+	record(ePVRTNull_glBindFramebuffer) << target << framebuffer;
+	g_sNull.uiFramebuffer = framebuffer;
+}
+
+GL_APICALL void GL_APIENTRY glBindRenderbuffer(GLenum target, GLuint renderbuffer)
+{
+	record(ePVRTNull_glBindRenderbuffer) << target << renderbuffer;
+	g_sNull.uiRenderbuffer = renderbuffer;
+}
+
+GL_APICALL void GL_APIENTRY glBindTexture(GLenum target, GLuint texture)
+{
+	record(ePVRTNull_glBindTexture) << target << texture;
+	g_sNull.auiTextures[g_sNull.uiActiveUnit][target == GL_TEXTURE_CUBE_MAP ? 1 : 0] = texture;
+}
+
+GL_APICALL void GL_APIENTRY glBlendColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+	record(ePVRTNull_glBlendColor) << red << green << blue << alpha;
+}
+
+GL_APICALL void GL_APIENTRY glBlendEquation(GLenum mode)
+{
+	record(ePVRTNull_glBlendEquation) << mode;
+}
+
+GL_APICALL void GL_APIENTRY glBlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha)
+{
+	record(ePVRTNull_glBlendEquationSeparate) << modeRGB << modeAlpha;
+}
+
+GL_APICALL void GL_APIENTRY glBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+	record(ePVRTNull_glBlendFunc) << sfactor << dfactor;
+	g_sNull.eBlendSrc = sfactor;
+	g_sNull.eBlendDst = dfactor;
+}
+
+GL_APICALL void GL_APIENTRY glBlendFuncSeparate(GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfactorAlpha, GLenum dfactorAlpha)
+{
+	record(ePVRTNull_glBlendFuncSeparate) << sfactorRGB << dfactorRGB << sfactorAlpha << dfactorAlpha;
+	g_sNull.eBlendSrc = sfactorRGB;
+	g_sNull.eBlendDst = dfactorRGB;
+}
+
+GL_APICALL void GL_APIENTRY glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+	record(ePVRTNull_glBufferData) << target << (GLint)size << usage;
+	if(data)
+		g_sNull.Add(&SPVRTNullGLES2Counters::ui64BufferBytes, (PVRTuint64)size);
+}
+
+GL_APICALL void GL_APIENTRY glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+	record(ePVRTNull_glBufferSubData) << target << (GLint)offset << (GLint)size;
+	if(data)
+		g_sNull.Add(&SPVRTNullGLES2Counters::ui64BufferBytes, (PVRTuint64)size);
+}
+
+GL_APICALL GLenum GL_APIENTRY glCheckFramebufferStatus(GLenum target)
+{
+	record(ePVRTNull_glCheckFramebufferStatus) << target;
+	return GL_FRAMEBUFFER_COMPLETE;
+}
+
+GL_APICALL void GL_APIENTRY glClear(GLbitfield mask)
+{
+	record(ePVRTNull_glClear) << mask;
+}
+
+GL_APICALL void GL_APIENTRY glClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+	record(ePVRTNull_glClearColor) << red << green << blue << alpha;
+	g_sNull.afClearColor[0] = red;
+	g_sNull.afClearColor[1] = green;
+	g_sNull.afClearColor[2] = blue;
+	g_sNull.afClearColor[3] = alpha;
+}
+
+GL_APICALL void GL_APIENTRY glClearDepthf(GLfloat d)
+{
+	record(ePVRTNull_glClearDepthf) << d;
+}
+
+GL_APICALL void GL_APIENTRY glClearStencil(GLint s)
+{
+	record(ePVRTNull_glClearStencil) << s;
+}
+
+GL_APICALL void GL_APIENTRY glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+{
+	record(ePVRTNull_glColorMask) << red << green << blue << alpha;
+}
+
+GL_APICALL void GL_APIENTRY glCompileShader(GLuint shader)
+{
+	record(ePVRTNull_glCompileShader) << shader;
+}
+
+GL_APICALL void GL_APIENTRY glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void* data)
+{
+	record(ePVRTNull_glCompressedTexImage2D) << target << level << internalformat << width << height << border << imageSize;
+	if(data)
+		g_sNull.Add(&SPVRTNullGLES2Counters::ui64TextureBytes, (PVRTuint64)imageSize);
+}
+
+GL_APICALL void GL_APIENTRY glCompressedTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void* data)
+{
+	record(ePVRTNull_glCompressedTexSubImage2D) << target << level << xoffset << yoffset << width << height << format << imageSize;
+	if(data)
+		g_sNull.Add(&SPVRTNullGLES2Counters::ui64TextureBytes, (PVRTuint64)imageSize);
+}
+
+GL_APICALL void GL_APIENTRY glCopyTexImage2D(GLenum target, GLint level, GLenum internalformat, GLint x, GLint y, GLsizei width, GLsizei height, GLint border)
+{
+	record(ePVRTNull_glCopyTexImage2D) << target << level << internalformat << x << y << width << height << border;
+}
+
+GL_APICALL void GL_APIENTRY glCopyTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	record(ePVRTNull_glCopyTexSubImage2D) << target << level << xoffset << yoffset << x << y << width << height;
+}
+
+GL_APICALL GLuint GL_APIENTRY glCreateProgram(void)
+{
+	GLuint program = g_sNull.Generate(eNullProgram);
+	record(ePVRTNull_glCreateProgram) << program;
+	return program;
+}
+
+GL_APICALL GLuint GL_APIENTRY glCreateShader(GLenum type)
+{
+	GLuint shader = g_sNull.Generate(eNullShader);
+	record(ePVRTNull_glCreateShader) << type << shader;
+	return shader;
+}
+
+GL_APICALL void GL_APIENTRY glCullFace(GLenum mode)
+{
+	record(ePVRTNull_glCullFace) << mode;
+	g_sNull.eCullFace = mode;
+}
+
+GL_APICALL void GL_APIENTRY glDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+	record(ePVRTNull_glDeleteBuffers) << n;
+	for(GLsizei i = 0; i < n; ++i)
+	{
+		g_sNull.Delete(eNullBuffer, buffers[i]);
+		if(buffers[i] == g_sNull.uiArrayBuffer)
+			g_sNull.uiArrayBuffer = 0;
+		if(buffers[i] == g_sNull.uiElementBuffer)
+			g_sNull.uiElementBuffer = 0;
+	}
+}
+
+GL_APICALL void GL_APIENTRY glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+{
+	record(ePVRTNull_glDeleteFramebuffers) << n;
+	for(GLsizei i = 0; i < n; ++i)
+	{
+		g_sNull.Delete(eNullFramebuffer, framebuffers[i]);
+		if(framebuffers[i] == g_sNull.uiFramebuffer)
+			g_sNull.uiFramebuffer = 0;
+	}
+}
+
+GL_APICALL void GL_APIENTRY glDeleteProgram(GLuint program)
+{
+	record(ePVRTNull_glDeleteProgram) << program;
+	g_sNull.Delete(eNullProgram, program);
+	g_sNull.mUniforms.erase(program);
+	g_sNull.mAttribs.erase(program);
+}
+
+GL_APICALL void GL_APIENTRY glDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers)
+{
+	record(ePVRTNull_glDeleteRenderbuffers) << n;
+	for(GLsizei i = 0; i < n; ++i)
+	{
+		g_sNull.Delete(eNullRenderbuffer, renderbuffers[i]);
+		if(renderbuffers[i] == g_sNull.uiRenderbuffer)
+			g_sNull.uiRenderbuffer = 0;
+	}
+}
+
+GL_APICALL void GL_APIENTRY glDeleteShader(GLuint shader)
+{
+	record(ePVRTNull_glDeleteShader) << shader;
+	g_sNull.Delete(eNullShader, shader);
+}
+
+GL_APICALL void GL_APIENTRY glDeleteTextures(GLsizei n, const GLuint* textures)
+{
+	record(ePVRTNull_glDeleteTextures) << n;
+	for(GLsizei i = 0; i < n; ++i)
+	{
+		g_sNull.Delete(eNullTexture, textures[i]);
+		for(int u = 0; u < NULLGLES2_MAX_TEXTURE_UNITS; ++u)
+		{
+			for(int t = 0; t < 2; ++t)
+			{
+				if(g_sNull.auiTextures[u][t] == textures[i])
+					g_sNull.auiTextures[u][t] = 0;
+			}
+		}
+	}
+}
+
+GL_APICALL void GL_APIENTRY glDepthFunc(GLenum func)
+{
+	record(ePVRTNull_glDepthFunc) << func;
+	g_sNull.eDepthFunc = func;
+}
+
+GL_APICALL void GL_APIENTRY glDepthMask(GLboolean flag)
+{
+	record(ePVRTNull_glDepthMask) << flag;
+	g_sNull.bDepthMask = flag;
+}
+
+GL_APICALL void GL_APIENTRY glDepthRangef(GLfloat n, GLfloat f)
+{
+	record(ePVRTNull_glDepthRangef) << n << f;
+}
+
+GL_APICALL void GL_APIENTRY glDetachShader(GLuint program, GLuint shader)
+{
+	record(ePVRTNull_glDetachShader) << program << shader;
+}
+
+GL_APICALL void GL_APIENTRY glDisable(GLenum cap)
+{
+	record(ePVRTNull_glDisable) << cap;
+	int i32Cap = SNullGLES2::capIndex(cap);
+	if(i32Cap >= 0)
+		g_sNull.abCaps[i32Cap] = GL_FALSE;
+}
+
+GL_APICALL void GL_APIENTRY glDisableVertexAttribArray(GLuint index)
+{
+	record(ePVRTNull_glDisableVertexAttribArray) << index;
+}
+
+GL_APICALL void GL_APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+	record(ePVRTNull_glDrawArrays) << mode << first << count;
+	g_sNull.Draw((PVRTuint64)count);
+}
+
+GL_APICALL void GL_APIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+{
+	record(ePVRTNull_glDrawElements) << mode << count << type << (GLuint)(size_t)indices;
+	g_sNull.Draw((PVRTuint64)count);
+}
+
+GL_APICALL void GL_APIENTRY glEnable(GLenum cap)
+{
+	record(ePVRTNull_glEnable) << cap;
+	int i32Cap = SNullGLES2::capIndex(cap);
+	if(i32Cap >= 0)
+		g_sNull.abCaps[i32Cap] = GL_TRUE;
+}
+
+GL_APICALL void GL_APIENTRY glEnableVertexAttribArray(GLuint index)
+{
+	record(ePVRTNull_glEnableVertexAttribArray) << index;
+}
+
+GL_APICALL void GL_APIENTRY glFinish(void)
+{
+	record(ePVRTNull_glFinish);
+}
+
+GL_APICALL void GL_APIENTRY glFlush(void)
+{
+	record(ePVRTNull_glFlush);
+}
+
+GL_APICALL void GL_APIENTRY glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer)
+{
+	record(ePVRTNull_glFramebufferRenderbuffer) << target << attachment << renderbuffertarget << renderbuffer;
+}
+
+GL_APICALL void GL_APIENTRY glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
+{
+	record(ePVRTNull_glFramebufferTexture2D) << target << attachment << textarget << texture << level;
+}
+
+GL_APICALL void GL_APIENTRY glFrontFace(GLenum mode)
+{
+	record(ePVRTNull_glFrontFace) << mode;
+	g_sNull.eFrontFace = mode;
+}
+
+static void generate(EPVRTNullGLES2Call eCall, ENullObject eType, GLsizei n, GLuint* names)
+{
+	record(eCall) << n;
+	for(GLsizei i = 0; i < n; ++i)
+		names[i] = g_sNull.Generate(eType);
+}
+
+GL_APICALL void GL_APIENTRY glGenBuffers(GLsizei n, GLuint* buffers)
+{
+	generate(ePVRTNull_glGenBuffers, eNullBuffer, n, buffers);
+}
+
+GL_APICALL void GL_APIENTRY glGenerateMipmap(GLenum target)
+{
+	record(ePVRTNull_glGenerateMipmap) << target;
+}
+
+GL_APICALL void GL_APIENTRY glGenFramebuffers(GLsizei n, GLuint* framebuffers)
+{
+	generate(ePVRTNull_glGenFramebuffers, eNullFramebuffer, n, framebuffers);
+}
+
+GL_APICALL void GL_APIENTRY glGenRenderbuffers(GLsizei n, GLuint* renderbuffers)
+{
+	generate(ePVRTNull_glGenRenderbuffers, eNullRenderbuffer, n, renderbuffers);
+}
+
+GL_APICALL void GL_APIENTRY glGenTextures(GLsizei n, GLuint* textures)
+{
+	generate(ePVRTNull_glGenTextures, eNullTexture, n, textures);
+}
+
+GL_APICALL void GL_APIENTRY glGetActiveAttrib(GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+	record(ePVRTNull_glGetActiveAttrib) << program << index;
+	std::vector<std::string>& aNames = g_sNull.mAttribs[program];
+	copyString(index < aNames.size() ? aNames[index].c_str() : "", bufSize, length, name);
+	if(size) *size = 1;
+	if(type) *type = GL_FLOAT_VEC4;
+}
+
+GL_APICALL void GL_APIENTRY glGetActiveUniform(GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+	record(ePVRTNull_glGetActiveUniform) << program << index;
+	std::vector<std::string>& aNames = g_sNull.mUniforms[program];
+	copyString(index < aNames.size() ? aNames[index].c_str() : "", bufSize, length, name);
+	if(size) *size = 1;
+	if(type) *type = GL_FLOAT_VEC4;
+}
+
+GL_APICALL void GL_APIENTRY glGetAttachedShaders(GLuint program, GLsizei maxCount, GLsizei* count, GLuint* shaders)
+{
+	record(ePVRTNull_glGetAttachedShaders) << program << maxCount;
+	if(count) *count = 0;
+}
+
+GL_APICALL GLint GL_APIENTRY glGetAttribLocation(GLuint program, const GLchar* name)
+{
+	record(ePVRTNull_glGetAttribLocation) << program;
+	return location(g_sNull.mAttribs, program, name);
+}
+
+GL_APICALL void GL_APIENTRY glGetIntegerv(GLenum pname, GLint* data);
+
+GL_APICALL void GL_APIENTRY glGetBooleanv(GLenum pname, GLboolean* data)
+{
+	record(ePVRTNull_glGetBooleanv) << pname;
+	int i32Cap = SNullGLES2::capIndex(pname);
+	if(i32Cap >= 0)
+	{
+		*data = g_sNull.abCaps[i32Cap];
+	}
+	else if(pname == GL_DEPTH_WRITEMASK)
+	{
+		*data = g_sNull.bDepthMask;
+	}
+	else
+	{
+		GLint i32Value = 0;
+		glGetIntegerv(pname, &i32Value);
+		*data = i32Value ? GL_TRUE : GL_FALSE;
+	}
+}
+
+GL_APICALL void GL_APIENTRY glGetBufferParameteriv(GLenum target, GLenum pname, GLint* params)
+{
+	record(ePVRTNull_glGetBufferParameteriv) << target << pname;
+	*params = 0;
+}
+
+GL_APICALL GLenum GL_APIENTRY glGetError(void)
+{
+	record(ePVRTNull_glGetError);
+	GLenum eError = g_sNull.eError;
+	g_sNull.eError = GL_NO_ERROR;
+	return eError;
+}
+
+GL_APICALL void GL_APIENTRY glGetFloatv(GLenum pname, GLfloat* data)
+{
+	record(ePVRTNull_glGetFloatv) << pname;
+	switch(pname)
+	{
+	case GL_COLOR_CLEAR_VALUE:
+		memcpy(data, g_sNull.afClearColor, sizeof(g_sNull.afClearColor));
+		break;
+	case GL_ALIASED_LINE_WIDTH_RANGE:
+	case GL_ALIASED_POINT_SIZE_RANGE:
+		data[0] = 1.0f;
+		data[1] = 64.0f;
+		break;
+	default:
+		data[0] = 0.0f;
+		break;
+	}
+}
+
+GL_APICALL void GL_APIENTRY glGetFramebufferAttachmentParameteriv(GLenum target, GLenum attachment, GLenum pname, GLint* params)
+{
+	record(ePVRTNull_glGetFramebufferAttachmentParameteriv) << target << attachment << pname;
+	*params = 0;
+}
+
+GL_APICALL void GL_APIENTRY glGetIntegerv(GLenum pname, GLint* data)
+{
+	record(ePVRTNull_glGetIntegerv) << pname;
+	switch(pname)
+	{
+	case GL_ACTIVE_TEXTURE:						*data = GL_TEXTURE0 + g_sNull.uiActiveUnit; break;
+	case GL_ARRAY_BUFFER_BINDING:				*data = g_sNull.uiArrayBuffer; break;
+	case GL_ELEMENT_ARRAY_BUFFER_BINDING:		*data = g_sNull.uiElementBuffer; break;
+	case GL_CURRENT_PROGRAM:					*data = g_sNull.uiProgram; break;
+	case GL_FRAMEBUFFER_BINDING:				*data = g_sNull.uiFramebuffer; break;
+	case GL_RENDERBUFFER_BINDING:				*data = g_sNull.uiRenderbuffer; break;
+	case GL_VERTEX_ARRAY_BINDING_OES:			*data = g_sNull.uiVertexArray; break;
+	case GL_TEXTURE_BINDING_2D:					*data = g_sNull.auiTextures[g_sNull.uiActiveUnit][0]; break;
+	case GL_TEXTURE_BINDING_CUBE_MAP:			*data = g_sNull.auiTextures[g_sNull.uiActiveUnit][1]; break;
+	case GL_CULL_FACE_MODE:						*data = g_sNull.eCullFace; break;
+	case GL_FRONT_FACE:							*data = g_sNull.eFrontFace; break;
+	case GL_DEPTH_FUNC:							*data = g_sNull.eDepthFunc; break;
+	case GL_BLEND_SRC_RGB:
+	case GL_BLEND_SRC_ALPHA:					*data = g_sNull.eBlendSrc; break;
+	case GL_BLEND_DST_RGB:
+	case GL_BLEND_DST_ALPHA:					*data = g_sNull.eBlendDst; break;
+	case GL_VIEWPORT:							memcpy(data, g_sNull.ai32Viewport, sizeof(g_sNull.ai32Viewport)); break;
+	case GL_SCISSOR_BOX:						memcpy(data, g_sNull.ai32Scissor, sizeof(g_sNull.ai32Scissor)); break;
+	case GL_MAX_VIEWPORT_DIMS:					data[0] = data[1] = 4096; break;
+	case GL_MAX_TEXTURE_SIZE:
+	case GL_MAX_RENDERBUFFER_SIZE:				*data = 4096; break;
+	case GL_MAX_CUBE_MAP_TEXTURE_SIZE:			*data = 2048; break;
+	case GL_MAX_VERTEX_ATTRIBS:					*data = NULLGLES2_MAX_ATTRIBS; break;
+	case GL_MAX_VERTEX_UNIFORM_VECTORS:			*data = 256; break;
+	case GL_MAX_FRAGMENT_UNIFORM_VECTORS:		*data = 64; break;
+	case GL_MAX_VARYING_VECTORS:				*data = 8; break;
+	case GL_MAX_TEXTURE_IMAGE_UNITS:
+	case GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS:		*data = 8; break;
+	case GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS:	*data = 16; break;
+	case GL_RED_BITS: case GL_GREEN_BITS: case GL_BLUE_BITS: case GL_ALPHA_BITS:	*data = 8; break;
+	case GL_DEPTH_BITS:							*data = 24; break;
+	case GL_STENCIL_BITS:						*data = 8; break;
+	case GL_SAMPLES:							*data = 0; break;
+	case GL_NUM_SHADER_BINARY_FORMATS:
+	case GL_NUM_COMPRESSED_TEXTURE_FORMATS:		*data = 0; break;
+	default:
+	{
+		int i32Cap = SNullGLES2::capIndex(pname);
+		*data = i32Cap >= 0 ? g_sNull.abCaps[i32Cap] : 0;
+		break;
+	}
+	}
+}
+
+GL_APICALL void GL_APIENTRY glGetProgramiv(GLuint program, GLenum pname, GLint* params)
+{
+	record(ePVRTNull_glGetProgramiv) << program << pname;
+	switch(pname)
+	{
+	case GL_LINK_STATUS:
+	case GL_VALIDATE_STATUS:		*params = g_sNull.Is(eNullProgram, program) ? GL_TRUE : GL_FALSE; break;
+	case GL_INFO_LOG_LENGTH:		*params = 1; break;
+	case GL_ACTIVE_UNIFORMS:		*params = (GLint)g_sNull.mUniforms[program].size(); break;
+	case GL_ACTIVE_ATTRIBUTES:		*params = (GLint)g_sNull.mAttribs[program].size(); break;
+	default:						*params = 0; break;
+	}
+}
+
+GL_APICALL void GL_APIENTRY glGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+{
+	record(ePVRTNull_glGetProgramInfoLog) << program;
+	copyString("", bufSize, length, infoLog);
+}
+
+GL_APICALL void GL_APIENTRY glGetRenderbufferParameteriv(GLenum target, GLenum pname, GLint* params)
+{
+	record(ePVRTNull_glGetRenderbufferParameteriv) << target << pname;
+	*params = 0;
+}
+
+GL_APICALL void GL_APIENTRY glGetShaderiv(GLuint shader, GLenum pname, GLint* params)
+{
+	record(ePVRTNull_glGetShaderiv) << shader << pname;
+	switch(pname)
+	{
+	case GL_COMPILE_STATUS:			*params = g_sNull.Is(eNullShader, shader) ? GL_TRUE : GL_FALSE; break;
+	case GL_INFO_LOG_LENGTH:		*params = 1; break;
+	default:						*params = 0; break;
+	}
+}
+
+GL_APICALL void GL_APIENTRY glGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+{
+	record(ePVRTNull_glGetShaderInfoLog) << shader;
+	copyString("", bufSize, length, infoLog);
+}
+
+GL_APICALL void GL_APIENTRY glGetShaderPrecisionFormat(GLenum shadertype, GLenum precisiontype, GLint* range, GLint* precision)
+{
+	record(ePVRTNull_glGetShaderPrecisionFormat) << shadertype << precisiontype;
+	// IEEE single precision for every type
+	range[0] = range[1] = 127;
+	*precision = 23;
+}
+
+GL_APICALL void GL_APIENTRY glGetShaderSource(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* source)
+{
+	record(ePVRTNull_glGetShaderSource) << shader;
+	copyString("", bufSize, length, source);
+}
+
+GL_APICALL const GLubyte* GL_APIENTRY glGetString(GLenum name)
+{
+	record(ePVRTNull_glGetString) << name;
+	switch(name)
+	{
+	case GL_VENDOR:						return (const GLubyte*)"Imagination Technologies";
+	case GL_RENDERER:					return (const GLubyte*)"PVRTNullGLES2";
+	case GL_VERSION:					return (const GLubyte*)"OpenGL ES 2.0 PVRTNullGLES2";
+	case GL_SHADING_LANGUAGE_VERSION:	return (const GLubyte*)"OpenGL ES GLSL ES 1.00";
+	case GL_EXTENSIONS:					return (const GLubyte*)c_szExtensions;
+	default:
+		g_sNull.eError = GL_INVALID_ENUM;
+		return NULL;
+	}
+}
+
+GL_APICALL void GL_APIENTRY glGetTexParameterfv(GLenum target, GLenum pname, GLfloat* params)
+{
+	record(ePVRTNull_glGetTexParameterfv) << target << pname;
+	*params = 0.0f;
+}
+
+GL_APICALL void GL_APIENTRY glGetTexParameteriv(GLenum target, GLenum pname, GLint* params)
+{
+	record(ePVRTNull_glGetTexParameteriv) << target << pname;
+	*params = 0;
+}
+
+GL_APICALL void GL_APIENTRY glGetUniformfv(GLuint program, GLint location, GLfloat* params)
+{
+	record(ePVRTNull_glGetUniformfv) << program << location;
+	*params = 0.0f;
+}
+
+GL_APICALL void GL_APIENTRY glGetUniformiv(GLuint program, GLint location, GLint* params)
+{
+	record(ePVRTNull_glGetUniformiv) << program << location;
+	*params = 0;
+}
+
+GL_APICALL GLint GL_APIENTRY glGetUniformLocation(GLuint program, const GLchar* name)
+{
+	record(ePVRTNull_glGetUniformLocation) << program;
+	return location(g_sNull.mUniforms, program, name);
+}
+
+GL_APICALL void GL_APIENTRY glGetVertexAttribfv(GLuint index, GLenum pname, GLfloat* params)
+{
+	record(ePVRTNull_glGetVertexAttribfv) << index << pname;
+	*params = 0.0f;
+}
+
+GL_APICALL void GL_APIENTRY glGetVertexAttribiv(GLuint index, GLenum pname, GLint* params)
+{
+	record(ePVRTNull_glGetVertexAttribiv) << index << pname;
+	*params = 0;
+}
+
+GL_APICALL void GL_APIENTRY glGetVertexAttribPointerv(GLuint index, GLenum pname, void** pointer)
+{
+	record(ePVRTNull_glGetVertexAttribPointerv) << index << pname;
+	*pointer = NULL;
+}
+
+GL_APICALL void GL_APIENTRY glHint(GLenum target, GLenum mode)
+{
+	record(ePVRTNull_glHint) << target << mode;
+}
+
+GL_APICALL GLboolean GL_APIENTRY glIsBuffer(GLuint buffer)
+{
+	record(ePVRTNull_glIsBuffer) << buffer;
+	return g_sNull.Is(eNullBuffer, buffer) ? GL_TRUE : GL_FALSE;
+}
+
+GL_APICALL GLboolean GL_APIENTRY glIsEnabled(GLenum cap)
+{
+	record(ePVRTNull_glIsEnabled) << cap;
+	int i32Cap = SNullGLES2::capIndex(cap);
+	return i32Cap >= 0 ? g_sNull.abCaps[i32Cap] : GL_FALSE;
+}
+
+GL_APICALL GLboolean GL_APIENTRY glIsFramebuffer(GLuint framebuffer)
+{
+	record(ePVRTNull_glIsFramebuffer) << framebuffer;
+	return g_sNull.Is(eNullFramebuffer, framebuffer) ? GL_TRUE : GL_FALSE;
+}
+
+GL_APICALL GLboolean GL_APIENTRY glIsProgram(GLuint program)
+{
+	record(ePVRTNull_glIsProgram) << program;
+	return g_sNull.Is(eNullProgram, program) ? GL_TRUE : GL_FALSE;
+}
+
+GL_APICALL GLboolean GL_APIENTRY glIsRenderbuffer(GLuint renderbuffer)
+{
+	record(ePVRTNull_glIsRenderbuffer) << renderbuffer;
+	return g_sNull.Is(eNullRenderbuffer, renderbuffer) ? GL_TRUE : GL_FALSE;
+}
+
+GL_APICALL GLboolean GL_APIENTRY glIsShader(GLuint shader)
+{
+	record(ePVRTNull_glIsShader) << shader;
+	return g_sNull.Is(eNullShader, shader) ? GL_TRUE : GL_FALSE;
+}
+
+GL_APICALL GLboolean GL_APIENTRY glIsTexture(GLuint texture)
+{
+	record(ePVRTNull_glIsTexture) << texture;
+	return g_sNull.Is(eNullTexture, texture) ? GL_TRUE : GL_FALSE;
+}
+
+GL_APICALL void GL_APIENTRY glLineWidth(GLfloat width)
+{
+	record(ePVRTNull_glLineWidth) << width;
+}
+
+GL_APICALL void GL_APIENTRY glLinkProgram(GLuint program)
+{
+	record(ePVRTNull_glLinkProgram) << program;
+}
+
+GL_APICALL void GL_APIENTRY glPixelStorei(GLenum pname, GLint param)
+{
+	record(ePVRTNull_glPixelStorei) << pname << param;
+}
+
+GL_APICALL void GL_APIENTRY glPolygonOffset(GLfloat factor, GLfloat units)
+{
+	record(ePVRTNull_glPolygonOffset) << factor << units;
+}
+
+GL_APICALL void GL_APIENTRY glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels)
+{
+	record(ePVRTNull_glReadPixels) << x << y << width << height << format << type;
+	PVRTuint64 ui64Bytes = pixelBytes(width, height, format, type);
+	if(pixels)
+		memset(pixels, 0, (size_t)ui64Bytes);
+	g_sNull.Add(&SPVRTNullGLES2Counters::ui64ReadBytes, ui64Bytes);
+}
+
+GL_APICALL void GL_APIENTRY glReleaseShaderCompiler(void)
+{
+	record(ePVRTNull_glReleaseShaderCompiler);
+}
+
+GL_APICALL void GL_APIENTRY glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height)
+{
+	record(ePVRTNull_glRenderbufferStorage) << target << internalformat << width << height;
+}
+
+GL_APICALL void GL_APIENTRY glSampleCoverage(GLfloat value, GLboolean invert)
+{
+	record(ePVRTNull_glSampleCoverage) << value << invert;
+}
+
+GL_APICALL void GL_APIENTRY glScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	record(ePVRTNull_glScissor) << x << y << width << height;
+	g_sNull.ai32Scissor[0] = x;
+	g_sNull.ai32Scissor[1] = y;
+	g_sNull.ai32Scissor[2] = width;
+	g_sNull.ai32Scissor[3] = height;
+}
+
+GL_APICALL void GL_APIENTRY glShaderBinary(GLsizei count, const GLuint* shaders, GLenum binaryformat, const void* binary, GLsizei length)
+{
+	record(ePVRTNull_glShaderBinary) << count << binaryformat << length;
+	// no binary formats are advertised
+	g_sNull.eError = GL_INVALID_ENUM;
+}
+
+GL_APICALL void GL_APIENTRY glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length)
+{
+	record(ePVRTNull_glShaderSource) << shader << count;
+}
+
+GL_APICALL void GL_APIENTRY glStencilFunc(GLenum func, GLint ref, GLuint mask)
+{
+	record(ePVRTNull_glStencilFunc) << func << ref << mask;
+}
+
+GL_APICALL void GL_APIENTRY glStencilFuncSeparate(GLenum face, GLenum func, GLint ref, GLuint mask)
+{
+	record(ePVRTNull_glStencilFuncSeparate) << face << func << ref << mask;
+}
+
+GL_APICALL void GL_APIENTRY glStencilMask(GLuint mask)
+{
+	record(ePVRTNull_glStencilMask) << mask;
+}
+
+GL_APICALL void GL_APIENTRY glStencilMaskSeparate(GLenum face, GLuint mask)
+{
+	record(ePVRTNull_glStencilMaskSeparate) << face << mask;
+}
+
+GL_APICALL void GL_APIENTRY glStencilOp(GLenum fail, GLenum zfail, GLenum zpass)
+{
+	record(ePVRTNull_glStencilOp) << fail << zfail << zpass;
+}
+
+GL_APICALL void GL_APIENTRY glStencilOpSeparate(GLenum face, GLenum sfail, GLenum dpfail, GLenum dppass)
+{
+	record(ePVRTNull_glStencilOpSeparate) << face << sfail << dpfail << dppass;
+}
+
+GL_APICALL void GL_APIENTRY glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels)
+{
+	record(ePVRTNull_glTexImage2D) << target << level << internalformat << width << height << border << format << type;
+	if(pixels)
+		g_sNull.Add(&SPVRTNullGLES2Counters::ui64TextureBytes, pixelBytes(width, height, format, type));
+}
+
+GL_APICALL void GL_APIENTRY glTexParameterf(GLenum target, GLenum pname, GLfloat param)
+{
+	record(ePVRTNull_glTexParameterf) << target << pname << param;
+}
+
+GL_APICALL void GL_APIENTRY glTexParameterfv(GLenum target, GLenum pname, const GLfloat* params)
+{
+	record(ePVRTNull_glTexParameterfv) << target << pname << params[0];
+}
+
+GL_APICALL void GL_APIENTRY glTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+	record(ePVRTNull_glTexParameteri) << target << pname << param;
+}
+
+GL_APICALL void GL_APIENTRY glTexParameteriv(GLenum target, GLenum pname, const GLint* params)
+{
+	record(ePVRTNull_glTexParameteriv) << target << pname << params[0];
+}
+
+GL_APICALL void GL_APIENTRY glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+	record(ePVRTNull_glTexSubImage2D) << target << level << xoffset << yoffset << width << height << format << type;
+	if(pixels)
+		g_sNull.Add(&SPVRTNullGLES2Counters::ui64TextureBytes, pixelBytes(width, height, format, type));
+}
+
+GL_APICALL void GL_APIENTRY glUniform1f(GLint location, GLfloat v0)
+{
+	record(ePVRTNull_glUniform1f) << location << v0;
+	uniformBytes(1, 4);
+}
+
+GL_APICALL void GL_APIENTRY glUniform1fv(GLint location, GLsizei count, const GLfloat* value)
+{
+	record(ePVRTNull_glUniform1fv) << location << count;
+	uniformBytes(count, 4);
+}
+
+GL_APICALL void GL_APIENTRY glUniform1i(GLint location, GLint v0)
+{
+	record(ePVRTNull_glUniform1i) << location << v0;
+	uniformBytes(1, 4);
+}
+
+GL_APICALL void GL_APIENTRY glUniform1iv(GLint location, GLsizei count, const GLint* value)
+{
+	record(ePVRTNull_glUniform1iv) << location << count;
+	uniformBytes(count, 4);
+}
+
+GL_APICALL void GL_APIENTRY glUniform2f(GLint location, GLfloat v0, GLfloat v1)
+{
+	record(ePVRTNull_glUniform2f) << location << v0 << v1;
+	uniformBytes(1, 8);
+}
+
+GL_APICALL void GL_APIENTRY glUniform2fv(GLint location, GLsizei count, const GLfloat* value)
+{
+	record(ePVRTNull_glUniform2fv) << location << count;
+	uniformBytes(count, 8);
+}
+
+GL_APICALL void GL_APIENTRY glUniform2i(GLint location, GLint v0, GLint v1)
+{
+	record(ePVRTNull_glUniform2i) << location << v0 << v1;
+	uniformBytes(1, 8);
+}
+
+GL_APICALL void GL_APIENTRY glUniform2iv(GLint location, GLsizei count, const GLint* value)
+{
+	record(ePVRTNull_glUniform2iv) << location << count;
+	uniformBytes(count, 8);
+}
+
+GL_APICALL void GL_APIENTRY glUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+{
+	record(ePVRTNull_glUniform3f) << location << v0 << v1 << v2;
+	uniformBytes(1, 12);
+}
+
+GL_APICALL void GL_APIENTRY glUniform3fv(GLint location, GLsizei count, const GLfloat* value)
+{
+	record(ePVRTNull_glUniform3fv) << location << count;
+	uniformBytes(count, 12);
+}
+
+GL_APICALL void GL_APIENTRY glUniform3i(GLint location, GLint v0, GLint v1, GLint v2)
+{
+	record(ePVRTNull_glUniform3i) << location << v0 << v1 << v2;
+	uniformBytes(1, 12);
+}
+
+GL_APICALL void GL_APIENTRY glUniform3iv(GLint location, GLsizei count, const GLint* value)
+{
+	record(ePVRTNull_glUniform3iv) << location << count;
+	uniformBytes(count, 12);
+}
+
+GL_APICALL void GL_APIENTRY glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+{
+	record(ePVRTNull_glUniform4f) << location << v0 << v1 << v2 << v3;
+	uniformBytes(1, 16);
+}
+
+GL_APICALL void GL_APIENTRY glUniform4fv(GLint location, GLsizei count, const GLfloat* value)
+{
+	record(ePVRTNull_glUniform4fv) << location << count;
+	uniformBytes(count, 16);
+}
+
+GL_APICALL void GL_APIENTRY glUniform4i(GLint location, GLint v0, GLint v1, GLint v2, GLint v3)
+{
+	record(ePVRTNull_glUniform4i) << location << v0 << v1 << v2 << v3;
+	uniformBytes(1, 16);
+}
+
+GL_APICALL void GL_APIENTRY glUniform4iv(GLint location, GLsizei count, const GLint* value)
+{
+	record(ePVRTNull_glUniform4iv) << location << count;
+	uniformBytes(count, 16);
+}
+
+GL_APICALL void GL_APIENTRY glUniformMatrix2fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+	record(ePVRTNull_glUniformMatrix2fv) << location << count << transpose;
+	uniformBytes(count, 16);
+}
+
+GL_APICALL void GL_APIENTRY glUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+	record(ePVRTNull_glUniformMatrix3fv) << location << count << transpose;
+	uniformBytes(count, 36);
+}
+
+GL_APICALL void GL_APIENTRY glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+	record(ePVRTNull_glUniformMatrix4fv) << location << count << transpose;
+	uniformBytes(count, 64);
+}
+
+GL_APICALL void GL_APIENTRY glUseProgram(GLuint program)
+{
+	record(ePVRTNull_glUseProgram) << program;
+	g_sNull.uiProgram = program;
+}
+
+GL_APICALL void GL_APIENTRY glValidateProgram(GLuint program)
+{
+	record(ePVRTNull_glValidateProgram) << program;
+}
+
+GL_APICALL void GL_APIENTRY glVertexAttrib1f(GLuint index, GLfloat x)
+{
+	record(ePVRTNull_glVertexAttrib1f) << index << x;
+}
+
+GL_APICALL void GL_APIENTRY glVertexAttrib1fv(GLuint index, const GLfloat* v)
+{
+	record(ePVRTNull_glVertexAttrib1fv) << index << v[0];
+}
+
+GL_APICALL void GL_APIENTRY glVertexAttrib2f(GLuint index, GLfloat x, GLfloat y)
+{
+	record(ePVRTNull_glVertexAttrib2f) << index << x << y;
+}
+
+GL_APICALL void GL_APIENTRY glVertexAttrib2fv(GLuint index, const GLfloat* v)
+{
+	record(ePVRTNull_glVertexAttrib2fv) << index << v[0] << v[1];
+}
+
+GL_APICALL void GL_APIENTRY glVertexAttrib3f(GLuint index, GLfloat x, GLfloat y, GLfloat z)
+{
+	record(ePVRTNull_glVertexAttrib3f) << index << x << y << z;
+}
+
+GL_APICALL void GL_APIENTRY glVertexAttrib3fv(GLuint index, const GLfloat* v)
+{
+	record(ePVRTNull_glVertexAttrib3fv) << index << v[0] << v[1] << v[2];
+}
+
+GL_APICALL void GL_APIENTRY glVertexAttrib4f(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+	record(ePVRTNull_glVertexAttrib4f) << index << x << y << z << w;
+}
+
+GL_APICALL void GL_APIENTRY glVertexAttrib4fv(GLuint index, const GLfloat* v)
+{
+	record(ePVRTNull_glVertexAttrib4fv) << index << v[0] << v[1] << v[2] << v[3];
+}
+
+GL_APICALL void GL_APIENTRY glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer)
+{
+	// client side arrays are recorded with their address truncated, buffer offsets exactly
+	record(ePVRTNull_glVertexAttribPointer) << index << size << type << normalized << stride << (GLuint)(size_t)pointer;
+}
+
+GL_APICALL void GL_APIENTRY glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	record(ePVRTNull_glViewport) << x << y << width << height;
+	g_sNull.ai32Viewport[0] = x;
+	g_sNull.ai32Viewport[1] = y;
+	g_sNull.ai32Viewport[2] = width;
+	g_sNull.ai32Viewport[3] = height;
+}
+
+} // extern "C"
+
+/****************************************************************************
+** Extensions, handed out by eglGetProcAddress
+****************************************************************************/
+static void GL_APIENTRY nullDrawElementsInstancedEXT(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei primcount)
+{
+	record(ePVRTNull_glDrawElementsInstancedEXT) << mode << count << type << (GLuint)(size_t)indices << primcount;
+	g_sNull.Draw((PVRTuint64)count * primcount);
+}
+
+static void GL_APIENTRY nullVertexAttribDivisorEXT(GLuint index, GLuint divisor)
+{
+	record(ePVRTNull_glVertexAttribDivisorEXT) << index << divisor;
+}
+
+static void GL_APIENTRY nullDiscardFramebufferEXT(GLenum target, GLsizei numAttachments, const GLenum* attachments)
+{
+	record(ePVRTNull_glDiscardFramebufferEXT) << target << numAttachments;
+}
+
+static void GL_APIENTRY nullBindVertexArrayOES(GLuint array)
+{
+	record(ePVRTNull_glBindVertexArrayOES) << array;
+	// the element buffer binding is the only vertex array state the queries answer from
+	g_sNull.mElementBuffers[g_sNull.uiVertexArray] = g_sNull.uiElementBuffer;
+	g_sNull.uiVertexArray = array;
+	g_sNull.uiElementBuffer = g_sNull.mElementBuffers[array];
+}
+
+static void GL_APIENTRY nullDeleteVertexArraysOES(GLsizei n, const GLuint* arrays)
+{
+	record(ePVRTNull_glDeleteVertexArraysOES) << n;
+	for(GLsizei i = 0; i < n; ++i)
+	{
+		if(!g_sNull.Is(eNullVertexArray, arrays[i]))
+			continue;
+		if(arrays[i] == g_sNull.uiVertexArray)
+			nullBindVertexArrayOES(0);
+		g_sNull.Delete(eNullVertexArray, arrays[i]);
+		g_sNull.mElementBuffers.erase(arrays[i]);
+	}
+}
+
+static void GL_APIENTRY nullGenVertexArraysOES(GLsizei n, GLuint* arrays)
+{
+	generate(ePVRTNull_glGenVertexArraysOES, eNullVertexArray, n, arrays);
+}
+
+static GLboolean GL_APIENTRY nullIsVertexArrayOES(GLuint array)
+{
+	record(ePVRTNull_glIsVertexArrayOES) << array;
+	return g_sNull.Is(eNullVertexArray, array) ? GL_TRUE : GL_FALSE;
+}
+
+/****************************************************************************
+** EGL
+****************************************************************************/
+// The handles only need to be different from the EGL_NO_* values
+#define NULLEGL_DISPLAY		((EGLDisplay)1)
+#define NULLEGL_CONFIG		((EGLConfig)1)
+#define NULLEGL_CONTEXT		((EGLContext)1)
+#define NULLEGL_SURFACE		((EGLSurface)1)
+
+static EGLBoolean eglFail(EGLint i32Error)
+{
+	g_sNull.i32EGLError = i32Error;
+	return EGL_FALSE;
+}
+
+extern "C" {
+
+EGLAPI EGLint EGLAPIENTRY eglGetError(void)
+{
+	EGLint i32Error = g_sNull.i32EGLError;
+	g_sNull.i32EGLError = EGL_SUCCESS;
+	return i32Error;
+}
+
+EGLAPI EGLDisplay EGLAPIENTRY eglGetDisplay(EGLNativeDisplayType display_id)
+{
+	return NULLEGL_DISPLAY;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglInitialize(EGLDisplay dpy, EGLint* major, EGLint* minor)
+{
+	if(dpy != NULLEGL_DISPLAY)
+		return eglFail(EGL_BAD_DISPLAY);
+	if(major) *major = 1;
+	if(minor) *minor = 4;
+	return EGL_TRUE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglTerminate(EGLDisplay dpy)
+{
+	PVRTNullGLES2Report(stdout);
+	return EGL_TRUE;
+}
+
+EGLAPI const char* EGLAPIENTRY eglQueryString(EGLDisplay dpy, EGLint name)
+{
+	switch(name)
+	{
+	case EGL_VENDOR:		return "Imagination Technologies";
+	case EGL_VERSION:		return "1.4 PVRTNullGLES2";
+	case EGL_EXTENSIONS:	return "";
+	case EGL_CLIENT_APIS:	return "OpenGL_ES";
+	default:				eglFail(EGL_BAD_PARAMETER); return NULL;
+	}
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglGetConfigs(EGLDisplay dpy, EGLConfig* configs, EGLint config_size, EGLint* num_config)
+{
+	if(configs && config_size > 0)
+		configs[0] = NULLEGL_CONFIG;
+	*num_config = 1;
+	return EGL_TRUE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglChooseConfig(EGLDisplay dpy, const EGLint* attrib_list, EGLConfig* configs, EGLint config_size, EGLint* num_config)
+{
+	// the one config has whatever is asked for
+	return eglGetConfigs(dpy, configs, config_size, num_config);
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglGetConfigAttrib(EGLDisplay dpy, EGLConfig config, EGLint attribute, EGLint* value)
+{
+	switch(attribute)
+	{
+	case EGL_CONFIG_ID:			*value = 1; break;
+	case EGL_BUFFER_SIZE:		*value = 32; break;
+	case EGL_RED_SIZE:
+	case EGL_GREEN_SIZE:
+	case EGL_BLUE_SIZE:
+	case EGL_ALPHA_SIZE:		*value = 8; break;
+	case EGL_DEPTH_SIZE:		*value = 24; break;
+	case EGL_STENCIL_SIZE:		*value = 8; break;
+	case EGL_SURFACE_TYPE:		*value = EGL_WINDOW_BIT | EGL_PBUFFER_BIT | EGL_PIXMAP_BIT; break;
+	case EGL_RENDERABLE_TYPE:	*value = EGL_OPENGL_ES2_BIT; break;
+	default:					*value = 0; break;
+	}
+	return EGL_TRUE;
+}
+
+/*!***************************************************************************
+ @Function		eglCreateWindowSurface
+ @Description	The surface is PVRTNULLGLES2_WIDTH by PVRTNULLGLES2_HEIGHT
+				unless attrib_list has EGL_WIDTH and EGL_HEIGHT, which real
+				window surfaces do not take.
+*****************************************************************************/
+EGLAPI EGLSurface EGLAPIENTRY eglCreateWindowSurface(EGLDisplay dpy, EGLConfig config, EGLNativeWindowType win, const EGLint* attrib_list)
+{
+	for(int i = 0; attrib_list && attrib_list[i] != EGL_NONE; i += 2)
+	{
+		if(attrib_list[i] == EGL_WIDTH && attrib_list[i + 1] > 0)
+			g_sNull.i32Width = attrib_list[i + 1];
+		else if(attrib_list[i] == EGL_HEIGHT && attrib_list[i + 1] > 0)
+			g_sNull.i32Height = attrib_list[i + 1];
+	}
+	return NULLEGL_SURFACE;
+}
+
+EGLAPI EGLSurface EGLAPIENTRY eglCreatePbufferSurface(EGLDisplay dpy, EGLConfig config, const EGLint* attrib_list)
+{
+	return eglCreateWindowSurface(dpy, config, 0, attrib_list);
+}
+
+EGLAPI EGLSurface EGLAPIENTRY eglCreatePixmapSurface(EGLDisplay dpy, EGLConfig config, EGLNativePixmapType pixmap, const EGLint* attrib_list)
+{
+	return eglCreateWindowSurface(dpy, config, 0, attrib_list);
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglDestroySurface(EGLDisplay dpy, EGLSurface surface)
+{
+	return EGL_TRUE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglQuerySurface(EGLDisplay dpy, EGLSurface surface, EGLint attribute, EGLint* value)
+{
+	if(surface != NULLEGL_SURFACE)
+		return eglFail(EGL_BAD_SURFACE);
+
+	switch(attribute)
+	{
+	case EGL_WIDTH:			*value = g_sNull.i32Width; break;
+	case EGL_HEIGHT:		*value = g_sNull.i32Height; break;
+	case EGL_CONFIG_ID:		*value = 1; break;
+	default:				*value = 0; break;
+	}
+	return EGL_TRUE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglBindAPI(EGLenum api)
+{
+	return api == EGL_OPENGL_ES_API ? EGL_TRUE : eglFail(EGL_BAD_PARAMETER);
+}
+
+EGLAPI EGLenum EGLAPIENTRY eglQueryAPI(void)
+{
+	return EGL_OPENGL_ES_API;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglWaitClient(void)
+{
+	return EGL_TRUE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglReleaseThread(void)
+{
+	return EGL_TRUE;
+}
+
+EGLAPI EGLSurface EGLAPIENTRY eglCreatePbufferFromClientBuffer(EGLDisplay dpy, EGLenum buftype, EGLClientBuffer buffer, EGLConfig config, const EGLint* attrib_list)
+{
+	eglFail(EGL_BAD_PARAMETER);
+	return EGL_NO_SURFACE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglSurfaceAttrib(EGLDisplay dpy, EGLSurface surface, EGLint attribute, EGLint value)
+{
+	return EGL_TRUE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglBindTexImage(EGLDisplay dpy, EGLSurface surface, EGLint buffer)
+{
+	return eglFail(EGL_BAD_SURFACE);
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglReleaseTexImage(EGLDisplay dpy, EGLSurface surface, EGLint buffer)
+{
+	return eglFail(EGL_BAD_SURFACE);
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglSwapInterval(EGLDisplay dpy, EGLint interval)
+{
+	return EGL_TRUE;
+}
+
+EGLAPI EGLContext EGLAPIENTRY eglCreateContext(EGLDisplay dpy, EGLConfig config, EGLContext share_context, const EGLint* attrib_list)
+{
+	for(int i = 0; attrib_list && attrib_list[i] != EGL_NONE; i += 2)
+	{
+		if(attrib_list[i] == EGL_CONTEXT_CLIENT_VERSION && attrib_list[i + 1] != 2)
+		{
+			eglFail(EGL_BAD_CONFIG);
+			return EGL_NO_CONTEXT;
+		}
+	}
+	return NULLEGL_CONTEXT;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglDestroyContext(EGLDisplay dpy, EGLContext ctx)
+{
+	if(ctx == NULLEGL_CONTEXT)
+		g_sNull.ResetState();
+	return EGL_TRUE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglMakeCurrent(EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx)
+{
+	bool bWasCurrent = g_sNull.bCurrent;
+	g_sNull.bCurrent = ctx == NULLEGL_CONTEXT;
+	// a new context starts with the viewport covering the surface
+	if(g_sNull.bCurrent && !bWasCurrent)
+	{
+		g_sNull.ai32Viewport[2] = g_sNull.ai32Scissor[2] = g_sNull.i32Width;
+		g_sNull.ai32Viewport[3] = g_sNull.ai32Scissor[3] = g_sNull.i32Height;
+	}
+	return EGL_TRUE;
+}
+
+EGLAPI EGLContext EGLAPIENTRY eglGetCurrentContext(void)
+{
+	return g_sNull.bCurrent ? NULLEGL_CONTEXT : EGL_NO_CONTEXT;
+}
+
+EGLAPI EGLSurface EGLAPIENTRY eglGetCurrentSurface(EGLint readdraw)
+{
+	return g_sNull.bCurrent ? NULLEGL_SURFACE : EGL_NO_SURFACE;
+}
+
+EGLAPI EGLDisplay EGLAPIENTRY eglGetCurrentDisplay(void)
+{
+	return g_sNull.bCurrent ? NULLEGL_DISPLAY : EGL_NO_DISPLAY;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglQueryContext(EGLDisplay dpy, EGLContext ctx, EGLint attribute, EGLint* value)
+{
+	switch(attribute)
+	{
+	case EGL_CONFIG_ID:					*value = 1; break;
+	case EGL_CONTEXT_CLIENT_TYPE:		*value = EGL_OPENGL_ES_API; break;
+	case EGL_CONTEXT_CLIENT_VERSION:	*value = 2; break;
+	case EGL_RENDER_BUFFER:				*value = EGL_BACK_BUFFER; break;
+	default:							*value = 0; break;
+	}
+	return EGL_TRUE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglWaitGL(void)
+{
+	return EGL_TRUE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglWaitNative(EGLint engine)
+{
+	return EGL_TRUE;
+}
+
+/*!***************************************************************************
+ @Function		eglSwapBuffers
+ @Description	Ends the frame: its counters and command stream become the
+				last frame's.
+*****************************************************************************/
+EGLAPI EGLBoolean EGLAPIENTRY eglSwapBuffers(EGLDisplay dpy, EGLSurface surface)
+{
+	if(surface != NULLEGL_SURFACE)
+		return eglFail(EGL_BAD_SURFACE);
+
+	record(ePVRTNull_eglSwapBuffers);
+	g_sNull.EndFrame();
+	return EGL_TRUE;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglCopyBuffers(EGLDisplay dpy, EGLSurface surface, EGLNativePixmapType target)
+{
+	return EGL_TRUE;
+}
+
+EGLAPI __eglMustCastToProperFunctionPointerType EGLAPIENTRY eglGetProcAddress(const char* procname)
+{
+	if(!procname)
+		return NULL;
+	if(strcmp(procname, "glDrawElementsInstancedEXT") == 0)
+		return (__eglMustCastToProperFunctionPointerType)nullDrawElementsInstancedEXT;
+	if(strcmp(procname, "glVertexAttribDivisorEXT") == 0)
+		return (__eglMustCastToProperFunctionPointerType)nullVertexAttribDivisorEXT;
+	if(strcmp(procname, "glDiscardFramebufferEXT") == 0)
+		return (__eglMustCastToProperFunctionPointerType)nullDiscardFramebufferEXT;
+	if(strcmp(procname, "glBindVertexArrayOES") == 0)
+		return (__eglMustCastToProperFunctionPointerType)nullBindVertexArrayOES;
+	if(strcmp(procname, "glDeleteVertexArraysOES") == 0)
+		return (__eglMustCastToProperFunctionPointerType)nullDeleteVertexArraysOES;
+	if(strcmp(procname, "glGenVertexArraysOES") == 0)
+		return (__eglMustCastToProperFunctionPointerType)nullGenVertexArraysOES;
+	if(strcmp(procname, "glIsVertexArrayOES") == 0)
+		return (__eglMustCastToProperFunctionPointerType)nullIsVertexArrayOES;
+	return NULL;
+}
+
+} // extern "C"
+
+#endif /* BUILD_NULLGLES2 */
+
+/*****************************************************************************
+ End of file (PVRTNullGLES2.cpp)
+*****************************************************************************/
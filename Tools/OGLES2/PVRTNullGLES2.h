@@ -0,0 +1,172 @@
+/*!****************************************************************************
+
+ @file         OGLES2/PVRTNullGLES2.h
+ @ingroup      API_OGLES2
+ @copyright    Copyright (c) Imagination Technologies Limited.
+ @brief        Recording OpenGL ES 2.0 and EGL implementation without a GPU.
+
+******************************************************************************/
+#ifndef _PVRTNULLGLES2_H_
+#define _PVRTNULLGLES2_H_
+
+/*!
+ @addtogroup API_OGLES2
+ @{
+*/
+
+#include <stdio.h>
+#include "../PVRTGlobal.h"
+
+/*!***************************************************************************
+ @details   Building the tools with BUILD_NULLGLES2 defined compiles
+            PVRTNullGLES2.cpp into them. It defines every OpenGL ES 2.0
+            entry point of gl2.h and the EGL functions PVRShell uses, so the
+            application links against it instead of libGLESv2 and libEGL
+            and runs with any OS shell, LinuxNullWS included, on a machine
+            without a GPU. Nothing is rendered: calls are counted, the bytes
+            they hand to the driver are summed and the calls of the frame are
+            kept as a command stream. Objects get increasing names, shaders
+            always compile and link, queries answer from the state that was
+            set. The counters and the stream roll over at eglSwapBuffers, a
+            report of the run is printed to stdout at eglTerminate.
+
+            The command stream is a list of 32 bit words. Every command is a
+            header word, the EPVRTNullGLES2Call in the low 16 bits and the
+            number of argument words in the high 16, followed by the
+            arguments. Floats are stored as their bits, pointers and strings
+            are not stored.
+*****************************************************************************/
+
+/****************************************************************************
+** Defines
+****************************************************************************/
+#define PVRTNULLGLES2_WIDTH				800			/*!< Window surface size when the shell does not ask for one */
+#define PVRTNULLGLES2_HEIGHT			600
+#define PVRTNULLGLES2_MAX_STREAM_WORDS	(1 << 22)	/*!< Commands of a frame past this are counted but not recorded */
+
+/****************************************************************************
+** Enumerations
+****************************************************************************/
+/*!***************************************************************************
+ @enum      EPVRTNullGLES2Call
+ @brief     Recorded calls, the gl2.h entry points in their order there
+            followed by the extension and EGL calls.
+*****************************************************************************/
+enum EPVRTNullGLES2Call
+{
+	ePVRTNull_glActiveTexture, ePVRTNull_glAttachShader, ePVRTNull_glBindAttribLocation, ePVRTNull_glBindBuffer,
+	ePVRTNull_glBindFramebuffer, ePVRTNull_glBindRenderbuffer, ePVRTNull_glBindTexture, ePVRTNull_glBlendColor,
+	ePVRTNull_glBlendEquation, ePVRTNull_glBlendEquationSeparate, ePVRTNull_glBlendFunc, ePVRTNull_glBlendFuncSeparate,
+	ePVRTNull_glBufferData, ePVRTNull_glBufferSubData, ePVRTNull_glCheckFramebufferStatus, ePVRTNull_glClear,
+	ePVRTNull_glClearColor, ePVRTNull_glClearDepthf, ePVRTNull_glClearStencil, ePVRTNull_glColorMask,
+	ePVRTNull_glCompileShader, ePVRTNull_glCompressedTexImage2D, ePVRTNull_glCompressedTexSubImage2D, ePVRTNull_glCopyTexImage2D,
+	ePVRTNull_glCopyTexSubImage2D, ePVRTNull_glCreateProgram, ePVRTNull_glCreateShader, ePVRTNull_glCullFace,
+	ePVRTNull_glDeleteBuffers, ePVRTNull_glDeleteFramebuffers, ePVRTNull_glDeleteProgram, ePVRTNull_glDeleteRenderbuffers,
+	ePVRTNull_glDeleteShader, ePVRTNull_glDeleteTextures, ePVRTNull_glDepthFunc, ePVRTNull_glDepthMask,
+	ePVRTNull_glDepthRangef, ePVRTNull_glDetachShader, ePVRTNull_glDisable, ePVRTNull_glDisableVertexAttribArray,
+	ePVRTNull_glDrawArrays, ePVRTNull_glDrawElements, ePVRTNull_glEnable, ePVRTNull_glEnableVertexAttribArray,
+	ePVRTNull_glFinish, ePVRTNull_glFlush, ePVRTNull_glFramebufferRenderbuffer, ePVRTNull_glFramebufferTexture2D,
+	ePVRTNull_glFrontFace, ePVRTNull_glGenBuffers, ePVRTNull_glGenerateMipmap, ePVRTNull_glGenFramebuffers,
+	ePVRTNull_glGenRenderbuffers, ePVRTNull_glGenTextures, ePVRTNull_glGetActiveAttrib, ePVRTNull_glGetActiveUniform,
+	ePVRTNull_glGetAttachedShaders, ePVRTNull_glGetAttribLocation, ePVRTNull_glGetBooleanv, ePVRTNull_glGetBufferParameteriv,
+	ePVRTNull_glGetError, ePVRTNull_glGetFloatv, ePVRTNull_glGetFramebufferAttachmentParameteriv, ePVRTNull_glGetIntegerv,
+	ePVRTNull_glGetProgramiv, ePVRTNull_glGetProgramInfoLog, ePVRTNull_glGetRenderbufferParameteriv, ePVRTNull_glGetShaderiv,
+	ePVRTNull_glGetShaderInfoLog, ePVRTNull_glGetShaderPrecisionFormat, ePVRTNull_glGetShaderSource, ePVRTNull_glGetString,
+	ePVRTNull_glGetTexParameterfv, ePVRTNull_glGetTexParameteriv, ePVRTNull_glGetUniformfv, ePVRTNull_glGetUniformiv,
+	ePVRTNull_glGetUniformLocation, ePVRTNull_glGetVertexAttribfv, ePVRTNull_glGetVertexAttribiv, ePVRTNull_glGetVertexAttribPointerv,
+	ePVRTNull_glHint, ePVRTNull_glIsBuffer, ePVRTNull_glIsEnabled, ePVRTNull_glIsFramebuffer,
+	ePVRTNull_glIsProgram, ePVRTNull_glIsRenderbuffer, ePVRTNull_glIsShader, ePVRTNull_glIsTexture,
+	ePVRTNull_glLineWidth, ePVRTNull_glLinkProgram, ePVRTNull_glPixelStorei, ePVRTNull_glPolygonOffset,
+	ePVRTNull_glReadPixels, ePVRTNull_glReleaseShaderCompiler, ePVRTNull_glRenderbufferStorage, ePVRTNull_glSampleCoverage,
+	ePVRTNull_glScissor, ePVRTNull_glShaderBinary, ePVRTNull_glShaderSource, ePVRTNull_glStencilFunc,
+	ePVRTNull_glStencilFuncSeparate, ePVRTNull_glStencilMask, ePVRTNull_glStencilMaskSeparate, ePVRTNull_glStencilOp,
+	ePVRTNull_glStencilOpSeparate, ePVRTNull_glTexImage2D, ePVRTNull_glTexParameterf, ePVRTNull_glTexParameterfv,
+	ePVRTNull_glTexParameteri, ePVRTNull_glTexParameteriv, ePVRTNull_glTexSubImage2D, ePVRTNull_glUniform1f,
+	ePVRTNull_glUniform1fv, ePVRTNull_glUniform1i, ePVRTNull_glUniform1iv, ePVRTNull_glUniform2f,
+	ePVRTNull_glUniform2fv, ePVRTNull_glUniform2i, ePVRTNull_glUniform2iv, ePVRTNull_glUniform3f,
+	ePVRTNull_glUniform3fv, ePVRTNull_glUniform3i, ePVRTNull_glUniform3iv, ePVRTNull_glUniform4f,
+	ePVRTNull_glUniform4fv, ePVRTNull_glUniform4i, ePVRTNull_glUniform4iv, ePVRTNull_glUniformMatrix2fv,
+	ePVRTNull_glUniformMatrix3fv, ePVRTNull_glUniformMatrix4fv, ePVRTNull_glUseProgram, ePVRTNull_glValidateProgram,
+	ePVRTNull_glVertexAttrib1f, ePVRTNull_glVertexAttrib1fv, ePVRTNull_glVertexAttrib2f, ePVRTNull_glVertexAttrib2fv,
+	ePVRTNull_glVertexAttrib3f, ePVRTNull_glVertexAttrib3fv, ePVRTNull_glVertexAttrib4f, ePVRTNull_glVertexAttrib4fv,
+	ePVRTNull_glVertexAttribPointer, ePVRTNull_glViewport,
+
+	ePVRTNull_glDrawElementsInstancedEXT, ePVRTNull_glVertexAttribDivisorEXT, ePVRTNull_glDiscardFramebufferEXT,
+	ePVRTNull_glBindVertexArrayOES, ePVRTNull_glDeleteVertexArraysOES, ePVRTNull_glGenVertexArraysOES, ePVRTNull_glIsVertexArrayOES,
+
+	ePVRTNull_eglSwapBuffers,
+
+	ePVRTNullGLES2NumCalls
+};
+
+/****************************************************************************
+** Structures
+****************************************************************************/
+/*!***************************************************************************
+ @struct    SPVRTNullGLES2Counters
+ @brief     What the application asked of the driver.
+*****************************************************************************/
+struct SPVRTNullGLES2Counters
+{
+	unsigned int	aui32Calls[ePVRTNullGLES2NumCalls];
+	unsigned int	ui32DrawCalls;			/*!< glDrawArrays, glDrawElements and instanced draws */
+	PVRTuint64		ui64Vertices;			/*!< vertices or indices drawn, times the instances */
+	PVRTuint64		ui64BufferBytes;		/*!< glBufferData and glBufferSubData */
+	PVRTuint64		ui64TextureBytes;		/*!< glTexImage2D, glTexSubImage2D and the compressed versions */
+	PVRTuint64		ui64UniformBytes;		/*!< glUniform* */
+	PVRTuint64		ui64ReadBytes;			/*!< glReadPixels */
+
+	unsigned int Calls() const;
+	PVRTuint64 UploadBytes() const;
+	void Reset();
+};
+
+/****************************************************************************
+** Functions
+****************************************************************************/
+/*!***************************************************************************
+ @brief     Counters of all frames so far.
+*****************************************************************************/
+const SPVRTNullGLES2Counters& PVRTNullGLES2Total();
+
+/*!***************************************************************************
+ @brief     Counters of the last frame that was swapped.
+*****************************************************************************/
+const SPVRTNullGLES2Counters& PVRTNullGLES2LastFrame();
+
+/*!***************************************************************************
+ @brief     Number of eglSwapBuffers calls.
+*****************************************************************************/
+unsigned int PVRTNullGLES2Frames();
+
+/*!***************************************************************************
+ @brief     	The command stream of the last frame that was swapped.
+ @param[out]	ui32Words	Number of words in the stream
+ @return		The first word, NULL when the stream is empty
+*****************************************************************************/
+const PVRTuint32* PVRTNullGLES2Commands(unsigned int& ui32Words);
+
+/*!***************************************************************************
+ @brief     Turns keeping the command stream on or off, counting goes on.
+            Recording is on by default.
+*****************************************************************************/
+void PVRTNullGLES2SetRecording(bool bRecord);
+
+/*!***************************************************************************
+ @brief     Name of the entry point of an EPVRTNullGLES2Call.
+*****************************************************************************/
+const char* PVRTNullGLES2CallName(unsigned int ui32Call);
+
+/*!***************************************************************************
+ @brief     Writes the totals, the per frame averages and the calls that
+            were made to pFile.
+*****************************************************************************/
+void PVRTNullGLES2Report(FILE* pFile);
+
+/*! @} */
+
+#endif /* _PVRTNULLGLES2_H_ */
+
+/*****************************************************************************
+ End of file (PVRTNullGLES2.h)
+*****************************************************************************/
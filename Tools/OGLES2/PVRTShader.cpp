@@ -18,6 +18,7 @@
 #include "PVRTShader.h"
 #include "PVRTResourceFile.h"
 #include "PVRTGlobal.h"
+#include "PVRTTrace.h"
 #include <ctype.h>
 #include <string.h>
 
@@ -184,6 +185,7 @@ EPVRTError PVRTShaderLoadFromFile(	const char* const pszBinFile,
 									const char* const* aszDefineArray, GLuint uiDefArraySize)
 {
 	PVRT_UNREFERENCED_PARAMETER(pContext);
+	PVRTTRACE_SCOPE("PVRTShaderLoadFromFile");
 
 	*pReturnError = "";
 
@@ -0,0 +1,435 @@
+/******************************************************************************
+
+ @File         OGLES2/PVRTStateCache.cpp
+
+ @Title        OGLES2/PVRTStateCache
+
+ @Version
+
+ @Copyright    Copyright (c) Imagination Technologies Limited.
+
+ @Platform     Independent
+
+ @Description  Shadow copy of OpenGL ES 2.0 binding and fixed function state
+               that drops redundant calls.
+
+******************************************************************************/
+#include <string.h>
+
+#include "PVRTContext.h"
+#include "PVRTStateCache.h"
+
+/****************************************************************************
+** Local code
+****************************************************************************/
+// Value of a cached name or enum that has not been set since Invalidate
+static const GLuint c_uiUnknown = 0xFFFFFFFF;
+
+/****************************************************************************
+** Struct: SPVRTStateCacheCounters
+****************************************************************************/
+unsigned int SPVRTStateCacheCounters::Issued() const
+{
+	unsigned int ui32Sum = 0;
+	for(int i = 0; i < ePVRTStateNumCalls; ++i)
+		ui32Sum += aui32Issued[i];
+	return ui32Sum;
+}
+
+unsigned int SPVRTStateCacheCounters::Filtered() const
+{
+	unsigned int ui32Sum = 0;
+	for(int i = 0; i < ePVRTStateNumCalls; ++i)
+		ui32Sum += aui32Filtered[i];
+	return ui32Sum;
+}
+
+void SPVRTStateCacheCounters::Reset()
+{
+	memset(aui32Issued, 0, sizeof(aui32Issued));
+	memset(aui32Filtered, 0, sizeof(aui32Filtered));
+}
+
+/****************************************************************************
+** Class: CPVRTStateCache
+****************************************************************************/
+CPVRTStateCache::CPVRTStateCache()
+{
+	m_sFrame.Reset();
+	m_sLastFrame.Reset();
+	Invalidate();
+}
+
+/*!***************************************************************************
+ @Function			Invalidate
+ @Description		Forgets all cached state, the next call of every kind is
+					issued. Use after code that bypasses the cache and after
+					the context was recreated.
+*****************************************************************************/
+void CPVRTStateCache::Invalidate()
+{
+	m_uiProgram = c_uiUnknown;
+	m_uiArrayBuffer = c_uiUnknown;
+	m_uiElementBuffer = c_uiUnknown;
+	m_uiFramebuffer = c_uiUnknown;
+	m_uiVertexArray = c_uiUnknown;
+	m_uiDefaultElementBuffer = c_uiUnknown;
+	memset(m_ai8DefaultAttribs, -1, sizeof(m_ai8DefaultAttribs));
+	m_uiActiveUnit = c_uiUnknown;
+	for(int i = 0; i < PVRTSTATECACHE_MAX_TEXTURE_UNITS; ++i)
+		m_auiTextures[i][0] = m_auiTextures[i][1] = c_uiUnknown;
+	memset(m_ai8Attribs, -1, sizeof(m_ai8Attribs));
+	memset(m_ai8Caps, -1, sizeof(m_ai8Caps));
+	m_eBlendSrc = m_eBlendDst = c_uiUnknown;
+	m_eDepthFunc = c_uiUnknown;
+	m_iDepthMask = -1;
+	m_eCullFace = c_uiUnknown;
+	m_eFrontFace = c_uiUnknown;
+}
+
+/*!***************************************************************************
+ @Function			NewFrame
+ @Description		Moves the counters of the frame that was drawn to
+					m_sLastFrame and starts counting again.
+*****************************************************************************/
+void CPVRTStateCache::NewFrame()
+{
+	m_sLastFrame = m_sFrame;
+	m_sFrame.Reset();
+}
+
+/*!***************************************************************************
+ @Function			filter
+ @Input				eCall			kind of call
+ @Input				bRedundant		the call would not change anything
+ @Return			true if the call has to be issued
+ @Description		Counts the call as issued or filtered.
+*****************************************************************************/
+bool CPVRTStateCache::filter(EPVRTStateCall eCall, bool bRedundant)
+{
+	if(bRedundant)
+	{
+		m_sFrame.aui32Filtered[eCall]++;
+		return false;
+	}
+	m_sFrame.aui32Issued[eCall]++;
+	return true;
+}
+
+int CPVRTStateCache::capabilityIndex(GLenum cap) const
+{
+	switch(cap)
+	{
+	case GL_BLEND:			return eCapBlend;
+	case GL_DEPTH_TEST:		return eCapDepthTest;
+	case GL_CULL_FACE:		return eCapCullFace;
+	case GL_SCISSOR_TEST:	return eCapScissorTest;
+	default:				return -1;
+	}
+}
+
+int CPVRTStateCache::textureTargetIndex(GLenum target) const
+{
+	switch(target)
+	{
+	case GL_TEXTURE_2D:			return 0;
+	case GL_TEXTURE_CUBE_MAP:	return 1;
+	default:					return -1;
+	}
+}
+
+void CPVRTStateCache::UseProgram(GLuint program)
+{
+	if(filter(ePVRTStateProgram, program == m_uiProgram))
+	{
+		glUseProgram(program);
+		m_uiProgram = program;
+	}
+}
+
+void CPVRTStateCache::BindBuffer(GLenum target, GLuint buffer)
+{
+	GLuint* puiBound = target == GL_ARRAY_BUFFER ? &m_uiArrayBuffer : (target == GL_ELEMENT_ARRAY_BUFFER ? &m_uiElementBuffer : 0);
+	if(filter(ePVRTStateBuffer, puiBound && *puiBound == buffer))
+	{
+		glBindBuffer(target, buffer);
+		if(puiBound)
+			*puiBound = buffer;
+	}
+}
+
+void CPVRTStateCache::ActiveTexture(GLenum texture)
+{
+	GLuint uiUnit = texture - GL_TEXTURE0;
+	if(filter(ePVRTStateActiveTexture, uiUnit == m_uiActiveUnit))
+	{
+		glActiveTexture(texture);
+		m_uiActiveUnit = uiUnit;
+	}
+}
+
+/*!***************************************************************************
+ @Function			BindTexture
+ @Input				target			GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP
+ @Input				texture			texture name
+ @Description		Binds to the active unit. When the active unit is not
+					known the bind is always issued.
+*****************************************************************************/
+void CPVRTStateCache::BindTexture(GLenum target, GLuint texture)
+{
+	int i32Target = textureTargetIndex(target);
+	GLuint* puiBound = 0;
+	if(i32Target >= 0 && m_uiActiveUnit < PVRTSTATECACHE_MAX_TEXTURE_UNITS)
+		puiBound = &m_auiTextures[m_uiActiveUnit][i32Target];
+
+	if(filter(ePVRTStateTexture, puiBound && *puiBound == texture))
+	{
+		glBindTexture(target, texture);
+		if(puiBound)
+			*puiBound = texture;
+	}
+}
+
+/*!***************************************************************************
+ @Function			BindTexture
+ @Input				unit			texture unit, 0 for GL_TEXTURE0
+ @Input				target			GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP
+ @Input				texture			texture name
+ @Description		Binds texture to unit, the unit is only made active when
+					the texture is not already bound there.
+*****************************************************************************/
+void CPVRTStateCache::BindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+	int i32Target = textureTargetIndex(target);
+	if(i32Target >= 0 && unit < PVRTSTATECACHE_MAX_TEXTURE_UNITS && m_auiTextures[unit][i32Target] == texture)
+	{
+		m_sFrame.aui32Filtered[ePVRTStateTexture]++;
+		return;
+	}
+	ActiveTexture(GL_TEXTURE0 + unit);
+	BindTexture(target, texture);
+}
+
+void CPVRTStateCache::EnableVertexAttribArray(GLuint index)
+{
+	bool bKnown = index < PVRTSTATECACHE_MAX_ATTRIBS;
+	if(filter(ePVRTStateAttribArray, bKnown && m_ai8Attribs[index] == 1))
+	{
+		glEnableVertexAttribArray(index);
+		if(bKnown)
+			m_ai8Attribs[index] = 1;
+	}
+}
+
+void CPVRTStateCache::DisableVertexAttribArray(GLuint index)
+{
+	bool bKnown = index < PVRTSTATECACHE_MAX_ATTRIBS;
+	if(filter(ePVRTStateAttribArray, bKnown && m_ai8Attribs[index] == 0))
+	{
+		glDisableVertexAttribArray(index);
+		if(bKnown)
+			m_ai8Attribs[index] = 0;
+	}
+}
+
+/*!***************************************************************************
+ @Function			EnableVertexAttribArrays
+ @Input				count			attributes 0 to count-1 are enabled
+ @Description		Enables the first count attribute arrays and disables the
+					other cached ones.
+*****************************************************************************/
+void CPVRTStateCache::EnableVertexAttribArrays(GLuint count)
+{
+	for(GLuint i = 0; i < PVRTSTATECACHE_MAX_ATTRIBS || i < count; ++i)
+	{
+		if(i < count)
+			EnableVertexAttribArray(i);
+		else if(m_ai8Attribs[i] != 0)
+			DisableVertexAttribArray(i);
+	}
+}
+
+void CPVRTStateCache::Enable(GLenum cap)
+{
+	int i32Cap = capabilityIndex(cap);
+	if(filter(ePVRTStateCapability, i32Cap >= 0 && m_ai8Caps[i32Cap] == 1))
+	{
+		glEnable(cap);
+		if(i32Cap >= 0)
+			m_ai8Caps[i32Cap] = 1;
+	}
+}
+
+void CPVRTStateCache::Disable(GLenum cap)
+{
+	int i32Cap = capabilityIndex(cap);
+	if(filter(ePVRTStateCapability, i32Cap >= 0 && m_ai8Caps[i32Cap] == 0))
+	{
+		glDisable(cap);
+		if(i32Cap >= 0)
+			m_ai8Caps[i32Cap] = 0;
+	}
+}
+
+void CPVRTStateCache::BlendFunc(GLenum sfactor, GLenum dfactor)
+{
+	if(filter(ePVRTStateFunc, sfactor == m_eBlendSrc && dfactor == m_eBlendDst))
+	{
+		glBlendFunc(sfactor, dfactor);
+		m_eBlendSrc = sfactor;
+		m_eBlendDst = dfactor;
+	}
+}
+
+void CPVRTStateCache::DepthFunc(GLenum func)
+{
+	if(filter(ePVRTStateFunc, func == m_eDepthFunc))
+	{
+		glDepthFunc(func);
+		m_eDepthFunc = func;
+	}
+}
+
+void CPVRTStateCache::DepthMask(GLboolean flag)
+{
+	if(filter(ePVRTStateFunc, (GLint)flag == m_iDepthMask))
+	{
+		glDepthMask(flag);
+		m_iDepthMask = flag;
+	}
+}
+
+void CPVRTStateCache::CullFace(GLenum mode)
+{
+	if(filter(ePVRTStateFunc, mode == m_eCullFace))
+	{
+		glCullFace(mode);
+		m_eCullFace = mode;
+	}
+}
+
+void CPVRTStateCache::FrontFace(GLenum mode)
+{
+	if(filter(ePVRTStateFunc, mode == m_eFrontFace))
+	{
+		glFrontFace(mode);
+		m_eFrontFace = mode;
+	}
+}
+
+void CPVRTStateCache::BindFramebuffer(GLenum target, GLuint framebuffer)
+{
+	if(filter(ePVRTStateFramebuffer, target == GL_FRAMEBUFFER && framebuffer == m_uiFramebuffer))
+	{
+		glBindFramebuffer(target, framebuffer);
+		if(target == GL_FRAMEBUFFER)
+			m_uiFramebuffer = framebuffer;
+	}
+}
+
+/*!***************************************************************************
+ @Function			BindVertexArray
+ @Input				extensions		loaded extensions of the context
+ @Input				vertexArray		vertex array object, 0 for the default
+ @Description		Binds through glBindVertexArrayOES, which PVRTgles2Ext
+					loads from OpenGL ES 3.0 or GL_OES_vertex_array_object.
+					Without it only the default object exists and nothing is
+					called.
+*****************************************************************************/
+void CPVRTStateCache::BindVertexArray(const CPVRTgles2Ext& extensions, GLuint vertexArray)
+{
+	if(!extensions.glBindVertexArrayOES)
+	{
+		m_uiVertexArray = 0;
+		return;
+	}
+	if(!filter(ePVRTStateVertexArray, vertexArray == m_uiVertexArray))
+		return;
+
+	extensions.glBindVertexArrayOES(vertexArray);
+	if(m_uiVertexArray == 0)
+	{
+		m_uiDefaultElementBuffer = m_uiElementBuffer;
+		memcpy(m_ai8DefaultAttribs, m_ai8Attribs, sizeof(m_ai8Attribs));
+	}
+
+	if(vertexArray == 0 && m_uiVertexArray != c_uiUnknown)
+	{
+		m_uiElementBuffer = m_uiDefaultElementBuffer;
+		memcpy(m_ai8Attribs, m_ai8DefaultAttribs, sizeof(m_ai8Attribs));
+	}
+	else
+	{
+		m_uiElementBuffer = c_uiUnknown;
+		memset(m_ai8Attribs, -1, sizeof(m_ai8Attribs));
+	}
+	m_uiVertexArray = vertexArray;
+}
+
+/*!***************************************************************************
+ @Function			DeleteProgram
+ @Description		Deletes the program. A program in use stays in use until
+					another one is used, so the cached program is kept.
+*****************************************************************************/
+void CPVRTStateCache::DeleteProgram(GLuint program)
+{
+	glDeleteProgram(program);
+}
+
+void CPVRTStateCache::DeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+	glDeleteBuffers(n, buffers);
+	for(GLsizei i = 0; i < n; ++i)
+	{
+		if(buffers[i] == 0)
+			continue;
+		if(buffers[i] == m_uiArrayBuffer)
+			m_uiArrayBuffer = 0;
+		if(buffers[i] == m_uiElementBuffer)
+			m_uiElementBuffer = 0;
+		// whether a vertex array object that is not bound lets go of it depends on the version
+		if(buffers[i] == m_uiDefaultElementBuffer)
+			m_uiDefaultElementBuffer = c_uiUnknown;
+	}
+}
+
+void CPVRTStateCache::DeleteTextures(GLsizei n, const GLuint* textures)
+{
+	glDeleteTextures(n, textures);
+	for(GLsizei i = 0; i < n; ++i)
+	{
+		if(textures[i] == 0)
+			continue;
+		for(int u = 0; u < PVRTSTATECACHE_MAX_TEXTURE_UNITS; ++u)
+		{
+			if(m_auiTextures[u][0] == textures[i])
+				m_auiTextures[u][0] = 0;
+			if(m_auiTextures[u][1] == textures[i])
+				m_auiTextures[u][1] = 0;
+		}
+	}
+}
+
+void CPVRTStateCache::DeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+{
+	glDeleteFramebuffers(n, framebuffers);
+	for(GLsizei i = 0; i < n; ++i)
+	{
+		if(framebuffers[i] != 0 && framebuffers[i] == m_uiFramebuffer)
+			m_uiFramebuffer = 0;
+	}
+}
+
+/*!***************************************************************************
+ @Function			BoundBuffer
+ @Input				target			GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER
+ @Return			the cached binding, 0xFFFFFFFF when not known
+*****************************************************************************/
+GLuint CPVRTStateCache::BoundBuffer(GLenum target) const
+{
+	return target == GL_ARRAY_BUFFER ? m_uiArrayBuffer : (target == GL_ELEMENT_ARRAY_BUFFER ? m_uiElementBuffer : c_uiUnknown);
+}
+
+/*****************************************************************************
+ End of file (PVRTStateCache.cpp)
+*****************************************************************************/
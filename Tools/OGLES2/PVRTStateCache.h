@@ -0,0 +1,153 @@
+/*!****************************************************************************
+
+ @file         OGLES2/PVRTStateCache.h
+ @ingroup      API_OGLES2
+ @copyright    Copyright (c) Imagination Technologies Limited.
+ @brief        Shadow copy of OpenGL ES 2.0 binding and fixed function state
+               that drops redundant calls.
+
+******************************************************************************/
+#ifndef _PVRTSTATECACHE_H_
+#define _PVRTSTATECACHE_H_
+
+/*!
+ @addtogroup API_OGLES2
+ @{
+*/
+
+#include "PVRTContext.h"
+#include "PVRTgles2Ext.h"
+#include "../PVRTGlobal.h"
+
+/****************************************************************************
+** Defines
+****************************************************************************/
+#define PVRTSTATECACHE_MAX_TEXTURE_UNITS	16	/*!< Units above this are passed through uncached */
+#define PVRTSTATECACHE_MAX_ATTRIBS			16	/*!< Vertex attributes above this are passed through uncached */
+
+/****************************************************************************
+** Enumerations
+****************************************************************************/
+/*!***************************************************************************
+ @enum      EPVRTStateCall
+ @brief     Kinds of calls counted by CPVRTStateCache.
+*****************************************************************************/
+enum EPVRTStateCall
+{
+	ePVRTStateProgram,			/*!< glUseProgram */
+	ePVRTStateBuffer,			/*!< glBindBuffer */
+	ePVRTStateActiveTexture,	/*!< glActiveTexture */
+	ePVRTStateTexture,			/*!< glBindTexture */
+	ePVRTStateAttribArray,		/*!< glEnableVertexAttribArray, glDisableVertexAttribArray */
+	ePVRTStateCapability,		/*!< glEnable, glDisable */
+	ePVRTStateFunc,				/*!< glBlendFunc, glDepthFunc, glDepthMask, glCullFace, glFrontFace */
+	ePVRTStateFramebuffer,		/*!< glBindFramebuffer */
+	ePVRTStateVertexArray,		/*!< glBindVertexArrayOES */
+	ePVRTStateNumCalls
+};
+
+/****************************************************************************
+** Structures
+****************************************************************************/
+/*!***************************************************************************
+ @struct    SPVRTStateCacheCounters
+ @brief     Calls that reached the driver and calls that were dropped.
+*****************************************************************************/
+struct SPVRTStateCacheCounters
+{
+	unsigned int	aui32Issued[ePVRTStateNumCalls];
+	unsigned int	aui32Filtered[ePVRTStateNumCalls];
+
+	unsigned int Issued() const;
+	unsigned int Filtered() const;
+	void Reset();
+};
+
+/****************************************************************************
+** Class
+****************************************************************************/
+/*!***************************************************************************
+ @class     CPVRTStateCache
+ @brief     Thin layer in front of the GL binding and render state calls.
+ @details   Every call is compared with the last value set through the cache
+            and only reaches GL when it differs. State starts out unknown, so
+            the first call after construction or Invalidate() is always
+            issued. Code that changes state behind the cache's back (Print3D,
+            PVRTCreateProgram, texture loading) must be followed by
+            Invalidate(). Deleting a bound object through the Delete functions
+            resets its binding like GL does. The element buffer binding and
+            the enabled attribute arrays belong to the bound vertex array
+            object: they are kept for the default one while another is bound
+            and are unknown for the others.
+*****************************************************************************/
+class CPVRTStateCache
+{
+public:
+	CPVRTStateCache();
+
+	void Invalidate();
+	void NewFrame();
+
+	void UseProgram(GLuint program);
+	void BindBuffer(GLenum target, GLuint buffer);
+	void ActiveTexture(GLenum texture);
+	void BindTexture(GLenum target, GLuint texture);
+	void BindTexture(GLuint unit, GLenum target, GLuint texture);
+	void EnableVertexAttribArray(GLuint index);
+	void DisableVertexAttribArray(GLuint index);
+	void EnableVertexAttribArrays(GLuint count);
+	void Enable(GLenum cap);
+	void Disable(GLenum cap);
+	void BlendFunc(GLenum sfactor, GLenum dfactor);
+	void DepthFunc(GLenum func);
+	void DepthMask(GLboolean flag);
+	void CullFace(GLenum mode);
+	void FrontFace(GLenum mode);
+	void BindFramebuffer(GLenum target, GLuint framebuffer);
+	void BindVertexArray(const CPVRTgles2Ext& extensions, GLuint vertexArray);
+
+	void DeleteProgram(GLuint program);
+	void DeleteBuffers(GLsizei n, const GLuint* buffers);
+	void DeleteTextures(GLsizei n, const GLuint* textures);
+	void DeleteFramebuffers(GLsizei n, const GLuint* framebuffers);
+
+	GLuint BoundBuffer(GLenum target) const;
+
+	/*! Counters of the frame being drawn, and of the last one after NewFrame */
+	SPVRTStateCacheCounters m_sFrame;
+	SPVRTStateCacheCounters m_sLastFrame;
+
+private:
+	bool filter(EPVRTStateCall eCall, bool bRedundant);
+	int capabilityIndex(GLenum cap) const;
+	int textureTargetIndex(GLenum target) const;
+
+	enum { eCapBlend, eCapDepthTest, eCapCullFace, eCapScissorTest, eCapNumCaps };
+
+	GLuint		m_uiProgram;
+	GLuint		m_uiArrayBuffer;
+	GLuint		m_uiElementBuffer;
+	GLuint		m_uiFramebuffer;
+	GLuint		m_uiVertexArray;
+	GLuint		m_uiActiveUnit;
+	GLuint		m_auiTextures[PVRTSTATECACHE_MAX_TEXTURE_UNITS][2];	/*!< 2D and cube map per unit */
+	PVRTint8	m_ai8Attribs[PVRTSTATECACHE_MAX_ATTRIBS];			/*!< -1 unknown, 0 disabled, 1 enabled */
+	PVRTint8	m_ai8Caps[eCapNumCaps];
+	GLenum		m_eBlendSrc, m_eBlendDst;
+	GLenum		m_eDepthFunc;
+	GLint		m_iDepthMask;
+	GLenum		m_eCullFace;
+	GLenum		m_eFrontFace;
+
+	// element buffer and attributes of vertex array object 0 while another one is bound
+	GLuint		m_uiDefaultElementBuffer;
+	PVRTint8	m_ai8DefaultAttribs[PVRTSTATECACHE_MAX_ATTRIBS];
+};
+
+/*! @} */
+
+#endif /* _PVRTSTATECACHE_H_ */
+
+/*****************************************************************************
+ End of file (PVRTStateCache.h)
+*****************************************************************************/
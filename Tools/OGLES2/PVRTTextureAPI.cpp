@@ -27,6 +27,7 @@
 #include "PVRTMatrix.h"
 #include "PVRTMisc.h"
 #include "PVRTResourceFile.h"
+#include "PVRTTrace.h"
 
 /*****************************************************************************
 ** Functions
@@ -1008,6 +1009,8 @@ EPVRTError PVRTTextureLoadFromPVR(	const char * const filename,
 									const unsigned int nLoadFromLevel,
 									CPVRTMap<unsigned int, CPVRTMap<unsigned int, MetaDataBlock> > *pMetaData)
 {
+	PVRTTRACE_SCOPE("PVRTTextureLoadFromPVR");
+
 	//Attempt to open file.
 	CPVRTResourceFile TexFile(filename);
 
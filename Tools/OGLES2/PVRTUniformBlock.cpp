@@ -0,0 +1,250 @@
+/******************************************************************************
+
+ @File         OGLES2/PVRTUniformBlock.cpp
+
+ @Title        OGLES2/PVRTUniformBlock
+
+ @Version
+
+ @Copyright    Copyright (c) Imagination Technologies Limited.
+
+ @Platform     Independent
+
+ @Description  Block of uniforms shared by several programs, set once and
+               uploaded to each program at most once per change.
+
+******************************************************************************/
+#include <string.h>
+
+#include "PVRTContext.h"
+#include "PVRTUniformBlock.h"
+
+/****************************************************************************
+** Struct: SPVRTUniformBlockCounters
+****************************************************************************/
+void SPVRTUniformBlockCounters::Reset()
+{
+	ui32Updates = ui32Skipped = ui32BufferBytes = 0;
+}
+
+/****************************************************************************
+** Class: CPVRTUniformBlock
+****************************************************************************/
+CPVRTUniformBlock::CPVRTUniformBlock() : m_pExtensions(0), m_pszBlockName(0), m_uiBinding(0), m_uiBuffer(0),
+	m_ui32BufferVersion(0), m_ui32Version(1), m_ui32NumMembers(0), m_ui32Size(0), m_ui32NumPrograms(0)
+{
+	memset(m_afValues, 0, sizeof(m_afValues));
+	m_sFrame.Reset();
+	m_sLastFrame.Reset();
+}
+
+/*!***************************************************************************
+ @Function			Init
+ @Input				extensions		loaded extensions, kept for Apply
+ @Input				pszBlockName	name of the uniform block in the shaders
+ @Input				uiBinding		uniform buffer binding point of the block
+ @Input				psMembers		members in declaration order, the names
+									must outlive the block
+ @Input				ui32NumMembers	number of members
+ @Return			true on success
+ @Description		Lays the members out std140. The values start out zero.
+					The uniform buffer is only created by AddProgram, for the
+					first program that declares the block.
+*****************************************************************************/
+bool CPVRTUniformBlock::Init(const CPVRTgles2Ext& extensions, const char* pszBlockName, GLuint uiBinding,
+	const SPVRTUniformBlockMember* psMembers, unsigned int ui32NumMembers)
+{
+	if(ui32NumMembers > PVRTUNIFORMBLOCK_MAX_MEMBERS)
+		return false;
+
+	m_pExtensions = &extensions;
+	m_pszBlockName = pszBlockName;
+	m_uiBinding = uiBinding;
+	m_ui32NumMembers = ui32NumMembers;
+	m_ui32NumPrograms = 0;
+
+	// std140: scalars align to 4 bytes, vec2 to 8, vec3, vec4 and mat4 columns to 16
+	unsigned int ui32Offset = 0;
+	for(unsigned int i = 0; i < ui32NumMembers; ++i)
+	{
+		unsigned int ui32Floats = psMembers[i].ui32Floats;
+		if(ui32Floats == 0 || (ui32Floats > 4 && ui32Floats != 16))
+			return false;
+		unsigned int ui32Align = ui32Floats == 1 ? 1 : (ui32Floats == 2 ? 2 : 4);
+		ui32Offset = (ui32Offset + ui32Align - 1) & ~(ui32Align - 1);
+		m_apszNames[i] = psMembers[i].pszName;
+		m_aui32Floats[i] = ui32Floats;
+		m_aui32Offsets[i] = ui32Offset;
+		ui32Offset += ui32Floats;
+	}
+	m_ui32Size = (ui32Offset + 3) & ~3u;
+	return true;
+}
+
+/*!***************************************************************************
+ @Function			AddProgram
+ @Input				program			linked program that uses the block
+ @Return			false when PVRTUNIFORMBLOCK_MAX_PROGRAMS are registered
+ @Description		Binds the program's uniform block to the buffer, creating
+					the buffer the first time, or looks up the locations of
+					the members when the program has no such block or the
+					context no uniform buffer objects.
+*****************************************************************************/
+bool CPVRTUniformBlock::AddProgram(GLuint program)
+{
+	RemoveProgram(program);
+	if(m_ui32NumPrograms == PVRTUNIFORMBLOCK_MAX_PROGRAMS)
+		return false;
+
+	SProgram& sProgram = m_asPrograms[m_ui32NumPrograms++];
+	sProgram.uiProgram = program;
+	sProgram.ui32Version = 0;
+	sProgram.bBlock = false;
+	if(m_pExtensions->glBindBufferBase && m_pExtensions->glGetUniformBlockIndex)
+	{
+		GLuint uiIndex = m_pExtensions->glGetUniformBlockIndex(program, m_pszBlockName);
+		if(uiIndex != GL_INVALID_INDEX)
+		{
+			if(!m_uiBuffer)
+			{
+				glGenBuffers(1, &m_uiBuffer);
+				glBindBuffer(GL_UNIFORM_BUFFER, m_uiBuffer);
+				glBufferData(GL_UNIFORM_BUFFER, m_ui32Size * sizeof(GLfloat), m_afValues, GL_DYNAMIC_DRAW);
+				m_ui32BufferVersion = 0;
+			}
+			m_pExtensions->glUniformBlockBinding(program, uiIndex, m_uiBinding);
+			sProgram.bBlock = true;
+		}
+	}
+	for(unsigned int i = 0; i < m_ui32NumMembers; ++i)
+		sProgram.ai32Locations[i] = sProgram.bBlock ? -1 : glGetUniformLocation(program, m_apszNames[i]);
+	return true;
+}
+
+void CPVRTUniformBlock::RemoveProgram(GLuint program)
+{
+	for(unsigned int i = 0; i < m_ui32NumPrograms; ++i)
+	{
+		if(m_asPrograms[i].uiProgram == program)
+		{
+			m_asPrograms[i] = m_asPrograms[--m_ui32NumPrograms];
+			return;
+		}
+	}
+}
+
+/*!***************************************************************************
+ @Function			Release
+ @Description		Deletes the uniform buffer and forgets the programs.
+*****************************************************************************/
+void CPVRTUniformBlock::Release()
+{
+	if(m_uiBuffer)
+		glDeleteBuffers(1, &m_uiBuffer);
+	m_uiBuffer = 0;
+	m_ui32NumPrograms = 0;
+}
+
+/*!***************************************************************************
+ @Function			Set
+ @Input				ui32Member		index in the members given to Init
+ @Input				pfValue			the member's floats
+ @Description		Stores the value. Only a different value makes Apply
+					upload the block again.
+*****************************************************************************/
+void CPVRTUniformBlock::Set(unsigned int ui32Member, const GLfloat* pfValue)
+{
+	GLfloat* pfStored = &m_afValues[m_aui32Offsets[ui32Member]];
+	size_t uBytes = m_aui32Floats[ui32Member] * sizeof(GLfloat);
+	if(memcmp(pfStored, pfValue, uBytes) != 0)
+	{
+		memcpy(pfStored, pfValue, uBytes);
+		m_ui32Version++;
+	}
+}
+
+void CPVRTUniformBlock::Set(unsigned int ui32Member, GLfloat fValue)
+{
+	Set(ui32Member, &fValue);
+}
+
+/*!***************************************************************************
+ @Function			Apply
+ @Input				cache			cache the plain uniforms go through
+ @Input				program			program in use, registered with AddProgram
+ @Description		Brings the program up to date with the block. Does nothing
+					when no value changed since the program's last Apply.
+*****************************************************************************/
+void CPVRTUniformBlock::Apply(CPVRTUniformCache& cache, GLuint program)
+{
+	SProgram* psProgram = 0;
+	for(unsigned int i = 0; i < m_ui32NumPrograms && !psProgram; ++i)
+	{
+		if(m_asPrograms[i].uiProgram == program)
+			psProgram = &m_asPrograms[i];
+	}
+	if(!psProgram)
+		return;
+
+	if(psProgram->bBlock)
+	{
+		if(m_ui32BufferVersion == m_ui32Version)
+		{
+			m_sFrame.ui32Skipped++;
+			return;
+		}
+		glBindBuffer(GL_UNIFORM_BUFFER, m_uiBuffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, m_ui32Size * sizeof(GLfloat), m_afValues);
+		m_pExtensions->glBindBufferBase(GL_UNIFORM_BUFFER, m_uiBinding, m_uiBuffer);
+		m_ui32BufferVersion = m_ui32Version;
+		m_sFrame.ui32Updates++;
+		m_sFrame.ui32BufferBytes += m_ui32Size * sizeof(GLfloat);
+		return;
+	}
+
+	if(psProgram->ui32Version == m_ui32Version)
+	{
+		m_sFrame.ui32Skipped++;
+		return;
+	}
+	for(unsigned int i = 0; i < m_ui32NumMembers; ++i)
+	{
+		GLint i32Location = psProgram->ai32Locations[i];
+		const GLfloat* pfValue = &m_afValues[m_aui32Offsets[i]];
+		switch(m_aui32Floats[i])
+		{
+		case 1:		cache.Uniform1f(program, i32Location, *pfValue); break;
+		case 2:		cache.Uniform2fv(program, i32Location, pfValue); break;
+		case 3:		cache.Uniform3fv(program, i32Location, pfValue); break;
+		case 4:		cache.Uniform4fv(program, i32Location, pfValue); break;
+		default:	cache.UniformMatrix4fv(program, i32Location, pfValue); break;
+		}
+	}
+	psProgram->ui32Version = m_ui32Version;
+	m_sFrame.ui32Updates++;
+}
+
+/*!***************************************************************************
+ @Function			NewFrame
+ @Description		Moves the counters of the frame that was drawn to
+					m_sLastFrame and starts counting again.
+*****************************************************************************/
+void CPVRTUniformBlock::NewFrame()
+{
+	m_sLastFrame = m_sFrame;
+	m_sFrame.Reset();
+}
+
+/*!***************************************************************************
+ @Function			IsBufferBacked
+ @Return			true when a registered program reads the values from a
+					uniform buffer
+*****************************************************************************/
+bool CPVRTUniformBlock::IsBufferBacked() const
+{
+	return m_uiBuffer != 0;
+}
+
+/*****************************************************************************
+ End of file (PVRTUniformBlock.cpp)
+*****************************************************************************/
@@ -0,0 +1,129 @@
+/*!****************************************************************************
+
+ @file         OGLES2/PVRTUniformBlock.h
+ @ingroup      API_OGLES2
+ @copyright    Copyright (c) Imagination Technologies Limited.
+ @brief        Block of uniforms shared by several programs, set once and
+               uploaded to each program at most once per change.
+
+******************************************************************************/
+#ifndef _PVRTUNIFORMBLOCK_H_
+#define _PVRTUNIFORMBLOCK_H_
+
+/*!
+ @addtogroup API_OGLES2
+ @{
+*/
+
+#include "PVRTContext.h"
+#include "PVRTgles2Ext.h"
+#include "PVRTUniformCache.h"
+#include "../PVRTGlobal.h"
+
+/****************************************************************************
+** Defines
+****************************************************************************/
+#define PVRTUNIFORMBLOCK_MAX_MEMBERS	16
+#define PVRTUNIFORMBLOCK_MAX_PROGRAMS	8
+
+/****************************************************************************
+** Structures
+****************************************************************************/
+/*!***************************************************************************
+ @struct    SPVRTUniformBlockMember
+ @brief     Name and size of a block member: 1 to 4 floats or 16 for a mat4.
+*****************************************************************************/
+struct SPVRTUniformBlockMember
+{
+	const char*		pszName;
+	unsigned int	ui32Floats;
+};
+
+/*!***************************************************************************
+ @struct    SPVRTUniformBlockCounters
+ @brief     How often the block reached a program and how often it was
+            already there.
+*****************************************************************************/
+struct SPVRTUniformBlockCounters
+{
+	unsigned int	ui32Updates;			/*!< Apply calls that uploaded the block */
+	unsigned int	ui32Skipped;			/*!< Apply calls that found the program up to date */
+	unsigned int	ui32BufferBytes;		/*!< Bytes written to the uniform buffer */
+
+	void Reset();
+};
+
+/****************************************************************************
+** Class
+****************************************************************************/
+/*!***************************************************************************
+ @class     CPVRTUniformBlock
+ @brief     Constants shared by several programs, such as the per view
+            values of a frame.
+ @details   The members are set once when they change and Apply() brings a
+            program up to date when it is about to draw. On OpenGL ES 3.0 the
+            values live in a uniform buffer laid out std140 for the programs
+            that declare a uniform block of the same name: a change is one
+            buffer upload whatever the number of programs. The buffer is only
+            created once such a program is added. Programs without
+            the block, and every program on OpenGL ES 2.0, get the members as
+            plain uniforms of the same names through a CPVRTUniformCache,
+            once per change and program. Members a program does not use are
+            skipped.
+*****************************************************************************/
+class CPVRTUniformBlock
+{
+public:
+	CPVRTUniformBlock();
+
+	bool Init(const CPVRTgles2Ext& extensions, const char* pszBlockName, GLuint uiBinding,
+		const SPVRTUniformBlockMember* psMembers, unsigned int ui32NumMembers);
+	bool AddProgram(GLuint program);
+	void RemoveProgram(GLuint program);
+	void Release();
+
+	void Set(unsigned int ui32Member, const GLfloat* pfValue);
+	void Set(unsigned int ui32Member, GLfloat fValue);
+	void Apply(CPVRTUniformCache& cache, GLuint program);
+	void NewFrame();
+
+	bool IsBufferBacked() const;
+
+	/*! Counters of the frame being drawn, and of the last one after NewFrame */
+	SPVRTUniformBlockCounters m_sFrame;
+	SPVRTUniformBlockCounters m_sLastFrame;
+
+private:
+	struct SProgram
+	{
+		GLuint			uiProgram;
+		bool			bBlock;											/*!< Reads the uniform buffer */
+		unsigned int	ui32Version;									/*!< Block version it holds */
+		GLint			ai32Locations[PVRTUNIFORMBLOCK_MAX_MEMBERS];
+	};
+
+	const CPVRTgles2Ext*	m_pExtensions;
+	const char*				m_pszBlockName;
+	GLuint					m_uiBinding;
+	GLuint					m_uiBuffer;				/*!< 0 until a program declaring the block is added */
+	unsigned int			m_ui32BufferVersion;	/*!< Block version in m_uiBuffer */
+	unsigned int			m_ui32Version;			/*!< Bumped by every Set that changes a value */
+
+	unsigned int			m_ui32NumMembers;
+	unsigned int			m_aui32Floats[PVRTUNIFORMBLOCK_MAX_MEMBERS];
+	unsigned int			m_aui32Offsets[PVRTUNIFORMBLOCK_MAX_MEMBERS];	/*!< std140, in floats */
+	const char*				m_apszNames[PVRTUNIFORMBLOCK_MAX_MEMBERS];
+	GLfloat					m_afValues[PVRTUNIFORMBLOCK_MAX_MEMBERS * 16];
+	unsigned int			m_ui32Size;				/*!< std140 size in floats */
+
+	SProgram				m_asPrograms[PVRTUNIFORMBLOCK_MAX_PROGRAMS];
+	unsigned int			m_ui32NumPrograms;
+};
+
+/*! @} */
+
+#endif /* _PVRTUNIFORMBLOCK_H_ */
+
+/*****************************************************************************
+ End of file (PVRTUniformBlock.h)
+*****************************************************************************/
@@ -0,0 +1,195 @@
+/******************************************************************************
+
+ @File         OGLES2/PVRTUniformCache.cpp
+
+ @Title        OGLES2/PVRTUniformCache
+
+ @Version
+
+ @Copyright    Copyright (c) Imagination Technologies Limited.
+
+ @Platform     Independent
+
+ @Description  Shadow copy of the uniform values of shader programs that drops
+               uploads of values a location already holds.
+
+******************************************************************************/
+#include <string.h>
+
+#include "PVRTContext.h"
+#include "PVRTUniformCache.h"
+
+/****************************************************************************
+** Struct: SPVRTUniformCacheCounters
+****************************************************************************/
+void SPVRTUniformCacheCounters::Reset()
+{
+	ui32Issued = ui32Filtered = 0;
+	ui32IssuedBytes = ui32FilteredBytes = 0;
+}
+
+/****************************************************************************
+** Class: CPVRTUniformCache
+****************************************************************************/
+CPVRTUniformCache::CPVRTUniformCache() : m_uiLastProgram(0)
+{
+	m_sFrame.Reset();
+	m_sLastFrame.Reset();
+}
+
+/*!***************************************************************************
+ @Function			Invalidate
+ @Description		Forgets the values of all programs. Use after the context
+					was recreated.
+*****************************************************************************/
+void CPVRTUniformCache::Invalidate()
+{
+	m_Programs.Clear();
+	m_uiLastProgram = 0;
+}
+
+/*!***************************************************************************
+ @Function			InvalidateProgram
+ @Input				program			program that was deleted or relinked
+ @Description		Forgets the values of one program, the next upload to
+					each of its locations is issued.
+*****************************************************************************/
+void CPVRTUniformCache::InvalidateProgram(GLuint program)
+{
+	for(unsigned int i = 0; i < m_Programs.GetSize(); ++i)
+	{
+		if(m_Programs[i].uiProgram == program)
+			memset(m_Programs[i].au8Floats, 0, sizeof(m_Programs[i].au8Floats));
+	}
+}
+
+/*!***************************************************************************
+ @Function			NewFrame
+ @Description		Moves the counters of the frame that was drawn to
+					m_sLastFrame and starts counting again.
+*****************************************************************************/
+void CPVRTUniformCache::NewFrame()
+{
+	m_sLastFrame = m_sFrame;
+	m_sFrame.Reset();
+}
+
+CPVRTUniformCache::SProgram* CPVRTUniformCache::findProgram(GLuint program)
+{
+	// draws of the same program come in runs, try the last one first
+	if(m_uiLastProgram < m_Programs.GetSize() && m_Programs[m_uiLastProgram].uiProgram == program)
+		return &m_Programs[m_uiLastProgram];
+
+	for(unsigned int i = 0; i < m_Programs.GetSize(); ++i)
+	{
+		if(m_Programs[i].uiProgram == program)
+		{
+			m_uiLastProgram = i;
+			return &m_Programs[i];
+		}
+	}
+
+	m_uiLastProgram = m_Programs.Append();
+	SProgram* psProgram = &m_Programs[m_uiLastProgram];
+	psProgram->uiProgram = program;
+	memset(psProgram->au8Floats, 0, sizeof(psProgram->au8Floats));
+	return psProgram;
+}
+
+/*!***************************************************************************
+ @Function			filter
+ @Input				program			program in use
+ @Input				location		uniform location, not -1
+ @Input				pValue			new value
+ @Input				uiFloats		size of the value in 32 bit words
+ @Return			true if the upload has to be issued
+ @Description		Compares the value with the cached one bit for bit, stores
+					it and counts the upload as issued or filtered.
+*****************************************************************************/
+bool CPVRTUniformCache::filter(GLuint program, GLint location, const void* pValue, unsigned int uiFloats)
+{
+	unsigned int uiBytes = uiFloats * sizeof(GLfloat);
+	if(location >= PVRTUNIFORMCACHE_MAX_LOCATIONS || uiFloats > PVRTUNIFORMCACHE_MAX_FLOATS)
+	{
+		m_sFrame.ui32Issued++;
+		m_sFrame.ui32IssuedBytes += uiBytes;
+		return true;
+	}
+
+	SProgram* psProgram = findProgram(program);
+	GLfloat* pfCached = psProgram->afValues[location];
+	if(psProgram->au8Floats[location] == uiFloats && memcmp(pfCached, pValue, uiBytes) == 0)
+	{
+		m_sFrame.ui32Filtered++;
+		m_sFrame.ui32FilteredBytes += uiBytes;
+		return false;
+	}
+
+	memcpy(pfCached, pValue, uiBytes);
+	psProgram->au8Floats[location] = (PVRTuint8)uiFloats;
+	m_sFrame.ui32Issued++;
+	m_sFrame.ui32IssuedBytes += uiBytes;
+	return true;
+}
+
+void CPVRTUniformCache::Uniform1i(GLuint program, GLint location, GLint x)
+{
+	if(location >= 0 && filter(program, location, &x, 1))
+		glUniform1i(location, x);
+}
+
+void CPVRTUniformCache::Uniform1f(GLuint program, GLint location, GLfloat x)
+{
+	if(location >= 0 && filter(program, location, &x, 1))
+		glUniform1f(location, x);
+}
+
+void CPVRTUniformCache::Uniform2fv(GLuint program, GLint location, const GLfloat* v)
+{
+	if(location >= 0 && filter(program, location, v, 2))
+		glUniform2fv(location, 1, v);
+}
+
+void CPVRTUniformCache::Uniform3fv(GLuint program, GLint location, const GLfloat* v)
+{
+	if(location >= 0 && filter(program, location, v, 3))
+		glUniform3fv(location, 1, v);
+}
+
+void CPVRTUniformCache::Uniform4fv(GLuint program, GLint location, const GLfloat* v)
+{
+	if(location >= 0 && filter(program, location, v, 4))
+		glUniform4fv(location, 1, v);
+}
+
+/*!***************************************************************************
+ @Function			Uniform4fv
+ @Input				count			number of vec4s in the array
+ @Description		Arrays are always issued and counted. The value of the
+					first element is forgotten, it may be set separately.
+*****************************************************************************/
+void CPVRTUniformCache::Uniform4fv(GLuint program, GLint location, GLsizei count, const GLfloat* v)
+{
+	if(location < 0)
+		return;
+	if(count == 1)
+	{
+		Uniform4fv(program, location, v);
+		return;
+	}
+	if(location < PVRTUNIFORMCACHE_MAX_LOCATIONS)
+		findProgram(program)->au8Floats[location] = 0;
+	m_sFrame.ui32Issued++;
+	m_sFrame.ui32IssuedBytes += count * 4 * sizeof(GLfloat);
+	glUniform4fv(location, count, v);
+}
+
+void CPVRTUniformCache::UniformMatrix4fv(GLuint program, GLint location, const GLfloat* value)
+{
+	if(location >= 0 && filter(program, location, value, 16))
+		glUniformMatrix4fv(location, 1, GL_FALSE, value);
+}
+
+/*****************************************************************************
+ End of file (PVRTUniformCache.cpp)
+*****************************************************************************/
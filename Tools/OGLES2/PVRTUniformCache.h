@@ -0,0 +1,101 @@
+/*!****************************************************************************
+
+ @file         OGLES2/PVRTUniformCache.h
+ @ingroup      API_OGLES2
+ @copyright    Copyright (c) Imagination Technologies Limited.
+ @brief        Shadow copy of the uniform values of shader programs that drops
+               uploads of values a location already holds.
+
+******************************************************************************/
+#ifndef _PVRTUNIFORMCACHE_H_
+#define _PVRTUNIFORMCACHE_H_
+
+/*!
+ @addtogroup API_OGLES2
+ @{
+*/
+
+#include "PVRTContext.h"
+#include "../PVRTGlobal.h"
+#include "../PVRTArray.h"
+
+/****************************************************************************
+** Defines
+****************************************************************************/
+#define PVRTUNIFORMCACHE_MAX_LOCATIONS	64	/*!< Locations above this are passed through uncached */
+#define PVRTUNIFORMCACHE_MAX_FLOATS		16	/*!< Largest cached value, a mat4. Arrays are passed through */
+
+/****************************************************************************
+** Structures
+****************************************************************************/
+/*!***************************************************************************
+ @struct    SPVRTUniformCacheCounters
+ @brief     Uploads that reached the driver and uploads that were dropped.
+*****************************************************************************/
+struct SPVRTUniformCacheCounters
+{
+	unsigned int	ui32Issued;
+	unsigned int	ui32Filtered;
+	unsigned int	ui32IssuedBytes;		/*!< Size of the issued values */
+	unsigned int	ui32FilteredBytes;
+
+	void Reset();
+};
+
+/****************************************************************************
+** Class
+****************************************************************************/
+/*!***************************************************************************
+ @class     CPVRTUniformCache
+ @brief     Thin layer in front of the glUniform calls.
+ @details   Uniform values belong to the program object, so the cache keeps
+            the last value uploaded to every location of every program it
+            sees and only calls GL when the new value differs. The program
+            passed in must be the one in use. Values start out unknown and
+            stay valid while other programs are used; programs that are
+            deleted or relinked must be forgotten with InvalidateProgram().
+            Location -1 is ignored like GL does.
+*****************************************************************************/
+class CPVRTUniformCache
+{
+public:
+	CPVRTUniformCache();
+
+	void Invalidate();
+	void InvalidateProgram(GLuint program);
+	void NewFrame();
+
+	void Uniform1i(GLuint program, GLint location, GLint x);
+	void Uniform1f(GLuint program, GLint location, GLfloat x);
+	void Uniform2fv(GLuint program, GLint location, const GLfloat* v);
+	void Uniform3fv(GLuint program, GLint location, const GLfloat* v);
+	void Uniform4fv(GLuint program, GLint location, const GLfloat* v);
+	void Uniform4fv(GLuint program, GLint location, GLsizei count, const GLfloat* v);
+	void UniformMatrix4fv(GLuint program, GLint location, const GLfloat* value);
+
+	/*! Counters of the frame being drawn, and of the last one after NewFrame */
+	SPVRTUniformCacheCounters m_sFrame;
+	SPVRTUniformCacheCounters m_sLastFrame;
+
+private:
+	struct SProgram
+	{
+		GLuint		uiProgram;
+		PVRTuint8	au8Floats[PVRTUNIFORMCACHE_MAX_LOCATIONS];		/*!< Size of the cached value, 0 unknown */
+		GLfloat		afValues[PVRTUNIFORMCACHE_MAX_LOCATIONS][PVRTUNIFORMCACHE_MAX_FLOATS];
+	};
+
+	bool filter(GLuint program, GLint location, const void* pValue, unsigned int uiFloats);
+	SProgram* findProgram(GLuint program);
+
+	CPVRTArray<SProgram>	m_Programs;
+	unsigned int			m_uiLastProgram;		/*!< Index of the last program found */
+};
+
+/*! @} */
+
+#endif /* _PVRTUNIFORMCACHE_H_ */
+
+/*****************************************************************************
+ End of file (PVRTUniformCache.h)
+*****************************************************************************/
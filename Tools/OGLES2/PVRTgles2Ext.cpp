@@ -51,9 +51,16 @@ void CPVRTgles2Ext::LoadExtensions()
 	glEndQueryEXT = 0;
 	glGetQueryivEXT = 0;
 	glGetQueryObjectuivEXT = 0;
+	glQueryCounterEXT = 0;
+	glGetQueryObjectui64vEXT = 0;
 	glRenderbufferStorageMultisampleEXT = 0;
 	glFramebufferTexture2DMultisampleEXT = 0;
 	glDrawBuffersEXT = 0;
+	glDrawElementsInstancedEXT = 0;
+	glVertexAttribDivisorEXT = 0;
+	glGetUniformBlockIndex = 0;
+	glUniformBlockBinding = 0;
+	glBindBufferBase = 0;
 
 	// Supported extensions provide new entry points for OpenGL ES 2.0.
 
@@ -78,14 +85,30 @@ void CPVRTgles2Ext::LoadExtensions()
         glGetBufferPointervOES = (PFNGLGETBUFFERPOINTERVOES) PVRGetProcAddress(glGetBufferPointervOES);
 	}
 
-	/* GL_OES_vertex_array_object */
-	if (strstr((char *)pszGLExtensions, "GL_OES_vertex_array_object"))
+	/* Vertex array objects: OpenGL ES 3.0 core or GL_OES_vertex_array_object */
+	const char *pszGLVersion = (const char *)glGetString(GL_VERSION);
+	bool bGLES3 = pszGLVersion && strncmp(pszGLVersion, "OpenGL ES ", 10) == 0 && pszGLVersion[10] >= '3' && pszGLVersion[10] <= '9';
+	if (bGLES3)
+	{
+		glBindVertexArrayOES = (PFNGLBINDVERTEXARRAYOES) PVRGetProcAddress(glBindVertexArray);
+		glDeleteVertexArraysOES = (PFNGLDELETEVERTEXARRAYSOES) PVRGetProcAddress(glDeleteVertexArrays);
+		glGenVertexArraysOES = (PFNGLGENVERTEXARRAYSOES) PVRGetProcAddress(glGenVertexArrays);
+		glIsVertexArrayOES = (PFNGLISVERTEXARRAYOES) PVRGetProcAddress(glIsVertexArray);
+	}
+	if ((!glBindVertexArrayOES || !glDeleteVertexArraysOES || !glGenVertexArraysOES) && strstr((char *)pszGLExtensions, "GL_OES_vertex_array_object"))
 	{
         glBindVertexArrayOES = (PFNGLBINDVERTEXARRAYOES) PVRGetProcAddress(glBindVertexArrayOES);
         glDeleteVertexArraysOES = (PFNGLDELETEVERTEXARRAYSOES) PVRGetProcAddress(glDeleteVertexArraysOES);
         glGenVertexArraysOES = (PFNGLGENVERTEXARRAYSOES) PVRGetProcAddress(glGenVertexArraysOES);
 		glIsVertexArrayOES = (PFNGLISVERTEXARRAYOES) PVRGetProcAddress(glIsVertexArrayOES);
 	}
+	if (!glBindVertexArrayOES || !glDeleteVertexArraysOES || !glGenVertexArraysOES)
+	{
+		glBindVertexArrayOES = 0;
+		glDeleteVertexArraysOES = 0;
+		glGenVertexArraysOES = 0;
+		glIsVertexArrayOES = 0;
+	}
 
 	/* GL_IMG_multisampled_render_to_texture */
 	if (strstr((char *)pszGLExtensions, "GL_IMG_multisampled_render_to_texture"))
@@ -106,6 +129,42 @@ void CPVRTgles2Ext::LoadExtensions()
 	{
 		glDrawBuffersEXT = (PFNGLDRAWBUFFERSEXT) PVRGetProcAddress(glDrawBuffersEXT);
 	}
+
+	/* Instanced arrays: OpenGL ES 3.0 core, GL_EXT_instanced_arrays or GL_ANGLE_instanced_arrays */
+	if (bGLES3)
+	{
+		glDrawElementsInstancedEXT = (PFNGLDRAWELEMENTSINSTANCEDEXT) PVRGetProcAddress(glDrawElementsInstanced);
+		glVertexAttribDivisorEXT = (PFNGLVERTEXATTRIBDIVISOREXT) PVRGetProcAddress(glVertexAttribDivisor);
+	}
+	if ((!glDrawElementsInstancedEXT || !glVertexAttribDivisorEXT) && strstr((char *)pszGLExtensions, "GL_EXT_instanced_arrays"))
+	{
+		glDrawElementsInstancedEXT = (PFNGLDRAWELEMENTSINSTANCEDEXT) PVRGetProcAddress(glDrawElementsInstancedEXT);
+		glVertexAttribDivisorEXT = (PFNGLVERTEXATTRIBDIVISOREXT) PVRGetProcAddress(glVertexAttribDivisorEXT);
+	}
+	if ((!glDrawElementsInstancedEXT || !glVertexAttribDivisorEXT) && strstr((char *)pszGLExtensions, "GL_ANGLE_instanced_arrays"))
+	{
+		glDrawElementsInstancedEXT = (PFNGLDRAWELEMENTSINSTANCEDEXT) PVRGetProcAddress(glDrawElementsInstancedANGLE);
+		glVertexAttribDivisorEXT = (PFNGLVERTEXATTRIBDIVISOREXT) PVRGetProcAddress(glVertexAttribDivisorANGLE);
+	}
+	if (!glDrawElementsInstancedEXT || !glVertexAttribDivisorEXT)
+	{
+		glDrawElementsInstancedEXT = 0;
+		glVertexAttribDivisorEXT = 0;
+	}
+
+	/* Uniform buffer objects: OpenGL ES 3.0 core */
+	if (bGLES3)
+	{
+		glGetUniformBlockIndex = (PFNGLGETUNIFORMBLOCKINDEX) PVRGetProcAddress(glGetUniformBlockIndex);
+		glUniformBlockBinding = (PFNGLUNIFORMBLOCKBINDING) PVRGetProcAddress(glUniformBlockBinding);
+		glBindBufferBase = (PFNGLBINDBUFFERBASE) PVRGetProcAddress(glBindBufferBase);
+	}
+	if (!glGetUniformBlockIndex || !glUniformBlockBinding || !glBindBufferBase)
+	{
+		glGetUniformBlockIndex = 0;
+		glUniformBlockBinding = 0;
+		glBindBufferBase = 0;
+	}
 #endif
 
 #if defined(GL_EXT_discard_framebuffer)
@@ -127,6 +186,20 @@ void CPVRTgles2Ext::LoadExtensions()
 		glGetQueryivEXT = (PFNGLGETQUERYIVEXT) PVRGetProcAddress(glGetQueryivEXT);
 		glGetQueryObjectuivEXT = (PFNGLGETQUERYOBJECTUIVEXT) PVRGetProcAddress(glGetQueryObjectuivEXT);
 	}
+
+	/* GL_EXT_disjoint_timer_query */
+	if (strstr((char *)pszGLExtensions, "GL_EXT_disjoint_timer_query"))
+	{
+		glGenQueriesEXT = (PFNGLGENQUERIESEXT) PVRGetProcAddress(glGenQueriesEXT);
+		glDeleteQueriesEXT = (PFNGLDELETEQUERIESEXT) PVRGetProcAddress(glDeleteQueriesEXT);
+		glIsQueryEXT = (PFNGLISQUERYEXT) PVRGetProcAddress(glIsQueryEXT);
+		glBeginQueryEXT = (PFNGLBEGINQUERYEXT) PVRGetProcAddress(glBeginQueryEXT);
+		glEndQueryEXT = (PFNGLENDQUERYEXT) PVRGetProcAddress(glEndQueryEXT);
+		glGetQueryivEXT = (PFNGLGETQUERYIVEXT) PVRGetProcAddress(glGetQueryivEXT);
+		glGetQueryObjectuivEXT = (PFNGLGETQUERYOBJECTUIVEXT) PVRGetProcAddress(glGetQueryObjectuivEXT);
+		glQueryCounterEXT = (PFNGLQUERYCOUNTEREXT) PVRGetProcAddress(glQueryCounterEXT);
+		glGetQueryObjectui64vEXT = (PFNGLGETQUERYOBJECTUI64VEXT) PVRGetProcAddress(glGetQueryObjectui64vEXT);
+	}
 }
 
 /*!***********************************************************************
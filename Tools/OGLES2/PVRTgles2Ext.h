@@ -92,6 +92,8 @@ public:
 	typedef void (GL_APIENTRY *PFNGLENDQUERYEXT) (GLenum target);
 	typedef void (GL_APIENTRY *PFNGLGETQUERYIVEXT) (GLenum target, GLenum pname, GLint *params);
 	typedef void (GL_APIENTRY *PFNGLGETQUERYOBJECTUIVEXT) (GLuint id, GLenum pname, GLuint *params);
+	typedef void (GL_APIENTRY *PFNGLQUERYCOUNTEREXT) (GLuint id, GLenum target);
+	typedef void (GL_APIENTRY *PFNGLGETQUERYOBJECTUI64VEXT) (GLuint id, GLenum pname, GLuint64 *params);
 
 	typedef void (GL_APIENTRYP PFNGLBINDVERTEXARRAYOES) (GLuint vertexarray);
 	typedef void (GL_APIENTRYP PFNGLDELETEVERTEXARRAYSOES) (GLsizei n, const GLuint *vertexarrays);
@@ -106,6 +108,13 @@ public:
 	
 	typedef void (GL_APIENTRYP PFNGLDRAWBUFFERSEXT) (GLsizei n, const GLenum *bufs);
 
+	typedef void (GL_APIENTRYP PFNGLDRAWELEMENTSINSTANCEDEXT) (GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei primcount);
+	typedef void (GL_APIENTRYP PFNGLVERTEXATTRIBDIVISOREXT) (GLuint index, GLuint divisor);
+
+	typedef GLuint (GL_APIENTRYP PFNGLGETUNIFORMBLOCKINDEX) (GLuint program, const GLchar *uniformBlockName);
+	typedef void (GL_APIENTRYP PFNGLUNIFORMBLOCKBINDING) (GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding);
+	typedef void (GL_APIENTRYP PFNGLBINDBUFFERBASE) (GLenum target, GLuint index, GLuint buffer);
+
 	// GL_EXT_multi_draw_arrays
 	PFNGLMULTIDRAWELEMENTS				glMultiDrawElementsEXT;
 	PFNGLMULTIDRAWARRAYS				glMultiDrawArraysEXT;
@@ -124,7 +133,7 @@ public:
 	#define GL_ANY_SAMPLES_PASSED_CONSERVATIVE_EXT                  0x8D6A
 	#define GL_CURRENT_QUERY_EXT                                    0x8865
 	#define GL_QUERY_RESULT_EXT                                     0x8866
-	#define GL_QUERY_RESULT_AVAILABLE_EXT                           0x886
+	#define GL_QUERY_RESULT_AVAILABLE_EXT                           0x8867
 #endif
 	PFNGLGENQUERIESEXT                  glGenQueriesEXT;
 	PFNGLDELETEQUERIESEXT               glDeleteQueriesEXT;
@@ -134,11 +143,22 @@ public:
 	PFNGLGETQUERYIVEXT                  glGetQueryivEXT;
 	PFNGLGETQUERYOBJECTUIVEXT           glGetQueryObjectuivEXT;
 
+	// GL_EXT_disjoint_timer_query, also loads the query functions above
+#if !defined(GL_EXT_disjoint_timer_query)
+	#define GL_QUERY_COUNTER_BITS_EXT                               0x8864
+	#define GL_TIME_ELAPSED_EXT                                     0x88BF
+	#define GL_TIMESTAMP_EXT                                        0x8E28
+	#define GL_GPU_DISJOINT_EXT                                     0x8FBB
+#endif
+	PFNGLQUERYCOUNTEREXT                glQueryCounterEXT;
+	PFNGLGETQUERYOBJECTUI64VEXT         glGetQueryObjectui64vEXT;
+
 	// GL_OES_vertex_array_object
 #if !defined(GL_OES_vertex_array_object)
 	#define GL_VERTEX_ARRAY_BINDING_OES 0x85B5
 #endif
 
+	// also loaded from the OpenGL ES 3.0 core entry points when the context has them
 	PFNGLBINDVERTEXARRAYOES glBindVertexArrayOES;
 	PFNGLDELETEVERTEXARRAYSOES glDeleteVertexArraysOES;
 	PFNGLGENVERTEXARRAYSOES glGenVertexArraysOES;
@@ -206,6 +226,20 @@ public:
 
 	PFNGLDRAWBUFFERSEXT                 glDrawBuffersEXT;
 
+	// GL_EXT_instanced_arrays, also loaded from GL_ANGLE_instanced_arrays or
+	// from the OpenGL ES 3.0 core entry points when the context has them
+	PFNGLDRAWELEMENTSINSTANCEDEXT       glDrawElementsInstancedEXT;
+	PFNGLVERTEXATTRIBDIVISOREXT         glVertexAttribDivisorEXT;
+
+	// Uniform buffer objects, OpenGL ES 3.0 core only
+#if !defined(GL_UNIFORM_BUFFER)
+	#define GL_UNIFORM_BUFFER                                       0x8A11
+	#define GL_INVALID_INDEX                                        0xFFFFFFFFu
+#endif
+	PFNGLGETUNIFORMBLOCKINDEX           glGetUniformBlockIndex;
+	PFNGLUNIFORMBLOCKBINDING            glUniformBlockBinding;
+	PFNGLBINDBUFFERBASE                 glBindBufferBase;
+
 public:
 	/*!***********************************************************************
 	@brief      		Initialises IMG extensions
@@ -0,0 +1,147 @@
+/******************************************************************************
+
+ @File         PVRTMappedFile.cpp
+
+ @Title        PVRTMappedFile
+
+ @Version
+
+ @Copyright    Copyright (c) Imagination Technologies Limited.
+
+ @Platform     Windows and POSIX
+
+ @Description  Copy-on-write view of a file mapped into memory.
+
+******************************************************************************/
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "PVRTMappedFile.h"
+#include "PVRTResourceFile.h"
+
+/****************************************************************************
+** Class: CPVRTMappedFile
+****************************************************************************/
+/*!***************************************************************************
+@Function			CPVRTMappedFile
+@Input				pszFilename		Name of the file, relative to the read path
+@Description		Constructor. IsOpen tells whether the mapping worked.
+*****************************************************************************/
+CPVRTMappedFile::CPVRTMappedFile(const char* pszFilename) :
+	m_pData(0),
+	m_Size(0)
+#if defined(_WIN32)
+	, m_hFile(INVALID_HANDLE_VALUE),
+	m_hMapping(0)
+#endif
+{
+	if(!pszFilename)
+		return;
+
+	CPVRTString Path(CPVRTResourceFile::GetReadPath());
+	Path += pszFilename;
+
+#if defined(_WIN32)
+	m_hFile = CreateFileA(Path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(m_hFile == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER Size;
+	if(!GetFileSizeEx(m_hFile, &Size) || Size.QuadPart == 0 || (unsigned long long) Size.QuadPart > (size_t) -1)
+		return;
+
+	m_hMapping = CreateFileMappingA(m_hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	if(!m_hMapping)
+		return;
+
+	m_pData = MapViewOfFile(m_hMapping, FILE_MAP_COPY, 0, 0, 0);
+	if(m_pData)
+		m_Size = (size_t) Size.QuadPart;
+#else
+	int File = open(Path.c_str(), O_RDONLY);
+	if(File < 0)
+		return;
+
+	struct stat Stat;
+	if(fstat(File, &Stat) == 0 && S_ISREG(Stat.st_mode) && Stat.st_size > 0)
+	{
+		void* pData = mmap(NULL, (size_t) Stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, File, 0);
+		if(pData != MAP_FAILED)
+		{
+			m_pData = pData;
+			m_Size = (size_t) Stat.st_size;
+		}
+	}
+
+	// the mapping keeps the file referenced
+	close(File);
+#endif
+}
+
+/*!***************************************************************************
+@Function			~CPVRTMappedFile
+@Description		Destructor
+*****************************************************************************/
+CPVRTMappedFile::~CPVRTMappedFile()
+{
+#if defined(_WIN32)
+	if(m_pData)
+		UnmapViewOfFile(m_pData);
+	if(m_hMapping)
+		CloseHandle(m_hMapping);
+	if(m_hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(m_hFile);
+#else
+	if(m_pData)
+		munmap(m_pData, m_Size);
+#endif
+}
+
+/*!***************************************************************************
+@Function			IsOpen
+@Returns			true if the file is mapped
+*****************************************************************************/
+bool CPVRTMappedFile::IsOpen() const
+{
+	return m_pData != 0;
+}
+
+/*!***************************************************************************
+@Function			Size
+@Returns			Size of the file in bytes
+*****************************************************************************/
+size_t CPVRTMappedFile::Size() const
+{
+	return m_Size;
+}
+
+/*!***************************************************************************
+@Function			DataPtr
+@Returns			The start of the file, aligned to a page
+*****************************************************************************/
+void* CPVRTMappedFile::DataPtr() const
+{
+	return m_pData;
+}
+
+/*!***************************************************************************
+@Function			Contains
+@Input				p				Any pointer
+@Returns			true if p points into the mapping
+*****************************************************************************/
+bool CPVRTMappedFile::Contains(const void* p) const
+{
+	const char* pBegin = (const char*) m_pData;
+	return m_pData && (const char*) p >= pBegin && (const char*) p < pBegin + m_Size;
+}
+
+/*****************************************************************************
+ End of file (PVRTMappedFile.cpp)
+*****************************************************************************/
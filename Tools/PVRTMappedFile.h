@@ -0,0 +1,63 @@
+/*!****************************************************************************
+
+ @file         PVRTMappedFile.h
+ @copyright    Copyright (c) Imagination Technologies Limited.
+ @brief        Copy-on-write view of a file mapped into memory.
+
+******************************************************************************/
+#ifndef _PVRTMAPPEDFILE_H_
+#define _PVRTMAPPEDFILE_H_
+
+#include <stdlib.h>
+
+/*!***************************************************************************
+ @class     CPVRTMappedFile
+ @brief     Maps a file under the CPVRTResourceFile read path copy-on-write,
+            so the pages are read from disk as they are touched and writes
+            change only the process's copy of a page.
+ @details   Only files on disk can be mapped. Memory files and files the
+            platform opens through CPVRTResourceFile::SetLoadReleaseFunctions
+            fail to open; use CPVRTResourceFile for those.
+*****************************************************************************/
+class CPVRTMappedFile
+{
+public:
+	/*!***************************************************************************
+	@brief     			CPVRTMappedFile constructor
+	@param[in]			pszFilename Name of the file, relative to the read path
+	*****************************************************************************/
+	CPVRTMappedFile(const char* pszFilename);
+
+	/*!***************************************************************************
+	@brief      		Unmaps the file. Pointers into it become invalid.
+	*****************************************************************************/
+	~CPVRTMappedFile();
+
+	bool IsOpen() const;
+	size_t Size() const;
+	void* DataPtr() const;
+
+	/*!***************************************************************************
+	@fn       			Contains
+	@param[in]			p Any pointer
+	@return 			true if p points into the mapping
+	*****************************************************************************/
+	bool Contains(const void* p) const;
+
+private:
+	CPVRTMappedFile(const CPVRTMappedFile&);
+	CPVRTMappedFile& operator=(const CPVRTMappedFile&);
+
+	void*	m_pData;
+	size_t	m_Size;
+#if defined(_WIN32)
+	void*	m_hFile;		/*!< HANDLE */
+	void*	m_hMapping;		/*!< HANDLE */
+#endif
+};
+
+#endif /* _PVRTMAPPEDFILE_H_ */
+
+/*****************************************************************************
+ End of file (PVRTMappedFile.h)
+*****************************************************************************/
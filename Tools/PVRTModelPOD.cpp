@@ -17,6 +17,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <atomic>
 
 #include "PVRTGlobal.h"
 #if defined(BUILD_DX11)
@@ -31,6 +32,8 @@
 #include "PVRTMisc.h"
 #include "PVRTResourceFile.h"
 #include "PVRTTrans.h"
+#include "PVRTTrace.h"
+#include "PVRTMappedFile.h"
 
 /****************************************************************************
 ** Defines
@@ -184,6 +187,7 @@ struct SPVRTPODImpl
 	PVRTMATRIX	*pWmZeroCache;	/*!< Pre-calculated frame 0 matrices */
 
 	bool		bFromMemory;	/*!< Was the mesh data loaded from memory? */
+	CPVRTMappedFile	*pMapping;	/*!< File that mesh and animation data point into, NULL if all data was copied */
 
 #ifdef _DEBUG
 	PVRTint64 nWmTotal, nWmCacheHit, nWmZeroCacheHit;
@@ -191,6 +195,11 @@ struct SPVRTPODImpl
 #endif
 };
 
+/****************************************************************************
+** Globals
+****************************************************************************/
+static std::atomic<unsigned int> s_ui32LoadGenerations(0);	/*!< Last value given to CPVRTModelPOD::GetLoadGeneration */
+
 /****************************************************************************
 ** Local code: Memory allocation
 ****************************************************************************/
@@ -229,6 +238,22 @@ void SafeRealloc(T* &ptr, size_t cnt)
 	_ASSERT(ptr);
 }
 
+/*!***************************************************************************
+ @Function			FreeOwned
+ @Modified			ptr
+ @Input				pMapping		File mapped by ReadFromFileMapped, or NULL
+ @Description		Frees ptr unless it points into the mapped file, and sets
+					it to NULL either way.
+*****************************************************************************/
+template <typename T>
+void FreeOwned(T* &ptr, const CPVRTMappedFile * const pMapping)
+{
+	if(pMapping && pMapping->Contains(ptr))
+		ptr = 0;
+	else
+		FREE(ptr);
+}
+
 /****************************************************************************
 ** Class: CPODData
 ****************************************************************************/
@@ -270,6 +295,17 @@ public:
 	virtual bool Read(void* lpBuffer, const unsigned int dwNumberOfBytesToRead) = 0;
 	virtual bool Skip(const unsigned int nBytes) = 0;
 
+	/*!***************************************************************************
+	@Function			Borrow
+	@Input				nBytes			Size of the block
+	@Input				nAlign			Alignment the block needs
+	@Return			Pointer to the block in the source, NULL to read a copy
+	@Description		Skips the block and returns where it is, for sources
+						whose data outlives the scene. Nothing is skipped when
+						NULL is returned.
+	*****************************************************************************/
+	virtual void* Borrow(const unsigned int nBytes, const unsigned int nAlign) { PVRT_UNREFERENCED_PARAMETER(nBytes); PVRT_UNREFERENCED_PARAMETER(nAlign); return 0; }
+
 	template <typename T>
 	bool Read(T &n)
 	{
@@ -316,6 +352,13 @@ public:
 		return Read(lpBuffer, dwNumberOfBytesToRead);
 	}
 
+	template <typename T>
+	bool BorrowOrReadAfterAlloc(T* &lpBuffer, const unsigned int dwNumberOfBytesToRead, const unsigned int nAlign)
+	{
+		lpBuffer = (T*) Borrow(dwNumberOfBytesToRead, nAlign);
+		return lpBuffer || ReadAfterAlloc(lpBuffer, dwNumberOfBytesToRead);
+	}
+
 	template <typename T>
 	bool ReadAfterAlloc32(T* &lpBuffer, const unsigned int dwNumberOfBytesToRead)
 	{
@@ -337,6 +380,15 @@ public:
 		return bRet;
 	}
 
+	// the file is little endian, big endian platforms always get a swapped copy
+	template <typename T>
+	bool BorrowOrReadAfterAlloc32(T* &lpBuffer, const unsigned int dwNumberOfBytesToRead)
+	{
+		check32BitType<T>();
+		lpBuffer = PVRTIsLittleEndian() ? (T*) Borrow(dwNumberOfBytesToRead, 4) : 0;
+		return lpBuffer || ReadAfterAlloc32(lpBuffer, dwNumberOfBytesToRead);
+	}
+
 	template <typename T>
 	bool ReadAfterAlloc16(T* &lpBuffer, const unsigned int dwNumberOfBytesToRead)
 	{
@@ -346,6 +398,14 @@ public:
 		return ReadArray16((unsigned short*) lpBuffer, dwNumberOfBytesToRead / 2);
 	}
 
+	template <typename T>
+	bool BorrowOrReadAfterAlloc16(T* &lpBuffer, const unsigned int dwNumberOfBytesToRead)
+	{
+		check16BitType<T>();
+		lpBuffer = PVRTIsLittleEndian() ? (T*) Borrow(dwNumberOfBytesToRead, 2) : 0;
+		return lpBuffer || ReadAfterAlloc16(lpBuffer, dwNumberOfBytesToRead);
+	}
+
 	bool ReadArray16(unsigned short* pn, unsigned int i32Size)
 	{
 		bool bRet = true;
@@ -486,6 +546,78 @@ bool CSourceStream::Skip(const unsigned int nBytes)
 	return true;
 }
 
+/*!***************************************************************************
+ Class: CSourceMapped
+*****************************************************************************/
+class CSourceMapped : public CSource
+{
+protected:
+	unsigned char	*m_pData;
+	size_t			m_nSize, m_nReadPos, m_nBorrowed;
+
+public:
+	CSourceMapped(const CPVRTMappedFile &file) : m_pData((unsigned char*) file.DataPtr()), m_nSize(file.Size()), m_nReadPos(0), m_nBorrowed(0) {}
+
+	virtual bool Read(void* lpBuffer, const unsigned int dwNumberOfBytesToRead);
+	virtual bool Skip(const unsigned int nBytes);
+	virtual void* Borrow(const unsigned int nBytes, const unsigned int nAlign);
+
+	size_t BorrowedBytes() const { return m_nBorrowed; }
+};
+
+/*!***************************************************************************
+@Function			Read
+@Modified			lpBuffer				Buffer to write the data into
+@Input				dwNumberOfBytesToRead	Number of bytes to read
+@Description		Reads specified number of bytes from the mapped file
+					into the output buffer.
+*****************************************************************************/
+bool CSourceMapped::Read(void* lpBuffer, const unsigned int dwNumberOfBytesToRead)
+{
+	_ASSERT(lpBuffer);
+
+	if(m_nReadPos + dwNumberOfBytesToRead > m_nSize)
+		return false;
+
+	memcpy(lpBuffer, &m_pData[m_nReadPos], dwNumberOfBytesToRead);
+	m_nReadPos += dwNumberOfBytesToRead;
+	return true;
+}
+
+/*!***************************************************************************
+@Function			Skip
+@Input				nBytes			The number of bytes to skip
+@Description		Skips the specified number of bytes of the mapped file.
+*****************************************************************************/
+bool CSourceMapped::Skip(const unsigned int nBytes)
+{
+	if(m_nReadPos + nBytes > m_nSize)
+		return false;
+
+	m_nReadPos += nBytes;
+	return true;
+}
+
+/*!***************************************************************************
+@Function			Borrow
+@Input				nBytes			Size of the block
+@Input				nAlign			Alignment the block needs
+@Return			Pointer to the block in the mapping, NULL if it is empty,
+					past the end or not aligned
+@Description		The mapping starts on a page, so a block is aligned when
+					its offset in the file is.
+*****************************************************************************/
+void* CSourceMapped::Borrow(const unsigned int nBytes, const unsigned int nAlign)
+{
+	if(nBytes == 0 || m_nReadPos + nBytes > m_nSize || ((size_t) &m_pData[m_nReadPos]) % nAlign != 0)
+		return 0;
+
+	void* pBlock = &m_pData[m_nReadPos];
+	m_nReadPos += nBytes;
+	m_nBorrowed += nBytes;
+	return pBlock;
+}
+
 #if defined(_WIN32)
 /*!***************************************************************************
  Class: CSourceResource
@@ -1170,18 +1302,18 @@ static bool ReadCPODData(
 			{
 				switch(PVRTModelPODDataTypeSize(s.eType))
 				{
-					case 1: if(!src.ReadAfterAlloc(s.pData, nLen)) return false; break;
+					case 1: if(!src.BorrowOrReadAfterAlloc(s.pData, nLen, 1)) return false; break;
 					case 2:
 						{ // reading 16bit data but have 8bit pointer
 							PVRTuint16 *p16Pointer=NULL;
-							if(!src.ReadAfterAlloc16(p16Pointer, nLen)) return false;
+							if(!src.BorrowOrReadAfterAlloc16(p16Pointer, nLen)) return false;
 							s.pData = (unsigned char*)p16Pointer;
 							break;
 						}
 					case 4:
 						{ // reading 32bit data but have 8bit pointer
 							PVRTuint32 *p32Pointer=NULL;
-							if(!src.ReadAfterAlloc32(p32Pointer, nLen)) return false;
+							if(!src.BorrowOrReadAfterAlloc32(p32Pointer, nLen)) return false;
 							s.pData = (unsigned char*)p32Pointer;
 							break;
 						}
@@ -1233,7 +1365,7 @@ static bool ReadCamera(
 		case ePODFileCamFOV:		if(!src.Read32(s.fFOV)) return false;							break;
 		case ePODFileCamFar:		if(!src.Read32(s.fFar)) return false;							break;
 		case ePODFileCamNear:		if(!src.Read32(s.fNear)) return false;						break;
-		case ePODFileCamAnimFOV:	if(!src.ReadAfterAlloc32(s.pfAnimFOV, nLen)) return false;	break;
+		case ePODFileCamAnimFOV:	if(!src.BorrowOrReadAfterAlloc32(s.pfAnimFOV, nLen)) return false;	break;
 
 		default:
 			if(!src.Skip(nLen)) return false;
@@ -1474,7 +1606,7 @@ static bool ReadMesh(
 		case ePODFileMeshNumUVW:			if(!src.Read32(s.nNumUVW)) return false;	if(!SafeAlloc(s.psUVW, s.nNumUVW)) return false;	break;
 		case ePODFileMeshStripLength:		if(!src.ReadAfterAlloc32(s.pnStripLength, nLen)) return false;								break;
 		case ePODFileMeshNumStrips:			if(!src.Read32(s.nNumStrips)) return false;													break;
-		case ePODFileMeshInterleaved:		if(!src.ReadAfterAlloc(s.pInterleaved, nLen)) return false;									break;
+		case ePODFileMeshInterleaved:		if(!src.BorrowOrReadAfterAlloc(s.pInterleaved, nLen, 4)) return false;						break;
 		case ePODFileMeshBoneBatches:		if(!src.ReadAfterAlloc32(s.sBoneBatches.pnBatches, nLen)) return false;						break;
 		case ePODFileMeshBoneBatchBoneCnts:	if(!src.ReadAfterAlloc32(s.sBoneBatches.pnBatchBoneCnt, nLen)) return false;					break;
 		case ePODFileMeshBoneBatchOffsets:	if(!src.ReadAfterAlloc32(s.sBoneBatches.pnBatchOffset, nLen)) return false;					break;
@@ -1559,17 +1691,17 @@ static bool ReadNode(
 		case ePODFileNodeIdxParent:	if(!src.Read32(s.nIdxParent)) return false;						break;
 		case ePODFileNodeAnimFlags:if(!src.Read32(s.nAnimFlags))return false;							break;
 
-		case ePODFileNodeAnimPosIdx:	if(!src.ReadAfterAlloc32(s.pnAnimPositionIdx, nLen)) return false;	break;
-		case ePODFileNodeAnimPos:	if(!src.ReadAfterAlloc32(s.pfAnimPosition, nLen)) return false;	break;
+		case ePODFileNodeAnimPosIdx:	if(!src.BorrowOrReadAfterAlloc32(s.pnAnimPositionIdx, nLen)) return false;	break;
+		case ePODFileNodeAnimPos:	if(!src.BorrowOrReadAfterAlloc32(s.pfAnimPosition, nLen)) return false;	break;
 
-		case ePODFileNodeAnimRotIdx:	if(!src.ReadAfterAlloc32(s.pnAnimRotationIdx, nLen)) return false;	break;
-		case ePODFileNodeAnimRot:	if(!src.ReadAfterAlloc32(s.pfAnimRotation, nLen)) return false;	break;
+		case ePODFileNodeAnimRotIdx:	if(!src.BorrowOrReadAfterAlloc32(s.pnAnimRotationIdx, nLen)) return false;	break;
+		case ePODFileNodeAnimRot:	if(!src.BorrowOrReadAfterAlloc32(s.pfAnimRotation, nLen)) return false;	break;
 
-		case ePODFileNodeAnimScaleIdx:	if(!src.ReadAfterAlloc32(s.pnAnimScaleIdx, nLen)) return false;	break;
-		case ePODFileNodeAnimScale:	if(!src.ReadAfterAlloc32(s.pfAnimScale, nLen)) return false;		break;
+		case ePODFileNodeAnimScaleIdx:	if(!src.BorrowOrReadAfterAlloc32(s.pnAnimScaleIdx, nLen)) return false;	break;
+		case ePODFileNodeAnimScale:	if(!src.BorrowOrReadAfterAlloc32(s.pfAnimScale, nLen)) return false;		break;
 
-		case ePODFileNodeAnimMatrixIdx:	if(!src.ReadAfterAlloc32(s.pnAnimMatrixIdx, nLen)) return false;	break;
-		case ePODFileNodeAnimMatrix:if(!src.ReadAfterAlloc32(s.pfAnimMatrix, nLen)) return false;	break;
+		case ePODFileNodeAnimMatrixIdx:	if(!src.BorrowOrReadAfterAlloc32(s.pnAnimMatrixIdx, nLen)) return false;	break;
+		case ePODFileNodeAnimMatrix:if(!src.BorrowOrReadAfterAlloc32(s.pfAnimMatrix, nLen)) return false;	break;
 
 		case ePODFileNodeUserData:
 			if(!src.ReadAfterAlloc(s.pUserData, nLen))
@@ -1830,7 +1962,7 @@ static bool Read(
 *****************************************************************************/
 static EPVRTError ReadFromSourceStream(
 	CPVRTModelPOD	* const pS,
-	CSourceStream &src,
+	CSource			&src,
 	char			* const pszExpOpt,
 	const size_t	count,
 	char			* const pszHistory,
@@ -1873,6 +2005,7 @@ EPVRTError CPVRTModelPOD::ReadFromFile(
 	char			* const pszHistory,
 	const size_t	historyCount)
 {
+	PVRTTRACE_SCOPE("CPVRTModelPOD::ReadFromFile");
 	CSourceStream src;
 
 	if(!src.Init(pszFileName))
@@ -1881,6 +2014,54 @@ EPVRTError CPVRTModelPOD::ReadFromFile(
 	return ReadFromSourceStream(this, src, pszExpOpt, count, pszHistory, historyCount);
 }
 
+/*!***************************************************************************
+ @Function			ReadFromFileMapped
+ @Input				pszFileName		Filename to load
+ @Return			PVR_SUCCESS if successful, PVR_FAIL if not
+ @Description		Loads the specified ".POD" file like ReadFromFile, but
+					maps the file instead of reading it. Vertex, index and
+					animation blocks are used where they lie in the mapping
+					when they are aligned and, for 16 and 32 bit data, the
+					platform is little endian; other blocks are copied as
+					usual. Big endian platforms fix interleaved data in
+					place, the copy-on-write mapping then copies just those
+					pages. The mapping lives until Destroy. The mesh
+					functions that reallocate data, e.g.
+					PVRTModelPODToggleInterleaved, need a scene loaded with
+					ReadFromFile. Falls back to ReadFromFile for files that
+					cannot be mapped.
+*****************************************************************************/
+EPVRTError CPVRTModelPOD::ReadFromFileMapped(const char * const pszFileName)
+{
+	PVRTTRACE_SCOPE("CPVRTModelPOD::ReadFromFileMapped");
+	Destroy();
+
+	CPVRTMappedFile *pMapping = new CPVRTMappedFile(pszFileName);
+
+	if(!pMapping->IsOpen())
+	{
+		delete pMapping;
+		return ReadFromFile(pszFileName);
+	}
+
+	CSourceMapped src(*pMapping);
+	if(ReadFromSourceStream(this, src, NULL, 0, NULL, 0) != PVR_SUCCESS)
+	{
+		// no pointers into the mapping may outlive it
+		delete pMapping;
+		DestroyImpl();
+		memset(this, 0, sizeof(*this));
+		return PVR_FAIL;
+	}
+
+	if(src.BorrowedBytes())
+		m_pImpl->pMapping = pMapping;
+	else
+		delete pMapping;
+
+	return PVR_SUCCESS;
+}
+
 /*!***************************************************************************
  @Function			ReadFromMemory
  @Input				pData			Data to load
@@ -2065,6 +2246,9 @@ EPVRTError CPVRTModelPOD::ReadFromResource(
 *************************************************************************/
 EPVRTError CPVRTModelPOD::InitImpl()
 {
+	// The scene data may still point into the mapped file
+	CPVRTMappedFile *pMapping = m_pImpl ? m_pImpl->pMapping : NULL;
+
 	// Allocate space for implementation data
 	delete m_pImpl;
 	m_pImpl = new SPVRTPODImpl;
@@ -2073,6 +2257,11 @@ EPVRTError CPVRTModelPOD::InitImpl()
 
 	// Zero implementation data
 	memset(m_pImpl, 0, sizeof(*m_pImpl));
+	m_pImpl->pMapping = pMapping;
+
+	// Destroy and the loaders zero the whole object, so the number comes from
+	// a counter shared by all scenes
+	m_nLoadGeneration = ++s_ui32LoadGenerations;
 
 #ifdef _DEBUG
 	m_pImpl->nWmTotal = 0;
@@ -2098,6 +2287,7 @@ void CPVRTModelPOD::DestroyImpl()
 		if(m_pImpl->pfCache)		delete [] m_pImpl->pfCache;
 		if(m_pImpl->pWmCache)		delete [] m_pImpl->pWmCache;
 		if(m_pImpl->pWmZeroCache)	delete [] m_pImpl->pWmZeroCache;
+		delete m_pImpl->pMapping;
 
 		delete m_pImpl;
 		m_pImpl = 0;
@@ -2130,11 +2320,21 @@ bool CPVRTModelPOD::IsLoaded()
 	return (m_pImpl!=NULL);
 }
 
+/*!***********************************************************************
+ @Function		GetLoadGeneration
+ @Return		0 before the first load, then a number unique to each load
+ @Description	Lets caches built from the scene data notice a reload.
+*************************************************************************/
+unsigned int CPVRTModelPOD::GetLoadGeneration() const
+{
+	return m_nLoadGeneration;
+}
+
 /*!***************************************************************************
  @Function			Constructor
  @Description		Initializes the pointer to scene data to NULL
 *****************************************************************************/
-CPVRTModelPOD::CPVRTModelPOD() : m_pImpl(NULL)
+CPVRTModelPOD::CPVRTModelPOD() : m_pImpl(NULL), m_nLoadGeneration(0)
 {}
 
 /*!***************************************************************************
@@ -2163,8 +2363,10 @@ void CPVRTModelPOD::Destroy()
 		if(!m_pImpl->bFromMemory)
 		{
 
+			const CPVRTMappedFile * const pMapping = m_pImpl->pMapping;
+
 			for(i = 0; i < nNumCamera; ++i)
-				FREE(pCamera[i].pfAnimFOV);
+				FreeOwned(pCamera[i].pfAnimFOV, pMapping);
 			FREE(pCamera);
 
 			FREE(pLight);
@@ -2179,23 +2381,23 @@ void CPVRTModelPOD::Destroy()
 			FREE(pMaterial);
 
 			for(i = 0; i < nNumMesh; ++i) {
-				FREE(pMesh[i].sFaces.pData);
+				FreeOwned(pMesh[i].sFaces.pData, pMapping);
 				FREE(pMesh[i].pnStripLength);
 				if(pMesh[i].pInterleaved)
 				{
-					FREE(pMesh[i].pInterleaved);
+					FreeOwned(pMesh[i].pInterleaved, pMapping);
 				}
 				else
 				{
-					FREE(pMesh[i].sVertex.pData);
-					FREE(pMesh[i].sNormals.pData);
-					FREE(pMesh[i].sTangents.pData);
-					FREE(pMesh[i].sBinormals.pData);
+					FreeOwned(pMesh[i].sVertex.pData, pMapping);
+					FreeOwned(pMesh[i].sNormals.pData, pMapping);
+					FreeOwned(pMesh[i].sTangents.pData, pMapping);
+					FreeOwned(pMesh[i].sBinormals.pData, pMapping);
 					for(unsigned int j = 0; j < pMesh[i].nNumUVW; ++j)
-						FREE(pMesh[i].psUVW[j].pData);
-					FREE(pMesh[i].sVtxColours.pData);
-					FREE(pMesh[i].sBoneIdx.pData);
-					FREE(pMesh[i].sBoneWeight.pData);
+						FreeOwned(pMesh[i].psUVW[j].pData, pMapping);
+					FreeOwned(pMesh[i].sVtxColours.pData, pMapping);
+					FreeOwned(pMesh[i].sBoneIdx.pData, pMapping);
+					FreeOwned(pMesh[i].sBoneWeight.pData, pMapping);
 				}
 				FREE(pMesh[i].psUVW);
 				pMesh[i].sBoneBatches.Release();
@@ -2204,14 +2406,14 @@ void CPVRTModelPOD::Destroy()
 
 			for(i = 0; i < nNumNode; ++i) {
 				FREE(pNode[i].pszName);
-				FREE(pNode[i].pfAnimPosition);
-				FREE(pNode[i].pnAnimPositionIdx);
-				FREE(pNode[i].pfAnimRotation);
-				FREE(pNode[i].pnAnimRotationIdx);
-				FREE(pNode[i].pfAnimScale);
-				FREE(pNode[i].pnAnimScaleIdx);
-				FREE(pNode[i].pfAnimMatrix);
-				FREE(pNode[i].pnAnimMatrixIdx);
+				FreeOwned(pNode[i].pfAnimPosition, pMapping);
+				FreeOwned(pNode[i].pnAnimPositionIdx, pMapping);
+				FreeOwned(pNode[i].pfAnimRotation, pMapping);
+				FreeOwned(pNode[i].pnAnimRotationIdx, pMapping);
+				FreeOwned(pNode[i].pfAnimScale, pMapping);
+				FreeOwned(pNode[i].pnAnimScaleIdx, pMapping);
+				FreeOwned(pNode[i].pfAnimMatrix, pMapping);
+				FreeOwned(pNode[i].pnAnimMatrixIdx, pMapping);
 				FREE(pNode[i].pUserData);
 				pNode[i].nAnimFlags = 0;
 			}
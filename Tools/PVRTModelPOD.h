@@ -339,6 +339,18 @@ public:
 		char			* const pszHistory = NULL,
 		const size_t	historyCount = 0);
 
+	/*!***************************************************************************
+	@fn       			ReadFromFileMapped
+	@param[in]			pszFileName		Filename to load
+	@return			    PVR_SUCCESS if successful, PVR_FAIL if not
+	@brief     		    Loads the specified ".POD" file from a mapping of the
+						file. Aligned vertex, index and animation data is not
+						copied, the scene points into the mapping, which is
+						kept until Destroy. Scenes loaded this way must not be
+						passed to the functions that reallocate mesh data.
+	*****************************************************************************/
+	EPVRTError ReadFromFileMapped(const char * const pszFileName);
+
 	/*!***************************************************************************
 	@brief     		    Loads the supplied pod data. This data can be exported
 						directly to a header using one of the pod exporters.
@@ -424,6 +436,15 @@ public:
 	*************************************************************************/
 	bool IsLoaded();
 
+	/*!***********************************************************************
+	@fn       		GetLoadGeneration
+	@return			0 before the first load, then a number unique to each load
+	@brief     	Changes every time InitImpl runs, so anything cached from
+					the scene data can tell when it was reloaded, even at
+					the same address.
+	*************************************************************************/
+	unsigned int GetLoadGeneration() const;
+
 	/*!***************************************************************************
 	 @fn       		Destroy
 	 @brief     	Frees the memory allocated to store the scene in pScene.
@@ -674,6 +695,7 @@ public:
 
 private:
 	SPVRTPODImpl	*m_pImpl;	/*!< Internal implementation data */
+	unsigned int	m_nLoadGeneration;	/*!< Set by InitImpl */
 };
 
 /****************************************************************************
@@ -21,6 +21,7 @@
 #include "PVRTResourceFile.h"
 #include "PVRTString.h"
 #include "PVRTMemoryFileSystem.h"
+#include "PVRTTrace.h"
 
 CPVRTString CPVRTResourceFile::s_ReadPath;
 
@@ -124,6 +125,8 @@ CPVRTResourceFile::CPVRTResourceFile(const char* const pszFilename) :
 	m_pData(0),
 	m_Handle(0)
 {
+	PVRTTRACE_SCOPE("CPVRTResourceFile");
+
 	CPVRTString Path(s_ReadPath);
 	Path += pszFilename;
 
@@ -0,0 +1,245 @@
+/******************************************************************************
+
+ @File         PVRTTrace.cpp
+
+ @Title        PVRTTrace
+
+ @Version
+
+ @Copyright    Copyright (c) Imagination Technologies Limited.
+
+ @Platform     ANSI compatible
+
+ @Description  Timeline events written as Chrome trace JSON.
+
+******************************************************************************/
+#include <stdio.h>
+#include <chrono>
+
+#include "PVRTTrace.h"
+
+/****************************************************************************
+** Defines
+****************************************************************************/
+#if defined(_MSC_VER)
+#define PVRTTRACE_THREAD_LOCAL	__declspec(thread)
+#else
+#define PVRTTRACE_THREAD_LOCAL	__thread
+#endif
+
+/****************************************************************************
+** Structures
+****************************************************************************/
+struct SPVRTTraceEvent
+{
+	const char*		pszName;
+	PVRTuint64		ui64TimeNs;		/*!< Since Start */
+	double			dValue;			/*!< Counter events only */
+	char			cPhase;			/*!< 'B', 'E' or 'C' as in the trace format */
+};
+
+struct SPVRTTraceBuffer
+{
+	SPVRTTraceEvent*			psEvents;
+	unsigned int				ui32Capacity;
+	std::atomic<unsigned int>	ui32Count;		/*!< Written by the owning thread only */
+	unsigned int				ui32Dropped;
+	unsigned int				ui32ThreadId;
+	const char*					pszThreadName;
+	SPVRTTraceBuffer*			psNext;
+};
+
+/****************************************************************************
+** Globals
+****************************************************************************/
+std::atomic<bool> CPVRTTrace::s_bEnabled(false);
+
+static std::atomic<SPVRTTraceBuffer*> s_psBuffers(0);
+static std::atomic<unsigned int> s_ui32NextThreadId(1);
+static unsigned int s_ui32EventsPerThread = PVRTTRACE_EVENTS_PER_THREAD;
+static std::chrono::steady_clock::time_point s_Start;
+static PVRTTRACE_THREAD_LOCAL SPVRTTraceBuffer* s_psThreadBuffer = 0;
+
+/****************************************************************************
+** Local functions
+****************************************************************************/
+static SPVRTTraceBuffer* ThreadBuffer()
+{
+	if(s_psThreadBuffer)
+		return s_psThreadBuffer;
+
+	SPVRTTraceBuffer* psBuffer = new SPVRTTraceBuffer;
+	psBuffer->psEvents = new SPVRTTraceEvent[s_ui32EventsPerThread];
+	psBuffer->ui32Capacity = s_ui32EventsPerThread;
+	psBuffer->ui32Count.store(0, std::memory_order_relaxed);
+	psBuffer->ui32Dropped = 0;
+	psBuffer->ui32ThreadId = s_ui32NextThreadId.fetch_add(1);
+	psBuffer->pszThreadName = 0;
+
+	// push onto the list, the only contention is between threads' first events
+	SPVRTTraceBuffer* psHead = s_psBuffers.load(std::memory_order_relaxed);
+	do
+	{
+		psBuffer->psNext = psHead;
+	} while(!s_psBuffers.compare_exchange_weak(psHead, psBuffer, std::memory_order_release, std::memory_order_relaxed));
+
+	s_psThreadBuffer = psBuffer;
+	return psBuffer;
+}
+
+static void Record(const char* pszName, char cPhase, double dValue)
+{
+	SPVRTTraceBuffer* psBuffer = ThreadBuffer();
+	unsigned int ui32Count = psBuffer->ui32Count.load(std::memory_order_relaxed);
+	if(ui32Count == psBuffer->ui32Capacity)
+	{
+		psBuffer->ui32Dropped++;
+		return;
+	}
+
+	SPVRTTraceEvent& sEvent = psBuffer->psEvents[ui32Count];
+	sEvent.pszName = pszName;
+	sEvent.ui64TimeNs = (PVRTuint64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_Start).count();
+	sEvent.dValue = dValue;
+	sEvent.cPhase = cPhase;
+	psBuffer->ui32Count.store(ui32Count + 1, std::memory_order_release);
+}
+
+// names are expected to be identifiers, anything JSON would choke on is replaced
+static void WriteName(FILE* pFile, const char* pszName)
+{
+	fputc('"', pFile);
+	for(const char* c = pszName; *c; ++c)
+		fputc((*c == '"' || *c == '\\' || (unsigned char)*c < 0x20) ? '_' : *c, pFile);
+	fputc('"', pFile);
+}
+
+/****************************************************************************
+** Class: CPVRTTrace
+****************************************************************************/
+/*!***************************************************************************
+ @Function			Start
+ @Input				ui32EventsPerThread	size of the buffers created from now on
+ @Return			false if the trace is already running
+ @Description		Forgets the events of a previous trace and starts
+					recording. Timestamps count from here.
+*****************************************************************************/
+bool CPVRTTrace::Start(unsigned int ui32EventsPerThread)
+{
+	if(IsEnabled())
+		return false;
+
+	s_ui32EventsPerThread = PVRT_MAX(ui32EventsPerThread, 1u);
+	for(SPVRTTraceBuffer* psBuffer = s_psBuffers.load(std::memory_order_acquire); psBuffer; psBuffer = psBuffer->psNext)
+	{
+		psBuffer->ui32Count.store(0, std::memory_order_relaxed);
+		psBuffer->ui32Dropped = 0;
+	}
+	s_Start = std::chrono::steady_clock::now();
+	s_bEnabled.store(true, std::memory_order_release);
+	return true;
+}
+
+/*!***************************************************************************
+ @Function			Stop
+ @Description		Stops recording, the events stay until the next Start.
+*****************************************************************************/
+void CPVRTTrace::Stop()
+{
+	s_bEnabled.store(false, std::memory_order_release);
+}
+
+/*!***************************************************************************
+ @Function			SetThreadName
+ @Input				pszName			shown for the calling thread, not copied
+*****************************************************************************/
+void CPVRTTrace::SetThreadName(const char* pszName)
+{
+	ThreadBuffer()->pszThreadName = pszName;
+}
+
+void CPVRTTrace::Begin(const char* pszName)
+{
+	Record(pszName, 'B', 0.0);
+}
+
+void CPVRTTrace::End(const char* pszName)
+{
+	Record(pszName, 'E', 0.0);
+}
+
+void CPVRTTrace::Counter(const char* pszName, double dValue)
+{
+	Record(pszName, 'C', dValue);
+}
+
+unsigned int CPVRTTrace::GetEventCount()
+{
+	unsigned int ui32Events = 0;
+	for(SPVRTTraceBuffer* psBuffer = s_psBuffers.load(std::memory_order_acquire); psBuffer; psBuffer = psBuffer->psNext)
+		ui32Events += psBuffer->ui32Count.load(std::memory_order_acquire);
+	return ui32Events;
+}
+
+unsigned int CPVRTTrace::GetDroppedCount()
+{
+	unsigned int ui32Dropped = 0;
+	for(SPVRTTraceBuffer* psBuffer = s_psBuffers.load(std::memory_order_acquire); psBuffer; psBuffer = psBuffer->psNext)
+		ui32Dropped += psBuffer->ui32Dropped;
+	return ui32Dropped;
+}
+
+/*!***************************************************************************
+ @Function			WriteJSON
+ @Input				pszFilename		file to create
+ @Return			false if the file cannot be written
+ @Description		Writes the recorded events in the JSON object format of
+					the trace event format, timestamps in microseconds. Call
+					after Stop, or while the other threads record nothing.
+*****************************************************************************/
+bool CPVRTTrace::WriteJSON(const char* pszFilename)
+{
+	FILE* pFile = fopen(pszFilename, "w");
+	if(!pFile)
+		return false;
+
+	fprintf(pFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool bFirst = true;
+	for(SPVRTTraceBuffer* psBuffer = s_psBuffers.load(std::memory_order_acquire); psBuffer; psBuffer = psBuffer->psNext)
+	{
+		unsigned int ui32Count = psBuffer->ui32Count.load(std::memory_order_acquire);
+		if(psBuffer->pszThreadName)
+		{
+			fprintf(pFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", bFirst ? "" : ",\n", psBuffer->ui32ThreadId);
+			WriteName(pFile, psBuffer->pszThreadName);
+			fprintf(pFile, "}}");
+			bFirst = false;
+		}
+		for(unsigned int i = 0; i < ui32Count; ++i)
+		{
+			const SPVRTTraceEvent& sEvent = psBuffer->psEvents[i];
+			fprintf(pFile, "%s{\"name\":", bFirst ? "" : ",\n");
+			WriteName(pFile, sEvent.pszName);
+			fprintf(pFile, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u", sEvent.cPhase, sEvent.ui64TimeNs * 0.001, psBuffer->ui32ThreadId);
+			if(sEvent.cPhase == 'C')
+				fprintf(pFile, ",\"args\":{\"value\":%.6g}", sEvent.dValue);
+			fprintf(pFile, "}");
+			bFirst = false;
+		}
+		if(psBuffer->ui32Dropped)
+		{
+			fprintf(pFile, "%s{\"name\":\"dropped events\",\"ph\":\"C\",\"ts\":0,\"pid\":1,\"tid\":%u,\"args\":{\"value\":%u}}",
+				bFirst ? "" : ",\n", psBuffer->ui32ThreadId, psBuffer->ui32Dropped);
+			bFirst = false;
+		}
+	}
+	fprintf(pFile, "\n]}\n");
+
+	bool bOK = !ferror(pFile);
+	fclose(pFile);
+	return bOK;
+}
+
+/*****************************************************************************
+ End of file (PVRTTrace.cpp)
+*****************************************************************************/
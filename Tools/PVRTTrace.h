@@ -0,0 +1,106 @@
+/*!****************************************************************************
+
+ @file         PVRTTrace.h
+ @copyright    Copyright (c) Imagination Technologies Limited.
+ @brief        Timeline events written as Chrome trace JSON.
+
+******************************************************************************/
+#ifndef _PVRTTRACE_H_
+#define _PVRTTRACE_H_
+
+#include <atomic>
+#include "PVRTGlobal.h"
+
+/****************************************************************************
+** Defines
+****************************************************************************/
+#define PVRTTRACE_EVENTS_PER_THREAD		65536	/*!< Default buffer size of each thread, in events */
+
+/*!***************************************************************************
+ Event macros. Names must be string literals or otherwise outlive the
+ trace, they are stored as pointers. Define PVRTTRACE_DISABLE to compile the
+ events out; compiled in, an event of a stopped trace costs one load and one
+ branch.
+*****************************************************************************/
+#if defined(PVRTTRACE_DISABLE)
+#define PVRTTRACE_SCOPE(name)
+#define PVRTTRACE_BEGIN(name)
+#define PVRTTRACE_END(name)
+#define PVRTTRACE_COUNTER(name, value)
+#else
+#define PVRTTRACE_JOIN2(a, b)			a##b
+#define PVRTTRACE_JOIN(a, b)			PVRTTRACE_JOIN2(a, b)
+#define PVRTTRACE_SCOPE(name)			CPVRTTraceScope PVRTTRACE_JOIN(sPVRTTraceScope, __LINE__)(name)
+#define PVRTTRACE_BEGIN(name)			do { if(CPVRTTrace::IsEnabled()) CPVRTTrace::Begin(name); } while(0)
+#define PVRTTRACE_END(name)				do { if(CPVRTTrace::IsEnabled()) CPVRTTrace::End(name); } while(0)
+#define PVRTTRACE_COUNTER(name, value)	do { if(CPVRTTrace::IsEnabled()) CPVRTTrace::Counter(name, (double)(value)); } while(0)
+#endif
+
+/*!***************************************************************************
+ @class     CPVRTTrace
+ @brief     Records begin, end and counter events of every thread while
+            started, and writes them in the Chrome trace event format, which
+            chrome://tracing and Perfetto open.
+ @details   Each thread writes into its own fixed size buffer, created on the
+            thread's first event and linked into a lock-free list, so
+            recording takes no lock and never allocates after that. A full
+            buffer drops the thread's later events and counts them. Start,
+            Stop and WriteJSON are meant for the main thread while the other
+            threads are idle; buffers are kept for the life of the process.
+*****************************************************************************/
+class CPVRTTrace
+{
+public:
+	static bool Start(unsigned int ui32EventsPerThread = PVRTTRACE_EVENTS_PER_THREAD);
+	static void Stop();
+	static bool WriteJSON(const char* pszFilename);
+
+	static void SetThreadName(const char* pszName);
+	static void Begin(const char* pszName);
+	static void End(const char* pszName);
+	static void Counter(const char* pszName, double dValue);
+
+	static unsigned int GetEventCount();
+	static unsigned int GetDroppedCount();
+
+	/*!***********************************************************************
+	 @brief      The only check an event makes while the trace is stopped
+	*************************************************************************/
+	static bool IsEnabled() { return s_bEnabled.load(std::memory_order_relaxed); }
+
+private:
+	static std::atomic<bool> s_bEnabled;
+};
+
+/*!***************************************************************************
+ @class     CPVRTTraceScope
+ @brief     Begin event on construction and the matching end event when the
+            scope is left. Use PVRTTRACE_SCOPE.
+*****************************************************************************/
+class CPVRTTraceScope
+{
+public:
+	CPVRTTraceScope(const char* pszName) : m_pszName(CPVRTTrace::IsEnabled() ? pszName : 0)
+	{
+		if(m_pszName)
+			CPVRTTrace::Begin(m_pszName);
+	}
+
+	~CPVRTTraceScope()
+	{
+		if(m_pszName)
+			CPVRTTrace::End(m_pszName);
+	}
+
+private:
+	CPVRTTraceScope(const CPVRTTraceScope&);
+	CPVRTTraceScope& operator=(const CPVRTTraceScope&);
+
+	const char* m_pszName;		/*!< 0 when the trace was stopped at construction */
+};
+
+#endif /* _PVRTTRACE_H_ */
+
+/*****************************************************************************
+ End of file (PVRTTrace.h)
+*****************************************************************************/
@@ -0,0 +1,40 @@
+#ifndef __MAFFINE_H_
+#define __MAFFINE_H_
+
+#include "OGLES2Tools.h"
+
+/*!****************************************************************************
+@Class		mAffine
+@Description	Affine transform stored as the top three rows of a 4x4 matrix,
+the bottom row is always 0 0 0 1. Row r holds the linear part's row r and
+the translation's r component, the layout of mInstanceBatch::AffineRows.
+Products, inverses and normal matrices skip the work a general PVRTMat4
+spends on the bottom row: the inverse is a 3x3 cofactor inverse and one
+matrix vector product.
+******************************************************************************/
+class mAffine
+{
+public:
+	mAffine();
+	explicit mAffine(const PVRTMat4 & matrix);
+
+	static mAffine Translation(const PVRTVec3 & translation);
+	static mAffine Scale(const PVRTVec3 & scale);
+	static mAffine TRS(const PVRTVec3 & translation, const PVRTMat3 & rotation, const PVRTVec3 & scale);
+
+	mAffine operator*(const mAffine & rhs) const;
+	PVRTVec3 TransformPoint(const PVRTVec3 & point) const;
+	PVRTVec3 TransformVector(const PVRTVec3 & vector) const;
+	PVRTVec3 GetTranslation() const;
+
+	mAffine Inverse() const;
+	PVRTMat3 InverseTranspose() const;
+	PVRTMat4 ToMat4() const;
+	PVRTMat4 TransposedMat4() const;
+
+	PVRTfloat32 Rows[3][4];
+};
+
+PVRTMat4 operator*(const PVRTMat4 & lhs, const mAffine & rhs);
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef __MBVH_H_
+#define __MBVH_H_
+
+#include <vector>
+#include <algorithm>
+#include "mBoxCuller.h"
+#include "mModel.h"
+#include "mWorkerPool.h"
+using namespace std;
+
+/*!****************************************************************************
+@Struct		BVHNode
+@Description	Node of a bounding volume hierarchy. The two children of an
+inner node are stored next to each other, Left is the first one and -1
+marks a leaf. Every node, inner or leaf, owns the range First/Count of
+the item order array, so a subtree's items are contiguous.
+******************************************************************************/
+struct BVHNode
+{
+	float Min[3];
+	float Max[3];
+	PVRTuint32 First;
+	PVRTuint32 Count;
+	int Left;
+	PVRTuint8 LastOutPlane;
+};
+
+struct BVHBin
+{
+	float Min[3];
+	float Max[3];
+	PVRTuint32 Count;
+};
+
+struct BVHRangeBounds
+{
+	float Min[3];
+	float Max[3];
+	float CentroidMin[3];
+	float CentroidMax[3];
+};
+
+/*!****************************************************************************
+@Class		mBVHBuilder
+@Description	Binned surface area heuristic build over item bounds, shared
+by mBVH and mTriangleBVH. With a worker pool the large top nodes bin
+their items in parallel, then the subtrees below them are built in
+parallel and stitched into one array. The tree does not depend on the
+number of threads, only the order of the nodes in the array does.
+******************************************************************************/
+class mBVHBuilder
+{
+public:
+	void Build(vector<PVRTVec3> & itemMin, vector<PVRTVec3> & itemMax, vector<BVHNode> & nodes, vector<PVRTuint32> & itemOrder, mWorkerPool * pool = nullptr);
+
+	int LeafSize = 4;			// ranges this small are never split
+	int MaxLeafSize = 16;		// ranges bigger than this are always split
+
+private:
+	PVRTVec3 * ItemMin = nullptr;
+	PVRTVec3 * ItemMax = nullptr;
+	PVRTuint32 * Order = nullptr;
+	vector<PVRTVec3> Centroid;
+
+	void boundRange(PVRTuint32 begin, PVRTuint32 end, BVHRangeBounds & range);
+	void binRange(PVRTuint32 begin, PVRTuint32 end, const float * centroidMin, const float * binScale, BVHBin * bins);
+	bool splitNode(BVHNode & node, int depth, PVRTuint32 & leftCount, mWorkerPool * pool);
+	void buildSubtree(BVHNode & root, int depth, vector<BVHNode> & nodesOut);
+};
+
+/*!****************************************************************************
+@Class		mBVH
+@Description	Scene index over model world bounds with no assumption about
+the layout, for stacked or clustered scenes the XZ quadtrees handle
+badly. Answers frustum queries like mLinearQuadTree and ray or segment
+queries for picking and line of sight. A model with a MeshBVH is hit
+on its triangles, any other model on its world box.
+The index is static: rebuild it after models move.
+******************************************************************************/
+class mBVH
+{
+public:
+	mBVH();
+	~mBVH();
+
+	void Build(vector<mModel*> & models, mWorkerPool * pool = nullptr);
+	void Query(mFrustumPlanes & planes, vector<mModel*> & modelsOut);
+	void QueryView(mFrustumPlanes & planes, vector<mModel*> & modelsOut, vector<PVRTuint8> & lastOutPlane, mCullStats & stats);
+	mModel * RayCast(PVRTVec3 origin, PVRTVec3 direction, float maxDistance, float & hitDistance);
+	void RayQuery(PVRTVec3 origin, PVRTVec3 direction, float maxDistance, vector<mModel*> & modelsOut);
+	bool SegmentBlocked(PVRTVec3 from, PVRTVec3 to, mModel * ignore = nullptr);
+	void Clear();
+	unsigned int size();
+
+	static bool IntersectBox(const float * boxMin, const float * boxMax, PVRTVec3 & origin, PVRTVec3 & invDirection, float maxDistance, float & hitDistance);
+	static bool IntersectModel(mModel * model, PVRTVec3 origin, PVRTVec3 direction, float maxDistance, float & hitDistance);
+
+	vector<BVHNode> Nodes;
+	vector<PVRTuint32> ModelIndex;
+	int NodesVisited = 0;
+	int NodesCulled = 0;
+	int NodesAccepted = 0;
+	int PlaneTests = 0;
+	int RayNodeTests = 0;
+	int RayModelTests = 0;
+
+private:
+	vector<mModel*> Models;
+	vector<PVRTVec3> BoxMin;
+	vector<PVRTVec3> BoxMax;
+	mBVHBuilder Builder;
+
+	void queryNodes(mFrustumPlanes & planes, vector<mModel*> & modelsOut, PVRTuint8 * lastOutPlane, mCullStats & stats, bool markModels);
+	mModel * traceRay(PVRTVec3 & origin, PVRTVec3 & direction, float maxDistance, float & hitDistance, bool anyHit, mModel * ignore, vector<mModel*> * modelsOut);
+};
+
+#endif
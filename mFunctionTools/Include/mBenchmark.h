@@ -0,0 +1,66 @@
+#ifndef __MBENCHMARK_H_
+#define __MBENCHMARK_H_
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include "mProfiler.h"
+using namespace std;
+
+/*!****************************************************************************
+@Struct		mBenchmarkStep
+@Description	One part of a benchmark script. The tokens are the step's
+text split at ':', the application decides what they mean.
+******************************************************************************/
+struct mBenchmarkStep
+{
+	string Name;
+	vector<string> Tokens;
+};
+
+/*!****************************************************************************
+@Class		mBenchmark
+@Description	Plays a script of steps, each for Warmup untimed frames then
+Frames timed ones, and keeps the time and the counters of every timed
+frame. A script is steps separated by ',', e.g. "main:quadtree,ttp:model".
+A frame's time runs from its NextFrame call to the next one, so the run
+needs one frame more than TotalFrames to time its last frame.
+******************************************************************************/
+class mBenchmark
+{
+public:
+	mBenchmark();
+	~mBenchmark();
+
+	bool Init(const char * script, unsigned int frames, unsigned int warmup);
+	int AddCounter(const char * name);
+
+	int NextFrame();
+	void SetCounter(int counter, double value);
+
+	bool Running() const;
+	bool Finished() const;
+	const mBenchmarkStep & CurrentStep() const;
+	unsigned int TotalFrames() const;
+	bool WriteSummary(const char * path, float timestepMs) const;
+
+	vector<mBenchmarkStep> Steps;
+	vector<string> CounterNames;
+	unsigned int Frames = 0;				// timed frames per step
+	unsigned int Warmup = 0;				// untimed frames before them
+
+private:
+	mSampleStats StepStats(int step, int counter) const;
+
+	int Step = -1;
+	unsigned int StepFrame = 0;
+	bool Timed = false;						// the frame since the last NextFrame
+	chrono::steady_clock::time_point FrameStart;
+
+	// one row per timed frame
+	vector<int> FrameStep;
+	vector<float> FrameMs;
+	vector<double> Counters;				// CounterNames.size() per row
+};
+
+#endif
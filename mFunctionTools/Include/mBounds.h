@@ -0,0 +1,76 @@
+#ifndef __MBOUNDS_H_
+#define __MBOUNDS_H_
+
+#include <vector>
+#include <float.h>
+#include "OGLES2Tools.h"
+#include "mWorkerPool.h"
+using namespace std;
+
+/*!****************************************************************************
+@Struct		mBounds
+@Description	Model space bounds of a POD mesh or model. The oriented box is
+only filled when it was asked for. SourceData/SourceVertices and
+SourceGeneration record which vertex data the bounds were computed from,
+mModel uses them to skip the computation when CreateSuroundBox runs again
+on the same POD without it being reloaded.
+******************************************************************************/
+struct mBounds
+{
+	PVRTVec3 Min = PVRTVec3(FLT_MAX, FLT_MAX, FLT_MAX);
+	PVRTVec3 Max = PVRTVec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	PVRTVec3 SphereCenter = PVRTVec3(0.0f, 0.0f, 0.0f);
+	float SphereRadius = -1.0f;
+	bool HasOrientedBox = false;
+	PVRTVec3 BoxCenter = PVRTVec3(0.0f, 0.0f, 0.0f);
+	PVRTVec3 BoxAxis[3];
+	PVRTVec3 BoxHalfSize = PVRTVec3(0.0f, 0.0f, 0.0f);
+	PVRTuint32 VertexCount = 0;
+	const void * SourceData = nullptr;
+	PVRTuint32 SourceVertices = 0;
+	PVRTuint32 SourceGeneration = 0;		// CPVRTModelPOD::GetLoadGeneration
+
+	bool IsValid() const { return VertexCount > 0; }
+};
+
+/*!****************************************************************************
+@Class		mBoundsEngine
+@Description	Computes mBounds from interleaved float positions. The AABB
+pass uses SSE or NEON min/max, the sphere and oriented box passes are
+scalar. With a worker pool, meshes with more than ParallelVertices
+vertices are split in chunks across the threads.
+The sphere starts from the most separated pair of axis extremes and is
+grown over the vertices (Ritter), the sphere around the AABB center is
+kept instead when it is smaller.
+The oriented box uses the principal axes of the vertex covariance.
+******************************************************************************/
+class mBoundsEngine
+{
+public:
+	mBoundsEngine();
+	~mBoundsEngine();
+
+	void Compute(const PVRTuint8 * positions, unsigned int stride, unsigned int vertexCount, mBounds & bounds);
+	void Compute(SPODMesh & mesh, mBounds & bounds);
+	void Compute(CPVRTModelPOD & modelPOD, mBounds & bounds);
+
+	static void ComputeAABB(const PVRTuint8 * positions, unsigned int stride, unsigned int vertexCount, PVRTVec3 & boxMin, PVRTVec3 & boxMax);
+
+	mWorkerPool * Pool = nullptr;
+	bool ComputeOrientedBox = false;
+	unsigned int ParallelVertices = 32768;
+	unsigned int VerticesProcessed = 0;
+
+private:
+	const PVRTuint8 * Positions = nullptr;
+	unsigned int Stride = 0;
+	unsigned int Count = 0;
+
+	int chunkCount();
+	void runChunks(int chunks, const function<void(unsigned int, unsigned int, int)> & chunk);
+	void computeSphere(mBounds & bounds);
+	void computeOrientedBox(mBounds & bounds);
+	float farthestDistance(PVRTVec3 center);
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef __MBOXCULLER_H_
+#define __MBOXCULLER_H_
+
+#include "PVRShell.h"
+#include "OGLES2Tools.h"
+#include "mModel.h"
+#include "mFrustum.h"
+#include <vector>
+
+#if defined(__AVX__)
+#define MBOXCULLER_AVX
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MBOXCULLER_SSE
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define MBOXCULLER_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+enum CullPath
+{
+	CullPathAuto,
+	CullPathScalar,
+	CullPathSSE,
+	CullPathAVX,
+	CullPathNEON
+};
+
+/*!****************************************************************************
+@Class		mBoxCuller
+@Description	Keeps world space AABBs in structure-of-arrays form and tests
+4 (SSE/NEON) or 8 (AVX) boxes per iteration against a frustum.
+The result is a bitmask with one bit per box, set when visible.
+******************************************************************************/
+class mBoxCuller
+{
+public:
+	mBoxCuller();
+	~mBoxCuller();
+
+	unsigned int addBox(PVRTVec3 boxMin, PVRTVec3 boxMax);
+	unsigned int addModel(mModel * model);
+	void updateBox(unsigned int index, PVRTVec3 boxMin, PVRTVec3 boxMax);
+	void updateModel(unsigned int index);
+	void clear();
+	unsigned int size();
+
+	void Cull(mFrustumPlanes & planes, int path = CullPathAuto);
+	void Cull(mFrustum & frustum, int path = CullPathAuto);
+	bool IsVisible(unsigned int index);
+	unsigned int VisibleCount();
+	void MarkModelsNeedRender();
+	static int BestPath();
+	static bool HasPath(int path);
+
+	vector<PVRTuint32> VisibleMask;
+	vector<mModel*> Models;
+
+private:
+	vector<float> MinX, MinY, MinZ;
+	vector<float> MaxX, MaxY, MaxZ;
+
+	unsigned int cullScalar(mFrustumPlanes & planes, unsigned int begin, unsigned int end);
+	unsigned int cullSSE(mFrustumPlanes & planes);
+	unsigned int cullAVX(mFrustumPlanes & planes);
+	unsigned int cullNEON(mFrustumPlanes & planes);
+};
+
+#endif
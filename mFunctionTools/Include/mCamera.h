@@ -3,6 +3,7 @@
 
 #include "PVRShell.h"
 #include "OGLES2Tools.h"
+#include "mFrustum.h"
 
 class Camera
 {
@@ -24,6 +25,7 @@ public:
 	PVRTMat4 getProjectionMatrix();
 	PVRTMat4 getLookAtMatrix();
 	PVRTMat4 getVPMatrix();
+	mFrustum & getFrustum();
 	PVRTVec3 getEulerAngle();
 	PVRTVec3 getPosition();
 	PVRTVec3 getForward();
@@ -63,6 +65,8 @@ private:
 	PVRTMat4 lookAtMatrix;
 	PVRTMat4 projectionMatrix;
 	PVRTMat4 VPMatrix;
+	mFrustum Frustum;
+	bool FrustumDirty = true;
 	GLfloat sgn(GLfloat a);
 };
 
@@ -0,0 +1,57 @@
+#ifndef __MCULLINGSERVICE_H_
+#define __MCULLINGSERVICE_H_
+
+#include <vector>
+#include "mCamera.h"
+#include "mSceneManager.h"
+#include "mWorkerPool.h"
+using namespace std;
+
+/*!****************************************************************************
+@Struct		mCullView
+@Description	One view to cull. When UseClipPlane is set the camera projection
+is bent with ModifyProjectionForClipping first, the same way the
+reflection and refraction passes render.
+******************************************************************************/
+struct mCullView
+{
+	Camera ViewCamera;
+	bool UseClipPlane;
+	PVRTVec4 ClipPlane;
+	vector<mModel*> Visible;
+	vector<PVRTuint8> LastOutPlane;
+	mCullStats Stats;
+};
+
+/*!****************************************************************************
+@Class		mCullingService
+@Description	Culls the scene index of an mSceneManager for several views at
+once, one task per view on a worker pool. Every view gets its own visible
+list. The linear quadtree and the BVH do not touch needRender, the other
+index modes set it for every view's models, see mSceneManager::QueryView.
+******************************************************************************/
+class mCullingService
+{
+public:
+	mCullingService();
+	~mCullingService();
+
+	void Init(int threadCount = -1);
+	int addView();
+	void setView(int view, Camera & camera);
+	void setView(int view, Camera & camera, PVRTVec4 clipPlane);
+	void Cull(mSceneManager & scene);
+	vector<mModel*> & VisibleModels(int view);
+	mCullStats & ViewStats(int view);
+	unsigned int ViewCount();
+	int ThreadCount();
+	void Destroy();
+
+private:
+	mWorkerPool Pool;
+	vector<mCullView> Views;
+
+	void cullView(mSceneManager & scene, int view);
+};
+
+#endif
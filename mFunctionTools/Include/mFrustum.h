@@ -0,0 +1,62 @@
+#ifndef __MFRUSTUM_H_
+#define __MFRUSTUM_H_
+
+#include "PVRShell.h"
+#include "OGLES2Tools.h"
+#include "mSuroundBox.h"
+
+/*!****************************************************************************
+@Struct		mFrustumPlanes
+@Description	Six world space clip planes (left, right, bottom, top, near, far)
+stored as a * x + b * y + c * z + d, positive side is inside.
+Extracted once per view and shared by every box test.
+******************************************************************************/
+const PVRTuint32 c_uiAllFrustumPlanes = 0x3F;
+
+struct mFrustumPlanes
+{
+	float A[6];
+	float B[6];
+	float C[6];
+	float D[6];
+
+	void ExtractFromMatrix(PVRTMat4 & VP_Matrix);
+	int ClassifyBox(const float * boxMin, const float * boxMax, PVRTuint32 & planeMask, PVRTuint8 & lastOutPlane, int & planeTests);
+};
+
+/*!****************************************************************************
+@Struct		mCullStats
+@Description	Work done by one traversal of a scene index.
+******************************************************************************/
+struct mCullStats
+{
+	int NodesVisited = 0;
+	int NodesCulled = 0;
+	int NodesAccepted = 0;
+	int PlaneTests = 0;
+	int NodesOccluded = 0;
+	int ModelsOccluded = 0;
+};
+
+/*!****************************************************************************
+@Class		mFrustum
+@Description	View frustum of a camera: normalized planes, the 8 corner points
+(near 0-3, far 4-7) and a bounding sphere, all in world space. Camera
+rebuilds it only after its view or projection matrix has changed.
+******************************************************************************/
+class mFrustum
+{
+public:
+	mFrustum();
+	~mFrustum();
+
+	void Update(PVRTMat4 & VP_Matrix, PVRTMat4::eClipspace cs);
+	bool SphereOutside(PVRTVec3 center, float radius);
+
+	mFrustumPlanes Planes;
+	PVRTVec3 Corners[8];
+	PVRTVec3 SphereCenter;
+	float SphereRadius = 0.0f;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef __MINSTANCEBATCH_H_
+#define __MINSTANCEBATCH_H_
+
+#include <vector>
+#include "OGLES2Tools.h"
+#include "mAffine.h"
+using namespace std;
+
+const unsigned int c_uiInstanceRowFloats = 12;		// 3x4 affine rows of one instance
+
+struct InstanceRange
+{
+	PVRTuint32 First;
+	PVRTuint32 Count;
+};
+
+/*!****************************************************************************
+@Class		mInstanceBatch
+@Description	Draws many copies of a mesh on OpenGL ES 2.0 without instanced
+arrays. The vertices are stored Slots times, each copy followed by its
+slot number as a float, and every index range is stored Slots times in a
+row pointing at the copies. Drawing n instances of a range is one
+glDrawElements of n * RangeCount indices from RangeFirst, the shader reads
+the instance transform from a uniform array with the slot number.
+Slots is limited by the 16 bit indices and by the caller's uniform space.
+******************************************************************************/
+class mInstanceBatch
+{
+public:
+	mInstanceBatch();
+	~mInstanceBatch();
+
+	bool Build(const PVRTuint8 * vertices, unsigned int stride, unsigned int vertexCount,
+		const PVRTuint16 * indices, const vector<InstanceRange> & ranges, unsigned int maxSlots);
+	void LoadVBO();
+	void DeleteVBOs();
+	void Destroy();
+
+	static void AffineRows(const PVRTMat4 & model, GLfloat * rows);
+	static void AffineRows(const mAffine & model, GLfloat * rows);
+
+	unsigned int Slots = 0;
+	unsigned int Stride = 0;					// source stride plus the slot float
+	unsigned int SlotOffset = 0;
+	vector<PVRTuint8> Vertices;
+	vector<PVRTuint16> Indices;
+	vector<InstanceRange> Ranges;				// First of the Slots copies, Count of one copy
+	GLuint VBO = 0;
+	GLuint IndexVBO = 0;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef __MLINEARQUADTREE_H_
+#define __MLINEARQUADTREE_H_
+
+#include <vector>
+#include <algorithm>
+#include "mBoxCuller.h"
+#include "mModel.h"
+using namespace std;
+
+class mOcclusionCuller;
+
+/*!****************************************************************************
+@Struct		LinearQuadNode
+@Description	Node of mLinearQuadTree. Children of a node are stored next to
+each other, the whole tree lives in one array in breadth-first order.
+Min/Max bound every model in the subtree, First/Count is the range of
+the subtree in the Morton sorted model index array. LastOutPlane is the
+frustum plane that culled the node last, it is tested first next time.
+******************************************************************************/
+struct LinearQuadNode
+{
+	float Min[3];
+	float Max[3];
+	PVRTuint32 First;
+	PVRTuint32 Count;
+	PVRTuint32 FirstChild;
+	PVRTuint8 ChildCount;
+	PVRTuint8 Level;
+	PVRTuint8 LastOutPlane;
+};
+
+/*!****************************************************************************
+@Class		mLinearQuadTree
+@Description	Pointer-free quadtree over the XZ plane. Models are bucketed by
+the Morton code of their world space center and sorted once, so a build
+is O(n log n). Empty children are never created.
+******************************************************************************/
+class mLinearQuadTree
+{
+public:
+	mLinearQuadTree();
+	~mLinearQuadTree();
+
+	void Build(vector<mModel*> & models, int depth, float Xmin, float Xmax, float Ymin, float Ymax, float Zmin, float Zmax);
+	void Query(mFrustumPlanes & planes, vector<mModel*> & modelsOut, mOcclusionCuller * occlusion = nullptr);
+	void QueryView(mFrustumPlanes & planes, vector<mModel*> & modelsOut, vector<PVRTuint8> & lastOutPlane, mCullStats & stats);
+	void Clear();
+
+	vector<LinearQuadNode> Nodes;
+	vector<PVRTuint32> ModelIndex;
+	int NodesVisited = 0;
+	int NodesCulled = 0;
+	int NodesAccepted = 0;
+	int PlaneTests = 0;
+	int NodesOccluded = 0;
+	int ModelsOccluded = 0;
+
+private:
+	vector<mModel*> Models;
+	vector<PVRTVec3> BoxMin;
+	vector<PVRTVec3> BoxMax;
+	int Depth = 1;
+
+	static PVRTuint32 mortonCode(PVRTuint32 x, PVRTuint32 z);
+	void computeNodeBounds();
+	void queryNodes(mFrustumPlanes & planes, vector<mModel*> & modelsOut, PVRTuint8 * lastOutPlane, mCullStats & stats, bool markModels,
+		mOcclusionCuller * occlusion);
+};
+
+#endif
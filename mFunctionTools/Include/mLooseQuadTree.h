@@ -0,0 +1,81 @@
+#ifndef __MLOOSEQUADTREE_H_
+#define __MLOOSEQUADTREE_H_
+
+#include <vector>
+#include "mBoxCuller.h"
+#include "mModel.h"
+using namespace std;
+
+struct LooseCell
+{
+	int Head;
+	int SubtreeCount;
+	PVRTuint8 LastOutPlane;
+};
+
+struct LooseEntry
+{
+	mModel * Model;
+	float Min[3];
+	float Max[3];
+	int Cell;
+	int Prev;
+	int Next;
+	PVRTuint8 LastOutPlane;
+};
+
+/*!****************************************************************************
+@Class		mLooseQuadTree
+@Description	Loose quadtree over the XZ plane for models that move. Every
+level is a full grid stored in one array, so a cell is found from the
+model bounds directly. A cell's loose bounds are twice its size, which
+lets a model sit in the cell holding its center at the deepest level
+where it is not bigger than a cell. Insert, remove and move only touch
+the model's old and new cell plus their parent counters, so the cost is
+bounded by the depth and never by the number of models.
+Models that leave the root bounds are kept in an overflow list and are
+tested one by one.
+******************************************************************************/
+class mLooseQuadTree
+{
+public:
+	mLooseQuadTree();
+	~mLooseQuadTree();
+
+	void Init(int depth, float Xmin, float Xmax, float Ymin, float Ymax, float Zmin, float Zmax);
+	void insertModel(mModel * model);
+	void removeModel(mModel * model);
+	void updateModel(mModel * model);
+	void Query(mFrustumPlanes & planes, vector<mModel*> & modelsOut);
+	void Clear();
+	unsigned int size();
+
+	int NodesVisited = 0;
+	int NodesCulled = 0;
+	int NodesAccepted = 0;
+	int PlaneTests = 0;
+	int ModelsTested = 0;
+
+private:
+	int Depth = 0;
+	float RootMin[3];
+	float RootMax[3];
+	vector<float> CellSizeX;
+	vector<float> CellSizeZ;
+	vector<int> LevelOffset;
+	vector<LooseCell> Cells;
+	vector<LooseEntry> Entries;
+	int FreeEntry = -1;
+	int Count = 0;
+
+	int findCell(LooseEntry & entry);
+	void linkEntry(int handle, int cell);
+	void unlinkEntry(int handle);
+	void addSubtreeCount(int cell, int delta);
+	void queryCell(mFrustumPlanes & planes, PVRTuint32 planeMask, int level, int x, int z, vector<mModel*> & modelsOut);
+	void emitCell(int level, int x, int z, vector<mModel*> & modelsOut);
+	void emitChildren(int level, int x, int z, vector<mModel*> & modelsOut);
+	void testList(mFrustumPlanes & planes, PVRTuint32 planeMask, int head, vector<mModel*> & modelsOut);
+};
+
+#endif
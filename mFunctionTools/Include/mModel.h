@@ -4,6 +4,23 @@
 #include "PVRShell.h"
 #include "OGLES2Tools.h"
 #include "mSuroundBox.h"
+#include "mFrustum.h"
+#include "mBounds.h"
+#include "mAffine.h"
+
+class mLooseQuadTree;
+class mTriangleBVH;
+
+// attribute locations the mesh VAOs are built with, programs bind their inputs in this order
+enum mModelAttribute
+{
+	mModelVertexAttrib,
+	mModelNormalAttrib,
+	mModelTangentAttrib,
+	mModelBinormalAttrib,
+	mModelTexCoordAttrib,
+	mModelNumAttribs
+};
 
 class mModel
 {
@@ -15,11 +32,24 @@ public:
 	CPVRTModelPOD * ModelPOD = nullptr;
 	GLuint * VBO = nullptr;
 	GLuint * IndexVBO = nullptr;
+	// one vertex array object per mesh, nullptr when the context has none
+	GLuint * VAO = nullptr;
 
 	bool needRender = false;
 
-	void LoadVBO();
-	void CreateSuroundBox();
+	// set by mLooseQuadTree, every transform change moves the model in it
+	mLooseQuadTree * LooseTree = nullptr;
+	int LooseHandle = -1;
+
+	// optional, owned by the caller, makes mBVH ray queries exact on the triangles
+	mTriangleBVH * MeshBVH = nullptr;
+
+	// model space bounds of ModelPOD, kept across CreateSuroundBox calls
+	mBounds Bounds;
+
+	void LoadVBO(CPVRTgles2Ext * extensions = nullptr);
+	void CreateSuroundBox(mWorkerPool * pool = nullptr, bool orientedBox = false);
+	void InvalidateBounds();
 	void SetPOD(CPVRTModelPOD * modelPOD);
 	void SetTransform(PVRTVec3 Position, PVRTVec3 EulerAngle, PVRTVec3 Scale);
 	void SetPosition(PVRTVec3 position);
@@ -30,7 +60,10 @@ public:
 	void SetScale(PVRTfloat32 x, PVRTfloat32 y, PVRTfloat32 z);
 	PVRTVec3 GetPosition();
 	PVRTMat4 GetModelMatrix();
-	bool NeedClip(PVRTMat4 & MVPmatrix);
+	const mAffine & GetTransform() const;
+	const mAffine & GetInverseTransform() const;
+	const PVRTMat3 & GetNormalMatrix() const;
+	bool NeedClip(mFrustum & frustum);
 
 	void DeleteVBOs();
 	void Destroy();
@@ -41,10 +74,16 @@ private:
 	PVRTVec3 Scale = PVRTVec3(1.0, 1.0, 1.0);
 	PVRTMat4 RotationMatrix;
 	PVRTMat4 ModelMatrix;
+	// ModelMatrix as an affine transform, its inverse and normal matrix, redone by every setter
+	mAffine Transform;
+	mAffine InverseTransform;
+	PVRTMat3 NormalMatrix = PVRTMat3::Identity();
+	CPVRTgles2Ext * Extensions = nullptr;
 
 	void UpdatePosition();
 	void UpdateRotateion();
 	void UpdateScale();
 	void ChangeScale(PVRTVec3 scale);
+	void UpdateInverse();
 };
 #endif
\ No newline at end of file
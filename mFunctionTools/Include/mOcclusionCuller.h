@@ -0,0 +1,62 @@
+#ifndef __MOCCLUSIONCULLER_H_
+#define __MOCCLUSIONCULLER_H_
+
+#include <vector>
+#include "mBoxCuller.h"
+#include "mCamera.h"
+#include "mModel.h"
+using namespace std;
+
+/*!****************************************************************************
+@Class		mOcclusionCuller
+@Description	CPU occlusion culling. A few occluder meshes are rasterized into
+a small depth buffer, then a max-depth pyramid is built over it and box
+bounds are tested against the level where they cover a few texels.
+Rasterization is conservative: a pixel is written only when the triangle
+covers it completely, with the farthest depth the triangle has inside it,
+and triangles crossing the near plane are dropped. A box is therefore
+only reported occluded when it really is hidden by the occluders.
+Needs no GL context.
+******************************************************************************/
+class mOcclusionCuller
+{
+public:
+	mOcclusionCuller();
+	~mOcclusionCuller();
+
+	void Init(int width, int height);
+	void Begin(Camera & camera);
+	void addOccluder(mModel * model);
+	void addOccluderMesh(SPODMesh & mesh, PVRTMat4 & modelMatrix);
+	void addOccluderTriangles(const PVRTuint8 * positions, unsigned int stride, unsigned int vertexCount,
+		const PVRTuint16 * indices, unsigned int triangleCount, PVRTMat4 & modelMatrix);
+	void End();
+	bool IsOccluded(PVRTVec3 boxMin, PVRTVec3 boxMax);
+	bool IsOccluded(mModel * model);
+	bool IsReady();
+
+	int Width();
+	int Height();
+	float DepthAt(int x, int y);
+
+	int TrianglesRasterized = 0;
+	int TrianglesSkipped = 0;
+	int BoxesTested = 0;
+	int BoxesOccluded = 0;
+
+private:
+	int BufferWidth = 0;
+	int BufferHeight = 0;
+	bool Ready = false;
+	PVRTMat4 VPMatrix;
+	vector<vector<float> > Levels;		// level 0 is the depth buffer, then max of 2x2
+	vector<int> LevelWidth;
+	vector<int> LevelHeight;
+	vector<PVRTVec4> ClipVertices;
+
+	void transformVertices(const PVRTuint8 * positions, unsigned int stride, unsigned int vertexCount, PVRTMat4 & MVP_Matrix);
+	void rasterTriangle(PVRTVec4 & v0, PVRTVec4 & v1, PVRTVec4 & v2);
+	void buildPyramid();
+};
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef __MPROFILER_H_
+#define __MPROFILER_H_
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include "OGLES2Tools.h"
+using namespace std;
+
+// Frames a GPU timer query is given before its result is read
+const int c_iProfilerGpuLatency = 4;
+
+/*!****************************************************************************
+@Struct		mSampleStats
+@Description	Summary of the samples in a ring, in the unit they were pushed.
+******************************************************************************/
+struct mSampleStats
+{
+	unsigned int Count = 0;
+	float Min = 0.0f;
+	float Avg = 0.0f;
+	float Max = 0.0f;
+	float P50 = 0.0f;
+	float P95 = 0.0f;
+	float P99 = 0.0f;
+};
+
+/*!****************************************************************************
+@Class		mSampleRing
+@Description	The last Capacity samples of a series. Push overwrites the
+oldest sample once the ring is full and never allocates, the statistics
+are computed from a sorted copy only when Stats is called.
+******************************************************************************/
+class mSampleRing
+{
+public:
+	void Init(unsigned int capacity);
+	void Clear();
+	void Push(float sample);
+	float Latest() const;
+	float At(unsigned int age) const;		// 0 is the latest sample
+	mSampleStats Stats() const;
+
+	vector<float> Samples;
+	unsigned int Head = 0;					// where the next sample goes
+	unsigned int Count = 0;
+
+private:
+	mutable vector<float> Sorted;
+};
+
+/*!****************************************************************************
+@Struct		mProfilerSection
+@Description	A named part of the frame. CpuMs holds one sample per frame,
+the sum of every Begin/End pair of the frame and 0 in frames that did not
+run the section. GpuMs holds one sample per frame the GPU timed the
+section in, c_iProfilerGpuLatency frames late.
+******************************************************************************/
+struct mProfilerSection
+{
+	string Name;
+	bool Gpu = false;
+	mSampleRing CpuMs;
+	mSampleRing GpuMs;
+
+	double FrameMs = 0.0;					// CPU time of the frame so far
+	chrono::steady_clock::time_point Start;
+	bool Open = false;
+	unsigned int Runs = 0;					// Begin calls this frame
+
+	GLuint Queries[c_iProfilerGpuLatency];	// set up by AddSection
+	bool Pending[c_iProfilerGpuLatency];
+};
+
+/*!****************************************************************************
+@Class		mProfiler
+@Description	Frame time and per section CPU timers, and GPU timers for the
+sections added with gpu true when the context has
+GL_EXT_disjoint_timer_query. Time elapsed queries cannot overlap, so a GPU
+section begun while another one is open, or begun again in the same frame,
+is only timed on the CPU. GPU results are read c_iProfilerGpuLatency frames
+later when they are available, so the timers never stall the pipeline, and
+are dropped when the GPU reports a disjoint operation.
+******************************************************************************/
+class mProfiler
+{
+public:
+	mProfiler();
+	~mProfiler();
+
+	void Init(const CPVRTgles2Ext * extensions, unsigned int history);
+	void Release();
+	int AddSection(const char * name, bool gpu);
+
+	void BeginFrame();
+	void BeginSection(int section);
+	void EndSection(int section);
+
+	bool HasGpuTimers() const;
+	bool WriteReport(const char * path) const;
+
+	mSampleRing FrameMs;
+	vector<mProfilerSection> Sections;
+	unsigned int Frames = 0;
+	unsigned int GpuDisjoints = 0;			// frames whose GPU results were dropped
+
+private:
+	void ReadGpuResults(bool disjoint);
+
+	const CPVRTgles2Ext * Extensions = 0;
+	unsigned int History = 0;
+	chrono::steady_clock::time_point FrameStart;
+	int OpenGpuSection = -1;
+};
+
+/*!****************************************************************************
+@Class		mProfileScope
+@Description	Times a section from construction to the end of the scope.
+******************************************************************************/
+class mProfileScope
+{
+public:
+	mProfileScope(mProfiler & profiler, int section) : Profiler(profiler), Section(section) { Profiler.BeginSection(Section); }
+	~mProfileScope() { Profiler.EndSection(Section); }
+
+private:
+	mProfileScope & operator=(const mProfileScope &);
+	mProfiler & Profiler;
+	int Section;
+};
+
+#endif
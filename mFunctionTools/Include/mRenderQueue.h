@@ -0,0 +1,101 @@
+#ifndef __MRENDERQUEUE_H_
+#define __MRENDERQUEUE_H_
+
+#include <vector>
+#include <functional>
+#include "OGLES2Tools.h"
+using namespace std;
+
+// Bits of each sort key field, pass is the top byte
+const int c_iRenderKeyPassBits = 8;
+const int c_iRenderKeyProgramBits = 8;
+const int c_iRenderKeyTextureBits = 12;
+const int c_iRenderKeyMeshBits = 12;
+const int c_iRenderKeyDepthBits = 24;
+
+/*!****************************************************************************
+@Struct		mRenderItem
+@Description	One submitted draw. Item is the caller's own handle, the queue
+only hands it back to mRenderBinder::Draw.
+******************************************************************************/
+struct mRenderItem
+{
+	PVRTuint64 Key;
+	PVRTuint32 Item;
+};
+
+/*!****************************************************************************
+@Struct		mRenderBinder
+@Description	What mRenderQueue::Execute calls. The Bind functions are only
+called when their key field differs from the previous draw, Draw is called
+for every item with the state already bound.
+******************************************************************************/
+struct mRenderBinder
+{
+	function<void(int pass)> BindPass;
+	function<void(int program)> BindProgram;
+	function<void(int textureSet)> BindTextures;
+	function<void(int mesh)> BindMesh;
+	function<void(PVRTuint32 item)> Draw;
+};
+
+/*!****************************************************************************
+@Struct		mRenderQueueStats
+@Description	Counters of the last Execute. Binds are the state changes that
+were issued; UnsortedBinds the ones the submission order would have needed
+and NaiveBinds the ones of binding everything for every draw.
+******************************************************************************/
+struct mRenderQueueStats
+{
+	unsigned int Items = 0;
+	unsigned int Binds = 0;
+	unsigned int UnsortedBinds = 0;
+	unsigned int NaiveBinds = 0;
+	unsigned int SortPasses = 0;			// radix digits that were not skipped
+};
+
+/*!****************************************************************************
+@Class		mRenderQueue
+@Description	Collects a frame's draws as 64 bit sort keys, radix sorts them
+and walks the sorted list binding only the state that changed.
+Opaque passes are keyed pass | program | textures | mesh | depth, so draws
+sharing state are together and front to back inside a state. Blended
+passes are keyed pass | inverted depth | program | textures | mesh, which
+keeps them back to front. Depth is quantized between SetDepthRange's near
+and far distances.
+******************************************************************************/
+class mRenderQueue
+{
+public:
+	mRenderQueue();
+	~mRenderQueue();
+
+	void SetPassBlended(int pass, bool blended);
+	void SetDepthRange(float nearDepth, float farDepth);
+	PVRTuint64 MakeKey(int pass, int program, int textureSet, int mesh, float depth);
+	void Submit(int pass, int program, int textureSet, int mesh, float depth, PVRTuint32 item);
+	void Sort();
+	void Execute(const mRenderBinder & binder);
+	void Clear();
+	unsigned int size();
+
+	static int KeyPass(PVRTuint64 key);
+	bool KeyBlended(PVRTuint64 key);
+	int KeyProgram(PVRTuint64 key);
+	int KeyTextureSet(PVRTuint64 key);
+	int KeyMesh(PVRTuint64 key);
+
+	vector<mRenderItem> Items;
+	mRenderQueueStats Stats;
+
+private:
+	vector<mRenderItem> Scratch;
+	vector<bool> PassBlended;
+	float NearDepth = 0.0f;
+	float FarDepth = 1.0f;
+
+	PVRTuint64 stateBits(PVRTuint64 key);
+	unsigned int countBinds();
+};
+
+#endif
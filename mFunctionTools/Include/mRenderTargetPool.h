@@ -0,0 +1,123 @@
+#ifndef __MRENDERTARGETPOOL_H_
+#define __MRENDERTARGETPOOL_H_
+
+#include <vector>
+#include "OGLES2Tools.h"
+using namespace std;
+
+// Size and formats of a render target, the key targets are shared by
+struct mRenderTargetDesc
+{
+	GLsizei Width = 0;
+	GLsizei Height = 0;
+	GLenum Format = GL_RGBA;				// of the color texture
+	GLenum Type = GL_UNSIGNED_BYTE;
+	GLenum DepthFormat = GL_DEPTH_COMPONENT16;	// 0 for no depth attachment
+
+	bool operator==(const mRenderTargetDesc & other) const;
+	bool operator!=(const mRenderTargetDesc & other) const { return !(*this == other); }
+};
+
+struct mRenderTarget
+{
+	mRenderTargetDesc Desc;
+	GLuint FBO = 0;
+	GLuint Texture = 0;
+	int Depth = -1;							// index in mRenderTargetPool::Depths
+	bool InUse = false;
+	unsigned int Bytes = 0;					// color texture only
+};
+
+// Depth renderbuffer attached to every target of its size and format
+struct mRenderTargetDepth
+{
+	GLsizei Width = 0;
+	GLsizei Height = 0;
+	GLenum Format = 0;
+	GLuint Renderbuffer = 0;
+	unsigned int Users = 0;
+	unsigned int Bytes = 0;
+};
+
+struct mRenderTargetStats
+{
+	unsigned int Targets = 0;
+	unsigned int TargetsInUse = 0;
+	unsigned int DepthBuffers = 0;
+	unsigned int TextureBytes = 0;
+	unsigned int DepthBytes = 0;
+	unsigned int Created = 0;				// since Init, a reused target is not created again
+	unsigned int Reused = 0;
+};
+
+/*!****************************************************************************
+@Class		mRenderTargetPool
+@Description	Hands out framebuffers with a color texture and a depth
+renderbuffer by mRenderTargetDesc. A released target is kept and given to
+the next Acquire of the same desc. The depth renderbuffer is only needed
+while a pass draws, so all targets of one size and depth format share
+one: passes that keep their textures for later still need a single depth
+buffer. Creating a target saves and restores the framebuffer, texture and
+renderbuffer bindings.
+******************************************************************************/
+class mRenderTargetPool
+{
+public:
+	mRenderTargetPool();
+	~mRenderTargetPool();
+
+	void Init(GLsizei screenWidth, GLsizei screenHeight);
+	mRenderTargetDesc ScaledDesc(float scale, GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE,
+		GLenum depthFormat = GL_DEPTH_COMPONENT16) const;
+	int Acquire(const mRenderTargetDesc & desc);
+	void Release(int target);
+	void ReleaseUnused();
+	void Destroy();
+
+	mRenderTargetStats GetStats() const;
+
+	GLsizei ScreenWidth = 0;
+	GLsizei ScreenHeight = 0;
+	vector<mRenderTarget> Targets;
+	vector<mRenderTargetDepth> Depths;
+
+private:
+	int AcquireDepth(const mRenderTargetDesc & desc);
+	void DeleteTarget(mRenderTarget & target);
+
+	unsigned int Created = 0;
+	unsigned int Reused = 0;
+};
+
+/*!****************************************************************************
+@Class		mRenderTargetPolicy
+@Description	When a pass renders into its target. Scale is the size of
+the target relative to the screen. The pass updates on its first frame,
+after Invalidate, and then when Interval frames have passed since its last
+update and the camera moved more than MoveThreshold or turned more than
+TurnThreshold degrees since then. Thresholds of 0 update every Interval
+frames whatever the camera does.
+******************************************************************************/
+class mRenderTargetPolicy
+{
+public:
+	bool NeedsUpdate(unsigned int frame, PVRTVec3 position, PVRTVec3 forward) const;
+	void Updated(unsigned int frame, PVRTVec3 position, PVRTVec3 forward);
+	void Invalidate();
+
+	float Scale = 1.0f;
+	unsigned int Interval = 1;
+	float MoveThreshold = 0.0f;
+	float TurnThreshold = 0.0f;
+
+	unsigned int Updates = 0;
+	unsigned int Skips = 0;
+
+private:
+	bool Valid = false;
+	unsigned int LastFrame = 0;
+	PVRTVec3 LastPosition;
+	PVRTVec3 LastForward;
+};
+
+#endif
@@ -5,17 +5,31 @@
 #include<algorithm>
 #include"mSuroundBox.h"
 #include"mModel.h"
+#include"mLinearQuadTree.h"
+#include"mLooseQuadTree.h"
+#include"mBVH.h"
+#include"mOcclusionCuller.h"
 using namespace std;
 
+enum SceneIndexMode
+{
+	SceneIndexQuadNode,
+	SceneIndexLinear,
+	SceneIndexLoose,
+	SceneIndexBVH
+};
+
 struct QuadNode
 {
 	mSuroundBox srBox;
 	mSuroundBox smallBox[4];
 	vector<mModel*> Models;
 	int Depth;
+	PVRTuint8 LastOutPlane;
 	QuadNode * children[4];
 	QuadNode(int depth, float Xmin, float Xmax, float Ymin, float Ymax, float Zmin, float Zmax){
 		Depth = depth;
+		LastOutPlane = 0;
 		srBox.CreateBoxFromCornerWorld(Xmin, Xmax, Ymin, Ymax, Zmin, Zmax);
 		smallBox[0].CreateBoxFromCornerWorld((Xmin + Xmax) / 2, Xmax, Ymin, Ymax, (Zmin + Zmax) / 2, Zmax);
 		smallBox[1].CreateBoxFromCornerWorld(Xmin, (Xmin + Xmax) / 2, Ymin, Ymax, (Zmin + Zmax) / 2, Zmax);
@@ -35,22 +49,43 @@ public:
 	mSceneManager(int depth, float Xmin, float Xmax, float Ymin, float Ymax, float Zmin, float Zmax);
 	~mSceneManager();
 	
-	vector<mModel*> ModelsNeedRender(PVRTMat4 & VP_Matrix);
+	vector<mModel*> ModelsNeedRender(mFrustum & frustum);
+	void QueryView(mFrustum & frustum, vector<mModel*> & modelsOut, vector<PVRTuint8> & lastOutPlane, mCullStats & stats);
+	bool CanQueryViewsInParallel();
+	mModel * RayCast(PVRTVec3 origin, PVRTVec3 direction, float maxDistance, float & hitDistance);
 	vector<mModel*> ModelsNeedRender2(PVRTMat4 & VP_Matrix);
 	vector<mModel*> ModelInScene;
 	int Count = 0;
+	int PlaneTests = 0;
+	int NodesVisited = 0;
+	int NodesAccepted = 0;
+	int NodesOccluded = 0;
+	int ModelsOccluded = 0;
 
 	void addModel(mModel * model);
+	void removeModel(mModel * model);
 	void makeQuadTree();
+	void makeLinearQuadTree();
+	void makeLooseQuadTree();
+	void makeBVH(mWorkerPool * pool = nullptr);
 	void Destroy();
 
+	int IndexMode = SceneIndexQuadNode;
+	mOcclusionCuller * Occlusion = nullptr;		// optional, applied by ModelsNeedRender when ready
+
 private:
-	QuadNode * QuadNodeHead;
+	QuadNode * QuadNodeHead = nullptr;
 	int QuadTreeDepth;
+	mLinearQuadTree LinearQuadTree;
+	mLooseQuadTree LooseQuadTree;
+	mBVH BVH;
 	
 	vector<mModel*> ModelWaitRender;
+	void queryIndex(mFrustumPlanes & planes);
+	void removeOccluded();
 	void makeQuadNode(QuadNode * ptr, vector<mModel*> ModelWaitArrange);
-	void checkQuadTree(QuadNode * ptr, PVRTMat4 & VP_Matrix);
+	void checkQuadTree(QuadNode * ptr, mFrustumPlanes & planes, PVRTuint32 planeMask);
+	void acceptQuadTree(QuadNode * ptr);
 	void deleteQuadNode(QuadNode* ptr);
 };
 
@@ -5,6 +5,8 @@
 #include "OGLES2Tools.h"
 #include <float.h>
 
+class mFrustum;
+
 //            2                                3
 //              ------------------------------
 //             /|                           /|
@@ -51,12 +53,15 @@ public:
 	~mSuroundBox();
 
 	void UpdateBoxModel(PVRTuint32 vertexNum, PVRTuint8 * pointPtr, PVRTuint8 stride);
+	void SetBoxModel(PVRTVec3 boxMin, PVRTVec3 boxMax);
 	void UpdateBoxWorld(PVRTMat4 & ModelMatrix);
 	void CreateBoxFromCornerWorld(float Xmin, float Xmax, float Ymin, float Ymax, float Zmin, float Zmax);
 	bool NeedClipFromObjSpace(PVRTMat4 & MVP_Matrix);
 	bool NeedClipFromWorldSpace(PVRTMat4 & VP_Matrix);
+	bool NeedClipFromFrustum(mFrustum & frustum);
 	int HitBox(mSuroundBox & Box);
 	bool CenterInsideBoxWorldSpace(mSuroundBox & Box);
+	void GetBoxWorld(PVRTVec3 & boxMin, PVRTVec3 & boxMax);
 
 	PVRTVec4 pointMin = PVRTVec4(FLT_MAX, FLT_MAX, FLT_MAX, 1.0);
 	PVRTVec4 pointMax = PVRTVec4(-FLT_MAX, -FLT_MAX, -FLT_MAX, 1.0);
@@ -64,6 +69,7 @@ public:
 private:
 	PVRTVec4 CenterModel;
 	PVRTVec4 CenterWorld;
+	float RadiusWorld = 0.0f;
 	PVRTVec4 pointCornersModel[8];
 	PVRTVec4 clipPlaneModel[6];
 
@@ -71,6 +77,7 @@ private:
 	PVRTVec4 clipPlaneWorld[6];
 	void createCornerPointsModel();
 	void createCornerPointsWorld();
+	void updateRadiusWorld();
 };
 
 
@@ -0,0 +1,45 @@
+#ifndef __MTRIANGLEBVH_H_
+#define __MTRIANGLEBVH_H_
+
+#include <vector>
+#include "mBVH.h"
+using namespace std;
+
+/*!****************************************************************************
+@Class		mTriangleBVH
+@Description	BVH over the triangles of POD meshes, in the space of the mesh
+vertices, for exact ray hits. Hand it to mModel::MeshBVH and the scene
+BVH ray queries test the model's triangles instead of its box.
+Triangles are copied and reordered so every leaf is contiguous.
+******************************************************************************/
+class mTriangleBVH
+{
+public:
+	mTriangleBVH();
+	~mTriangleBVH();
+
+	void Build(CPVRTModelPOD & modelPOD, mWorkerPool * pool = nullptr);
+	void Build(SPODMesh & mesh, mWorkerPool * pool = nullptr);
+	void Build(const PVRTuint8 * positions, unsigned int stride, unsigned int vertexCount,
+		const PVRTuint16 * indices, unsigned int triangleCount, mWorkerPool * pool = nullptr);
+	bool RayCast(PVRTVec3 origin, PVRTVec3 direction, float maxDistance, float & hitDistance, unsigned int * triangle = nullptr);
+	void Clear();
+	unsigned int TriangleCount();
+
+	vector<BVHNode> Nodes;
+	int RayNodeTests = 0;
+	int RayTriangleTests = 0;
+
+private:
+	vector<PVRTVec3> Vertices;				// 3 per triangle
+	vector<PVRTuint32> TriangleIndex;		// triangle number before the reorder
+	mBVHBuilder Builder;
+
+	void addMesh(SPODMesh & mesh);
+	void addTriangles(const PVRTuint8 * positions, unsigned int stride, unsigned int vertexCount,
+		const PVRTuint16 * indices, const PVRTuint32 * indices32, unsigned int triangleCount);
+	void buildTree(mWorkerPool * pool);
+	bool intersectTriangle(unsigned int triangle, PVRTVec3 & origin, PVRTVec3 & direction, float maxDistance, float & hitDistance);
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef __MWATERCLIPMAP_H_
+#define __MWATERCLIPMAP_H_
+
+#include <vector>
+#include "OGLES2Tools.h"
+using namespace std;
+
+const int c_iClipmapMaxLevels = 16;
+const unsigned int c_uiClipmapVertexFloats = 14;		// position, normal, tangent, binormal, uv
+
+/*!****************************************************************************
+@Struct		ClipmapRange
+@Description	Part of mWaterClipmap::Indices. Vertices is the number of
+different vertices the range uses.
+******************************************************************************/
+struct ClipmapRange
+{
+	PVRTuint32 First;
+	PVRTuint32 Count;
+	PVRTuint32 Vertices;
+};
+
+struct ClipmapDraw
+{
+	int Level;
+	int Range;
+	PVRTMat4 Model;
+};
+
+/*!****************************************************************************
+@Class		mWaterClipmap
+@Description	Camera centered water made of nested square levels. Level l
+has quads of Spacing * 2^l and is GridSize quads wide, so every level
+covers twice the size of the one inside it and the water reaches
+Extent() around the camera with the same vertex count everywhere.
+All levels share one vertex grid, the meshes are index ranges of it:
+eFull for the finest level, eRing for the others and one of four
+L-shaped trims filling the one quad gap left by the snapping.
+Level l is snapped to 2 * its quad size, so the inner level is always
+on the outer level's vertices. The outer edge of every level drops its
+odd vertices, so both sides of a level border have the same vertices.
+******************************************************************************/
+class mWaterClipmap
+{
+public:
+	enum ERange{ eFull, eRing, eTrim, eNumRanges = eTrim + 4 };
+
+	mWaterClipmap();
+	~mWaterClipmap();
+
+	bool Generate(int gridSize, int levels, float spacing);
+	void LoadVBO();
+	void DeleteVBOs();
+	void Update(PVRTVec3 eye);
+	float Extent();
+	void Destroy();
+
+	vector<GLfloat> Vertices;
+	vector<PVRTuint16> Indices;
+	ClipmapRange Ranges[eNumRanges];
+	GLuint VBO = 0;
+	GLuint IndexVBO = 0;
+	int GridSize = 0;
+	int LevelCount = 0;
+	float Spacing = 0.0f;
+	double GenerateMs = 0.0;
+
+	// per Update
+	vector<ClipmapDraw> Draws;
+	unsigned int FrameVertices = 0;
+	unsigned int FrameTriangles = 0;
+
+private:
+	void beginRange(int range);
+	void endRange(int range);
+	void emitQuad(int x, int z);
+	void snapEdge(int & x, int & z);
+	PVRTuint16 vertexIndex(int x, int z);
+};
+
+#endif
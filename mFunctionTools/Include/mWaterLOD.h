@@ -0,0 +1,103 @@
+#ifndef __MWATERLOD_H_
+#define __MWATERLOD_H_
+
+#include <vector>
+#include <unordered_map>
+#include "mModel.h"
+using namespace std;
+
+// stitch bits, set when the neighbor on that side of the tile is one level coarser
+const int c_iWaterStitchMinX = 1;
+const int c_iWaterStitchMaxX = 2;
+const int c_iWaterStitchMinZ = 4;
+const int c_iWaterStitchMaxZ = 8;
+const int c_iWaterStitchCombinations = 16;
+const int c_iWaterMaxLevels = 8;
+
+/*!****************************************************************************
+@Struct		WaterLODLevel
+@Description	One mesh of the WaterPlane family. Resolution is the number of
+quads per side, Scale stretches the mesh in XZ to the tile size. The
+mesh's own faces are not used: the interior quads and the outer ring are
+indexed again, the ring once for every stitch combination.
+******************************************************************************/
+struct WaterLODLevel
+{
+	CPVRTModelPOD * POD;
+	int Resolution;
+	float MeshSize;
+	float Scale;
+	GLuint VBO;
+	PVRTuint32 InteriorFirst;					// indices, into mWaterLOD::Indices
+	PVRTuint32 InteriorCount;
+	PVRTuint32 RingFirst[c_iWaterStitchCombinations];
+	PVRTuint32 RingCount[c_iWaterStitchCombinations];
+	vector<PVRTuint16> GridVertex;			// vertex of grid point (x, z), (Resolution + 1)^2
+};
+
+struct WaterLODTile
+{
+	mModel * Model;
+	int GridX;
+	int GridZ;
+	int Level;
+	int Stitch;
+};
+
+/*!****************************************************************************
+@Class		mWaterLOD
+@Description	Per tile level of detail for a grid of water tiles that all use
+the same flat mesh. The levels are WaterPlane meshes of lower resolution
+stretched to the tile size; only resolutions dividing the next finer one
+are kept so every coarse edge vertex also exists in the finer mesh.
+Select picks for every tile the coarsest level whose quads project to at
+most MaxPixelError pixels, then limits neighbors to one level apart.
+A tile next to a coarser one snaps its odd edge vertices onto the coarse
+edge, so shared edges have the same vertices and no cracks or T-joints.
+******************************************************************************/
+class mWaterLOD
+{
+public:
+	mWaterLOD();
+	~mWaterLOD();
+
+	bool AddLevel(CPVRTModelPOD * modelPOD);
+	bool Build(float tileSize);
+	void LoadVBO();
+	void DeleteVBOs();
+	void AddTile(mModel * model);
+	void ClearTiles();
+	void Select(PVRTVec3 eye, float projectionScale);
+	bool GetTile(mModel * model, int & level, int & stitch);
+	PVRTMat4 GetLevelMatrix(mModel * model, int level);
+	mAffine GetLevelTransform(mModel * model, int level, mAffine & inverse);
+	unsigned int LevelCount();
+	void Destroy();
+
+	vector<WaterLODLevel> Levels;				// finest first
+	vector<PVRTuint16> Indices;
+	GLuint IndexVBO = 0;
+	float TileSize = 0.0f;
+	float MaxPixelError = 12.0f;				// projected quad size
+
+	// per Select
+	unsigned int TilesPerLevel[c_iWaterMaxLevels];
+
+private:
+	vector<WaterLODTile> Tiles;
+	unordered_map<mModel*, int> TileIndex;
+	vector<int> Grid;							// tile index or -1
+	int GridMinX = 0;
+	int GridMinZ = 0;
+	int GridWidth = 0;
+	int GridDepth = 0;
+	bool GridDirty = true;
+
+	bool mapGrid(WaterLODLevel & level);
+	void buildIndices(WaterLODLevel & level, int ratio, bool faceUp);
+	void emitQuad(WaterLODLevel & level, int x, int z, int stitch, int ratio, bool faceUp);
+	void buildGrid();
+	int neighbor(WaterLODTile & tile, int dx, int dz);
+};
+
+#endif
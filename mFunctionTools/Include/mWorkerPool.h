@@ -0,0 +1,43 @@
+#ifndef __MWORKERPOOL_H_
+#define __MWORKERPOOL_H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+using namespace std;
+
+/*!****************************************************************************
+@Class		mWorkerPool
+@Description	Fixed set of worker threads running parallel-for style jobs.
+Run hands out task indices 0..taskCount-1 to the workers and the calling
+thread, and returns once every task has finished. Only one thread may
+call Run at a time. With zero worker threads Run executes serially.
+******************************************************************************/
+class mWorkerPool
+{
+public:
+	mWorkerPool();
+	~mWorkerPool();
+
+	void Init(int threadCount = -1);
+	void Run(int taskCount, const function<void(int)> & task);
+	int ThreadCount();
+	void Destroy();
+
+private:
+	vector<thread> Threads;
+	mutex Mutex;
+	condition_variable WakeUp;
+	condition_variable Done;
+	const function<void(int)> * Task = nullptr;
+	int TaskCount = 0;
+	int NextTask = 0;
+	int Pending = 0;
+	bool Quit = false;
+
+	void workerLoop();
+};
+
+#endif
@@ -0,0 +1,200 @@
+#include "..\Include\mAffine.h"
+
+
+mAffine::mAffine()
+{
+	for (int row = 0; row < 3; ++row){
+		for (int column = 0; column < 4; ++column){
+			this->Rows[row][column] = row == column ? 1.0f : 0.0f;
+		}
+	}
+}
+
+mAffine::mAffine(const PVRTMat4 & matrix)
+{
+	for (int row = 0; row < 3; ++row){
+		for (int column = 0; column < 4; ++column){
+			this->Rows[row][column] = matrix.f[column * 4 + row];
+		}
+	}
+}
+
+mAffine mAffine::Translation(const PVRTVec3 & translation)
+{
+	mAffine result;
+	result.Rows[0][3] = translation.x;
+	result.Rows[1][3] = translation.y;
+	result.Rows[2][3] = translation.z;
+	return result;
+}
+
+mAffine mAffine::Scale(const PVRTVec3 & scale)
+{
+	mAffine result;
+	result.Rows[0][0] = scale.x;
+	result.Rows[1][1] = scale.y;
+	result.Rows[2][2] = scale.z;
+	return result;
+}
+
+/*!****************************************************************************
+@Function		TRS
+@Input			translation		applied last
+@Input			rotation		column major like PVRTMat3
+@Input			scale			applied first, along the model axes
+@Description	Translation * Rotation * Scale without the matrix products,
+the rotation's columns are scaled and the translation copied.
+******************************************************************************/
+mAffine mAffine::TRS(const PVRTVec3 & translation, const PVRTMat3 & rotation, const PVRTVec3 & scale)
+{
+	mAffine result;
+	const PVRTfloat32 s[3] = { scale.x, scale.y, scale.z };
+	const PVRTfloat32 t[3] = { translation.x, translation.y, translation.z };
+	for (int row = 0; row < 3; ++row){
+		for (int column = 0; column < 3; ++column){
+			result.Rows[row][column] = rotation.f[column * 3 + row] * s[column];
+		}
+		result.Rows[row][3] = t[row];
+	}
+	return result;
+}
+
+mAffine mAffine::operator*(const mAffine & rhs) const
+{
+	mAffine result;
+	for (int row = 0; row < 3; ++row){
+		const PVRTfloat32 * r = this->Rows[row];
+		for (int column = 0; column < 4; ++column){
+			result.Rows[row][column] = r[0] * rhs.Rows[0][column] + r[1] * rhs.Rows[1][column] + r[2] * rhs.Rows[2][column];
+		}
+		result.Rows[row][3] += r[3];
+	}
+	return result;
+}
+
+PVRTVec3 mAffine::TransformPoint(const PVRTVec3 & point) const
+{
+	return PVRTVec3(
+		this->Rows[0][0] * point.x + this->Rows[0][1] * point.y + this->Rows[0][2] * point.z + this->Rows[0][3],
+		this->Rows[1][0] * point.x + this->Rows[1][1] * point.y + this->Rows[1][2] * point.z + this->Rows[1][3],
+		this->Rows[2][0] * point.x + this->Rows[2][1] * point.y + this->Rows[2][2] * point.z + this->Rows[2][3]);
+}
+
+PVRTVec3 mAffine::TransformVector(const PVRTVec3 & vector) const
+{
+	return PVRTVec3(
+		this->Rows[0][0] * vector.x + this->Rows[0][1] * vector.y + this->Rows[0][2] * vector.z,
+		this->Rows[1][0] * vector.x + this->Rows[1][1] * vector.y + this->Rows[1][2] * vector.z,
+		this->Rows[2][0] * vector.x + this->Rows[2][1] * vector.y + this->Rows[2][2] * vector.z);
+}
+
+PVRTVec3 mAffine::GetTranslation() const
+{
+	return PVRTVec3(this->Rows[0][3], this->Rows[1][3], this->Rows[2][3]);
+}
+
+/*!****************************************************************************
+@Function		Inverse
+@Description	Inverts the linear part from its cofactors and moves the
+translation through it. A singular transform (a zero scale) gives the
+identity instead of infinities.
+******************************************************************************/
+mAffine mAffine::Inverse() const
+{
+	const PVRTfloat32 (*m)[4] = this->Rows;
+	// cofactors of the linear part, transposed: the adjugate
+	PVRTfloat32 a[3][3];
+	a[0][0] = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+	a[0][1] = m[0][2] * m[2][1] - m[0][1] * m[2][2];
+	a[0][2] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+	a[1][0] = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+	a[1][1] = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+	a[1][2] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+	a[2][0] = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+	a[2][1] = m[0][1] * m[2][0] - m[0][0] * m[2][1];
+	a[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+
+	mAffine result;
+	PVRTfloat32 det = m[0][0] * a[0][0] + m[0][1] * a[1][0] + m[0][2] * a[2][0];
+	if (det == 0.0f) return result;
+
+	PVRTfloat32 invDet = 1.0f / det;
+	for (int row = 0; row < 3; ++row){
+		for (int column = 0; column < 3; ++column){
+			result.Rows[row][column] = a[row][column] * invDet;
+		}
+	}
+	for (int row = 0; row < 3; ++row){
+		result.Rows[row][3] = -(result.Rows[row][0] * m[0][3] + result.Rows[row][1] * m[1][3] + result.Rows[row][2] * m[2][3]);
+	}
+	return result;
+}
+
+/*!****************************************************************************
+@Function		InverseTranspose
+@Return		PVRTMat3		the normal matrix, column major
+@Description	Transposed inverse of the linear part, the translation does
+not move normals.
+******************************************************************************/
+PVRTMat3 mAffine::InverseTranspose() const
+{
+	mAffine inverse = this->Inverse();
+	PVRTMat3 result;
+	for (int row = 0; row < 3; ++row){
+		for (int column = 0; column < 3; ++column){
+			// element (row, column) of the transpose is (column, row) of the inverse
+			result.f[column * 3 + row] = inverse.Rows[column][row];
+		}
+	}
+	return result;
+}
+
+PVRTMat4 mAffine::ToMat4() const
+{
+	PVRTMat4 result;
+	for (int column = 0; column < 4; ++column){
+		result.f[column * 4 + 0] = this->Rows[0][column];
+		result.f[column * 4 + 1] = this->Rows[1][column];
+		result.f[column * 4 + 2] = this->Rows[2][column];
+		result.f[column * 4 + 3] = column == 3 ? 1.0f : 0.0f;
+	}
+	return result;
+}
+
+/*!****************************************************************************
+@Function		TransposedMat4
+@Description	ToMat4().transpose() without the temporary, for uniforms that
+want the 4x4 inverse transpose: call it on the inverse.
+******************************************************************************/
+PVRTMat4 mAffine::TransposedMat4() const
+{
+	PVRTMat4 result;
+	for (int row = 0; row < 3; ++row){
+		for (int column = 0; column < 4; ++column){
+			result.f[row * 4 + column] = this->Rows[row][column];
+		}
+	}
+	result.f[12] = result.f[13] = result.f[14] = 0.0f;
+	result.f[15] = 1.0f;
+	return result;
+}
+
+/*!****************************************************************************
+@Function		operator*
+@Description	PVRTMat4 times an affine transform, for model view and model
+view projection matrices. 48 multiplies instead of 64.
+******************************************************************************/
+PVRTMat4 operator*(const PVRTMat4 & lhs, const mAffine & rhs)
+{
+	PVRTMat4 result;
+	for (int column = 0; column < 4; ++column){
+		const PVRTfloat32 c0 = rhs.Rows[0][column], c1 = rhs.Rows[1][column], c2 = rhs.Rows[2][column];
+		for (int row = 0; row < 4; ++row){
+			result.f[column * 4 + row] = lhs.f[row] * c0 + lhs.f[4 + row] * c1 + lhs.f[8 + row] * c2;
+		}
+	}
+	for (int row = 0; row < 4; ++row){
+		result.f[12 + row] += lhs.f[12 + row];
+	}
+	return result;
+}
@@ -0,0 +1,613 @@
+#include "..\Include\mBVH.h"
+#include "..\Include\mTriangleBVH.h"
+#include <float.h>
+
+const int c_iBVHBins = 16;
+const int c_iBVHMaxDepth = 60;
+const int c_iBVHStackSize = 128;
+const float c_fBVHTraversalCost = 1.0f;					// relative to one item test
+const PVRTuint32 c_uiBVHParallelBinning = 65536;		// smaller ranges are binned on one thread
+const PVRTuint32 c_uiBVHMinTaskSize = 1024;				// smaller ranges are not worth a task
+
+struct BVHBuildTask
+{
+	PVRTuint32 Node;
+	int Depth;
+};
+
+static BVHNode MakeBVHNode(PVRTuint32 first, PVRTuint32 count)
+{
+	BVHNode node;
+	node.First = first;
+	node.Count = count;
+	node.Left = -1;
+	node.LastOutPlane = 0;
+	return node;
+}
+
+static void ResetBin(BVHBin & bin)
+{
+	for (int a = 0; a < 3; ++a){
+		bin.Min[a] = FLT_MAX;
+		bin.Max[a] = -FLT_MAX;
+	}
+	bin.Count = 0;
+}
+
+static void GrowBin(BVHBin & bin, const float * boxMin, const float * boxMax)
+{
+	for (int a = 0; a < 3; ++a){
+		bin.Min[a] = PVRT_MIN(bin.Min[a], boxMin[a]);
+		bin.Max[a] = PVRT_MAX(bin.Max[a], boxMax[a]);
+	}
+}
+
+static float HalfArea(const float * boxMin, const float * boxMax)
+{
+	float dx = boxMax[0] - boxMin[0], dy = boxMax[1] - boxMin[1], dz = boxMax[2] - boxMin[2];
+	return dx * dy + dy * dz + dz * dx;
+}
+
+void mBVHBuilder::boundRange(PVRTuint32 begin, PVRTuint32 end, BVHRangeBounds & range)
+{
+	for (int a = 0; a < 3; ++a){
+		range.Min[a] = range.CentroidMin[a] = FLT_MAX;
+		range.Max[a] = range.CentroidMax[a] = -FLT_MAX;
+	}
+	for (PVRTuint32 i = begin; i < end; ++i){
+		PVRTuint32 item = this->Order[i];
+		for (int a = 0; a < 3; ++a){
+			range.Min[a] = PVRT_MIN(range.Min[a], (&this->ItemMin[item].x)[a]);
+			range.Max[a] = PVRT_MAX(range.Max[a], (&this->ItemMax[item].x)[a]);
+			range.CentroidMin[a] = PVRT_MIN(range.CentroidMin[a], (&this->Centroid[item].x)[a]);
+			range.CentroidMax[a] = PVRT_MAX(range.CentroidMax[a], (&this->Centroid[item].x)[a]);
+		}
+	}
+}
+
+void mBVHBuilder::binRange(PVRTuint32 begin, PVRTuint32 end, const float * centroidMin, const float * binScale, BVHBin * bins)
+{
+	for (int b = 0; b < 3 * c_iBVHBins; ++b) ResetBin(bins[b]);
+	for (PVRTuint32 i = begin; i < end; ++i){
+		PVRTuint32 item = this->Order[i];
+		for (int a = 0; a < 3; ++a){
+			if (binScale[a] == 0.0f) continue;
+			int b = PVRT_MIN(c_iBVHBins - 1, (int)(((&this->Centroid[item].x)[a] - centroidMin[a]) * binScale[a]));
+			BVHBin & bin = bins[a * c_iBVHBins + b];
+			GrowBin(bin, &this->ItemMin[item].x, &this->ItemMax[item].x);
+			bin.Count++;
+		}
+	}
+}
+
+/*!****************************************************************************
+@Function		splitNode
+@Modified		node		First/Count in, bounds out
+@Input			depth		depth of the node, the root is 0
+@Output		leftCount	items that went to the left child
+@Input			pool		bins large ranges in parallel, may be NULL
+@Return		bool		false when the node stays a leaf
+@Description	Bins the item centroids on all three axes and keeps the split
+with the lowest SAH cost. The range is partitioned in place, the left
+child gets the first leftCount items.
+******************************************************************************/
+bool mBVHBuilder::splitNode(BVHNode & node, int depth, PVRTuint32 & leftCount, mWorkerPool * pool)
+{
+	PVRTuint32 first = node.First, count = node.Count;
+	bool parallel = pool != nullptr && pool->ThreadCount() > 0 && count >= c_uiBVHParallelBinning;
+	int chunks = parallel ? 2 * (pool->ThreadCount() + 1) : 1;
+
+	BVHRangeBounds range;
+	if (parallel){
+		vector<BVHRangeBounds> ranges(chunks);
+		pool->Run(chunks, [&](int c){
+			this->boundRange(first + (PVRTuint32)((PVRTuint64)count * c / chunks),
+				first + (PVRTuint32)((PVRTuint64)count * (c + 1) / chunks), ranges[c]);
+		});
+		range = ranges[0];
+		for (int c = 1; c < chunks; ++c){
+			for (int a = 0; a < 3; ++a){
+				range.Min[a] = PVRT_MIN(range.Min[a], ranges[c].Min[a]);
+				range.Max[a] = PVRT_MAX(range.Max[a], ranges[c].Max[a]);
+				range.CentroidMin[a] = PVRT_MIN(range.CentroidMin[a], ranges[c].CentroidMin[a]);
+				range.CentroidMax[a] = PVRT_MAX(range.CentroidMax[a], ranges[c].CentroidMax[a]);
+			}
+		}
+	}
+	else{
+		this->boundRange(first, first + count, range);
+	}
+	for (int a = 0; a < 3; ++a){
+		node.Min[a] = range.Min[a];
+		node.Max[a] = range.Max[a];
+	}
+	if ((int)count <= this->LeafSize || depth >= c_iBVHMaxDepth) return false;
+
+	float * centroidMin = range.CentroidMin;
+	float * centroidMax = range.CentroidMax;
+	float binScale[3];
+	bool anyExtent = false;
+	for (int a = 0; a < 3; ++a){
+		float extent = centroidMax[a] - centroidMin[a];
+		binScale[a] = extent > 0.0f ? c_iBVHBins * 0.9999f / extent : 0.0f;
+		anyExtent = anyExtent || extent > 0.0f;
+	}
+	if (!anyExtent){
+		// every centroid is the same point, no split can separate them
+		if ((int)count <= this->MaxLeafSize) return false;
+		leftCount = count / 2;
+		return true;
+	}
+
+	BVHBin bins[3 * c_iBVHBins];
+	if (parallel){
+		vector<BVHBin> chunkBins(chunks * 3 * c_iBVHBins);
+		pool->Run(chunks, [&](int c){
+			this->binRange(first + (PVRTuint32)((PVRTuint64)count * c / chunks),
+				first + (PVRTuint32)((PVRTuint64)count * (c + 1) / chunks), centroidMin, binScale, &chunkBins[c * 3 * c_iBVHBins]);
+		});
+		for (int b = 0; b < 3 * c_iBVHBins; ++b){
+			bins[b] = chunkBins[b];
+			for (int c = 1; c < chunks; ++c){
+				BVHBin & other = chunkBins[c * 3 * c_iBVHBins + b];
+				GrowBin(bins[b], other.Min, other.Max);
+				bins[b].Count += other.Count;
+			}
+		}
+	}
+	else{
+		this->binRange(first, first + count, centroidMin, binScale, bins);
+	}
+
+	// sweep: split s puts bins 0..s on the left and s+1.. on the right
+	float bestCost = FLT_MAX;
+	int bestAxis = -1, bestSplit = -1;
+	for (int a = 0; a < 3; ++a){
+		if (binScale[a] == 0.0f) continue;
+		BVHBin * axisBins = &bins[a * c_iBVHBins];
+		float rightCost[c_iBVHBins];
+		BVHBin right;
+		ResetBin(right);
+		for (int s = c_iBVHBins - 1; s > 0; --s){
+			GrowBin(right, axisBins[s].Min, axisBins[s].Max);
+			right.Count += axisBins[s].Count;
+			rightCost[s - 1] = right.Count ? HalfArea(right.Min, right.Max) * right.Count : 0.0f;
+		}
+		BVHBin left;
+		ResetBin(left);
+		for (int s = 0; s < c_iBVHBins - 1; ++s){
+			GrowBin(left, axisBins[s].Min, axisBins[s].Max);
+			left.Count += axisBins[s].Count;
+			if (left.Count == 0 || left.Count == count) continue;
+			float cost = HalfArea(left.Min, left.Max) * left.Count + rightCost[s];
+			if (cost < bestCost){
+				bestCost = cost;
+				bestAxis = a;
+				bestSplit = s;
+			}
+		}
+	}
+
+	float parentArea = HalfArea(node.Min, node.Max);
+	float splitCost = bestAxis < 0 ? FLT_MAX : c_fBVHTraversalCost + (parentArea > 0.0f ? bestCost / parentArea : 0.0f);
+	if (splitCost >= (float)count && (int)count <= this->MaxLeafSize) return false;
+
+	PVRTuint32 * begin = this->Order + first;
+	PVRTuint32 * end = begin + count;
+	if (bestAxis >= 0){
+		float binMin = centroidMin[bestAxis], scale = binScale[bestAxis];
+		PVRTVec3 * centroid = &this->Centroid[0];
+		PVRTuint32 * middle = partition(begin, end, [=](PVRTuint32 item){
+			return PVRT_MIN(c_iBVHBins - 1, (int)(((&centroid[item].x)[bestAxis] - binMin) * scale)) <= bestSplit;
+		});
+		leftCount = (PVRTuint32)(middle - begin);
+		if (leftCount > 0 && leftCount < count) return true;
+	}
+
+	// no usable bin split, fall back to the median on the widest axis
+	int axis = 0;
+	for (int a = 1; a < 3; ++a){
+		if (centroidMax[a] - centroidMin[a] > centroidMax[axis] - centroidMin[axis]) axis = a;
+	}
+	PVRTVec3 * centroid = &this->Centroid[0];
+	nth_element(begin, begin + count / 2, end, [=](PVRTuint32 lhs, PVRTuint32 rhs){
+		return (&centroid[lhs].x)[axis] < (&centroid[rhs].x)[axis];
+	});
+	leftCount = count / 2;
+	return true;
+}
+
+/*!****************************************************************************
+@Function		buildSubtree
+@Input			root		node with its item range set
+@Input			depth		depth of root in the whole tree
+@Output		nodesOut	root first, child indices are local to nodesOut
+******************************************************************************/
+void mBVHBuilder::buildSubtree(BVHNode & root, int depth, vector<BVHNode> & nodesOut)
+{
+	nodesOut.clear();
+	nodesOut.push_back(root);
+	vector<BVHBuildTask> stack;
+	BVHBuildTask task = { 0, depth };
+	stack.push_back(task);
+	while (!stack.empty()){
+		task = stack.back();
+		stack.pop_back();
+		PVRTuint32 leftCount;
+		if (!this->splitNode(nodesOut[task.Node], task.Depth, leftCount, nullptr)) continue;
+
+		BVHNode & node = nodesOut[task.Node];
+		BVHNode left = MakeBVHNode(node.First, leftCount);
+		BVHNode right = MakeBVHNode(node.First + leftCount, node.Count - leftCount);
+		node.Left = (int)nodesOut.size();
+		nodesOut.push_back(left);
+		nodesOut.push_back(right);
+		BVHBuildTask leftTask = { (PVRTuint32)nodesOut.size() - 2, task.Depth + 1 };
+		BVHBuildTask rightTask = { (PVRTuint32)nodesOut.size() - 1, task.Depth + 1 };
+		stack.push_back(rightTask);
+		stack.push_back(leftTask);
+	}
+}
+
+/*!****************************************************************************
+@Function		Build
+@Input			itemMin		bounds of every item
+@Input			itemMax
+@Output		nodes		node 0 is the root
+@Output		itemOrder	item indices, the range of a node is contiguous
+@Input			pool		optional, NULL builds on the calling thread
+******************************************************************************/
+void mBVHBuilder::Build(vector<PVRTVec3> & itemMin, vector<PVRTVec3> & itemMax, vector<BVHNode> & nodes, vector<PVRTuint32> & itemOrder, mWorkerPool * pool)
+{
+	PVRTuint32 count = (PVRTuint32)itemMin.size();
+	nodes.clear();
+	itemOrder.resize(count);
+	if (count == 0) return;
+
+	this->ItemMin = &itemMin[0];
+	this->ItemMax = &itemMax[0];
+	this->Order = &itemOrder[0];
+	this->Centroid.resize(count);
+	for (PVRTuint32 i = 0; i < count; ++i){
+		itemOrder[i] = i;
+		this->Centroid[i] = (itemMin[i] + itemMax[i]) * 0.5f;
+	}
+
+	nodes.push_back(MakeBVHNode(0, count));
+	vector<BVHBuildTask> tasks;
+	BVHBuildTask rootTask = { 0, 0 };
+	tasks.push_back(rootTask);
+
+	// split the biggest ranges on this thread until every worker has a few subtrees
+	if (pool != nullptr && pool->ThreadCount() > 0){
+		unsigned int target = 4 * (pool->ThreadCount() + 1);
+		while (!tasks.empty() && tasks.size() < target){
+			unsigned int largest = 0;
+			for (unsigned int t = 1; t < tasks.size(); ++t){
+				if (nodes[tasks[t].Node].Count > nodes[tasks[largest].Node].Count) largest = t;
+			}
+			if (nodes[tasks[largest].Node].Count < c_uiBVHMinTaskSize) break;
+
+			BVHBuildTask task = tasks[largest];
+			tasks.erase(tasks.begin() + largest);
+			PVRTuint32 leftCount;
+			if (!this->splitNode(nodes[task.Node], task.Depth, leftCount, pool)) continue;
+
+			BVHNode left = MakeBVHNode(nodes[task.Node].First, leftCount);
+			BVHNode right = MakeBVHNode(nodes[task.Node].First + leftCount, nodes[task.Node].Count - leftCount);
+			nodes[task.Node].Left = (int)nodes.size();
+			nodes.push_back(left);
+			nodes.push_back(right);
+			BVHBuildTask leftTask = { (PVRTuint32)nodes.size() - 2, task.Depth + 1 };
+			BVHBuildTask rightTask = { (PVRTuint32)nodes.size() - 1, task.Depth + 1 };
+			tasks.push_back(leftTask);
+			tasks.push_back(rightTask);
+		}
+	}
+
+	vector<vector<BVHNode> > subtrees(tasks.size());
+	function<void(int)> buildTask = [&](int t){
+		BVHNode root = nodes[tasks[t].Node];
+		this->buildSubtree(root, tasks[t].Depth, subtrees[t]);
+	};
+	if (pool != nullptr) pool->Run((int)tasks.size(), buildTask);
+	else buildTask(0);
+
+	// local node i > 0 of a subtree lands at base + i - 1
+	for (unsigned int t = 0; t < tasks.size(); ++t){
+		vector<BVHNode> & subtree = subtrees[t];
+		int base = (int)nodes.size();
+		for (unsigned int i = 0; i < subtree.size(); ++i){
+			BVHNode node = subtree[i];
+			if (node.Left >= 0) node.Left = base + node.Left - 1;
+			if (i == 0) nodes[tasks[t].Node] = node;
+			else nodes.push_back(node);
+		}
+	}
+
+	this->Centroid.clear();
+	this->ItemMin = nullptr;
+	this->ItemMax = nullptr;
+	this->Order = nullptr;
+}
+
+mBVH::mBVH()
+{
+}
+
+mBVH::~mBVH()
+{
+}
+
+/*!****************************************************************************
+@Function		Build
+@Input			models		models to index, the pointers must stay valid
+@Input			pool		optional, NULL builds on the calling thread
+@Description	Unlike the quadtrees there are no root bounds, every model
+is indexed wherever it is.
+******************************************************************************/
+void mBVH::Build(vector<mModel*> & models, mWorkerPool * pool)
+{
+	this->Clear();
+	this->Models = models;
+	this->BoxMin.resize(models.size());
+	this->BoxMax.resize(models.size());
+	for (unsigned int i = 0; i < models.size(); ++i){
+		models[i]->SurrondBox.GetBoxWorld(this->BoxMin[i], this->BoxMax[i]);
+	}
+	this->Builder.Build(this->BoxMin, this->BoxMax, this->Nodes, this->ModelIndex, pool);
+}
+
+/*!****************************************************************************
+@Function		Query
+@Input			planes		world space frustum planes
+@Output		modelsOut	visible models are appended, needRender is set
+@Description	Leaves are accepted with all their models, a node fully inside
+the frustum takes its whole item range without visiting its children.
+******************************************************************************/
+void mBVH::Query(mFrustumPlanes & planes, vector<mModel*> & modelsOut)
+{
+	mCullStats stats;
+	this->queryNodes(planes, modelsOut, nullptr, stats, true);
+	this->NodesVisited = stats.NodesVisited;
+	this->NodesCulled = stats.NodesCulled;
+	this->NodesAccepted = stats.NodesAccepted;
+	this->PlaneTests = stats.PlaneTests;
+}
+
+/*!****************************************************************************
+@Function		QueryView
+@Input			planes			world space frustum planes
+@Output		modelsOut		visible models are appended
+@Modified		lastOutPlane	one entry per node, owned by the caller
+@Output		stats			work done by this query
+@Description	Read-only on the tree and the models, several views may be
+queried at the same time from different threads.
+******************************************************************************/
+void mBVH::QueryView(mFrustumPlanes & planes, vector<mModel*> & modelsOut, vector<PVRTuint8> & lastOutPlane, mCullStats & stats)
+{
+	if (lastOutPlane.size() != this->Nodes.size()) lastOutPlane.assign(this->Nodes.size(), 0);
+	stats = mCullStats();
+	this->queryNodes(planes, modelsOut, lastOutPlane.empty() ? nullptr : &lastOutPlane[0], stats, false);
+}
+
+void mBVH::queryNodes(mFrustumPlanes & planes, vector<mModel*> & modelsOut, PVRTuint8 * lastOutPlane, mCullStats & stats, bool markModels)
+{
+	if (this->Nodes.empty()) return;
+
+	int stack[c_iBVHStackSize];
+	PVRTuint32 stackMask[c_iBVHStackSize];
+	int top = 0;
+	stack[top] = 0;
+	stackMask[top++] = c_uiAllFrustumPlanes;
+	while (top > 0){
+		--top;
+		BVHNode & node = this->Nodes[stack[top]];
+		PVRTuint8 & nodeLastOut = lastOutPlane ? lastOutPlane[stack[top]] : node.LastOutPlane;
+		PVRTuint32 planeMask = stackMask[top];
+		stats.NodesVisited++;
+		if (planes.ClassifyBox(node.Min, node.Max, planeMask, nodeLastOut, stats.PlaneTests) == NoHit){
+			stats.NodesCulled++;
+			continue;
+		}
+
+		if (node.Left < 0 || planeMask == 0){
+			if (node.Left >= 0) stats.NodesAccepted++;
+			for (PVRTuint32 i = node.First; i < node.First + node.Count; ++i){
+				mModel * model = this->Models[this->ModelIndex[i]];
+				if (markModels) model->needRender = true;
+				modelsOut.push_back(model);
+			}
+			continue;
+		}
+		stack[top] = node.Left + 1;
+		stackMask[top++] = planeMask;
+		stack[top] = node.Left;
+		stackMask[top++] = planeMask;
+	}
+}
+
+/*!****************************************************************************
+@Function		IntersectBox
+@Input			invDirection	1 / direction per axis
+@Output		hitDistance		entry distance, 0 when the origin is inside
+@Return		bool			true when the ray enters the box before maxDistance
+******************************************************************************/
+bool mBVH::IntersectBox(const float * boxMin, const float * boxMax, PVRTVec3 & origin, PVRTVec3 & invDirection, float maxDistance, float & hitDistance)
+{
+	float tNear = 0.0f, tFar = maxDistance;
+	for (int a = 0; a < 3; ++a){
+		float t0 = (boxMin[a] - (&origin.x)[a]) * (&invDirection.x)[a];
+		float t1 = (boxMax[a] - (&origin.x)[a]) * (&invDirection.x)[a];
+		tNear = PVRT_MAX(tNear, PVRT_MIN(t0, t1));
+		tFar = PVRT_MIN(tFar, PVRT_MAX(t0, t1));
+	}
+	hitDistance = tNear;
+	return tNear <= tFar;
+}
+
+/*!****************************************************************************
+@Function		IntersectModel
+@Input			direction		the distance is measured in its length
+@Output		hitDistance
+@Return		bool			true when the model is hit before maxDistance
+@Description	Exact on the triangles when the model has a MeshBVH, on the
+world box otherwise.
+******************************************************************************/
+bool mBVH::IntersectModel(mModel * model, PVRTVec3 origin, PVRTVec3 direction, float maxDistance, float & hitDistance)
+{
+	PVRTVec3 boxMin, boxMax;
+	model->SurrondBox.GetBoxWorld(boxMin, boxMax);
+	PVRTVec3 invDirection;
+	for (int a = 0; a < 3; ++a){
+		float d = (&direction.x)[a];
+		(&invDirection.x)[a] = 1.0f / (fabs(d) > 1e-20f ? d : (d < 0.0f ? -1e-20f : 1e-20f));
+	}
+	if (!IntersectBox(&boxMin.x, &boxMax.x, origin, invDirection, maxDistance, hitDistance)) return false;
+	if (model->MeshBVH == nullptr) return true;
+
+	// an affine transform keeps the ray parameter, so distances stay in world units
+	PVRTMat4 inverse = model->GetModelMatrix().inverseEx();
+	PVRTVec3 meshOrigin(inverse * PVRTVec4(origin, 1.0f));
+	PVRTVec3 meshDirection(inverse * PVRTVec4(direction, 0.0f));
+	return model->MeshBVH->RayCast(meshOrigin, meshDirection, maxDistance, hitDistance);
+}
+
+mModel * mBVH::traceRay(PVRTVec3 & origin, PVRTVec3 & direction, float maxDistance, float & hitDistance, bool anyHit, mModel * ignore, vector<mModel*> * modelsOut)
+{
+	this->RayNodeTests = 0;
+	this->RayModelTests = 0;
+	if (this->Nodes.empty()) return nullptr;
+
+	PVRTVec3 invDirection;
+	for (int a = 0; a < 3; ++a){
+		float d = (&direction.x)[a];
+		(&invDirection.x)[a] = 1.0f / (fabs(d) > 1e-20f ? d : (d < 0.0f ? -1e-20f : 1e-20f));
+	}
+
+	mModel * hitModel = nullptr;
+	float nearest = maxDistance;
+	int stack[c_iBVHStackSize];
+	float stackDistance[c_iBVHStackSize];
+	int top = 0;
+	float entry;
+	this->RayNodeTests++;
+	if (!IntersectBox(this->Nodes[0].Min, this->Nodes[0].Max, origin, invDirection, nearest, entry)) return nullptr;
+	stack[top] = 0;
+	stackDistance[top++] = entry;
+	while (top > 0){
+		--top;
+		if (stackDistance[top] > nearest) continue;
+		BVHNode & node = this->Nodes[stack[top]];
+		if (node.Left < 0){
+			for (PVRTuint32 i = node.First; i < node.First + node.Count; ++i){
+				mModel * model = this->Models[this->ModelIndex[i]];
+				if (model == ignore) continue;
+				this->RayModelTests++;
+				float distance;
+				if (!IntersectModel(model, origin, direction, nearest, distance)) continue;
+				if (modelsOut){
+					modelsOut->push_back(model);
+					continue;
+				}
+				nearest = distance;
+				hitModel = model;
+				if (anyHit){
+					hitDistance = nearest;
+					return hitModel;
+				}
+			}
+			continue;
+		}
+
+		// the nearer child is popped first, the farther one may be skipped later
+		float leftEntry, rightEntry;
+		this->RayNodeTests += 2;
+		bool leftHit = IntersectBox(this->Nodes[node.Left].Min, this->Nodes[node.Left].Max, origin, invDirection, nearest, leftEntry);
+		bool rightHit = IntersectBox(this->Nodes[node.Left + 1].Min, this->Nodes[node.Left + 1].Max, origin, invDirection, nearest, rightEntry);
+		if (leftHit && rightHit && leftEntry < rightEntry){
+			stack[top] = node.Left + 1;
+			stackDistance[top++] = rightEntry;
+			rightHit = false;
+		}
+		if (leftHit){
+			stack[top] = node.Left;
+			stackDistance[top++] = leftEntry;
+		}
+		if (rightHit){
+			stack[top] = node.Left + 1;
+			stackDistance[top++] = rightEntry;
+		}
+	}
+	hitDistance = nearest;
+	return hitModel;
+}
+
+/*!****************************************************************************
+@Function		RayCast
+@Input			origin
+@Input			direction		does not need to be normalized
+@Input			maxDistance		world units along the ray
+@Output		hitDistance		world units, only set on a hit
+@Return		mModel*			nearest model hit, NULL for none
+******************************************************************************/
+mModel * mBVH::RayCast(PVRTVec3 origin, PVRTVec3 direction, float maxDistance, float & hitDistance)
+{
+	float length = direction.length();
+	if (length <= 0.0f) return nullptr;
+	direction /= length;
+	float distance;
+	mModel * model = this->traceRay(origin, direction, maxDistance, distance, false, nullptr, nullptr);
+	if (model) hitDistance = distance;
+	return model;
+}
+
+/*!****************************************************************************
+@Function		RayQuery
+@Output		modelsOut		every model the ray hits before maxDistance, in
+no particular order
+******************************************************************************/
+void mBVH::RayQuery(PVRTVec3 origin, PVRTVec3 direction, float maxDistance, vector<mModel*> & modelsOut)
+{
+	float length = direction.length();
+	if (length <= 0.0f) return;
+	direction /= length;
+	float distance;
+	this->traceRay(origin, direction, maxDistance, distance, false, nullptr, &modelsOut);
+}
+
+/*!****************************************************************************
+@Function		SegmentBlocked
+@Input			ignore		model to skip, usually the one looking
+@Return		bool		true when any model lies between from and to
+@Description	Line of sight test, stops at the first hit found.
+******************************************************************************/
+bool mBVH::SegmentBlocked(PVRTVec3 from, PVRTVec3 to, mModel * ignore)
+{
+	PVRTVec3 direction = to - from;
+	float length = direction.length();
+	if (length <= 0.0f) return false;
+	direction /= length;
+	float distance;
+	return this->traceRay(from, direction, length, distance, true, ignore, nullptr) != nullptr;
+}
+
+void mBVH::Clear()
+{
+	this->Nodes.clear();
+	this->ModelIndex.clear();
+	this->Models.clear();
+	this->BoxMin.clear();
+	this->BoxMax.clear();
+	this->NodesVisited = 0;
+	this->NodesCulled = 0;
+	this->NodesAccepted = 0;
+	this->PlaneTests = 0;
+	this->RayNodeTests = 0;
+	this->RayModelTests = 0;
+}
+
+unsigned int mBVH::size()
+{
+	return (unsigned int)this->Models.size();
+}
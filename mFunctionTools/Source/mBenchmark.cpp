@@ -0,0 +1,217 @@
+#include "..\Include\mBenchmark.h"
+#include <stdio.h>
+
+static void Split(const string & text, char separator, vector<string> & parts)
+{
+	size_t start = 0;
+	while (start <= text.size()){
+		size_t end = text.find(separator, start);
+		if (end == string::npos) end = text.size();
+		if (end > start) parts.push_back(text.substr(start, end - start));
+		start = end + 1;
+	}
+}
+
+// names come from the command line, anything JSON would choke on is replaced
+static void WriteName(FILE * file, const string & name)
+{
+	fputc('"', file);
+	for (unsigned int i = 0; i < name.size(); ++i){
+		char c = name[i];
+		fputc((c == '"' || c == '\\' || (unsigned char)c < 0x20) ? '_' : c, file);
+	}
+	fputc('"', file);
+}
+
+static void WriteStats(FILE * file, const mSampleStats & stats)
+{
+	fprintf(file, "{\"count\": %u, \"min\": %.4f, \"avg\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}",
+		stats.Count, stats.Min, stats.Avg, stats.P50, stats.P95, stats.P99, stats.Max);
+}
+
+mBenchmark::mBenchmark()
+{
+}
+
+mBenchmark::~mBenchmark()
+{
+}
+
+/*!****************************************************************************
+@Function		Init
+@Input			script		steps separated by ',', tokens by ':'
+@Input			frames		timed frames per step
+@Input			warmup		untimed frames at the start of each step
+@Return		bool		false if the script has no step
+@Description	Forgets the counters and results of a previous run.
+******************************************************************************/
+bool mBenchmark::Init(const char * script, unsigned int frames, unsigned int warmup)
+{
+	this->Steps.clear();
+	this->CounterNames.clear();
+	this->FrameStep.clear();
+	this->FrameMs.clear();
+	this->Counters.clear();
+	this->Frames = PVRT_MAX(frames, 1u);
+	this->Warmup = warmup;
+	this->Step = -1;
+	this->StepFrame = 0;
+	this->Timed = false;
+
+	vector<string> steps;
+	Split(script ? script : "", ',', steps);
+	for (unsigned int i = 0; i < steps.size(); ++i){
+		mBenchmarkStep step;
+		step.Name = steps[i];
+		Split(steps[i], ':', step.Tokens);
+		this->Steps.push_back(step);
+	}
+	this->FrameStep.reserve(this->TotalFrames());
+	this->FrameMs.reserve(this->TotalFrames());
+	return !this->Steps.empty();
+}
+
+/*!****************************************************************************
+@Function		AddCounter
+@Input			name		column of the per frame rows
+@Return		int		id for SetCounter
+@Description	Add every counter before the first NextFrame.
+******************************************************************************/
+int mBenchmark::AddCounter(const char * name)
+{
+	this->CounterNames.push_back(name);
+	return (int)this->CounterNames.size() - 1;
+}
+
+/*!****************************************************************************
+@Function		NextFrame
+@Return		int		the step that starts with this frame, -1 otherwise
+@Description	Call once at the start of every frame. Ends the time of the
+previous frame and moves the script on.
+******************************************************************************/
+int mBenchmark::NextFrame()
+{
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	if (this->Timed) this->FrameMs.back() = (float)chrono::duration<double, milli>(now - this->FrameStart).count();
+	this->FrameStart = now;
+	this->Timed = false;
+	if (this->Finished()) return -1;
+
+	int started = -1;
+	if (this->Step < 0 || this->StepFrame == this->Warmup + this->Frames){
+		this->Step++;
+		this->StepFrame = 0;
+		if (this->Finished()) return -1;
+		started = this->Step;
+	}
+	if (this->StepFrame >= this->Warmup){
+		this->Timed = true;
+		this->FrameStep.push_back(this->Step);
+		this->FrameMs.push_back(0.0f);
+		this->Counters.resize(this->Counters.size() + this->CounterNames.size(), 0.0);
+	}
+	this->StepFrame++;
+	return started;
+}
+
+/*!****************************************************************************
+@Function		SetCounter
+@Input			counter		id from AddCounter
+@Input			value		of the current frame, ignored in warmup frames
+******************************************************************************/
+void mBenchmark::SetCounter(int counter, double value)
+{
+	if (!this->Timed || counter < 0 || counter >= (int)this->CounterNames.size()) return;
+	this->Counters[(this->FrameMs.size() - 1) * this->CounterNames.size() + counter] = value;
+}
+
+bool mBenchmark::Running() const
+{
+	return this->Step >= 0 && this->Step < (int)this->Steps.size();
+}
+
+bool mBenchmark::Finished() const
+{
+	return this->Step >= (int)this->Steps.size();
+}
+
+const mBenchmarkStep & mBenchmark::CurrentStep() const
+{
+	return this->Steps[this->Step];
+}
+
+unsigned int mBenchmark::TotalFrames() const
+{
+	return (unsigned int)this->Steps.size() * (this->Warmup + this->Frames);
+}
+
+// frame times of step for counter -1
+mSampleStats mBenchmark::StepStats(int step, int counter) const
+{
+	mSampleRing ring;
+	ring.Init(this->Frames);
+	unsigned int counterCount = (unsigned int)this->CounterNames.size();
+	for (unsigned int i = 0; i < this->FrameMs.size(); ++i){
+		if (this->FrameStep[i] != step) continue;
+		ring.Push(counter < 0 ? this->FrameMs[i] : (float)this->Counters[i * counterCount + counter]);
+	}
+	return ring.Stats();
+}
+
+/*!****************************************************************************
+@Function		WriteSummary
+@Input			path		JSON file, overwritten
+@Input			timestepMs		the fixed time step of the run
+@Return		bool		false if the file cannot be written
+@Description	Frame time statistics of all timed frames and of every step,
+with the statistics of each counter per step, then one row per timed
+frame: step, frame time in milliseconds and the counters.
+******************************************************************************/
+bool mBenchmark::WriteSummary(const char * path, float timestepMs) const
+{
+	FILE * file = fopen(path, "w");
+	if (file == NULL) return false;
+
+	mSampleRing all;
+	all.Init((unsigned int)this->FrameMs.size());
+	for (unsigned int i = 0; i < this->FrameMs.size(); ++i) all.Push(this->FrameMs[i]);
+
+	fprintf(file, "{\n\"timestep_ms\": %.3f,\n\"warmup_frames\": %u,\n\"frames_per_step\": %u,\n\"complete\": %s,\n\"frame_ms\": ",
+		timestepMs, this->Warmup, this->Frames, this->Finished() ? "true" : "false");
+	WriteStats(file, all.Stats());
+
+	fprintf(file, ",\n\"counters\": [");
+	for (unsigned int c = 0; c < this->CounterNames.size(); ++c){
+		if (c) fprintf(file, ", ");
+		WriteName(file, this->CounterNames[c]);
+	}
+
+	fprintf(file, "],\n\"steps\": [");
+	for (unsigned int s = 0; s < this->Steps.size(); ++s){
+		fprintf(file, "%s\n{\"name\": ", s ? "," : "");
+		WriteName(file, this->Steps[s].Name);
+		fprintf(file, ", \"frame_ms\": ");
+		WriteStats(file, this->StepStats((int)s, -1));
+		fprintf(file, ", \"counters\": {");
+		for (unsigned int c = 0; c < this->CounterNames.size(); ++c){
+			fprintf(file, "%s", c ? ", " : "");
+			WriteName(file, this->CounterNames[c]);
+			fprintf(file, ": ");
+			WriteStats(file, this->StepStats((int)s, (int)c));
+		}
+		fprintf(file, "}}");
+	}
+
+	fprintf(file, "\n],\n\"frames\": [");
+	unsigned int counterCount = (unsigned int)this->CounterNames.size();
+	for (unsigned int i = 0; i < this->FrameMs.size(); ++i){
+		fprintf(file, "%s\n[%d, %.4f", i ? "," : "", this->FrameStep[i], this->FrameMs[i]);
+		for (unsigned int c = 0; c < counterCount; ++c) fprintf(file, ", %.6g", this->Counters[i * counterCount + c]);
+		fprintf(file, "]");
+	}
+	fprintf(file, "\n]\n}\n");
+
+	bool ok = !ferror(file);
+	fclose(file);
+	return ok;
+}
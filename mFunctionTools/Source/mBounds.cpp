@@ -0,0 +1,413 @@
+#include "..\Include\mBounds.h"
+#include "..\Include\mBoxCuller.h"
+
+/*!****************************************************************************
+@Function		JacobiEigen
+@Modified		a			symmetric 3x3 matrix, diagonal holds the eigenvalues
+@Output		vectors		eigenvectors in the columns
+******************************************************************************/
+static void JacobiEigen(double a[3][3], double vectors[3][3])
+{
+	for (int i = 0; i < 3; ++i){
+		for (int j = 0; j < 3; ++j) vectors[i][j] = i == j ? 1.0 : 0.0;
+	}
+	for (int sweep = 0; sweep < 32; ++sweep){
+		double off = fabs(a[0][1]) + fabs(a[0][2]) + fabs(a[1][2]);
+		if (off < 1e-12 * (fabs(a[0][0]) + fabs(a[1][1]) + fabs(a[2][2]) + 1e-30)) return;
+		for (int p = 0; p < 2; ++p){
+			for (int q = p + 1; q < 3; ++q){
+				if (a[p][q] == 0.0) continue;
+				double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+				double t = (theta >= 0.0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+				double c = 1.0 / sqrt(t * t + 1.0), s = t * c;
+				for (int k = 0; k < 3; ++k){
+					double akp = a[k][p], akq = a[k][q];
+					a[k][p] = c * akp - s * akq;
+					a[k][q] = s * akp + c * akq;
+				}
+				for (int k = 0; k < 3; ++k){
+					double apk = a[p][k], aqk = a[q][k];
+					a[p][k] = c * apk - s * aqk;
+					a[q][k] = s * apk + c * aqk;
+				}
+				for (int k = 0; k < 3; ++k){
+					double vkp = vectors[k][p], vkq = vectors[k][q];
+					vectors[k][p] = c * vkp - s * vkq;
+					vectors[k][q] = s * vkp + c * vkq;
+				}
+			}
+		}
+	}
+}
+
+mBoundsEngine::mBoundsEngine()
+{
+}
+
+mBoundsEngine::~mBoundsEngine()
+{
+}
+
+/*!****************************************************************************
+@Function		ComputeAABB
+@Input			positions		first vertex position, 3 floats
+@Input			stride			bytes between two positions
+@Output		boxMin			FLT_MAX / -FLT_MAX when vertexCount is 0
+@Output		boxMax
+@Description	Single threaded. Vertices are read 4 floats at a time, except
+the last one which could end the buffer.
+******************************************************************************/
+void mBoundsEngine::ComputeAABB(const PVRTuint8 * positions, unsigned int stride, unsigned int vertexCount, PVRTVec3 & boxMin, PVRTVec3 & boxMax)
+{
+	boxMin = PVRTVec3(FLT_MAX, FLT_MAX, FLT_MAX);
+	boxMax = PVRTVec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	if (vertexCount == 0) return;
+	unsigned int last = vertexCount - 1;
+	unsigned int i = 0;
+
+#if defined(MBOXCULLER_SSE)
+	__m128 min0 = _mm_set1_ps(FLT_MAX), min1 = min0;
+	__m128 max0 = _mm_set1_ps(-FLT_MAX), max1 = max0;
+	for (; i + 1 < last; i += 2){
+		__m128 v0 = _mm_loadu_ps((const float*)(positions + i * stride));
+		__m128 v1 = _mm_loadu_ps((const float*)(positions + (i + 1) * stride));
+		min0 = _mm_min_ps(min0, v0);
+		max0 = _mm_max_ps(max0, v0);
+		min1 = _mm_min_ps(min1, v1);
+		max1 = _mm_max_ps(max1, v1);
+	}
+	for (; i < last; ++i){
+		__m128 v = _mm_loadu_ps((const float*)(positions + i * stride));
+		min0 = _mm_min_ps(min0, v);
+		max0 = _mm_max_ps(max0, v);
+	}
+	float result[4];
+	_mm_storeu_ps(result, _mm_min_ps(min0, min1));
+	boxMin = PVRTVec3(result[0], result[1], result[2]);
+	_mm_storeu_ps(result, _mm_max_ps(max0, max1));
+	boxMax = PVRTVec3(result[0], result[1], result[2]);
+#elif defined(MBOXCULLER_NEON)
+	float32x4_t min0 = vdupq_n_f32(FLT_MAX), min1 = min0;
+	float32x4_t max0 = vdupq_n_f32(-FLT_MAX), max1 = max0;
+	for (; i + 1 < last; i += 2){
+		float32x4_t v0 = vld1q_f32((const float*)(positions + i * stride));
+		float32x4_t v1 = vld1q_f32((const float*)(positions + (i + 1) * stride));
+		min0 = vminq_f32(min0, v0);
+		max0 = vmaxq_f32(max0, v0);
+		min1 = vminq_f32(min1, v1);
+		max1 = vmaxq_f32(max1, v1);
+	}
+	for (; i < last; ++i){
+		float32x4_t v = vld1q_f32((const float*)(positions + i * stride));
+		min0 = vminq_f32(min0, v);
+		max0 = vmaxq_f32(max0, v);
+	}
+	float result[4];
+	vst1q_f32(result, vminq_f32(min0, min1));
+	boxMin = PVRTVec3(result[0], result[1], result[2]);
+	vst1q_f32(result, vmaxq_f32(max0, max1));
+	boxMax = PVRTVec3(result[0], result[1], result[2]);
+#endif
+
+	for (; i < vertexCount; ++i){
+		const float * p = (const float*)(positions + i * stride);
+		boxMin.x = PVRT_MIN(boxMin.x, p[0]);
+		boxMin.y = PVRT_MIN(boxMin.y, p[1]);
+		boxMin.z = PVRT_MIN(boxMin.z, p[2]);
+		boxMax.x = PVRT_MAX(boxMax.x, p[0]);
+		boxMax.y = PVRT_MAX(boxMax.y, p[1]);
+		boxMax.z = PVRT_MAX(boxMax.z, p[2]);
+	}
+}
+
+int mBoundsEngine::chunkCount()
+{
+	if (this->Pool == nullptr || this->Pool->ThreadCount() == 0 || this->Count < this->ParallelVertices) return 1;
+	return 2 * (this->Pool->ThreadCount() + 1);
+}
+
+void mBoundsEngine::runChunks(int chunks, const function<void(unsigned int, unsigned int, int)> & chunk)
+{
+	if (chunks == 1){
+		chunk(0, this->Count, 0);
+		return;
+	}
+	unsigned int count = this->Count;
+	this->Pool->Run(chunks, [&](int c){
+		chunk((unsigned int)((PVRTuint64)count * c / chunks), (unsigned int)((PVRTuint64)count * (c + 1) / chunks), c);
+	});
+}
+
+/*!****************************************************************************
+@Function		Compute
+@Input			positions		first vertex position, 3 floats
+@Input			stride			bytes between two positions
+@Input			vertexCount
+@Output		bounds
+******************************************************************************/
+void mBoundsEngine::Compute(const PVRTuint8 * positions, unsigned int stride, unsigned int vertexCount, mBounds & bounds)
+{
+	bounds = mBounds();
+	if (positions == nullptr || vertexCount == 0) return;
+	this->Positions = positions;
+	this->Stride = stride;
+	this->Count = vertexCount;
+
+	int chunks = this->chunkCount();
+	vector<PVRTVec3> chunkMin(chunks), chunkMax(chunks);
+	this->runChunks(chunks, [&](unsigned int begin, unsigned int end, int c){
+		ComputeAABB(this->Positions + begin * this->Stride, this->Stride, end - begin, chunkMin[c], chunkMax[c]);
+	});
+	for (int c = 0; c < chunks; ++c){
+		bounds.Min.x = PVRT_MIN(bounds.Min.x, chunkMin[c].x);
+		bounds.Min.y = PVRT_MIN(bounds.Min.y, chunkMin[c].y);
+		bounds.Min.z = PVRT_MIN(bounds.Min.z, chunkMin[c].z);
+		bounds.Max.x = PVRT_MAX(bounds.Max.x, chunkMax[c].x);
+		bounds.Max.y = PVRT_MAX(bounds.Max.y, chunkMax[c].y);
+		bounds.Max.z = PVRT_MAX(bounds.Max.z, chunkMax[c].z);
+	}
+
+	this->computeSphere(bounds);
+	if (this->ComputeOrientedBox) this->computeOrientedBox(bounds);
+
+	bounds.VertexCount = vertexCount;
+	bounds.SourceData = positions;
+	bounds.SourceVertices = vertexCount;
+	this->VerticesProcessed += vertexCount;
+	this->Positions = nullptr;
+}
+
+void mBoundsEngine::Compute(SPODMesh & mesh, mBounds & bounds)
+{
+	const PVRTuint8 * positions = mesh.pInterleaved ? mesh.pInterleaved + (size_t)mesh.sVertex.pData : mesh.sVertex.pData;
+	if (mesh.sVertex.eType != EPODDataFloat || mesh.sVertex.n < 3){
+		bounds = mBounds();
+		return;
+	}
+	this->Compute(positions, mesh.sVertex.nStride, mesh.nNumVertex, bounds);
+}
+
+/*!****************************************************************************
+@Function		Compute
+@Input			modelPOD	all meshes, node transforms are ignored
+@Output		bounds
+@Description	A POD with several meshes has its positions gathered into one
+array first so the sphere and box are fitted to all of them at once.
+******************************************************************************/
+void mBoundsEngine::Compute(CPVRTModelPOD & modelPOD, mBounds & bounds)
+{
+	if (modelPOD.nNumMesh == 1){
+		this->Compute(modelPOD.pMesh[0], bounds);
+		bounds.SourceData = &modelPOD;
+		bounds.SourceGeneration = modelPOD.GetLoadGeneration();
+		return;
+	}
+
+	vector<PVRTVec3> gathered;
+	for (unsigned int m = 0; m < modelPOD.nNumMesh; ++m){
+		SPODMesh & mesh = modelPOD.pMesh[m];
+		if (mesh.sVertex.eType != EPODDataFloat || mesh.sVertex.n < 3) continue;
+		const PVRTuint8 * positions = mesh.pInterleaved ? mesh.pInterleaved + (size_t)mesh.sVertex.pData : mesh.sVertex.pData;
+		if (positions == nullptr) continue;
+		for (unsigned int i = 0; i < mesh.nNumVertex; ++i){
+			gathered.push_back(PVRTVec3((const float*)(positions + i * mesh.sVertex.nStride)));
+		}
+	}
+	if (gathered.empty()){
+		bounds = mBounds();
+		return;
+	}
+	this->Compute((const PVRTuint8*)&gathered[0], sizeof(PVRTVec3), (unsigned int)gathered.size(), bounds);
+	bounds.SourceData = &modelPOD;
+	bounds.SourceGeneration = modelPOD.GetLoadGeneration();
+	bounds.SourceVertices = 0;
+	for (unsigned int m = 0; m < modelPOD.nNumMesh; ++m) bounds.SourceVertices += modelPOD.pMesh[m].nNumVertex;
+}
+
+float mBoundsEngine::farthestDistance(PVRTVec3 center)
+{
+	int chunks = this->chunkCount();
+	vector<float> chunkDistance(chunks, 0.0f);
+	this->runChunks(chunks, [&](unsigned int begin, unsigned int end, int c){
+		float best = 0.0f;
+		for (unsigned int i = begin; i < end; ++i){
+			const float * p = (const float*)(this->Positions + i * this->Stride);
+			float dx = p[0] - center.x, dy = p[1] - center.y, dz = p[2] - center.z;
+			best = PVRT_MAX(best, dx * dx + dy * dy + dz * dz);
+		}
+		chunkDistance[c] = best;
+	});
+	float best = 0.0f;
+	for (int c = 0; c < chunks; ++c) best = PVRT_MAX(best, chunkDistance[c]);
+	return sqrt(best);
+}
+
+void mBoundsEngine::computeSphere(mBounds & bounds)
+{
+	// vertices at the ends of each axis
+	int chunks = this->chunkCount();
+	vector<PVRTVec3> extremes(chunks * 6);
+	this->runChunks(chunks, [&](unsigned int begin, unsigned int end, int c){
+		float lowValue[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, highValue[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		unsigned int low[3] = { begin, begin, begin }, high[3] = { begin, begin, begin };
+		for (unsigned int i = begin; i < end; ++i){
+			const float * p = (const float*)(this->Positions + i * this->Stride);
+			for (int a = 0; a < 3; ++a){
+				if (p[a] < lowValue[a]){ lowValue[a] = p[a]; low[a] = i; }
+				if (p[a] > highValue[a]){ highValue[a] = p[a]; high[a] = i; }
+			}
+		}
+		for (int a = 0; a < 3; ++a){
+			extremes[c * 6 + 2 * a] = PVRTVec3((const float*)(this->Positions + low[a] * this->Stride));
+			extremes[c * 6 + 2 * a + 1] = PVRTVec3((const float*)(this->Positions + high[a] * this->Stride));
+		}
+	});
+	PVRTVec3 low[3], high[3];
+	for (int a = 0; a < 3; ++a){
+		low[a] = extremes[2 * a];
+		high[a] = extremes[2 * a + 1];
+		for (int c = 1; c < chunks; ++c){
+			if ((&extremes[c * 6 + 2 * a].x)[a] < (&low[a].x)[a]) low[a] = extremes[c * 6 + 2 * a];
+			if ((&extremes[c * 6 + 2 * a + 1].x)[a] > (&high[a].x)[a]) high[a] = extremes[c * 6 + 2 * a + 1];
+		}
+	}
+	int axis = 0;
+	for (int a = 1; a < 3; ++a){
+		if ((high[a] - low[a]).lenSqr() > (high[axis] - low[axis]).lenSqr()) axis = a;
+	}
+
+	// Ritter growth, each chunk grows its own copy of the starting sphere
+	// over its vertices, the chunk spheres are then merged
+	PVRTVec3 start = (low[axis] + high[axis]) * 0.5f;
+	float startRadius = (high[axis] - low[axis]).length() * 0.5f;
+	vector<PVRTVec3> chunkCenter(chunks, start);
+	vector<float> chunkRadius(chunks, startRadius);
+	this->runChunks(chunks, [&](unsigned int begin, unsigned int end, int c){
+		PVRTVec3 center = start;
+		float radius = startRadius, radiusSqr = radius * radius;
+		for (unsigned int i = begin; i < end; ++i){
+			const float * p = (const float*)(this->Positions + i * this->Stride);
+			float dx = p[0] - center.x, dy = p[1] - center.y, dz = p[2] - center.z;
+			float distanceSqr = dx * dx + dy * dy + dz * dz;
+			if (distanceSqr <= radiusSqr) continue;
+			float distance = sqrt(distanceSqr);
+			float grown = (radius + distance) * 0.5f;
+			float move = (grown - radius) / distance;
+			center.x += dx * move;
+			center.y += dy * move;
+			center.z += dz * move;
+			radius = grown;
+			radiusSqr = radius * radius;
+		}
+		chunkCenter[c] = center;
+		chunkRadius[c] = radius;
+	});
+	PVRTVec3 center = chunkCenter[0];
+	float radius = chunkRadius[0];
+	for (int c = 1; c < chunks; ++c){
+		PVRTVec3 offset = chunkCenter[c] - center;
+		float distance = offset.length();
+		if (distance + chunkRadius[c] <= radius) continue;
+		if (distance + radius <= chunkRadius[c]){
+			center = chunkCenter[c];
+			radius = chunkRadius[c];
+			continue;
+		}
+		float grown = (distance + radius + chunkRadius[c]) * 0.5f;
+		center += offset * ((grown - radius) / distance);
+		radius = grown;
+	}
+	// the incremental updates round, one relative ulp or so keeps every vertex inside
+	radius *= 1.0f + 4.0f * FLT_EPSILON;
+
+	PVRTVec3 boxCenter = (bounds.Min + bounds.Max) * 0.5f;
+	float boxRadius = this->farthestDistance(boxCenter);
+	if (boxRadius < radius){
+		center = boxCenter;
+		radius = boxRadius;
+	}
+	bounds.SphereCenter = center;
+	bounds.SphereRadius = radius;
+}
+
+void mBoundsEngine::computeOrientedBox(mBounds & bounds)
+{
+	int chunks = this->chunkCount();
+	vector<double> chunkSums(chunks * 9, 0.0);
+	this->runChunks(chunks, [&](unsigned int begin, unsigned int end, int c){
+		double * sums = &chunkSums[c * 9];
+		for (unsigned int i = begin; i < end; ++i){
+			const float * p = (const float*)(this->Positions + i * this->Stride);
+			double x = p[0], y = p[1], z = p[2];
+			sums[0] += x; sums[1] += y; sums[2] += z;
+			sums[3] += x * x; sums[4] += x * y; sums[5] += x * z;
+			sums[6] += y * y; sums[7] += y * z; sums[8] += z * z;
+		}
+	});
+	double sums[9] = { 0.0 };
+	for (int c = 0; c < chunks; ++c){
+		for (int k = 0; k < 9; ++k) sums[k] += chunkSums[c * 9 + k];
+	}
+	double n = (double)this->Count;
+	double mean[3] = { sums[0] / n, sums[1] / n, sums[2] / n };
+	double covariance[3][3];
+	covariance[0][0] = sums[3] / n - mean[0] * mean[0];
+	covariance[0][1] = covariance[1][0] = sums[4] / n - mean[0] * mean[1];
+	covariance[0][2] = covariance[2][0] = sums[5] / n - mean[0] * mean[2];
+	covariance[1][1] = sums[6] / n - mean[1] * mean[1];
+	covariance[1][2] = covariance[2][1] = sums[7] / n - mean[1] * mean[2];
+	covariance[2][2] = sums[8] / n - mean[2] * mean[2];
+	double vectors[3][3];
+	JacobiEigen(covariance, vectors);
+
+	PVRTVec3 axes[3];
+	for (int a = 0; a < 3; ++a){
+		axes[a] = PVRTVec3((float)vectors[0][a], (float)vectors[1][a], (float)vectors[2][a]);
+		axes[a].normalize();
+	}
+	axes[2] = axes[0].cross(axes[1]);
+	axes[2].normalize();
+
+	vector<float> chunkExtent(chunks * 6);
+	this->runChunks(chunks, [&](unsigned int begin, unsigned int end, int c){
+		float * extent = &chunkExtent[c * 6];
+		for (int a = 0; a < 3; ++a){
+			extent[2 * a] = FLT_MAX;
+			extent[2 * a + 1] = -FLT_MAX;
+		}
+		for (unsigned int i = begin; i < end; ++i){
+			PVRTVec3 p((const float*)(this->Positions + i * this->Stride));
+			for (int a = 0; a < 3; ++a){
+				float d = p.dot(axes[a]);
+				extent[2 * a] = PVRT_MIN(extent[2 * a], d);
+				extent[2 * a + 1] = PVRT_MAX(extent[2 * a + 1], d);
+			}
+		}
+	});
+	float low[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, high[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (int c = 0; c < chunks; ++c){
+		for (int a = 0; a < 3; ++a){
+			low[a] = PVRT_MIN(low[a], chunkExtent[c * 6 + 2 * a]);
+			high[a] = PVRT_MAX(high[a], chunkExtent[c * 6 + 2 * a + 1]);
+		}
+	}
+
+	// principal axes are not always better, keep the AABB when it is smaller
+	PVRTVec3 boxSize = bounds.Max - bounds.Min;
+	float orientedVolume = (high[0] - low[0]) * (high[1] - low[1]) * (high[2] - low[2]);
+	bounds.HasOrientedBox = true;
+	if (orientedVolume >= boxSize.x * boxSize.y * boxSize.z){
+		bounds.BoxCenter = (bounds.Min + bounds.Max) * 0.5f;
+		bounds.BoxAxis[0] = PVRTVec3(1.0f, 0.0f, 0.0f);
+		bounds.BoxAxis[1] = PVRTVec3(0.0f, 1.0f, 0.0f);
+		bounds.BoxAxis[2] = PVRTVec3(0.0f, 0.0f, 1.0f);
+		bounds.BoxHalfSize = boxSize * 0.5f;
+		return;
+	}
+	bounds.BoxCenter = PVRTVec3(0.0f, 0.0f, 0.0f);
+	for (int a = 0; a < 3; ++a){
+		bounds.BoxAxis[a] = axes[a];
+		bounds.BoxCenter += axes[a] * ((low[a] + high[a]) * 0.5f);
+	}
+	bounds.BoxHalfSize = PVRTVec3(high[0] - low[0], high[1] - low[1], high[2] - low[2]) * 0.5f;
+}
@@ -0,0 +1,287 @@
+#include "..\Include\mBoxCuller.h"
+
+mBoxCuller::mBoxCuller()
+{
+}
+
+mBoxCuller::~mBoxCuller()
+{
+}
+
+unsigned int mBoxCuller::addBox(PVRTVec3 boxMin, PVRTVec3 boxMax)
+{
+	this->MinX.push_back(boxMin.x);
+	this->MinY.push_back(boxMin.y);
+	this->MinZ.push_back(boxMin.z);
+	this->MaxX.push_back(boxMax.x);
+	this->MaxY.push_back(boxMax.y);
+	this->MaxZ.push_back(boxMax.z);
+	this->Models.push_back(nullptr);
+	return (unsigned int)this->MinX.size() - 1;
+}
+
+unsigned int mBoxCuller::addModel(mModel * model)
+{
+	PVRTVec3 boxMin, boxMax;
+	model->SurrondBox.GetBoxWorld(boxMin, boxMax);
+	unsigned int index = this->addBox(boxMin, boxMax);
+	this->Models[index] = model;
+	return index;
+}
+
+void mBoxCuller::updateBox(unsigned int index, PVRTVec3 boxMin, PVRTVec3 boxMax)
+{
+	this->MinX[index] = boxMin.x;
+	this->MinY[index] = boxMin.y;
+	this->MinZ[index] = boxMin.z;
+	this->MaxX[index] = boxMax.x;
+	this->MaxY[index] = boxMax.y;
+	this->MaxZ[index] = boxMax.z;
+}
+
+void mBoxCuller::updateModel(unsigned int index)
+{
+	if (this->Models[index] == nullptr) return;
+	PVRTVec3 boxMin, boxMax;
+	this->Models[index]->SurrondBox.GetBoxWorld(boxMin, boxMax);
+	this->updateBox(index, boxMin, boxMax);
+}
+
+void mBoxCuller::clear()
+{
+	this->MinX.clear();
+	this->MinY.clear();
+	this->MinZ.clear();
+	this->MaxX.clear();
+	this->MaxY.clear();
+	this->MaxZ.clear();
+	this->Models.clear();
+	this->VisibleMask.clear();
+}
+
+unsigned int mBoxCuller::size()
+{
+	return (unsigned int)this->MinX.size();
+}
+
+int mBoxCuller::BestPath()
+{
+#if defined(MBOXCULLER_AVX)
+	return CullPathAVX;
+#elif defined(MBOXCULLER_SSE)
+	return CullPathSSE;
+#elif defined(MBOXCULLER_NEON)
+	return CullPathNEON;
+#else
+	return CullPathScalar;
+#endif
+}
+
+// false for a SIMD path that would run the scalar fallback
+bool mBoxCuller::HasPath(int path)
+{
+	switch (path)
+	{
+	case CullPathAuto:
+	case CullPathScalar: return true;
+#if defined(MBOXCULLER_SSE)
+	case CullPathSSE: return true;
+#endif
+#if defined(MBOXCULLER_AVX)
+	case CullPathAVX: return true;
+#endif
+#if defined(MBOXCULLER_NEON)
+	case CullPathNEON: return true;
+#endif
+	default: return false;
+	}
+}
+
+void mBoxCuller::Cull(mFrustum & frustum, int path)
+{
+	this->Cull(frustum.Planes, path);
+}
+
+/*!****************************************************************************
+@Function		Cull
+@Input			planes		world space frustum planes
+@Input			path		CullPath, CullPathAuto picks the widest compiled in
+@Description	Fills VisibleMask, one bit per box. The SIMD kernels handle whole
+groups of 4 or 8 boxes and the remainder goes through the scalar path.
+A path that is not compiled in falls back to the scalar path.
+******************************************************************************/
+void mBoxCuller::Cull(mFrustumPlanes & planes, int path)
+{
+	unsigned int boxCount = this->size();
+	this->VisibleMask.assign((boxCount + 31) / 32, 0);
+	if (path == CullPathAuto) path = BestPath();
+
+	unsigned int done = 0;
+	switch (path)
+	{
+	case CullPathSSE: done = this->cullSSE(planes); break;
+	case CullPathAVX: done = this->cullAVX(planes); break;
+	case CullPathNEON: done = this->cullNEON(planes); break;
+	default: break;
+	}
+	this->cullScalar(planes, done, boxCount);
+}
+
+unsigned int mBoxCuller::cullScalar(mFrustumPlanes & planes, unsigned int begin, unsigned int end)
+{
+	for (unsigned int i = begin; i < end; ++i){
+		bool visible = true;
+		for (int p = 0; p < 6; ++p){
+			// distance of the corner furthest along the plane normal
+			float dist = PVRT_MAX(planes.A[p] * this->MinX[i], planes.A[p] * this->MaxX[i])
+				+ PVRT_MAX(planes.B[p] * this->MinY[i], planes.B[p] * this->MaxY[i])
+				+ PVRT_MAX(planes.C[p] * this->MinZ[i], planes.C[p] * this->MaxZ[i])
+				+ planes.D[p];
+			if (dist <= 0.0f){
+				visible = false;
+				break;
+			}
+		}
+		if (visible) this->VisibleMask[i >> 5] |= 1u << (i & 31);
+	}
+	return end;
+}
+
+unsigned int mBoxCuller::cullSSE(mFrustumPlanes & planes)
+{
+#if defined(MBOXCULLER_SSE)
+	unsigned int count = this->size() & ~3u;
+	__m128 planeA[6], planeB[6], planeC[6], planeD[6];
+	for (int p = 0; p < 6; ++p){
+		planeA[p] = _mm_set1_ps(planes.A[p]);
+		planeB[p] = _mm_set1_ps(planes.B[p]);
+		planeC[p] = _mm_set1_ps(planes.C[p]);
+		planeD[p] = _mm_set1_ps(planes.D[p]);
+	}
+	const __m128 zero = _mm_setzero_ps();
+
+	for (unsigned int i = 0; i < count; i += 4){
+		__m128 minX = _mm_loadu_ps(&this->MinX[i]);
+		__m128 minY = _mm_loadu_ps(&this->MinY[i]);
+		__m128 minZ = _mm_loadu_ps(&this->MinZ[i]);
+		__m128 maxX = _mm_loadu_ps(&this->MaxX[i]);
+		__m128 maxY = _mm_loadu_ps(&this->MaxY[i]);
+		__m128 maxZ = _mm_loadu_ps(&this->MaxZ[i]);
+		int visible = 0xF;
+		for (int p = 0; p < 6; ++p){
+			__m128 dist = _mm_add_ps(
+				_mm_add_ps(_mm_max_ps(_mm_mul_ps(planeA[p], minX), _mm_mul_ps(planeA[p], maxX)),
+				_mm_max_ps(_mm_mul_ps(planeB[p], minY), _mm_mul_ps(planeB[p], maxY))),
+				_mm_add_ps(_mm_max_ps(_mm_mul_ps(planeC[p], minZ), _mm_mul_ps(planeC[p], maxZ)), planeD[p]));
+			visible &= _mm_movemask_ps(_mm_cmpgt_ps(dist, zero));
+			if (visible == 0) break;
+		}
+		this->VisibleMask[i >> 5] |= (PVRTuint32)visible << (i & 31);
+	}
+	return count;
+#else
+	PVRT_UNREFERENCED_PARAMETER(planes);
+	return 0;
+#endif
+}
+
+unsigned int mBoxCuller::cullAVX(mFrustumPlanes & planes)
+{
+#if defined(MBOXCULLER_AVX)
+	unsigned int count = this->size() & ~7u;
+	__m256 planeA[6], planeB[6], planeC[6], planeD[6];
+	for (int p = 0; p < 6; ++p){
+		planeA[p] = _mm256_set1_ps(planes.A[p]);
+		planeB[p] = _mm256_set1_ps(planes.B[p]);
+		planeC[p] = _mm256_set1_ps(planes.C[p]);
+		planeD[p] = _mm256_set1_ps(planes.D[p]);
+	}
+	const __m256 zero = _mm256_setzero_ps();
+
+	for (unsigned int i = 0; i < count; i += 8){
+		__m256 minX = _mm256_loadu_ps(&this->MinX[i]);
+		__m256 minY = _mm256_loadu_ps(&this->MinY[i]);
+		__m256 minZ = _mm256_loadu_ps(&this->MinZ[i]);
+		__m256 maxX = _mm256_loadu_ps(&this->MaxX[i]);
+		__m256 maxY = _mm256_loadu_ps(&this->MaxY[i]);
+		__m256 maxZ = _mm256_loadu_ps(&this->MaxZ[i]);
+		int visible = 0xFF;
+		for (int p = 0; p < 6; ++p){
+			__m256 dist = _mm256_add_ps(
+				_mm256_add_ps(_mm256_max_ps(_mm256_mul_ps(planeA[p], minX), _mm256_mul_ps(planeA[p], maxX)),
+				_mm256_max_ps(_mm256_mul_ps(planeB[p], minY), _mm256_mul_ps(planeB[p], maxY))),
+				_mm256_add_ps(_mm256_max_ps(_mm256_mul_ps(planeC[p], minZ), _mm256_mul_ps(planeC[p], maxZ)), planeD[p]));
+			visible &= _mm256_movemask_ps(_mm256_cmp_ps(dist, zero, _CMP_GT_OQ));
+			if (visible == 0) break;
+		}
+		this->VisibleMask[i >> 5] |= (PVRTuint32)visible << (i & 31);
+	}
+	return count;
+#else
+	PVRT_UNREFERENCED_PARAMETER(planes);
+	return 0;
+#endif
+}
+
+unsigned int mBoxCuller::cullNEON(mFrustumPlanes & planes)
+{
+#if defined(MBOXCULLER_NEON)
+	unsigned int count = this->size() & ~3u;
+	const uint32_t bitWeights[4] = { 1, 2, 4, 8 };
+	const uint32x4_t weights = vld1q_u32(bitWeights);
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+
+	for (unsigned int i = 0; i < count; i += 4){
+		float32x4_t minX = vld1q_f32(&this->MinX[i]);
+		float32x4_t minY = vld1q_f32(&this->MinY[i]);
+		float32x4_t minZ = vld1q_f32(&this->MinZ[i]);
+		float32x4_t maxX = vld1q_f32(&this->MaxX[i]);
+		float32x4_t maxY = vld1q_f32(&this->MaxY[i]);
+		float32x4_t maxZ = vld1q_f32(&this->MaxZ[i]);
+		PVRTuint32 visible = 0xF;
+		for (int p = 0; p < 6; ++p){
+			float32x4_t dist = vdupq_n_f32(planes.D[p]);
+			dist = vaddq_f32(dist, vmaxq_f32(vmulq_n_f32(minX, planes.A[p]), vmulq_n_f32(maxX, planes.A[p])));
+			dist = vaddq_f32(dist, vmaxq_f32(vmulq_n_f32(minY, planes.B[p]), vmulq_n_f32(maxY, planes.B[p])));
+			dist = vaddq_f32(dist, vmaxq_f32(vmulq_n_f32(minZ, planes.C[p]), vmulq_n_f32(maxZ, planes.C[p])));
+			uint32x4_t bits = vandq_u32(vcgtq_f32(dist, zero), weights);
+			uint32x2_t sum = vadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+			sum = vpadd_u32(sum, sum);
+			visible &= vget_lane_u32(sum, 0);
+			if (visible == 0) break;
+		}
+		this->VisibleMask[i >> 5] |= visible << (i & 31);
+	}
+	return count;
+#else
+	PVRT_UNREFERENCED_PARAMETER(planes);
+	return 0;
+#endif
+}
+
+bool mBoxCuller::IsVisible(unsigned int index)
+{
+	return (this->VisibleMask[index >> 5] >> (index & 31)) & 1u;
+}
+
+unsigned int mBoxCuller::VisibleCount()
+{
+	unsigned int count = 0;
+	for (unsigned int i = 0; i < this->VisibleMask.size(); ++i){
+		PVRTuint32 bits = this->VisibleMask[i];
+		while (bits){
+			bits &= bits - 1;
+			count++;
+		}
+	}
+	return count;
+}
+
+void mBoxCuller::MarkModelsNeedRender()
+{
+	for (unsigned int i = 0; i < this->Models.size(); ++i){
+		if (this->Models[i] != nullptr && this->IsVisible(i)){
+			this->Models[i]->needRender = true;
+		}
+	}
+}
@@ -49,6 +49,7 @@ void Camera::CreateProjectionMatrixRH()
 void Camera::CreateVPMatrixRH()
 {
 	this->VPMatrix = this->projectionMatrix * this->viewMatrix;
+	this->FrustumDirty = true;
 }
 
 void Camera::reCreateProjectionMatrix()
@@ -181,6 +182,21 @@ PVRTMat4 Camera::getVPMatrix()
 	return this->VPMatrix;
 }
 
+/*!****************************************************************************
+@Function		getFrustum
+@Return		mFrustum &		world space frustum of the current VP matrix
+@Description	Rebuilt on first use after the VP matrix has changed, so every
+test in a frame shares one set of planes.
+******************************************************************************/
+mFrustum & Camera::getFrustum()
+{
+	if (this->FrustumDirty){
+		this->Frustum.Update(this->VPMatrix, this->CS);
+		this->FrustumDirty = false;
+	}
+	return this->Frustum;
+}
+
 PVRTVec3 Camera::getEulerAngle()
 {
 	return this->EulerAngle;
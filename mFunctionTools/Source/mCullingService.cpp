@@ -0,0 +1,93 @@
+#include "..\Include\mCullingService.h"
+
+mCullingService::mCullingService()
+{
+}
+
+mCullingService::~mCullingService()
+{
+}
+
+void mCullingService::Init(int threadCount)
+{
+	this->Pool.Init(threadCount);
+}
+
+int mCullingService::addView()
+{
+	mCullView view;
+	view.UseClipPlane = false;
+	view.ClipPlane = PVRTVec4(0.0f, 1.0f, 0.0f, 0.0f);
+	this->Views.push_back(view);
+	return (int)this->Views.size() - 1;
+}
+
+void mCullingService::setView(int view, Camera & camera)
+{
+	this->Views[view].ViewCamera = camera;
+	this->Views[view].UseClipPlane = false;
+}
+
+/*!****************************************************************************
+@Function		setView
+@Input			view		index returned by addView
+@Input			camera		camera of the pass, copied
+@Input			clipPlane	world space plane given to ModifyProjectionForClipping
+******************************************************************************/
+void mCullingService::setView(int view, Camera & camera, PVRTVec4 clipPlane)
+{
+	this->Views[view].ViewCamera = camera;
+	this->Views[view].ViewCamera.ModifyProjectionForClipping(clipPlane);
+	this->Views[view].UseClipPlane = true;
+	this->Views[view].ClipPlane = clipPlane;
+}
+
+/*!****************************************************************************
+@Function		Cull
+@Input			scene		scene whose index is culled
+@Description	Runs all views in parallel when the scene index allows it,
+otherwise one after the other on the calling thread.
+******************************************************************************/
+void mCullingService::Cull(mSceneManager & scene)
+{
+	if (scene.CanQueryViewsInParallel() && this->Views.size() > 1){
+		this->Pool.Run((int)this->Views.size(), [this, &scene](int view){ this->cullView(scene, view); });
+		return;
+	}
+	for (unsigned int i = 0; i < this->Views.size(); ++i){
+		this->cullView(scene, i);
+	}
+}
+
+void mCullingService::cullView(mSceneManager & scene, int view)
+{
+	mCullView & cullView = this->Views[view];
+	cullView.Visible.clear();
+	scene.QueryView(cullView.ViewCamera.getFrustum(), cullView.Visible, cullView.LastOutPlane, cullView.Stats);
+}
+
+vector<mModel*> & mCullingService::VisibleModels(int view)
+{
+	return this->Views[view].Visible;
+}
+
+mCullStats & mCullingService::ViewStats(int view)
+{
+	return this->Views[view].Stats;
+}
+
+unsigned int mCullingService::ViewCount()
+{
+	return (unsigned int)this->Views.size();
+}
+
+int mCullingService::ThreadCount()
+{
+	return this->Pool.ThreadCount() + 1;
+}
+
+void mCullingService::Destroy()
+{
+	this->Pool.Destroy();
+	this->Views.clear();
+}
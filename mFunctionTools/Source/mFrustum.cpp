@@ -0,0 +1,117 @@
+#include "..\Include\mFrustum.h"
+
+void mFrustumPlanes::ExtractFromMatrix(PVRTMat4 & VP_Matrix)
+{
+	const float * f = VP_Matrix.ptr();
+	// rows of the column major matrix
+	PVRTVec4 row1(f[0], f[4], f[8], f[12]);
+	PVRTVec4 row2(f[1], f[5], f[9], f[13]);
+	PVRTVec4 row3(f[2], f[6], f[10], f[14]);
+	PVRTVec4 row4(f[3], f[7], f[11], f[15]);
+	PVRTVec4 clipPlanes[6];
+	clipPlanes[0] = row1 + row4; //left
+	clipPlanes[1] = row4 - row1; //right
+	clipPlanes[2] = row2 + row4; //bottom
+	clipPlanes[3] = row4 - row2; //top
+	clipPlanes[4] = row3 + row4; //near
+	clipPlanes[5] = row4 - row3; //far
+
+	for (int i = 0; i < 6; ++i){
+		float length = sqrt(clipPlanes[i].x * clipPlanes[i].x + clipPlanes[i].y * clipPlanes[i].y + clipPlanes[i].z * clipPlanes[i].z);
+		if (length > 0.0f) clipPlanes[i] /= length;
+		this->A[i] = clipPlanes[i].x;
+		this->B[i] = clipPlanes[i].y;
+		this->C[i] = clipPlanes[i].z;
+		this->D[i] = clipPlanes[i].w;
+	}
+}
+
+/*!****************************************************************************
+@Function		ClassifyBox
+@Input			boxMin			world space AABB
+@Input			boxMax
+@Modified		planeMask		planes to test, on return the planes the box
+still crosses. A child only needs the mask its parent left.
+@Modified		lastOutPlane	plane that rejected the box last time, tested
+first and updated when the box is rejected again
+@Modified		planeTests		incremented once per plane tested
+@Return		int				NoHit (outside), Cross or Inside
+******************************************************************************/
+int mFrustumPlanes::ClassifyBox(const float * boxMin, const float * boxMax, PVRTuint32 & planeMask, PVRTuint8 & lastOutPlane, int & planeTests)
+{
+	int p = lastOutPlane;
+	for (int i = 0; i < 6; ++i, p = (p == 5) ? 0 : p + 1){
+		if ((planeMask & (1u << p)) == 0) continue;
+		planeTests++;
+		float farDist = this->D[p], nearDist = this->D[p];
+		if (this->A[p] >= 0.0f){ farDist += this->A[p] * boxMax[0]; nearDist += this->A[p] * boxMin[0]; }
+		else{ farDist += this->A[p] * boxMin[0]; nearDist += this->A[p] * boxMax[0]; }
+		if (this->B[p] >= 0.0f){ farDist += this->B[p] * boxMax[1]; nearDist += this->B[p] * boxMin[1]; }
+		else{ farDist += this->B[p] * boxMin[1]; nearDist += this->B[p] * boxMax[1]; }
+		if (this->C[p] >= 0.0f){ farDist += this->C[p] * boxMax[2]; nearDist += this->C[p] * boxMin[2]; }
+		else{ farDist += this->C[p] * boxMin[2]; nearDist += this->C[p] * boxMax[2]; }
+
+		if (farDist <= 0.0f){
+			lastOutPlane = (PVRTuint8)p;
+			return NoHit;
+		}
+		if (nearDist > 0.0f) planeMask &= ~(1u << p);
+	}
+	return planeMask == 0 ? Inside : Cross;
+}
+
+mFrustum::mFrustum()
+{
+}
+
+mFrustum::~mFrustum()
+{
+}
+
+/*!****************************************************************************
+@Function		Update
+@Input			VP_Matrix		view projection matrix
+@Input			cs				clip space of the projection, D3D depth is 0..1
+@Description	Corners come from the clip space cube through the inverse VP
+matrix, so an oblique near plane set by ModifyProjectionForClipping
+is followed as well.
+******************************************************************************/
+void mFrustum::Update(PVRTMat4 & VP_Matrix, PVRTMat4::eClipspace cs)
+{
+	this->Planes.ExtractFromMatrix(VP_Matrix);
+
+	PVRTMat4 inverseVP = VP_Matrix.inverseEx();
+	float nearZ = (cs == PVRTMat4::D3D) ? 0.0f : -1.0f;
+	PVRTVec3 center(0.0f, 0.0f, 0.0f);
+	for (int i = 0; i < 8; ++i){
+		PVRTVec4 clipCorner((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : nearZ, 1.0f);
+		PVRTVec4 worldCorner = inverseVP * clipCorner;
+		this->Corners[i] = PVRTVec3(worldCorner.x, worldCorner.y, worldCorner.z) / worldCorner.w;
+		center += this->Corners[i];
+	}
+	this->SphereCenter = center / 8.0f;
+	this->SphereRadius = 0.0f;
+	for (int i = 0; i < 8; ++i){
+		this->SphereRadius = PVRT_MAX(this->SphereRadius, (this->Corners[i] - this->SphereCenter).length());
+	}
+}
+
+/*!****************************************************************************
+@Function		SphereOutside
+@Input			center		world space sphere
+@Input			radius
+@Return		bool		true when the sphere is certainly not visible
+@Description	Cheap test run before any box test. First against the bounding
+sphere of the frustum, then against each plane.
+******************************************************************************/
+bool mFrustum::SphereOutside(PVRTVec3 center, float radius)
+{
+	PVRTVec3 offset = center - this->SphereCenter;
+	float reach = this->SphereRadius + radius;
+	if (offset.dot(offset) > reach * reach) return true;
+	for (int p = 0; p < 6; ++p){
+		float dist = this->Planes.A[p] * center.x + this->Planes.B[p] * center.y + this->Planes.C[p] * center.z + this->Planes.D[p];
+		if (dist < -radius) return true;
+	}
+	return false;
+}
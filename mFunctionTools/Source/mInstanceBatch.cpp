@@ -0,0 +1,105 @@
+#include "..\Include\mInstanceBatch.h"
+#include <string.h>
+
+mInstanceBatch::mInstanceBatch()
+{
+}
+
+mInstanceBatch::~mInstanceBatch()
+{
+}
+
+/*!****************************************************************************
+@Function		Build
+@Input			vertices		interleaved source vertices
+@Input			stride			source vertex size in bytes
+@Input			indices			source triangle list
+@Input			ranges			parts of indices that are drawn separately
+@Input			maxSlots		most copies a draw will ask for
+@Return		bool			false when not even one copy fits 16 bit indices
+******************************************************************************/
+bool mInstanceBatch::Build(const PVRTuint8 * vertices, unsigned int stride, unsigned int vertexCount,
+	const PVRTuint16 * indices, const vector<InstanceRange> & ranges, unsigned int maxSlots)
+{
+	this->Destroy();
+	if (vertices == nullptr || indices == nullptr || vertexCount == 0 || vertexCount > 65536 || maxSlots == 0) return false;
+
+	this->Slots = PVRT_MIN(maxSlots, 65536 / vertexCount);
+	this->SlotOffset = stride;
+	this->Stride = stride + sizeof(GLfloat);
+
+	this->Vertices.resize(this->Slots * vertexCount * this->Stride);
+	PVRTuint8 * out = &this->Vertices[0];
+	for (unsigned int slot = 0; slot < this->Slots; ++slot){
+		GLfloat slotValue = (GLfloat)slot;
+		for (unsigned int i = 0; i < vertexCount; ++i){
+			memcpy(out, vertices + i * stride, stride);
+			memcpy(out + stride, &slotValue, sizeof(GLfloat));
+			out += this->Stride;
+		}
+	}
+
+	for (unsigned int r = 0; r < ranges.size(); ++r){
+		InstanceRange range;
+		range.First = (PVRTuint32)this->Indices.size();
+		range.Count = ranges[r].Count;
+		for (unsigned int slot = 0; slot < this->Slots; ++slot){
+			PVRTuint32 offset = slot * vertexCount;
+			for (PVRTuint32 i = 0; i < ranges[r].Count; ++i){
+				this->Indices.push_back((PVRTuint16)(indices[ranges[r].First + i] + offset));
+			}
+		}
+		this->Ranges.push_back(range);
+	}
+	return true;
+}
+
+void mInstanceBatch::LoadVBO()
+{
+	if (this->Vertices.empty() || this->Indices.empty()) return;
+	glGenBuffers(1, &this->VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+	glBufferData(GL_ARRAY_BUFFER, this->Vertices.size(), &this->Vertices[0], GL_STATIC_DRAW);
+	glGenBuffers(1, &this->IndexVBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->IndexVBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->Indices.size() * sizeof(PVRTuint16), &this->Indices[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void mInstanceBatch::DeleteVBOs()
+{
+	if (this->VBO) glDeleteBuffers(1, &this->VBO);
+	if (this->IndexVBO) glDeleteBuffers(1, &this->IndexVBO);
+	this->VBO = this->IndexVBO = 0;
+}
+
+void mInstanceBatch::Destroy()
+{
+	this->DeleteVBOs();
+	this->Vertices.clear();
+	this->Indices.clear();
+	this->Ranges.clear();
+	this->Slots = 0;
+}
+
+/*!****************************************************************************
+@Function		AffineRows
+@Input			model		affine transform, the last row is dropped
+@Output		rows		12 floats, the first three rows of model
+@Description	Layout of one instance, both in the instance attribute buffer
+and in the uniform array.
+******************************************************************************/
+void mInstanceBatch::AffineRows(const PVRTMat4 & model, GLfloat * rows)
+{
+	for (int row = 0; row < 3; ++row){
+		for (int column = 0; column < 4; ++column){
+			rows[row * 4 + column] = model.f[column * 4 + row];
+		}
+	}
+}
+
+void mInstanceBatch::AffineRows(const mAffine & model, GLfloat * rows)
+{
+	memcpy(rows, model.Rows, sizeof(model.Rows));
+}
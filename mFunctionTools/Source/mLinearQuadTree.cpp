@@ -0,0 +1,263 @@
+#include "..\Include\mLinearQuadTree.h"
+#include "..\Include\mOcclusionCuller.h"
+
+const int c_iLinearQuadTreeMaxDepth = 16;
+const int c_iLinearQuadTreeStackSize = 64;
+
+struct MortonEntry
+{
+	PVRTuint32 Code;
+	PVRTuint32 Index;
+	bool operator<(const MortonEntry & rhs) const { return Code < rhs.Code; }
+};
+
+mLinearQuadTree::mLinearQuadTree()
+{
+}
+
+mLinearQuadTree::~mLinearQuadTree()
+{
+}
+
+PVRTuint32 mLinearQuadTree::mortonCode(PVRTuint32 x, PVRTuint32 z)
+{
+	// spread the low 16 bits of x and z over the even and odd bits
+	x &= 0x0000FFFF;
+	x = (x | (x << 8)) & 0x00FF00FF;
+	x = (x | (x << 4)) & 0x0F0F0F0F;
+	x = (x | (x << 2)) & 0x33333333;
+	x = (x | (x << 1)) & 0x55555555;
+	z &= 0x0000FFFF;
+	z = (z | (z << 8)) & 0x00FF00FF;
+	z = (z | (z << 4)) & 0x0F0F0F0F;
+	z = (z | (z << 2)) & 0x33333333;
+	z = (z | (z << 1)) & 0x55555555;
+	return x | (z << 1);
+}
+
+/*!****************************************************************************
+@Function		Build
+@Input			models		models to index, the pointers must stay valid
+@Input			depth		number of levels, the root is level 1
+@Description	Same layout as mSceneManager::makeQuadTree: models whose world
+center is outside the root box are left out, the others end up in the
+leaf cell that holds their center. Node bounds are the union of the
+model bounds below them, so objects that straddle cells are not lost.
+******************************************************************************/
+void mLinearQuadTree::Build(vector<mModel*> & models, int depth, float Xmin, float Xmax, float Ymin, float Ymax, float Zmin, float Zmax)
+{
+	this->Clear();
+	this->Depth = PVRT_CLAMP(depth, 1, c_iLinearQuadTreeMaxDepth);
+	this->Models = models;
+
+	PVRTuint32 cells = 1u << (this->Depth - 1);
+	float cellScaleX = cells / (Xmax - Xmin);
+	float cellScaleZ = cells / (Zmax - Zmin);
+
+	vector<MortonEntry> entries;
+	entries.reserve(models.size());
+	this->BoxMin.resize(models.size());
+	this->BoxMax.resize(models.size());
+	for (unsigned int i = 0; i < models.size(); ++i){
+		models[i]->SurrondBox.GetBoxWorld(this->BoxMin[i], this->BoxMax[i]);
+		PVRTVec3 center = (this->BoxMin[i] + this->BoxMax[i]) * 0.5f;
+		if (center.x <= Xmin || center.x > Xmax) continue;
+		if (center.y <= Ymin || center.y > Ymax) continue;
+		if (center.z <= Zmin || center.z > Zmax) continue;
+
+		PVRTuint32 cellX = (PVRTuint32)PVRT_CLAMP((int)((center.x - Xmin) * cellScaleX), 0, (int)cells - 1);
+		PVRTuint32 cellZ = (PVRTuint32)PVRT_CLAMP((int)((center.z - Zmin) * cellScaleZ), 0, (int)cells - 1);
+		MortonEntry entry;
+		entry.Code = mortonCode(cellX, cellZ);
+		entry.Index = i;
+		entries.push_back(entry);
+	}
+	sort(entries.begin(), entries.end());
+
+	this->ModelIndex.resize(entries.size());
+	for (unsigned int i = 0; i < entries.size(); ++i){
+		this->ModelIndex[i] = entries[i].Index;
+	}
+
+	LinearQuadNode root;
+	root.First = 0;
+	root.Count = (PVRTuint32)entries.size();
+	root.FirstChild = 0;
+	root.ChildCount = 0;
+	root.Level = 1;
+	root.LastOutPlane = 0;
+	this->Nodes.push_back(root);
+
+	// breadth-first: every node splits its sorted range by the next 2 bits of the code
+	for (unsigned int n = 0; n < this->Nodes.size(); ++n){
+		LinearQuadNode node = this->Nodes[n];
+		if (node.Level == this->Depth || node.Count == 0) continue;
+
+		int shift = 2 * (this->Depth - 1 - node.Level);
+		PVRTuint32 firstChild = (PVRTuint32)this->Nodes.size();
+		PVRTuint8 childCount = 0;
+		PVRTuint32 end = node.First + node.Count;
+		PVRTuint32 runStart = node.First;
+		while (runStart < end){
+			PVRTuint32 digit = (entries[runStart].Code >> shift) & 3;
+			PVRTuint32 runEnd = runStart + 1;
+			while (runEnd < end && ((entries[runEnd].Code >> shift) & 3) == digit) runEnd++;
+
+			LinearQuadNode child;
+			child.First = runStart;
+			child.Count = runEnd - runStart;
+			child.FirstChild = 0;
+			child.ChildCount = 0;
+			child.Level = (PVRTuint8)(node.Level + 1);
+			child.LastOutPlane = 0;
+			this->Nodes.push_back(child);
+			childCount++;
+			runStart = runEnd;
+		}
+		this->Nodes[n].FirstChild = firstChild;
+		this->Nodes[n].ChildCount = childCount;
+	}
+
+	this->computeNodeBounds();
+}
+
+void mLinearQuadTree::computeNodeBounds()
+{
+	// children always come after their parent, so a reverse walk is bottom-up
+	for (int n = (int)this->Nodes.size() - 1; n >= 0; --n){
+		LinearQuadNode & node = this->Nodes[n];
+		PVRTVec3 nodeMin(FLT_MAX, FLT_MAX, FLT_MAX);
+		PVRTVec3 nodeMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		if (node.ChildCount == 0){
+			for (PVRTuint32 i = node.First; i < node.First + node.Count; ++i){
+				PVRTVec3 & boxMin = this->BoxMin[this->ModelIndex[i]];
+				PVRTVec3 & boxMax = this->BoxMax[this->ModelIndex[i]];
+				nodeMin.x = PVRT_MIN(nodeMin.x, boxMin.x);
+				nodeMin.y = PVRT_MIN(nodeMin.y, boxMin.y);
+				nodeMin.z = PVRT_MIN(nodeMin.z, boxMin.z);
+				nodeMax.x = PVRT_MAX(nodeMax.x, boxMax.x);
+				nodeMax.y = PVRT_MAX(nodeMax.y, boxMax.y);
+				nodeMax.z = PVRT_MAX(nodeMax.z, boxMax.z);
+			}
+		}
+		else{
+			for (PVRTuint32 c = node.FirstChild; c < node.FirstChild + node.ChildCount; ++c){
+				LinearQuadNode & child = this->Nodes[c];
+				nodeMin.x = PVRT_MIN(nodeMin.x, child.Min[0]);
+				nodeMin.y = PVRT_MIN(nodeMin.y, child.Min[1]);
+				nodeMin.z = PVRT_MIN(nodeMin.z, child.Min[2]);
+				nodeMax.x = PVRT_MAX(nodeMax.x, child.Max[0]);
+				nodeMax.y = PVRT_MAX(nodeMax.y, child.Max[1]);
+				nodeMax.z = PVRT_MAX(nodeMax.z, child.Max[2]);
+			}
+		}
+		node.Min[0] = nodeMin.x;
+		node.Min[1] = nodeMin.y;
+		node.Min[2] = nodeMin.z;
+		node.Max[0] = nodeMax.x;
+		node.Max[1] = nodeMax.y;
+		node.Max[2] = nodeMax.z;
+	}
+	// per-model boxes are only needed while building
+	vector<PVRTVec3>().swap(this->BoxMin);
+	vector<PVRTVec3>().swap(this->BoxMax);
+}
+
+/*!****************************************************************************
+@Function		Query
+@Input			planes		world space frustum planes
+@Output		modelsOut	visible models are appended
+@Input			occlusion	optional, built for the camera of planes
+@Description	Iterative traversal with a fixed size stack. Every model of a
+visible leaf gets needRender set, like mSceneManager::checkQuadTree.
+Each stack entry carries the planes its parent still crosses, an empty
+mask means the subtree is inside and is taken without tests. With an
+occlusion culler every node that passes the frustum is tested against it,
+so one test drops a whole hidden subtree.
+******************************************************************************/
+void mLinearQuadTree::Query(mFrustumPlanes & planes, vector<mModel*> & modelsOut, mOcclusionCuller * occlusion)
+{
+	mCullStats stats;
+	this->queryNodes(planes, modelsOut, nullptr, stats, true, occlusion);
+	this->NodesVisited = stats.NodesVisited;
+	this->NodesCulled = stats.NodesCulled;
+	this->NodesAccepted = stats.NodesAccepted;
+	this->PlaneTests = stats.PlaneTests;
+	this->NodesOccluded = stats.NodesOccluded;
+	this->ModelsOccluded = stats.ModelsOccluded;
+}
+
+/*!****************************************************************************
+@Function		QueryView
+@Input			planes			world space frustum planes
+@Output		modelsOut		visible models are appended
+@Modified		lastOutPlane	per node plane coherency of this view
+@Output		stats			work done by this query
+@Description	Same traversal as Query but the tree and the models are only
+read, so several views can query one tree from different threads.
+******************************************************************************/
+void mLinearQuadTree::QueryView(mFrustumPlanes & planes, vector<mModel*> & modelsOut, vector<PVRTuint8> & lastOutPlane, mCullStats & stats)
+{
+	if (lastOutPlane.size() != this->Nodes.size()) lastOutPlane.assign(this->Nodes.size(), 0);
+	stats = mCullStats();
+	this->queryNodes(planes, modelsOut, lastOutPlane.empty() ? nullptr : &lastOutPlane[0], stats, false, nullptr);
+}
+
+void mLinearQuadTree::queryNodes(mFrustumPlanes & planes, vector<mModel*> & modelsOut, PVRTuint8 * lastOutPlane, mCullStats & stats, bool markModels,
+	mOcclusionCuller * occlusion)
+{
+	if (this->Nodes.empty()) return;
+
+	PVRTuint32 stack[c_iLinearQuadTreeStackSize];
+	PVRTuint32 stackMask[c_iLinearQuadTreeStackSize];
+	int top = 0;
+	stack[top] = 0;
+	stackMask[top++] = c_uiAllFrustumPlanes;
+	while (top > 0){
+		--top;
+		LinearQuadNode & node = this->Nodes[stack[top]];
+		PVRTuint8 & nodeLastOut = lastOutPlane ? lastOutPlane[stack[top]] : node.LastOutPlane;
+		PVRTuint32 planeMask = stackMask[top];
+		stats.NodesVisited++;
+		if (planeMask == 0){
+			stats.NodesAccepted++;
+		}
+		else if (planes.ClassifyBox(node.Min, node.Max, planeMask, nodeLastOut, stats.PlaneTests) == NoHit){
+			stats.NodesCulled++;
+			continue;
+		}
+		if (occlusion && occlusion->IsOccluded(PVRTVec3(node.Min[0], node.Min[1], node.Min[2]), PVRTVec3(node.Max[0], node.Max[1], node.Max[2]))){
+			stats.NodesOccluded++;
+			stats.ModelsOccluded += node.Count;
+			continue;
+		}
+
+		if (node.ChildCount == 0){
+			for (PVRTuint32 i = node.First; i < node.First + node.Count; ++i){
+				mModel * model = this->Models[this->ModelIndex[i]];
+				if (markModels) model->needRender = true;
+				modelsOut.push_back(model);
+			}
+			continue;
+		}
+		for (PVRTuint32 c = 0; c < node.ChildCount; ++c){
+			stack[top] = node.FirstChild + c;
+			stackMask[top++] = planeMask;
+		}
+	}
+}
+
+void mLinearQuadTree::Clear()
+{
+	this->Nodes.clear();
+	this->ModelIndex.clear();
+	this->Models.clear();
+	this->BoxMin.clear();
+	this->BoxMax.clear();
+	this->NodesVisited = 0;
+	this->NodesCulled = 0;
+	this->NodesAccepted = 0;
+	this->PlaneTests = 0;
+	this->NodesOccluded = 0;
+	this->ModelsOccluded = 0;
+}
@@ -0,0 +1,281 @@
+#include "..\Include\mLooseQuadTree.h"
+
+const int c_iLooseQuadTreeMaxDepth = 10;
+
+mLooseQuadTree::mLooseQuadTree()
+{
+}
+
+mLooseQuadTree::~mLooseQuadTree()
+{
+}
+
+void mLooseQuadTree::Init(int depth, float Xmin, float Xmax, float Ymin, float Ymax, float Zmin, float Zmax)
+{
+	this->Clear();
+	this->Depth = PVRT_CLAMP(depth, 1, c_iLooseQuadTreeMaxDepth);
+	this->RootMin[0] = Xmin;
+	this->RootMin[1] = Ymin;
+	this->RootMin[2] = Zmin;
+	this->RootMax[0] = Xmax;
+	this->RootMax[1] = Ymax;
+	this->RootMax[2] = Zmax;
+
+	this->CellSizeX.resize(this->Depth);
+	this->CellSizeZ.resize(this->Depth);
+	this->LevelOffset.resize(this->Depth + 1);
+	int offset = 0;
+	for (int level = 0; level < this->Depth; ++level){
+		int n = 1 << level;
+		this->CellSizeX[level] = (Xmax - Xmin) / n;
+		this->CellSizeZ[level] = (Zmax - Zmin) / n;
+		this->LevelOffset[level] = offset;
+		offset += n * n;
+	}
+	this->LevelOffset[this->Depth] = offset;
+
+	// the last cell is the overflow list, it has no place in the grid
+	LooseCell empty;
+	empty.Head = -1;
+	empty.SubtreeCount = 0;
+	empty.LastOutPlane = 0;
+	this->Cells.assign(offset + 1, empty);
+}
+
+/*!****************************************************************************
+@Function		findCell
+@Input			entry		entry with up to date world bounds
+@Return		int			cell index, the overflow cell if it fits nowhere
+@Description	Deepest level whose cells are at least as big as the model,
+then the cell of that level holding the model center.
+******************************************************************************/
+int mLooseQuadTree::findCell(LooseEntry & entry)
+{
+	int overflow = (int)this->Cells.size() - 1;
+	float sizeX = entry.Max[0] - entry.Min[0];
+	float sizeZ = entry.Max[2] - entry.Min[2];
+	float centerX = (entry.Min[0] + entry.Max[0]) * 0.5f;
+	float centerZ = (entry.Min[2] + entry.Max[2]) * 0.5f;
+
+	if (centerX < this->RootMin[0] || centerX > this->RootMax[0]) return overflow;
+	if (centerZ < this->RootMin[2] || centerZ > this->RootMax[2]) return overflow;
+	if (entry.Min[1] < this->RootMin[1] || entry.Max[1] > this->RootMax[1]) return overflow;
+	if (sizeX > this->CellSizeX[0] || sizeZ > this->CellSizeZ[0]) return overflow;
+
+	int level = this->Depth - 1;
+	while (level > 0 && (sizeX > this->CellSizeX[level] || sizeZ > this->CellSizeZ[level])) level--;
+
+	int n = 1 << level;
+	int x = PVRT_CLAMP((int)((centerX - this->RootMin[0]) / this->CellSizeX[level]), 0, n - 1);
+	int z = PVRT_CLAMP((int)((centerZ - this->RootMin[2]) / this->CellSizeZ[level]), 0, n - 1);
+	return this->LevelOffset[level] + z * n + x;
+}
+
+void mLooseQuadTree::addSubtreeCount(int cell, int delta)
+{
+	if (cell == (int)this->Cells.size() - 1) return;
+	int level = 0;
+	while (cell >= this->LevelOffset[level + 1]) level++;
+	int n = 1 << level;
+	int x = (cell - this->LevelOffset[level]) % n;
+	int z = (cell - this->LevelOffset[level]) / n;
+	for (; level >= 0; --level){
+		this->Cells[this->LevelOffset[level] + z * (1 << level) + x].SubtreeCount += delta;
+		x >>= 1;
+		z >>= 1;
+	}
+}
+
+void mLooseQuadTree::linkEntry(int handle, int cell)
+{
+	LooseEntry & entry = this->Entries[handle];
+	entry.Cell = cell;
+	entry.Prev = -1;
+	entry.Next = this->Cells[cell].Head;
+	if (entry.Next >= 0) this->Entries[entry.Next].Prev = handle;
+	this->Cells[cell].Head = handle;
+	this->addSubtreeCount(cell, 1);
+}
+
+void mLooseQuadTree::unlinkEntry(int handle)
+{
+	LooseEntry & entry = this->Entries[handle];
+	if (entry.Prev >= 0) this->Entries[entry.Prev].Next = entry.Next;
+	else this->Cells[entry.Cell].Head = entry.Next;
+	if (entry.Next >= 0) this->Entries[entry.Next].Prev = entry.Prev;
+	this->addSubtreeCount(entry.Cell, -1);
+	entry.Cell = -1;
+}
+
+void mLooseQuadTree::insertModel(mModel * model)
+{
+	if (model->LooseTree != nullptr) return;
+
+	int handle;
+	if (this->FreeEntry >= 0){
+		handle = this->FreeEntry;
+		this->FreeEntry = this->Entries[handle].Next;
+	}
+	else{
+		handle = (int)this->Entries.size();
+		this->Entries.push_back(LooseEntry());
+	}
+
+	LooseEntry & entry = this->Entries[handle];
+	PVRTVec3 boxMin, boxMax;
+	model->SurrondBox.GetBoxWorld(boxMin, boxMax);
+	entry.Model = model;
+	entry.LastOutPlane = 0;
+	entry.Min[0] = boxMin.x; entry.Min[1] = boxMin.y; entry.Min[2] = boxMin.z;
+	entry.Max[0] = boxMax.x; entry.Max[1] = boxMax.y; entry.Max[2] = boxMax.z;
+	this->linkEntry(handle, this->findCell(entry));
+
+	model->LooseTree = this;
+	model->LooseHandle = handle;
+	this->Count++;
+}
+
+void mLooseQuadTree::removeModel(mModel * model)
+{
+	if (model->LooseTree != this) return;
+	int handle = model->LooseHandle;
+	if (handle < 0 || handle >= (int)this->Entries.size() || this->Entries[handle].Model != model) return;
+
+	this->unlinkEntry(handle);
+	this->Entries[handle].Model = nullptr;
+	this->Entries[handle].Next = this->FreeEntry;
+	this->FreeEntry = handle;
+
+	model->LooseTree = nullptr;
+	model->LooseHandle = -1;
+	this->Count--;
+}
+
+/*!****************************************************************************
+@Function		updateModel
+@Input			model		model whose transform has changed
+@Description	Called by mModel after its world box has been updated. The
+entry only moves when the model changes cell.
+******************************************************************************/
+void mLooseQuadTree::updateModel(mModel * model)
+{
+	int handle = model->LooseHandle;
+	if (handle < 0 || handle >= (int)this->Entries.size() || this->Entries[handle].Model != model) return;
+
+	LooseEntry & entry = this->Entries[handle];
+	PVRTVec3 boxMin, boxMax;
+	model->SurrondBox.GetBoxWorld(boxMin, boxMax);
+	entry.Min[0] = boxMin.x; entry.Min[1] = boxMin.y; entry.Min[2] = boxMin.z;
+	entry.Max[0] = boxMax.x; entry.Max[1] = boxMax.y; entry.Max[2] = boxMax.z;
+
+	int cell = this->findCell(entry);
+	if (cell == entry.Cell) return;
+	this->unlinkEntry(handle);
+	this->linkEntry(handle, cell);
+}
+
+void mLooseQuadTree::testList(mFrustumPlanes & planes, PVRTuint32 planeMask, int head, vector<mModel*> & modelsOut)
+{
+	for (int handle = head; handle >= 0; handle = this->Entries[handle].Next){
+		LooseEntry & entry = this->Entries[handle];
+		PVRTuint32 entryMask = planeMask;
+		if (entryMask != 0) this->ModelsTested++;
+		if (planes.ClassifyBox(entry.Min, entry.Max, entryMask, entry.LastOutPlane, this->PlaneTests) == NoHit) continue;
+		entry.Model->needRender = true;
+		modelsOut.push_back(entry.Model);
+	}
+}
+
+void mLooseQuadTree::emitCell(int level, int x, int z, vector<mModel*> & modelsOut)
+{
+	LooseCell & cell = this->Cells[this->LevelOffset[level] + z * (1 << level) + x];
+	if (cell.SubtreeCount == 0) return;
+	this->NodesVisited++;
+	this->NodesAccepted++;
+	for (int handle = cell.Head; handle >= 0; handle = this->Entries[handle].Next){
+		this->Entries[handle].Model->needRender = true;
+		modelsOut.push_back(this->Entries[handle].Model);
+	}
+	this->emitChildren(level, x, z, modelsOut);
+}
+
+void mLooseQuadTree::emitChildren(int level, int x, int z, vector<mModel*> & modelsOut)
+{
+	if (level + 1 == this->Depth) return;
+	for (int c = 0; c < 4; ++c){
+		this->emitCell(level + 1, 2 * x + (c & 1), 2 * z + (c >> 1), modelsOut);
+	}
+}
+
+void mLooseQuadTree::queryCell(mFrustumPlanes & planes, PVRTuint32 planeMask, int level, int x, int z, vector<mModel*> & modelsOut)
+{
+	LooseCell & cell = this->Cells[this->LevelOffset[level] + z * (1 << level) + x];
+	if (cell.SubtreeCount == 0) return;
+
+	// loose bounds: the cell grown by half a cell on every side in XZ
+	float cellMin[3], cellMax[3];
+	cellMin[0] = this->RootMin[0] + (x - 0.5f) * this->CellSizeX[level];
+	cellMax[0] = this->RootMin[0] + (x + 1.5f) * this->CellSizeX[level];
+	cellMin[1] = this->RootMin[1];
+	cellMax[1] = this->RootMax[1];
+	cellMin[2] = this->RootMin[2] + (z - 0.5f) * this->CellSizeZ[level];
+	cellMax[2] = this->RootMin[2] + (z + 1.5f) * this->CellSizeZ[level];
+
+	// a child's loose bounds lie inside its parent's, so the plane mask carries over
+	this->NodesVisited++;
+	int hit = planes.ClassifyBox(cellMin, cellMax, planeMask, cell.LastOutPlane, this->PlaneTests);
+	if (hit == NoHit){
+		this->NodesCulled++;
+		return;
+	}
+
+	// planeMask is empty when the cell is inside, its models are then taken untested
+	this->testList(planes, planeMask, cell.Head, modelsOut);
+	if (hit == Inside){
+		this->emitChildren(level, x, z, modelsOut);
+		return;
+	}
+	if (level + 1 == this->Depth) return;
+	for (int c = 0; c < 4; ++c){
+		this->queryCell(planes, planeMask, level + 1, 2 * x + (c & 1), 2 * z + (c >> 1), modelsOut);
+	}
+}
+
+/*!****************************************************************************
+@Function		Query
+@Input			planes		world space frustum planes
+@Output		modelsOut	visible models are appended
+@Description	Cells fully inside the frustum accept their whole subtree,
+cells crossing a plane test their own models one by one.
+******************************************************************************/
+void mLooseQuadTree::Query(mFrustumPlanes & planes, vector<mModel*> & modelsOut)
+{
+	this->NodesVisited = 0;
+	this->NodesCulled = 0;
+	this->NodesAccepted = 0;
+	this->PlaneTests = 0;
+	this->ModelsTested = 0;
+	if (this->Cells.empty()) return;
+	this->queryCell(planes, c_uiAllFrustumPlanes, 0, 0, 0, modelsOut);
+	this->testList(planes, c_uiAllFrustumPlanes, this->Cells.back().Head, modelsOut);
+}
+
+void mLooseQuadTree::Clear()
+{
+	for (unsigned int i = 0; i < this->Entries.size(); ++i){
+		mModel * model = this->Entries[i].Model;
+		if (model != nullptr && model->LooseTree == this){
+			model->LooseTree = nullptr;
+			model->LooseHandle = -1;
+		}
+	}
+	this->Entries.clear();
+	this->Cells.clear();
+	this->FreeEntry = -1;
+	this->Count = 0;
+}
+
+unsigned int mLooseQuadTree::size()
+{
+	return (unsigned int)this->Count;
+}
@@ -1,4 +1,5 @@
 #include "..\Include\mModel.h"
+#include "..\Include\mLooseQuadTree.h"
 
 
 mModel::mModel()
@@ -17,19 +18,25 @@ void mModel::Destroy()
 	this->ModelPOD->Destroy();
 	delete[] this->VBO;
 	delete[] this->IndexVBO;
+	delete[] this->VAO;
 	this->ModelPOD = nullptr;
 	this->VBO = nullptr;
 	this->IndexVBO = nullptr;
+	this->VAO = nullptr;
 }
 
 void mModel::DeleteVBOs()
 {
+	if (this->VAO) this->Extensions->glDeleteVertexArraysOES(this->ModelPOD->nNumMesh, this->VAO);
 	glDeleteBuffers(this->ModelPOD->nNumMesh, this->VBO);
 	glDeleteBuffers(this->ModelPOD->nNumMesh, this->IndexVBO);
+	delete[] this->VAO;
+	this->VAO = nullptr;
 }
 
 void mModel::SetPOD(CPVRTModelPOD * modelPOD)
 {
+	if (this->ModelPOD != modelPOD) this->InvalidateBounds();
 	this->ModelPOD = modelPOD;
 }
 
@@ -46,9 +53,21 @@ void mModel::SetTransform(PVRTVec3 Position, PVRTVec3 EulerAngle, PVRTVec3 Scal)
 	this->Position = Position;
 	this->EulerAngle = EulerAngle;
 	this->Scale = Scale;
+	this->UpdateInverse();
 }
 
-void mModel::LoadVBO()
+/*!****************************************************************************
+@Function		LoadVBO
+@Input			extensions		loaded extensions, the VAOs are only built
+when it has glGenVertexArraysOES (OpenGL ES 3.0 or
+GL_OES_vertex_array_object)
+@Description	Uploads every mesh to a vertex and an index buffer. With
+vertex array objects each mesh also gets one holding both buffers and the
+attributes the mesh has at their mModelAttribute locations, so drawing it
+is a single glBindVertexArrayOES. Without them VAO stays nullptr and the
+attributes have to be set per draw.
+******************************************************************************/
+void mModel::LoadVBO(CPVRTgles2Ext * extensions)
 {
 	this->VBO = new GLuint[this->ModelPOD->nNumMesh];
 	this->IndexVBO = new GLuint[this->ModelPOD->nNumMesh];
@@ -72,6 +91,29 @@ void mModel::LoadVBO()
 		}
 
 	}
+
+	this->Extensions = extensions;
+	if (!extensions || !extensions->glGenVertexArraysOES) return;
+
+	this->VAO = new GLuint[this->ModelPOD->nNumMesh];
+	extensions->glGenVertexArraysOES(this->ModelPOD->nNumMesh, this->VAO);
+	for (unsigned int i = 0; i < this->ModelPOD->nNumMesh; ++i)
+	{
+		SPODMesh& Mesh = this->ModelPOD->pMesh[i];
+		extensions->glBindVertexArrayOES(this->VAO[i]);
+		glBindBuffer(GL_ARRAY_BUFFER, this->VBO[i]);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->IndexVBO[i]);
+
+		// pData are offsets into the interleaved buffer
+		CPODData * attribs[mModelNumAttribs] = { &Mesh.sVertex, &Mesh.sNormals, &Mesh.sTangents, &Mesh.sBinormals, Mesh.nNumUVW ? &Mesh.psUVW[0] : nullptr };
+		for (int a = 0; a < mModelNumAttribs; ++a)
+		{
+			if (!attribs[a] || !attribs[a]->n) continue;
+			glEnableVertexAttribArray(a);
+			glVertexAttribPointer(a, attribs[a]->n, GL_FLOAT, GL_FALSE, attribs[a]->nStride, attribs[a]->pData);
+		}
+	}
+	extensions->glBindVertexArrayOES(0);
 }
 
 void mModel::SetPosition(PVRTVec3 position)
@@ -79,7 +121,9 @@ void mModel::SetPosition(PVRTVec3 position)
 	if (this->Position == position) return;
 	this->Position = position;
 	this->UpdatePosition();
+	this->UpdateInverse();
 	this->SurrondBox.UpdateBoxWorld(this->ModelMatrix);
+	if (this->LooseTree) this->LooseTree->updateModel(this);
 }
 
 void mModel::SetPosition(PVRTfloat32 x, PVRTfloat32 y, PVRTfloat32 z)
@@ -88,7 +132,9 @@ void mModel::SetPosition(PVRTfloat32 x, PVRTfloat32 y, PVRTfloat32 z)
 	if (this->Position == newPosition) return;
 	this->Position = newPosition;
 	this->UpdatePosition();
+	this->UpdateInverse();
 	this->SurrondBox.UpdateBoxWorld(this->ModelMatrix);
+	if (this->LooseTree) this->LooseTree->updateModel(this);
 }
 
 void mModel::SetEulerAngle(PVRTVec3 eulerAngle)
@@ -99,7 +145,9 @@ void mModel::SetEulerAngle(PVRTVec3 eulerAngle)
 	this->ModelMatrix = this->RotationMatrix;
 	this->UpdatePosition();
 	this->UpdateScale();
+	this->UpdateInverse();
 	this->SurrondBox.UpdateBoxWorld(this->ModelMatrix);
+	if (this->LooseTree) this->LooseTree->updateModel(this);
 }
 
 void mModel::SetEulerAngle(PVRTfloat32 x, PVRTfloat32 y, PVRTfloat32 z)
@@ -111,7 +159,9 @@ void mModel::SetEulerAngle(PVRTfloat32 x, PVRTfloat32 y, PVRTfloat32 z)
 	this->ModelMatrix = this->RotationMatrix;
 	this->UpdatePosition();
 	this->UpdateScale();
+	this->UpdateInverse();
 	this->SurrondBox.UpdateBoxWorld(this->ModelMatrix);
+	if (this->LooseTree) this->LooseTree->updateModel(this);
 }
 
 void mModel::SetScale(PVRTVec3 scale)
@@ -119,7 +169,9 @@ void mModel::SetScale(PVRTVec3 scale)
 	if (this->Scale == scale) return;
 	this->ChangeScale(scale);
 	this->Scale = scale;
+	this->UpdateInverse();
 	this->SurrondBox.UpdateBoxWorld(this->ModelMatrix);
+	if (this->LooseTree) this->LooseTree->updateModel(this);
 }
 
 void mModel::SetScale(PVRTfloat32 x, PVRTfloat32 y, PVRTfloat32 z)
@@ -128,21 +180,43 @@ void mModel::SetScale(PVRTfloat32 x, PVRTfloat32 y, PVRTfloat32 z)
 	if (this->Scale == newScale) return;
 	this->ChangeScale(newScale);
 	this->Scale = newScale;
+	this->UpdateInverse();
 	this->SurrondBox.UpdateBoxWorld(this->ModelMatrix);
+	if (this->LooseTree) this->LooseTree->updateModel(this);
 }
 
-void mModel::CreateSuroundBox()
+/*!****************************************************************************
+@Function		CreateSuroundBox
+@Input			pool			optional, splits large meshes across its threads
+@Input			orientedBox		also fit Bounds' oriented box
+@Description	Bounds are only computed the first time for a POD, calling it
+again after a context reload reuses them. Reloading the POD computes them
+again, call InvalidateBounds after changing the vertex data in place.
+******************************************************************************/
+void mModel::CreateSuroundBox(mWorkerPool * pool, bool orientedBox)
 {
-	for (unsigned int i = 0; i < this->ModelPOD->nNumMesh; ++i)
+	PVRTuint32 vertexCount = 0;
+	for (unsigned int i = 0; i < this->ModelPOD->nNumMesh; ++i) vertexCount += this->ModelPOD->pMesh[i].nNumVertex;
+	bool cached = this->Bounds.IsValid() && this->Bounds.SourceData == this->ModelPOD && this->Bounds.SourceVertices == vertexCount
+		&& this->Bounds.SourceGeneration == this->ModelPOD->GetLoadGeneration();
+	if (!cached || (orientedBox && !this->Bounds.HasOrientedBox))
 	{
-		SPODMesh& Mesh = this->ModelPOD->pMesh[i];
-		this->SurrondBox.UpdateBoxModel(Mesh.nNumVertex, Mesh.pInterleaved, Mesh.sVertex.nStride);
+		mBoundsEngine engine;
+		engine.Pool = pool;
+		engine.ComputeOrientedBox = orientedBox;
+		engine.Compute(*this->ModelPOD, this->Bounds);
 	}
+	if (this->Bounds.IsValid()) this->SurrondBox.SetBoxModel(this->Bounds.Min, this->Bounds.Max);
 }
 
-bool mModel::NeedClip(PVRTMat4 & MVPmatrix)
+void mModel::InvalidateBounds()
 {
-	return this->SurrondBox.NeedClipFromObjSpace(MVPmatrix);
+	this->Bounds = mBounds();
+}
+
+bool mModel::NeedClip(mFrustum & frustum)
+{
+	return this->SurrondBox.NeedClipFromFrustum(frustum);
 }
 
 PVRTMat4 mModel::GetModelMatrix()
@@ -150,6 +224,33 @@ PVRTMat4 mModel::GetModelMatrix()
 	return this->ModelMatrix;
 }
 
+const mAffine & mModel::GetTransform() const
+{
+	return this->Transform;
+}
+
+const mAffine & mModel::GetInverseTransform() const
+{
+	return this->InverseTransform;
+}
+
+const PVRTMat3 & mModel::GetNormalMatrix() const
+{
+	return this->NormalMatrix;
+}
+
+/*!****************************************************************************
+@Function		UpdateInverse
+@Description	Refreshes the cached transforms after ModelMatrix changed, so
+drawing a model costs no inverse.
+******************************************************************************/
+void mModel::UpdateInverse()
+{
+	this->Transform = mAffine(this->ModelMatrix);
+	this->InverseTransform = this->Transform.Inverse();
+	this->NormalMatrix = this->Transform.InverseTranspose();
+}
+
 void mModel::UpdatePosition()
 {
 	this->ModelMatrix.ptr()[12] = this->Position.x;
@@ -0,0 +1,421 @@
+#include "..\Include\mOcclusionCuller.h"
+#include <float.h>
+#include <algorithm>
+
+mOcclusionCuller::mOcclusionCuller()
+{
+}
+
+mOcclusionCuller::~mOcclusionCuller()
+{
+}
+
+/*!****************************************************************************
+@Function		Init
+@Input			width		depth buffer width, rounded up to a multiple of 4
+@Input			height		depth buffer height
+@Description	Allocates the depth buffer and every pyramid level once.
+******************************************************************************/
+void mOcclusionCuller::Init(int width, int height)
+{
+	this->BufferWidth = (PVRT_MAX(width, 4) + 3) & ~3;
+	this->BufferHeight = PVRT_MAX(height, 1);
+	this->Levels.clear();
+	this->LevelWidth.clear();
+	this->LevelHeight.clear();
+
+	int w = this->BufferWidth, h = this->BufferHeight;
+	while (true){
+		this->Levels.push_back(vector<float>(w * h, 1.0f));
+		this->LevelWidth.push_back(w);
+		this->LevelHeight.push_back(h);
+		if (w == 1 && h == 1) break;
+		w = (w + 1) / 2;
+		h = (h + 1) / 2;
+	}
+	this->Ready = false;
+}
+
+/*!****************************************************************************
+@Function		Begin
+@Input			camera		view the occluders are rasterized for
+@Description	Clears the depth buffer to the far plane. Occluders are added
+next and End builds the pyramid.
+******************************************************************************/
+void mOcclusionCuller::Begin(Camera & camera)
+{
+	this->VPMatrix = camera.getVPMatrix();
+	if (!this->Levels.empty()) fill(this->Levels[0].begin(), this->Levels[0].end(), 1.0f);
+	this->Ready = false;
+	this->TrianglesRasterized = 0;
+	this->TrianglesSkipped = 0;
+	this->BoxesTested = 0;
+	this->BoxesOccluded = 0;
+}
+
+void mOcclusionCuller::addOccluder(mModel * model)
+{
+	if (model->ModelPOD == nullptr) return;
+	PVRTMat4 modelMatrix = model->GetModelMatrix();
+	for (unsigned int i = 0; i < model->ModelPOD->nNumMesh; ++i){
+		this->addOccluderMesh(model->ModelPOD->pMesh[i], modelMatrix);
+	}
+}
+
+/*!****************************************************************************
+@Function		addOccluderMesh
+@Input			mesh			POD mesh, triangle list or strips, 16 bit indices
+@Input			modelMatrix		model to world transform
+******************************************************************************/
+void mOcclusionCuller::addOccluderMesh(SPODMesh & mesh, PVRTMat4 & modelMatrix)
+{
+	const PVRTuint8 * positions = mesh.pInterleaved ? mesh.pInterleaved + (size_t)mesh.sVertex.pData : mesh.sVertex.pData;
+	if (positions == nullptr || mesh.sVertex.eType != EPODDataFloat) return;
+	const PVRTuint16 * indices = nullptr;
+	if (mesh.sFaces.pData){
+		if (mesh.sFaces.eType != EPODDataUnsignedShort){
+			this->TrianglesSkipped += mesh.nNumFaces;
+			return;
+		}
+		indices = (const PVRTuint16*)mesh.sFaces.pData;
+	}
+
+	if (mesh.nNumStrips == 0){
+		this->addOccluderTriangles(positions, mesh.sVertex.nStride, mesh.nNumVertex, indices, mesh.nNumFaces, modelMatrix);
+		return;
+	}
+
+	PVRTMat4 MVP = this->VPMatrix * modelMatrix;
+	this->transformVertices(positions, mesh.sVertex.nStride, mesh.nNumVertex, MVP);
+	unsigned int offset = 0;
+	for (unsigned int s = 0; s < mesh.nNumStrips; ++s){
+		for (unsigned int t = 0; t < mesh.pnStripLength[s]; ++t){
+			unsigned int i0 = offset + t, i1 = offset + t + 1, i2 = offset + t + 2;
+			if (indices){
+				i0 = indices[i0];
+				i1 = indices[i1];
+				i2 = indices[i2];
+			}
+			if (i0 >= mesh.nNumVertex || i1 >= mesh.nNumVertex || i2 >= mesh.nNumVertex) continue;
+			this->rasterTriangle(this->ClipVertices[i0], this->ClipVertices[i1], this->ClipVertices[i2]);
+		}
+		offset += mesh.pnStripLength[s] + 2;
+	}
+}
+
+/*!****************************************************************************
+@Function		addOccluderTriangles
+@Input			positions		first vertex position, 3 floats
+@Input			stride			bytes between two positions
+@Input			vertexCount
+@Input			indices			3 per triangle, NULL for a non indexed list
+@Input			triangleCount
+@Input			modelMatrix		model to world transform
+******************************************************************************/
+void mOcclusionCuller::addOccluderTriangles(const PVRTuint8 * positions, unsigned int stride, unsigned int vertexCount,
+	const PVRTuint16 * indices, unsigned int triangleCount, PVRTMat4 & modelMatrix)
+{
+	PVRTMat4 MVP = this->VPMatrix * modelMatrix;
+	this->transformVertices(positions, stride, vertexCount, MVP);
+	for (unsigned int t = 0; t < triangleCount; ++t){
+		unsigned int i0 = 3 * t, i1 = 3 * t + 1, i2 = 3 * t + 2;
+		if (indices){
+			i0 = indices[i0];
+			i1 = indices[i1];
+			i2 = indices[i2];
+		}
+		if (i0 >= vertexCount || i1 >= vertexCount || i2 >= vertexCount) continue;
+		this->rasterTriangle(this->ClipVertices[i0], this->ClipVertices[i1], this->ClipVertices[i2]);
+	}
+}
+
+void mOcclusionCuller::transformVertices(const PVRTuint8 * positions, unsigned int stride, unsigned int vertexCount, PVRTMat4 & MVP_Matrix)
+{
+	this->ClipVertices.resize(vertexCount);
+	const float * m = MVP_Matrix.ptr();
+#if defined(MBOXCULLER_SSE)
+	__m128 column0 = _mm_loadu_ps(m);
+	__m128 column1 = _mm_loadu_ps(m + 4);
+	__m128 column2 = _mm_loadu_ps(m + 8);
+	__m128 column3 = _mm_loadu_ps(m + 12);
+	for (unsigned int i = 0; i < vertexCount; ++i){
+		const float * p = (const float*)(positions + i * stride);
+		__m128 clip = _mm_add_ps(_mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(p[0])), _mm_mul_ps(column1, _mm_set1_ps(p[1]))),
+			_mm_add_ps(_mm_mul_ps(column2, _mm_set1_ps(p[2])), column3));
+		_mm_storeu_ps(&this->ClipVertices[i].x, clip);
+	}
+#elif defined(MBOXCULLER_NEON)
+	float32x4_t column0 = vld1q_f32(m);
+	float32x4_t column1 = vld1q_f32(m + 4);
+	float32x4_t column2 = vld1q_f32(m + 8);
+	float32x4_t column3 = vld1q_f32(m + 12);
+	for (unsigned int i = 0; i < vertexCount; ++i){
+		const float * p = (const float*)(positions + i * stride);
+		float32x4_t clip = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(column3, column0, p[0]), column1, p[1]), column2, p[2]);
+		vst1q_f32(&this->ClipVertices[i].x, clip);
+	}
+#else
+	for (unsigned int i = 0; i < vertexCount; ++i){
+		const float * p = (const float*)(positions + i * stride);
+		PVRTVec4 & clip = this->ClipVertices[i];
+		clip.x = m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12];
+		clip.y = m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13];
+		clip.z = m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14];
+		clip.w = m[3] * p[0] + m[7] * p[1] + m[11] * p[2] + m[15];
+	}
+#endif
+}
+
+/*!****************************************************************************
+@Function		rasterTriangle
+@Description	Edge function rasterizer. A pixel is written only when the
+whole pixel is inside all three edges, and it gets the largest depth the
+triangle plane reaches over the pixel, so the buffer never holds an
+occluder nearer than it really is. SSE and NEON do 4 pixels of a row at
+once, the rows start on a multiple of 4 like the buffer width.
+******************************************************************************/
+void mOcclusionCuller::rasterTriangle(PVRTVec4 & v0, PVRTVec4 & v1, PVRTVec4 & v2)
+{
+	PVRTVec4 * v[3] = { &v0, &v1, &v2 };
+	float x[3], y[3], z[3];
+	for (int i = 0; i < 3; ++i){
+		// clipping is not needed for occluders, dropping the triangle is safe
+		if (v[i]->w <= 0.0f || v[i]->z < -v[i]->w){
+			this->TrianglesSkipped++;
+			return;
+		}
+		float invW = 1.0f / v[i]->w;
+		x[i] = (v[i]->x * invW * 0.5f + 0.5f) * this->BufferWidth;
+		y[i] = (v[i]->y * invW * 0.5f + 0.5f) * this->BufferHeight;
+		z[i] = v[i]->z * invW;
+	}
+
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (area < 0.0f){
+		swap(x[1], x[2]);
+		swap(y[1], y[2]);
+		swap(z[1], z[2]);
+		area = -area;
+	}
+	if (area < 1e-6f){
+		this->TrianglesSkipped++;
+		return;
+	}
+
+	int minX = PVRT_MAX(0, (int)floor(PVRT_MIN(x[0], PVRT_MIN(x[1], x[2]))));
+	int maxX = PVRT_MIN(this->BufferWidth - 1, (int)ceil(PVRT_MAX(x[0], PVRT_MAX(x[1], x[2]))) - 1);
+	int minY = PVRT_MAX(0, (int)floor(PVRT_MIN(y[0], PVRT_MIN(y[1], y[2]))));
+	int maxY = PVRT_MIN(this->BufferHeight - 1, (int)ceil(PVRT_MAX(y[0], PVRT_MAX(y[1], y[2]))) - 1);
+	if (minX > maxX || minY > maxY){
+		this->TrianglesSkipped++;
+		return;
+	}
+	this->TrianglesRasterized++;
+
+	// edge a->b: E = A * px + B * py + C, positive inside
+	float edgeA[3], edgeB[3], edgeC[3], edgeT[3];
+	for (int e = 0; e < 3; ++e){
+		int a = e, b = (e + 1) % 3;
+		edgeA[e] = y[a] - y[b];
+		edgeB[e] = x[b] - x[a];
+		edgeC[e] = -(edgeA[e] * x[a] + edgeB[e] * y[a]);
+		edgeT[e] = 0.5f * (fabs(edgeA[e]) + fabs(edgeB[e]));
+	}
+	float dzdx = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+	float dzdy = ((x[1] - x[0]) * (z[2] - z[0]) - (x[2] - x[0]) * (z[1] - z[0])) / area;
+	float zBias = z[0] - dzdx * x[0] - dzdy * y[0] + 0.5f * (fabs(dzdx) + fabs(dzdy));
+	float zMax = PVRT_MAX(z[0], PVRT_MAX(z[1], z[2]));
+	vector<float> & depth = this->Levels[0];
+
+#if defined(MBOXCULLER_SSE)
+	const __m128 pixelOffset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 firstCx = _mm_set1_ps(minX + 0.5f);
+	const __m128 lastCx = _mm_set1_ps(maxX + 0.5f);
+	__m128 sseA[3], sseB[3], sseC[3], sseT[3];
+	for (int e = 0; e < 3; ++e){
+		sseA[e] = _mm_set1_ps(edgeA[e]);
+		sseB[e] = _mm_set1_ps(edgeB[e]);
+		sseC[e] = _mm_set1_ps(edgeC[e]);
+		sseT[e] = _mm_set1_ps(edgeT[e]);
+	}
+	const __m128 sseDzdx = _mm_set1_ps(dzdx);
+	const __m128 sseZMax = _mm_set1_ps(zMax);
+	for (int py = minY; py <= maxY; ++py){
+		float cy = py + 0.5f;
+		__m128 rowZ = _mm_set1_ps(zBias + dzdy * cy);
+		__m128 rowE[3];
+		for (int e = 0; e < 3; ++e) rowE[e] = _mm_add_ps(_mm_mul_ps(sseB[e], _mm_set1_ps(cy)), sseC[e]);
+		float * row = &depth[py * this->BufferWidth];
+		for (int px = minX & ~3; px <= maxX; px += 4){
+			__m128 cx = _mm_add_ps(_mm_set1_ps((float)px), pixelOffset);
+			__m128 inside = _mm_and_ps(_mm_cmpge_ps(cx, firstCx), _mm_cmple_ps(cx, lastCx));
+			for (int e = 0; e < 3; ++e){
+				__m128 edge = _mm_add_ps(_mm_mul_ps(sseA[e], cx), rowE[e]);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(edge, sseT[e]));
+			}
+			if (_mm_movemask_ps(inside) == 0) continue;
+			__m128 pixelZ = _mm_min_ps(_mm_add_ps(_mm_mul_ps(sseDzdx, cx), rowZ), sseZMax);
+			__m128 old = _mm_loadu_ps(row + px);
+			__m128 nearer = _mm_min_ps(old, pixelZ);
+			_mm_storeu_ps(row + px, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+		}
+	}
+#elif defined(MBOXCULLER_NEON)
+	const float pixelOffsets[4] = { 0.5f, 1.5f, 2.5f, 3.5f };
+	const float32x4_t pixelOffset = vld1q_f32(pixelOffsets);
+	const float32x4_t firstCx = vdupq_n_f32(minX + 0.5f);
+	const float32x4_t lastCx = vdupq_n_f32(maxX + 0.5f);
+	float32x4_t neonT[3];
+	for (int e = 0; e < 3; ++e) neonT[e] = vdupq_n_f32(edgeT[e]);
+	const float32x4_t neonZMax = vdupq_n_f32(zMax);
+	for (int py = minY; py <= maxY; ++py){
+		float cy = py + 0.5f;
+		float32x4_t rowZ = vdupq_n_f32(zBias + dzdy * cy);
+		float32x4_t rowE[3];
+		for (int e = 0; e < 3; ++e) rowE[e] = vdupq_n_f32(edgeB[e] * cy + edgeC[e]);
+		float * row = &depth[py * this->BufferWidth];
+		for (int px = minX & ~3; px <= maxX; px += 4){
+			float32x4_t cx = vaddq_f32(vdupq_n_f32((float)px), pixelOffset);
+			uint32x4_t inside = vandq_u32(vcgeq_f32(cx, firstCx), vcleq_f32(cx, lastCx));
+			for (int e = 0; e < 3; ++e){
+				float32x4_t edge = vmlaq_n_f32(rowE[e], cx, edgeA[e]);
+				inside = vandq_u32(inside, vcgeq_f32(edge, neonT[e]));
+			}
+			uint32x2_t any = vorr_u32(vget_low_u32(inside), vget_high_u32(inside));
+			if ((vget_lane_u32(any, 0) | vget_lane_u32(any, 1)) == 0) continue;
+			float32x4_t pixelZ = vminq_f32(vmlaq_n_f32(rowZ, cx, dzdx), neonZMax);
+			float32x4_t old = vld1q_f32(row + px);
+			vst1q_f32(row + px, vbslq_f32(inside, vminq_f32(old, pixelZ), old));
+		}
+	}
+#else
+	for (int py = minY; py <= maxY; ++py){
+		float cy = py + 0.5f;
+		float * row = &depth[py * this->BufferWidth];
+		for (int px = minX; px <= maxX; ++px){
+			float cx = px + 0.5f;
+			bool inside = true;
+			for (int e = 0; e < 3 && inside; ++e){
+				inside = edgeA[e] * cx + edgeB[e] * cy + edgeC[e] >= edgeT[e];
+			}
+			if (!inside) continue;
+			float pixelZ = PVRT_MIN(zBias + dzdx * cx + dzdy * cy, zMax);
+			row[px] = PVRT_MIN(row[px], pixelZ);
+		}
+	}
+#endif
+}
+
+void mOcclusionCuller::End()
+{
+	this->buildPyramid();
+	this->Ready = true;
+}
+
+void mOcclusionCuller::buildPyramid()
+{
+	for (unsigned int level = 1; level < this->Levels.size(); ++level){
+		vector<float> & src = this->Levels[level - 1];
+		vector<float> & dst = this->Levels[level];
+		int srcW = this->LevelWidth[level - 1], srcH = this->LevelHeight[level - 1];
+		int dstW = this->LevelWidth[level], dstH = this->LevelHeight[level];
+		for (int ty = 0; ty < dstH; ++ty){
+			int y0 = 2 * ty, y1 = PVRT_MIN(2 * ty + 1, srcH - 1);
+			for (int tx = 0; tx < dstW; ++tx){
+				int x0 = 2 * tx, x1 = PVRT_MIN(2 * tx + 1, srcW - 1);
+				float farthest = PVRT_MAX(PVRT_MAX(src[y0 * srcW + x0], src[y0 * srcW + x1]),
+					PVRT_MAX(src[y1 * srcW + x0], src[y1 * srcW + x1]));
+				dst[ty * dstW + tx] = farthest;
+			}
+		}
+	}
+}
+
+/*!****************************************************************************
+@Function		IsOccluded
+@Input			boxMin		world space AABB
+@Input			boxMax
+@Return		bool		true when the box is hidden behind the occluders
+@Description	Projects the 8 corners, picks the pyramid level where the screen
+rectangle covers at most 4x4 texels and compares the nearest box depth
+with the farthest occluder depth of those texels. Boxes crossing the
+near plane or entirely off screen are never reported occluded.
+******************************************************************************/
+bool mOcclusionCuller::IsOccluded(PVRTVec3 boxMin, PVRTVec3 boxMax)
+{
+	this->BoxesTested++;
+	if (!this->Ready) return false;
+
+	// one full transform, the other corners add the scaled matrix columns
+	const float * m = this->VPMatrix.ptr();
+	float base[4], edgeX[4], edgeY[4], edgeZ[4];
+	for (int r = 0; r < 4; ++r){
+		base[r] = m[r] * boxMin.x + m[4 + r] * boxMin.y + m[8 + r] * boxMin.z + m[12 + r];
+		edgeX[r] = m[r] * (boxMax.x - boxMin.x);
+		edgeY[r] = m[4 + r] * (boxMax.y - boxMin.y);
+		edgeZ[r] = m[8 + r] * (boxMax.z - boxMin.z);
+	}
+
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, minZ = FLT_MAX;
+	for (int i = 0; i < 8; ++i){
+		PVRTVec4 clip(base[0], base[1], base[2], base[3]);
+		if (i & 1){ clip.x += edgeX[0]; clip.y += edgeX[1]; clip.z += edgeX[2]; clip.w += edgeX[3]; }
+		if (i & 2){ clip.x += edgeY[0]; clip.y += edgeY[1]; clip.z += edgeY[2]; clip.w += edgeY[3]; }
+		if (i & 4){ clip.x += edgeZ[0]; clip.y += edgeZ[1]; clip.z += edgeZ[2]; clip.w += edgeZ[3]; }
+		if (clip.w <= 0.0f || clip.z < -clip.w) return false;
+		float invW = 1.0f / clip.w;
+		float sx = (clip.x * invW * 0.5f + 0.5f) * this->BufferWidth;
+		float sy = (clip.y * invW * 0.5f + 0.5f) * this->BufferHeight;
+		minX = PVRT_MIN(minX, sx);
+		maxX = PVRT_MAX(maxX, sx);
+		minY = PVRT_MIN(minY, sy);
+		maxY = PVRT_MAX(maxY, sy);
+		minZ = PVRT_MIN(minZ, clip.z * invW);
+	}
+
+	int x0 = PVRT_MAX(0, (int)floor(minX));
+	int x1 = PVRT_MIN(this->BufferWidth - 1, (int)floor(maxX));
+	int y0 = PVRT_MAX(0, (int)floor(minY));
+	int y1 = PVRT_MIN(this->BufferHeight - 1, (int)floor(maxY));
+	if (x0 > x1 || y0 > y1) return false;
+
+	unsigned int level = 0;
+	while (level + 1 < this->Levels.size() && ((x1 >> level) - (x0 >> level) > 3 || (y1 >> level) - (y0 >> level) > 3)) level++;
+
+	vector<float> & depth = this->Levels[level];
+	int levelWidth = this->LevelWidth[level];
+	for (int ty = y0 >> level; ty <= (y1 >> level); ++ty){
+		for (int tx = x0 >> level; tx <= (x1 >> level); ++tx){
+			if (depth[ty * levelWidth + tx] >= minZ) return false;
+		}
+	}
+	this->BoxesOccluded++;
+	return true;
+}
+
+bool mOcclusionCuller::IsOccluded(mModel * model)
+{
+	PVRTVec3 boxMin, boxMax;
+	model->SurrondBox.GetBoxWorld(boxMin, boxMax);
+	return this->IsOccluded(boxMin, boxMax);
+}
+
+bool mOcclusionCuller::IsReady()
+{
+	return this->Ready;
+}
+
+int mOcclusionCuller::Width()
+{
+	return this->BufferWidth;
+}
+
+int mOcclusionCuller::Height()
+{
+	return this->BufferHeight;
+}
+
+float mOcclusionCuller::DepthAt(int x, int y)
+{
+	return this->Levels[0][y * this->BufferWidth + x];
+}
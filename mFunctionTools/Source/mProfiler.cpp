@@ -0,0 +1,268 @@
+#include "..\Include\mProfiler.h"
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static double ElapsedMs(chrono::steady_clock::time_point from, chrono::steady_clock::time_point to)
+{
+	return chrono::duration<double, milli>(to - from).count();
+}
+
+// sorted ascending, p 0..1, nearest rank
+static float Percentile(const vector<float> & sorted, unsigned int count, float p)
+{
+	unsigned int rank = (unsigned int)ceil(p * count);
+	return sorted[PVRT_MIN(PVRT_MAX(rank, 1u), count) - 1];
+}
+
+void mSampleRing::Init(unsigned int capacity)
+{
+	this->Samples.assign(PVRT_MAX(capacity, 1u), 0.0f);
+	this->Sorted.reserve(this->Samples.size());
+	this->Head = this->Count = 0;
+}
+
+void mSampleRing::Clear()
+{
+	this->Head = this->Count = 0;
+}
+
+void mSampleRing::Push(float sample)
+{
+	if (this->Samples.empty()) return;
+	this->Samples[this->Head] = sample;
+	this->Head = (this->Head + 1) % this->Samples.size();
+	if (this->Count < this->Samples.size()) this->Count++;
+}
+
+float mSampleRing::Latest() const
+{
+	return this->At(0);
+}
+
+float mSampleRing::At(unsigned int age) const
+{
+	if (age >= this->Count) return 0.0f;
+	unsigned int capacity = (unsigned int)this->Samples.size();
+	return this->Samples[(this->Head + capacity - 1 - age) % capacity];
+}
+
+/*!****************************************************************************
+@Function		Stats
+@Return		mSampleStats		all zero for an empty ring
+@Description	Sorts a copy of the samples, percentiles are nearest rank.
+******************************************************************************/
+mSampleStats mSampleRing::Stats() const
+{
+	mSampleStats stats;
+	if (this->Count == 0) return stats;
+
+	this->Sorted.assign(this->Samples.begin(), this->Samples.begin() + this->Count);
+	sort(this->Sorted.begin(), this->Sorted.end());
+	double sum = 0.0;
+	for (unsigned int i = 0; i < this->Count; ++i) sum += this->Sorted[i];
+
+	stats.Count = this->Count;
+	stats.Min = this->Sorted.front();
+	stats.Max = this->Sorted.back();
+	stats.Avg = (float)(sum / this->Count);
+	stats.P50 = Percentile(this->Sorted, this->Count, 0.50f);
+	stats.P95 = Percentile(this->Sorted, this->Count, 0.95f);
+	stats.P99 = Percentile(this->Sorted, this->Count, 0.99f);
+	return stats;
+}
+
+mProfiler::mProfiler()
+{
+}
+
+mProfiler::~mProfiler()
+{
+}
+
+/*!****************************************************************************
+@Function		Init
+@Input			extensions		loaded extensions, 0 for CPU timers only
+@Input			history		frames each ring keeps
+@Description	Forgets the sections and samples of a previous Init. Call
+Release before the context goes away.
+******************************************************************************/
+void mProfiler::Init(const CPVRTgles2Ext * extensions, unsigned int history)
+{
+	this->Release();
+	this->Extensions = extensions;
+	this->History = history;
+	this->Sections.clear();
+	this->FrameMs.Init(history);
+	this->Frames = 0;
+	this->GpuDisjoints = 0;
+	this->FrameStart = chrono::steady_clock::now();
+}
+
+/*!****************************************************************************
+@Function		Release
+@Description	Deletes the GPU queries, the samples stay readable.
+******************************************************************************/
+void mProfiler::Release()
+{
+	if (this->OpenGpuSection >= 0) this->Extensions->glEndQueryEXT(GL_TIME_ELAPSED_EXT);
+	this->OpenGpuSection = -1;
+	for (unsigned int i = 0; i < this->Sections.size(); ++i){
+		mProfilerSection & section = this->Sections[i];
+		if (section.Gpu) this->Extensions->glDeleteQueriesEXT(c_iProfilerGpuLatency, section.Queries);
+		memset(section.Queries, 0, sizeof(section.Queries));
+		memset(section.Pending, 0, sizeof(section.Pending));
+		section.Gpu = false;
+	}
+}
+
+/*!****************************************************************************
+@Function		AddSection
+@Input			name		shown in the overlay and the report
+@Input			gpu		also time the section on the GPU when possible
+@Return		int		id for BeginSection and EndSection
+******************************************************************************/
+int mProfiler::AddSection(const char * name, bool gpu)
+{
+	mProfilerSection section;
+	section.Name = name;
+	section.Gpu = gpu && this->HasGpuTimers();
+	section.CpuMs.Init(this->History);
+	section.GpuMs.Init(this->History);
+	memset(section.Queries, 0, sizeof(section.Queries));
+	memset(section.Pending, 0, sizeof(section.Pending));
+	if (section.Gpu) this->Extensions->glGenQueriesEXT(c_iProfilerGpuLatency, section.Queries);
+	this->Sections.push_back(section);
+	return (int)this->Sections.size() - 1;
+}
+
+bool mProfiler::HasGpuTimers() const
+{
+	return this->Extensions && this->Extensions->glGetQueryObjectui64vEXT && this->Extensions->glBeginQueryEXT;
+}
+
+/*!****************************************************************************
+@Function		BeginFrame
+@Description	Ends the previous frame: pushes its frame time and the CPU
+time of every section, then collects the GPU results that are ready.
+******************************************************************************/
+void mProfiler::BeginFrame()
+{
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	if (this->Frames > 0){
+		this->FrameMs.Push((float)ElapsedMs(this->FrameStart, now));
+		for (unsigned int i = 0; i < this->Sections.size(); ++i){
+			mProfilerSection & section = this->Sections[i];
+			section.CpuMs.Push((float)section.FrameMs);
+			section.FrameMs = 0.0;
+			section.Runs = 0;
+		}
+	}
+
+	if (this->HasGpuTimers()){
+		// reading the flag also clears it
+		GLint disjoint = 0;
+		glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+		this->ReadGpuResults(disjoint != 0);
+	}
+
+	this->Frames++;
+	this->FrameStart = now;
+}
+
+void mProfiler::ReadGpuResults(bool disjoint)
+{
+	bool dropped = false;
+	for (unsigned int i = 0; i < this->Sections.size(); ++i){
+		mProfilerSection & section = this->Sections[i];
+		if (!section.Gpu) continue;
+		for (int slot = 0; slot < c_iProfilerGpuLatency; ++slot){
+			if (!section.Pending[slot]) continue;
+			GLuint available = 0;
+			this->Extensions->glGetQueryObjectuivEXT(section.Queries[slot], GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+			if (!available) continue;
+			section.Pending[slot] = false;
+			if (disjoint){
+				dropped = true;
+				continue;
+			}
+			GLuint64 ns = 0;
+			this->Extensions->glGetQueryObjectui64vEXT(section.Queries[slot], GL_QUERY_RESULT_EXT, &ns);
+			section.GpuMs.Push((float)(ns * 1.0e-6));
+		}
+	}
+	if (dropped) this->GpuDisjoints++;
+}
+
+/*!****************************************************************************
+@Function		BeginSection
+@Input			section		id from AddSection
+@Description	Starts the CPU timer, and the GPU timer on the section's first
+run of the frame when no other GPU section is open and the query slot of
+this frame has been read.
+******************************************************************************/
+void mProfiler::BeginSection(int section)
+{
+	mProfilerSection & s = this->Sections[section];
+	s.Open = true;
+	s.Runs++;
+	if (s.Gpu && s.Runs == 1 && this->OpenGpuSection < 0){
+		int slot = this->Frames % c_iProfilerGpuLatency;
+		if (!s.Pending[slot]){
+			this->Extensions->glBeginQueryEXT(GL_TIME_ELAPSED_EXT, s.Queries[slot]);
+			this->OpenGpuSection = section;
+		}
+	}
+	s.Start = chrono::steady_clock::now();
+}
+
+void mProfiler::EndSection(int section)
+{
+	mProfilerSection & s = this->Sections[section];
+	if (!s.Open) return;
+	s.FrameMs += ElapsedMs(s.Start, chrono::steady_clock::now());
+	s.Open = false;
+	if (this->OpenGpuSection == section){
+		this->Extensions->glEndQueryEXT(GL_TIME_ELAPSED_EXT);
+		s.Pending[this->Frames % c_iProfilerGpuLatency] = true;
+		this->OpenGpuSection = -1;
+	}
+}
+
+/*!****************************************************************************
+@Function		WriteReport
+@Input			path		text file, overwritten
+@Return		bool		false if the file cannot be written
+@Description	Statistics of every series in milliseconds, then the frame
+and section CPU times of the frames in the rings, oldest first, as CSV.
+******************************************************************************/
+bool mProfiler::WriteReport(const char * path) const
+{
+	FILE * file = fopen(path, "w");
+	if (file == NULL) return false;
+
+	fprintf(file, "# frames %u, gpu timers %s, gpu disjoint frames %u\n", this->Frames, this->HasGpuTimers() ? "yes" : "no", this->GpuDisjoints);
+	fprintf(file, "series,count,min_ms,avg_ms,p50_ms,p95_ms,p99_ms,max_ms\n");
+	mSampleStats stats = this->FrameMs.Stats();
+	fprintf(file, "frame,%u,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", stats.Count, stats.Min, stats.Avg, stats.P50, stats.P95, stats.P99, stats.Max);
+	for (unsigned int i = 0; i < this->Sections.size(); ++i){
+		const mProfilerSection & section = this->Sections[i];
+		stats = section.CpuMs.Stats();
+		fprintf(file, "cpu.%s,%u,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", section.Name.c_str(), stats.Count, stats.Min, stats.Avg, stats.P50, stats.P95, stats.P99, stats.Max);
+		if (!section.GpuMs.Count) continue;
+		stats = section.GpuMs.Stats();
+		fprintf(file, "gpu.%s,%u,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", section.Name.c_str(), stats.Count, stats.Min, stats.Avg, stats.P50, stats.P95, stats.P99, stats.Max);
+	}
+
+	fprintf(file, "\nframe_ms");
+	for (unsigned int i = 0; i < this->Sections.size(); ++i) fprintf(file, ",%s_ms", this->Sections[i].Name.c_str());
+	fprintf(file, "\n");
+	for (unsigned int age = this->FrameMs.Count; age-- > 0;){
+		fprintf(file, "%.4f", this->FrameMs.At(age));
+		for (unsigned int i = 0; i < this->Sections.size(); ++i) fprintf(file, ",%.4f", this->Sections[i].CpuMs.At(age));
+		fprintf(file, "\n");
+	}
+	fclose(file);
+	return true;
+}
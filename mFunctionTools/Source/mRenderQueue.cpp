@@ -0,0 +1,227 @@
+#include "..\Include\mRenderQueue.h"
+#include <string.h>
+
+const int c_iRenderKeyDigits = 8;				// radix sort passes of one byte
+
+const PVRTuint64 c_uiDepthMask = (1ull << c_iRenderKeyDepthBits) - 1;
+const PVRTuint64 c_uiMeshMask = (1ull << c_iRenderKeyMeshBits) - 1;
+const PVRTuint64 c_uiTextureMask = (1ull << c_iRenderKeyTextureBits) - 1;
+const PVRTuint64 c_uiProgramMask = (1ull << c_iRenderKeyProgramBits) - 1;
+const PVRTuint64 c_uiPassMask = (1ull << c_iRenderKeyPassBits) - 1;
+
+// state fields are packed the same way in both layouts, only their offset differs
+const int c_iMeshShift = 0;
+const int c_iTextureShift = c_iMeshShift + c_iRenderKeyMeshBits;
+const int c_iProgramShift = c_iTextureShift + c_iRenderKeyTextureBits;
+const int c_iStateBits = c_iProgramShift + c_iRenderKeyProgramBits;
+const int c_iPassShift = 64 - c_iRenderKeyPassBits;
+
+mRenderQueue::mRenderQueue()
+{
+}
+
+mRenderQueue::~mRenderQueue()
+{
+}
+
+void mRenderQueue::SetPassBlended(int pass, bool blended)
+{
+	if (pass < 0 || pass > (int)c_uiPassMask) return;
+	if ((int)this->PassBlended.size() <= pass) this->PassBlended.resize(pass + 1, false);
+	this->PassBlended[pass] = blended;
+}
+
+void mRenderQueue::SetDepthRange(float nearDepth, float farDepth)
+{
+	this->NearDepth = nearDepth;
+	this->FarDepth = farDepth > nearDepth ? farDepth : nearDepth + 1.0f;
+}
+
+/*!****************************************************************************
+@Function		MakeKey
+@Input			pass			draw pass, passes are executed in increasing order
+@Input			program			shader program id
+@Input			textureSet		texture set id
+@Input			mesh			vertex and index buffer id
+@Input			depth			view distance, quantized between the depth range
+@Return		PVRTuint64		sort key, ids are masked to their field size
+******************************************************************************/
+PVRTuint64 mRenderQueue::MakeKey(int pass, int program, int textureSet, int mesh, float depth)
+{
+	float t = (depth - this->NearDepth) / (this->FarDepth - this->NearDepth);
+	t = PVRT_CLAMP(t, 0.0f, 1.0f);
+	PVRTuint64 depthBits = (PVRTuint64)(t * (float)c_uiDepthMask) & c_uiDepthMask;
+
+	PVRTuint64 state = (((PVRTuint64)program & c_uiProgramMask) << c_iProgramShift)
+		| (((PVRTuint64)textureSet & c_uiTextureMask) << c_iTextureShift)
+		| (((PVRTuint64)mesh & c_uiMeshMask) << c_iMeshShift);
+	PVRTuint64 key = ((PVRTuint64)pass & c_uiPassMask) << c_iPassShift;
+
+	bool blended = pass >= 0 && pass < (int)this->PassBlended.size() && this->PassBlended[pass];
+	if (blended){
+		key |= ((c_uiDepthMask - depthBits) << c_iStateBits) | state;
+	}
+	else{
+		key |= (state << c_iRenderKeyDepthBits) | depthBits;
+	}
+	return key;
+}
+
+void mRenderQueue::Submit(int pass, int program, int textureSet, int mesh, float depth, PVRTuint32 item)
+{
+	mRenderItem renderItem;
+	renderItem.Key = this->MakeKey(pass, program, textureSet, mesh, depth);
+	renderItem.Item = item;
+	this->Items.push_back(renderItem);
+}
+
+int mRenderQueue::KeyPass(PVRTuint64 key)
+{
+	return (int)(key >> c_iPassShift);
+}
+
+bool mRenderQueue::KeyBlended(PVRTuint64 key)
+{
+	int pass = KeyPass(key);
+	return pass < (int)this->PassBlended.size() && this->PassBlended[pass];
+}
+
+PVRTuint64 mRenderQueue::stateBits(PVRTuint64 key)
+{
+	return this->KeyBlended(key) ? key : key >> c_iRenderKeyDepthBits;
+}
+
+int mRenderQueue::KeyProgram(PVRTuint64 key)
+{
+	return (int)((this->stateBits(key) >> c_iProgramShift) & c_uiProgramMask);
+}
+
+int mRenderQueue::KeyTextureSet(PVRTuint64 key)
+{
+	return (int)((this->stateBits(key) >> c_iTextureShift) & c_uiTextureMask);
+}
+
+int mRenderQueue::KeyMesh(PVRTuint64 key)
+{
+	return (int)((this->stateBits(key) >> c_iMeshShift) & c_uiMeshMask);
+}
+
+/*!****************************************************************************
+@Function		countBinds
+@Return		unsigned int		state changes walking Items would issue
+******************************************************************************/
+unsigned int mRenderQueue::countBinds()
+{
+	unsigned int binds = 0;
+	for (unsigned int i = 0; i < this->Items.size(); ++i){
+		PVRTuint64 key = this->Items[i].Key;
+		if (i == 0){
+			binds += 4;
+			continue;
+		}
+		PVRTuint64 previous = this->Items[i - 1].Key;
+		if (KeyPass(key) != KeyPass(previous)) binds++;
+		if (this->KeyProgram(key) != this->KeyProgram(previous)) binds++;
+		if (this->KeyTextureSet(key) != this->KeyTextureSet(previous)) binds++;
+		if (this->KeyMesh(key) != this->KeyMesh(previous)) binds++;
+	}
+	return binds;
+}
+
+/*!****************************************************************************
+@Function		Sort
+@Description	Stable LSD radix sort of Items on the whole key, one byte per
+pass. All byte histograms are built in one sweep first, and bytes that are
+the same in every key are skipped.
+******************************************************************************/
+void mRenderQueue::Sort()
+{
+	unsigned int count = (unsigned int)this->Items.size();
+	this->Stats.Items = count;
+	this->Stats.UnsortedBinds = this->countBinds();
+	this->Stats.NaiveBinds = count * 4;
+	this->Stats.SortPasses = 0;
+	if (count < 2) return;
+
+	unsigned int histograms[c_iRenderKeyDigits][256];
+	memset(histograms, 0, sizeof(histograms));
+	for (unsigned int i = 0; i < count; ++i){
+		PVRTuint64 key = this->Items[i].Key;
+		for (int d = 0; d < c_iRenderKeyDigits; ++d){
+			histograms[d][(key >> (d * 8)) & 0xFF]++;
+		}
+	}
+
+	this->Scratch.resize(count);
+	mRenderItem * source = &this->Items[0];
+	mRenderItem * target = &this->Scratch[0];
+	for (int d = 0; d < c_iRenderKeyDigits; ++d){
+		unsigned int * histogram = histograms[d];
+		if (histogram[(source[0].Key >> (d * 8)) & 0xFF] == count) continue;
+
+		unsigned int offset = 0;
+		for (int b = 0; b < 256; ++b){
+			unsigned int size = histogram[b];
+			histogram[b] = offset;
+			offset += size;
+		}
+		for (unsigned int i = 0; i < count; ++i){
+			target[histogram[(source[i].Key >> (d * 8)) & 0xFF]++] = source[i];
+		}
+		mRenderItem * swap = source;
+		source = target;
+		target = swap;
+		this->Stats.SortPasses++;
+	}
+	if (source != &this->Items[0]) this->Items.swap(this->Scratch);
+}
+
+/*!****************************************************************************
+@Function		Execute
+@Input			binder		state and draw functions of the caller
+@Description	Walks the sorted Items. A pass change rebinds the pass only,
+program, textures and mesh stay bound across passes when they match.
+******************************************************************************/
+void mRenderQueue::Execute(const mRenderBinder & binder)
+{
+	this->Stats.Binds = 0;
+	int pass = -1, program = -1, textureSet = -1, mesh = -1;
+	for (unsigned int i = 0; i < this->Items.size(); ++i){
+		PVRTuint64 key = this->Items[i].Key;
+		int itemPass = KeyPass(key);
+		int itemProgram = this->KeyProgram(key);
+		int itemTextureSet = this->KeyTextureSet(key);
+		int itemMesh = this->KeyMesh(key);
+		if (itemPass != pass){
+			pass = itemPass;
+			if (binder.BindPass) binder.BindPass(pass);
+			this->Stats.Binds++;
+		}
+		if (itemProgram != program){
+			program = itemProgram;
+			if (binder.BindProgram) binder.BindProgram(program);
+			this->Stats.Binds++;
+		}
+		if (itemTextureSet != textureSet){
+			textureSet = itemTextureSet;
+			if (binder.BindTextures) binder.BindTextures(textureSet);
+			this->Stats.Binds++;
+		}
+		if (itemMesh != mesh){
+			mesh = itemMesh;
+			if (binder.BindMesh) binder.BindMesh(mesh);
+			this->Stats.Binds++;
+		}
+		binder.Draw(this->Items[i].Item);
+	}
+}
+
+void mRenderQueue::Clear()
+{
+	this->Items.clear();
+}
+
+unsigned int mRenderQueue::size()
+{
+	return (unsigned int)this->Items.size();
+}
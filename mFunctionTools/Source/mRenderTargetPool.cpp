@@ -0,0 +1,251 @@
+#include "..\Include\mRenderTargetPool.h"
+#include <math.h>
+
+// Bytes per pixel as allocated, drivers keep 24 bit formats in 32 bits
+static unsigned int ColorPixelBytes(GLenum format, GLenum type)
+{
+	if (type == GL_UNSIGNED_SHORT_5_6_5 || type == GL_UNSIGNED_SHORT_4_4_4_4 || type == GL_UNSIGNED_SHORT_5_5_5_1) return 2;
+	switch (format)
+	{
+	case GL_ALPHA:
+	case GL_LUMINANCE: return 1;
+	case GL_LUMINANCE_ALPHA: return 2;
+	default: return 4;
+	}
+}
+
+static unsigned int DepthPixelBytes(GLenum format)
+{
+	return format == GL_DEPTH_COMPONENT16 ? 2 : 4;
+}
+
+bool mRenderTargetDesc::operator==(const mRenderTargetDesc & other) const
+{
+	return this->Width == other.Width && this->Height == other.Height && this->Format == other.Format &&
+		this->Type == other.Type && this->DepthFormat == other.DepthFormat;
+}
+
+mRenderTargetPool::mRenderTargetPool()
+{
+}
+
+mRenderTargetPool::~mRenderTargetPool()
+{
+}
+
+void mRenderTargetPool::Init(GLsizei screenWidth, GLsizei screenHeight)
+{
+	this->Destroy();
+	this->ScreenWidth = screenWidth;
+	this->ScreenHeight = screenHeight;
+	this->Created = this->Reused = 0;
+}
+
+/*!****************************************************************************
+@Function		ScaledDesc
+@Input			scale		of the screen size, 0.5 for half resolution
+@Return		mRenderTargetDesc		at least one pixel wide and high
+******************************************************************************/
+mRenderTargetDesc mRenderTargetPool::ScaledDesc(float scale, GLenum format, GLenum type, GLenum depthFormat) const
+{
+	mRenderTargetDesc desc;
+	desc.Width = PVRT_MAX((GLsizei)floor(this->ScreenWidth * scale + 0.5f), 1);
+	desc.Height = PVRT_MAX((GLsizei)floor(this->ScreenHeight * scale + 0.5f), 1);
+	desc.Format = format;
+	desc.Type = type;
+	desc.DepthFormat = depthFormat;
+	return desc;
+}
+
+/*!****************************************************************************
+@Function		Acquire
+@Input			desc		size and formats
+@Return		int			index in Targets, -1 when the framebuffer is not
+complete with these formats
+@Description	Returns a released target of the same desc, or creates one.
+The target's texture contents are undefined.
+******************************************************************************/
+int mRenderTargetPool::Acquire(const mRenderTargetDesc & desc)
+{
+	for (unsigned int i = 0; i < this->Targets.size(); ++i){
+		mRenderTarget & target = this->Targets[i];
+		if (!target.InUse && target.FBO && target.Desc == desc){
+			target.InUse = true;
+			this->Reused++;
+			return (int)i;
+		}
+	}
+
+	GLint previousFBO = 0, previousTexture = 0, previousRenderbuffer = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFBO);
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+	glGetIntegerv(GL_RENDERBUFFER_BINDING, &previousRenderbuffer);
+
+	mRenderTarget target;
+	target.Desc = desc;
+	glGenTextures(1, &target.Texture);
+	glBindTexture(GL_TEXTURE_2D, target.Texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, desc.Format, desc.Width, desc.Height, 0, desc.Format, desc.Type, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	target.Bytes = desc.Width * desc.Height * ColorPixelBytes(desc.Format, desc.Type);
+
+	glGenFramebuffers(1, &target.FBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, target.FBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.Texture, 0);
+	if (desc.DepthFormat){
+		target.Depth = this->AcquireDepth(desc);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, this->Depths[target.Depth].Renderbuffer);
+	}
+	bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFBO);
+	glBindTexture(GL_TEXTURE_2D, previousTexture);
+	glBindRenderbuffer(GL_RENDERBUFFER, previousRenderbuffer);
+
+	if (!complete){
+		this->DeleteTarget(target);
+		return -1;
+	}
+
+	target.InUse = true;
+	this->Created++;
+	// reuse the slot of a deleted target
+	for (unsigned int i = 0; i < this->Targets.size(); ++i){
+		if (this->Targets[i].FBO == 0){
+			this->Targets[i] = target;
+			return (int)i;
+		}
+	}
+	this->Targets.push_back(target);
+	return (int)this->Targets.size() - 1;
+}
+
+int mRenderTargetPool::AcquireDepth(const mRenderTargetDesc & desc)
+{
+	int freeSlot = -1;
+	for (unsigned int i = 0; i < this->Depths.size(); ++i){
+		mRenderTargetDepth & depth = this->Depths[i];
+		if (depth.Renderbuffer && depth.Width == desc.Width && depth.Height == desc.Height && depth.Format == desc.DepthFormat){
+			depth.Users++;
+			return (int)i;
+		}
+		if (!depth.Renderbuffer && freeSlot < 0) freeSlot = (int)i;
+	}
+
+	mRenderTargetDepth depth;
+	depth.Width = desc.Width;
+	depth.Height = desc.Height;
+	depth.Format = desc.DepthFormat;
+	depth.Users = 1;
+	depth.Bytes = desc.Width * desc.Height * DepthPixelBytes(desc.DepthFormat);
+	glGenRenderbuffers(1, &depth.Renderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depth.Renderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, desc.DepthFormat, desc.Width, desc.Height);
+
+	if (freeSlot >= 0){
+		this->Depths[freeSlot] = depth;
+		return freeSlot;
+	}
+	this->Depths.push_back(depth);
+	return (int)this->Depths.size() - 1;
+}
+
+/*!****************************************************************************
+@Function		Release
+@Input			target		index from Acquire, -1 is ignored
+@Description	Keeps the target for the next Acquire of its desc.
+******************************************************************************/
+void mRenderTargetPool::Release(int target)
+{
+	if (target < 0 || target >= (int)this->Targets.size()) return;
+	this->Targets[target].InUse = false;
+}
+
+/*!****************************************************************************
+@Function		ReleaseUnused
+@Description	Deletes the released targets and the depth buffers nobody
+uses any more.
+******************************************************************************/
+void mRenderTargetPool::ReleaseUnused()
+{
+	for (unsigned int i = 0; i < this->Targets.size(); ++i){
+		if (!this->Targets[i].InUse && this->Targets[i].FBO) this->DeleteTarget(this->Targets[i]);
+	}
+}
+
+void mRenderTargetPool::DeleteTarget(mRenderTarget & target)
+{
+	if (target.FBO) glDeleteFramebuffers(1, &target.FBO);
+	if (target.Texture) glDeleteTextures(1, &target.Texture);
+	if (target.Depth >= 0){
+		mRenderTargetDepth & depth = this->Depths[target.Depth];
+		if (--depth.Users == 0){
+			glDeleteRenderbuffers(1, &depth.Renderbuffer);
+			depth = mRenderTargetDepth();
+		}
+	}
+	target = mRenderTarget();
+}
+
+void mRenderTargetPool::Destroy()
+{
+	for (unsigned int i = 0; i < this->Targets.size(); ++i){
+		if (this->Targets[i].FBO) this->DeleteTarget(this->Targets[i]);
+	}
+	this->Targets.clear();
+	this->Depths.clear();
+}
+
+/*!****************************************************************************
+@Function		GetStats
+@Description	GPU memory held by the pool, in use or released.
+******************************************************************************/
+mRenderTargetStats mRenderTargetPool::GetStats() const
+{
+	mRenderTargetStats stats;
+	for (unsigned int i = 0; i < this->Targets.size(); ++i){
+		const mRenderTarget & target = this->Targets[i];
+		if (!target.FBO) continue;
+		stats.Targets++;
+		if (target.InUse) stats.TargetsInUse++;
+		stats.TextureBytes += target.Bytes;
+	}
+	for (unsigned int i = 0; i < this->Depths.size(); ++i){
+		if (!this->Depths[i].Renderbuffer) continue;
+		stats.DepthBuffers++;
+		stats.DepthBytes += this->Depths[i].Bytes;
+	}
+	stats.Created = this->Created;
+	stats.Reused = this->Reused;
+	return stats;
+}
+
+bool mRenderTargetPolicy::NeedsUpdate(unsigned int frame, PVRTVec3 position, PVRTVec3 forward) const
+{
+	if (!this->Valid) return true;
+	if (frame - this->LastFrame < PVRT_MAX(this->Interval, 1u)) return false;
+	if (this->MoveThreshold <= 0.0f && this->TurnThreshold <= 0.0f) return true;
+	if (this->MoveThreshold > 0.0f && (position - this->LastPosition).lenSqr() > this->MoveThreshold * this->MoveThreshold) return true;
+	if (this->TurnThreshold > 0.0f){
+		float cosTurn = forward.normalized().dot(this->LastForward);
+		if (cosTurn < cos(this->TurnThreshold * PVRT_PI / 180.0f)) return true;
+	}
+	return false;
+}
+
+void mRenderTargetPolicy::Updated(unsigned int frame, PVRTVec3 position, PVRTVec3 forward)
+{
+	this->Valid = true;
+	this->LastFrame = frame;
+	this->LastPosition = position;
+	this->LastForward = forward.normalized();
+	this->Updates++;
+}
+
+void mRenderTargetPolicy::Invalidate()
+{
+	this->Valid = false;
+}
@@ -29,6 +29,22 @@ mSceneManager::mSceneManager(int depth, float Xmin, float Xmax, float Ymin, floa
 void mSceneManager::addModel(mModel * model)
 {
 	this->ModelInScene.push_back(model);
+	if (this->IndexMode == SceneIndexLoose) this->LooseQuadTree.insertModel(model);
+}
+
+/*!****************************************************************************
+@Function		removeModel
+@Input			model		model added with addModel
+@Description	Only the loose quadtree forgets the model right away, the other
+modes need makeQuadTree, makeLinearQuadTree or makeBVH again.
+******************************************************************************/
+void mSceneManager::removeModel(mModel * model)
+{
+	vector<mModel*>::iterator it = find(this->ModelInScene.begin(), this->ModelInScene.end(), model);
+	if (it == this->ModelInScene.end()) return;
+	*it = this->ModelInScene.back();
+	this->ModelInScene.pop_back();
+	this->LooseQuadTree.removeModel(model);
 }
 
 void mSceneManager::makeQuadTree()
@@ -36,6 +52,54 @@ void mSceneManager::makeQuadTree()
 	makeQuadNode(this->QuadNodeHead, this->ModelInScene);
 }
 
+/*!****************************************************************************
+@Function		makeLinearQuadTree
+@Description	Builds the pointer-free tree over ModelInScene with the same
+bounds and depth as the QuadNode tree and routes ModelsNeedRender to it.
+******************************************************************************/
+void mSceneManager::makeLinearQuadTree()
+{
+	if (this->QuadNodeHead == nullptr) return;
+	mSuroundBox & rootBox = this->QuadNodeHead->srBox;
+	this->LinearQuadTree.Build(this->ModelInScene, this->QuadTreeDepth,
+		rootBox.pointMin.x, rootBox.pointMax.x,
+		rootBox.pointMin.y, rootBox.pointMax.y,
+		rootBox.pointMin.z, rootBox.pointMax.z);
+	this->IndexMode = SceneIndexLinear;
+}
+
+/*!****************************************************************************
+@Function		makeLooseQuadTree
+@Description	Puts ModelInScene into the loose quadtree. From then on models
+added, removed or moved are updated in place, no rebuild is needed.
+******************************************************************************/
+void mSceneManager::makeLooseQuadTree()
+{
+	if (this->QuadNodeHead == nullptr) return;
+	mSuroundBox & rootBox = this->QuadNodeHead->srBox;
+	this->LooseQuadTree.Init(this->QuadTreeDepth,
+		rootBox.pointMin.x, rootBox.pointMax.x,
+		rootBox.pointMin.y, rootBox.pointMax.y,
+		rootBox.pointMin.z, rootBox.pointMax.z);
+	for (unsigned int i = 0; i < this->ModelInScene.size(); ++i){
+		this->LooseQuadTree.insertModel(this->ModelInScene[i]);
+	}
+	this->IndexMode = SceneIndexLoose;
+}
+
+/*!****************************************************************************
+@Function		makeBVH
+@Input			pool		optional, builds on the worker threads
+@Description	Builds the SAH BVH over ModelInScene and routes ModelsNeedRender
+and RayCast to it. The scene bounds given to the constructor are not
+used, models anywhere are indexed.
+******************************************************************************/
+void mSceneManager::makeBVH(mWorkerPool * pool)
+{
+	this->BVH.Build(this->ModelInScene, pool);
+	this->IndexMode = SceneIndexBVH;
+}
+
 void mSceneManager::makeQuadNode(QuadNode * ptr, vector<mModel*> ModelWaitArrange)
 {
 	if (ptr == nullptr) return;
@@ -96,33 +160,203 @@ void mSceneManager::makeQuadNode(QuadNode * ptr, vector<mModel*> ModelWaitArrang
 	}
 }
 
-vector<mModel*> mSceneManager::ModelsNeedRender(PVRTMat4 & VP_Matrix)
+/*!****************************************************************************
+@Function		ModelsNeedRender
+@Input			frustum			frustum of the camera
+@Return		vector<mModel*>	models to draw, their needRender is set
+@Description	Count is the number of nodes not culled. PlaneTests,
+NodesVisited and NodesAccepted show how much work the traversal did:
+NodesAccepted are nodes taken without any test because a parent was
+fully inside the frustum. When Occlusion is set and built, models
+behind the occluders are dropped and counted in ModelsOccluded. The linear
+quadtree tests its nodes during the traversal, a hidden node takes its
+whole subtree with it. The other modes test every visible model afterwards.
+******************************************************************************/
+vector<mModel*> mSceneManager::ModelsNeedRender(mFrustum & frustum)
+{
+	this->queryIndex(frustum.Planes);
+	if (this->IndexMode != SceneIndexLinear && this->Occlusion != nullptr && this->Occlusion->IsReady()) this->removeOccluded();
+	return this->ModelWaitRender;
+}
+
+void mSceneManager::queryIndex(mFrustumPlanes & planes)
 {
 	this->Count = 0;
+	this->PlaneTests = 0;
+	this->NodesVisited = 0;
+	this->NodesAccepted = 0;
+	this->NodesOccluded = 0;
+	this->ModelsOccluded = 0;
 	this->ModelWaitRender.clear();
-	this->checkQuadTree(this->QuadNodeHead, VP_Matrix);
-	return this->ModelWaitRender;
+	if (this->IndexMode == SceneIndexLinear){
+		this->LinearQuadTree.Query(planes, this->ModelWaitRender, this->Occlusion != nullptr && this->Occlusion->IsReady() ? this->Occlusion : nullptr);
+		this->Count = this->LinearQuadTree.NodesVisited - this->LinearQuadTree.NodesCulled;
+		this->NodesOccluded = this->LinearQuadTree.NodesOccluded;
+		this->ModelsOccluded = this->LinearQuadTree.ModelsOccluded;
+		this->PlaneTests = this->LinearQuadTree.PlaneTests;
+		this->NodesVisited = this->LinearQuadTree.NodesVisited;
+		this->NodesAccepted = this->LinearQuadTree.NodesAccepted;
+	}
+	else if (this->IndexMode == SceneIndexLoose){
+		this->LooseQuadTree.Query(planes, this->ModelWaitRender);
+		this->Count = this->LooseQuadTree.NodesVisited - this->LooseQuadTree.NodesCulled;
+		this->PlaneTests = this->LooseQuadTree.PlaneTests;
+		this->NodesVisited = this->LooseQuadTree.NodesVisited;
+		this->NodesAccepted = this->LooseQuadTree.NodesAccepted;
+	}
+	else if (this->IndexMode == SceneIndexBVH){
+		this->BVH.Query(planes, this->ModelWaitRender);
+		this->Count = this->BVH.NodesVisited - this->BVH.NodesCulled;
+		this->PlaneTests = this->BVH.PlaneTests;
+		this->NodesVisited = this->BVH.NodesVisited;
+		this->NodesAccepted = this->BVH.NodesAccepted;
+	}
+	else{
+		this->checkQuadTree(this->QuadNodeHead, planes, c_uiAllFrustumPlanes);
+	}
+}
+
+/*!****************************************************************************
+@Function		removeOccluded
+@Description	Second pass after the frustum query: models hidden behind the
+occluders lose needRender and leave the list. The occlusion culler must
+have been built for the same camera as the frustum.
+******************************************************************************/
+void mSceneManager::removeOccluded()
+{
+	unsigned int kept = 0;
+	for (unsigned int i = 0; i < this->ModelWaitRender.size(); ++i){
+		mModel * model = this->ModelWaitRender[i];
+		if (this->Occlusion->IsOccluded(model)){
+			model->needRender = false;
+			this->ModelsOccluded++;
+			continue;
+		}
+		this->ModelWaitRender[kept++] = model;
+	}
+	this->ModelWaitRender.resize(kept);
 }
 
-void mSceneManager::checkQuadTree(QuadNode * ptr, PVRTMat4 & VP_Matrix)
+/*!****************************************************************************
+@Function		QueryView
+@Input			frustum			frustum of one view
+@Output		modelsOut		visible models are appended
+@Modified		lastOutPlane	plane coherency kept by the caller for this view
+@Output		stats			work done by this query
+@Description	The linear quadtree and the BVH leave needRender alone and can
+be queried from several threads at once, see CanQueryViewsInParallel. The
+other modes go through queryIndex, which sets needRender on the visible
+models, so they are queried serially and the flags of every view add up.
+They never apply the occlusion pass, the occlusion culler only knows about
+one camera.
+******************************************************************************/
+void mSceneManager::QueryView(mFrustum & frustum, vector<mModel*> & modelsOut, vector<PVRTuint8> & lastOutPlane, mCullStats & stats)
+{
+	if (this->IndexMode == SceneIndexLinear){
+		this->LinearQuadTree.QueryView(frustum.Planes, modelsOut, lastOutPlane, stats);
+		return;
+	}
+	if (this->IndexMode == SceneIndexBVH){
+		this->BVH.QueryView(frustum.Planes, modelsOut, lastOutPlane, stats);
+		return;
+	}
+	this->queryIndex(frustum.Planes);
+	modelsOut.insert(modelsOut.end(), this->ModelWaitRender.begin(), this->ModelWaitRender.end());
+	stats.NodesVisited = this->NodesVisited;
+	stats.NodesCulled = this->NodesVisited - this->Count;
+	stats.NodesAccepted = this->NodesAccepted;
+	stats.PlaneTests = this->PlaneTests;
+}
+
+bool mSceneManager::CanQueryViewsInParallel()
+{
+	return this->IndexMode == SceneIndexLinear || this->IndexMode == SceneIndexBVH;
+}
+
+/*!****************************************************************************
+@Function		RayCast
+@Input			origin
+@Input			direction		does not need to be normalized
+@Input			maxDistance		world units along the ray
+@Output		hitDistance		only set on a hit
+@Return		mModel*			nearest model hit, NULL for none
+@Description	Goes through the BVH after makeBVH, otherwise every model in
+the scene is tested.
+******************************************************************************/
+mModel * mSceneManager::RayCast(PVRTVec3 origin, PVRTVec3 direction, float maxDistance, float & hitDistance)
+{
+	if (this->IndexMode == SceneIndexBVH) return this->BVH.RayCast(origin, direction, maxDistance, hitDistance);
+
+	float length = direction.length();
+	if (length <= 0.0f) return nullptr;
+	direction /= length;
+	mModel * hitModel = nullptr;
+	float nearest = maxDistance;
+	for (unsigned int i = 0; i < this->ModelInScene.size(); ++i){
+		float distance;
+		if (!mBVH::IntersectModel(this->ModelInScene[i], origin, direction, nearest, distance)) continue;
+		nearest = distance;
+		hitModel = this->ModelInScene[i];
+	}
+	if (hitModel) hitDistance = nearest;
+	return hitModel;
+}
+
+/*!****************************************************************************
+@Function		checkQuadTree
+@Input			ptr			node to test
+@Input			planes		world space frustum planes
+@Input			planeMask	planes the parent box still crosses
+@Description	Children are only tested against the planes their parent
+crosses, a node fully inside the frustum hands its whole subtree to
+acceptQuadTree.
+******************************************************************************/
+void mSceneManager::checkQuadTree(QuadNode * ptr, mFrustumPlanes & planes, PVRTuint32 planeMask)
 {
 	if (ptr == nullptr) return;
-	if (ptr->srBox.NeedClipFromWorldSpace(VP_Matrix) == false){
-		this->Count++;
-		if (ptr->Depth == this->QuadTreeDepth){
-			for (unsigned int i = 0; i < ptr->Models.size(); i++){
-				ptr->Models[i]->needRender = true;
-			}
+	this->NodesVisited++;
+	int hit = planes.ClassifyBox(&ptr->srBox.pointMin.x, &ptr->srBox.pointMax.x, planeMask, ptr->LastOutPlane, this->PlaneTests);
+	if (hit == NoHit) return;
+
+	this->Count++;
+	if (ptr->Depth == this->QuadTreeDepth){
+		for (unsigned int i = 0; i < ptr->Models.size(); i++){
+			ptr->Models[i]->needRender = true;
+			this->ModelWaitRender.push_back(ptr->Models[i]);
 		}
-		
-		this->checkQuadTree(ptr->children[0], VP_Matrix);
-		this->checkQuadTree(ptr->children[1], VP_Matrix);
-		this->checkQuadTree(ptr->children[2], VP_Matrix);
-		this->checkQuadTree(ptr->children[3], VP_Matrix);
 	}
+
+	for (int c = 0; c < 4; ++c){
+		if (hit == Inside) this->acceptQuadTree(ptr->children[c]);
+		else this->checkQuadTree(ptr->children[c], planes, planeMask);
+	}
+}
+
+void mSceneManager::acceptQuadTree(QuadNode * ptr)
+{
+	if (ptr == nullptr) return;
+	this->Count++;
+	this->NodesVisited++;
+	this->NodesAccepted++;
+	if (ptr->Depth == this->QuadTreeDepth){
+		for (unsigned int i = 0; i < ptr->Models.size(); i++){
+			ptr->Models[i]->needRender = true;
+			this->ModelWaitRender.push_back(ptr->Models[i]);
+		}
+	}
+
+	this->acceptQuadTree(ptr->children[0]);
+	this->acceptQuadTree(ptr->children[1]);
+	this->acceptQuadTree(ptr->children[2]);
+	this->acceptQuadTree(ptr->children[3]);
 }
 
 void mSceneManager::Destroy()
 {
 	this->deleteQuadNode(this->QuadNodeHead);
+	this->QuadNodeHead = nullptr;
+	this->LinearQuadTree.Clear();
+	this->LooseQuadTree.Clear();
+	this->BVH.Clear();
+	this->IndexMode = SceneIndexQuadNode;
 }
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "..\Include\mSuroundBox.h"
+#include "..\Include\mFrustum.h"
+#include "..\Include\mBounds.h"
 
 mSuroundBox::mSuroundBox()
 {
@@ -11,20 +13,16 @@ mSuroundBox::~mSuroundBox()
 
 void mSuroundBox::UpdateBoxModel(PVRTuint32 vertexNum, PVRTuint8 * pointPtr, PVRTuint8 stride)
 {
-	GLfloat x, y, z;
-	for (unsigned int i = 0; i < vertexNum; ++i)
-	{
-		x = *(GLfloat*)(pointPtr + i * stride);
-		y = *(GLfloat*)(pointPtr + i * stride + 4);
-		z = *(GLfloat*)(pointPtr + i * stride + 8);
-
-		if (x < this->pointMin.x) this->pointMin.x = x;
-		if (x > this->pointMax.x) this->pointMax.x = x;
-		if (y < this->pointMin.y) this->pointMin.y = y;
-		if (y > this->pointMax.y) this->pointMax.y = y;
-		if (z < this->pointMin.z) this->pointMin.z = z;
-		if (z > this->pointMax.z) this->pointMax.z = z;
-	}
+	PVRTVec3 boxMin, boxMax;
+	mBoundsEngine::ComputeAABB(pointPtr, stride, vertexNum, boxMin, boxMax);
+	this->SetBoxModel(PVRTVec3(PVRT_MIN(boxMin.x, this->pointMin.x), PVRT_MIN(boxMin.y, this->pointMin.y), PVRT_MIN(boxMin.z, this->pointMin.z)),
+		PVRTVec3(PVRT_MAX(boxMax.x, this->pointMax.x), PVRT_MAX(boxMax.y, this->pointMax.y), PVRT_MAX(boxMax.z, this->pointMax.z)));
+}
+
+void mSuroundBox::SetBoxModel(PVRTVec3 boxMin, PVRTVec3 boxMax)
+{
+	this->pointMin = PVRTVec4(boxMin, 1.0f);
+	this->pointMax = PVRTVec4(boxMax, 1.0f);
 	this->CenterModel = (this->pointMin + this->pointMax) / 2;
 	this->createCornerPointsModel();
 	this->clipPlaneModel[0] = PVRTVec4(1.0, 0.0, 0.0, -this->pointMin.x); //left
@@ -46,6 +44,20 @@ void mSuroundBox::UpdateBoxWorld(PVRTMat4 & ModelMatrix)
 		this->clipPlaneWorld[i] = ModelMatrix * this->clipPlaneModel[i];
 	}
 	this->CenterWorld = ModelMatrix * this->CenterModel;
+	this->updateRadiusWorld();
+}
+
+void mSuroundBox::updateRadiusWorld()
+{
+	float radiusSqr = 0.0f;
+	for (int i = 0; i < 8; ++i)
+	{
+		PVRTVec3 offset(this->pointCornersWorld[i].x - this->CenterWorld.x,
+			this->pointCornersWorld[i].y - this->CenterWorld.y,
+			this->pointCornersWorld[i].z - this->CenterWorld.z);
+		radiusSqr = PVRT_MAX(radiusSqr, offset.dot(offset));
+	}
+	this->RadiusWorld = sqrt(radiusSqr);
 }
 
 void mSuroundBox::CreateBoxFromCornerWorld(float Xmin, float Xmax, float Ymin, float Ymax, float Zmin, float Zmax)
@@ -58,6 +70,7 @@ void mSuroundBox::CreateBoxFromCornerWorld(float Xmin, float Xmax, float Ymin, f
 	this->pointMax.z = Zmax;
 	this->CenterWorld = (this->pointMin + this->pointMax) / 2;
 	this->createCornerPointsWorld();
+	this->updateRadiusWorld();
 	this->clipPlaneWorld[0] = PVRTVec4(1.0, 0.0, 0.0, -Xmin); //left
 	this->clipPlaneWorld[1] = PVRTVec4(-1.0, 0.0, 0.0, Xmax); //right
 	this->clipPlaneWorld[2] = PVRTVec4(0.0, 1.0, 0.0, -Ymin); //bottom
@@ -175,6 +188,36 @@ bool mSuroundBox::NeedClipFromWorldSpace(PVRTMat4 & VP_Matrix)
 	return false;
 }
 
+/*!****************************************************************************
+@Function		NeedClipFromFrustum
+@Input			frustum		cached frustum of the camera
+@Return		bool		true when the box can be skipped
+@Description	Same corner test as NeedClipFromWorldSpace on planes that are
+already built. The bounding sphere rejects most boxes first, and planes
+the sphere is fully in front of need no corner test.
+******************************************************************************/
+bool mSuroundBox::NeedClipFromFrustum(mFrustum & frustum)
+{
+	PVRTVec3 center(this->CenterWorld.x, this->CenterWorld.y, this->CenterWorld.z);
+	if (frustum.SphereOutside(center, this->RadiusWorld)) return true;
+
+	mFrustumPlanes & planes = frustum.Planes;
+	for (int i = 0; i < 6; ++i){
+		PVRTVec4 plane(planes.A[i], planes.B[i], planes.C[i], planes.D[i]);
+		if (plane.dot(this->CenterWorld) > this->RadiusWorld) continue;
+		if (plane.dot(this->pointCornersWorld[0]) > 0) continue;
+		if (plane.dot(this->pointCornersWorld[1]) > 0) continue;
+		if (plane.dot(this->pointCornersWorld[2]) > 0) continue;
+		if (plane.dot(this->pointCornersWorld[3]) > 0) continue;
+		if (plane.dot(this->pointCornersWorld[4]) > 0) continue;
+		if (plane.dot(this->pointCornersWorld[5]) > 0) continue;
+		if (plane.dot(this->pointCornersWorld[6]) > 0) continue;
+		if (plane.dot(this->pointCornersWorld[7]) > 0) continue;
+		return true;
+	}
+	return false;
+}
+
 bool mSuroundBox::CenterInsideBoxWorldSpace(mSuroundBox & Box)
 {
 	if (this->CenterWorld.dot(Box.clipPlaneWorld[0]) <= 0) return false;
@@ -186,6 +229,27 @@ bool mSuroundBox::CenterInsideBoxWorldSpace(mSuroundBox & Box)
 	return true;
 }
 
+/*!****************************************************************************
+@Function		GetBoxWorld
+@Output		boxMin		minimum corner of the world space AABB
+@Output		boxMax		maximum corner of the world space AABB
+@Description	Axis aligned bounds of the eight world space corners
+******************************************************************************/
+void mSuroundBox::GetBoxWorld(PVRTVec3 & boxMin, PVRTVec3 & boxMax)
+{
+	boxMin = PVRTVec3(FLT_MAX, FLT_MAX, FLT_MAX);
+	boxMax = PVRTVec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (int i = 0; i < 8; ++i){
+		PVRTVec4 & p = this->pointCornersWorld[i];
+		if (p.x < boxMin.x) boxMin.x = p.x;
+		if (p.y < boxMin.y) boxMin.y = p.y;
+		if (p.z < boxMin.z) boxMin.z = p.z;
+		if (p.x > boxMax.x) boxMax.x = p.x;
+		if (p.y > boxMax.y) boxMax.y = p.y;
+		if (p.z > boxMax.z) boxMax.z = p.z;
+	}
+}
+
 void mSuroundBox::createCornerPointsModel()
 {
 	this->pointCornersModel[0] = PVRTVec4(this->pointMin.x, this->pointMin.y, this->pointMin.z, 1.0);
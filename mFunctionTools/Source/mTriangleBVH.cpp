@@ -0,0 +1,227 @@
+#include "..\Include\mTriangleBVH.h"
+
+const int c_iTriangleBVHStackSize = 128;
+
+mTriangleBVH::mTriangleBVH()
+{
+}
+
+mTriangleBVH::~mTriangleBVH()
+{
+}
+
+/*!****************************************************************************
+@Function		Build
+@Input			modelPOD	every mesh of the POD goes into one tree
+@Input			pool		optional, NULL builds on the calling thread
+@Description	Node transforms are ignored, like mModel::CreateSuroundBox.
+******************************************************************************/
+void mTriangleBVH::Build(CPVRTModelPOD & modelPOD, mWorkerPool * pool)
+{
+	this->Clear();
+	for (unsigned int i = 0; i < modelPOD.nNumMesh; ++i){
+		this->addMesh(modelPOD.pMesh[i]);
+	}
+	this->buildTree(pool);
+}
+
+void mTriangleBVH::Build(SPODMesh & mesh, mWorkerPool * pool)
+{
+	this->Clear();
+	this->addMesh(mesh);
+	this->buildTree(pool);
+}
+
+/*!****************************************************************************
+@Function		Build
+@Input			positions		first vertex position, 3 floats
+@Input			stride			bytes between two positions
+@Input			indices			3 per triangle, NULL for a non indexed list
+******************************************************************************/
+void mTriangleBVH::Build(const PVRTuint8 * positions, unsigned int stride, unsigned int vertexCount,
+	const PVRTuint16 * indices, unsigned int triangleCount, mWorkerPool * pool)
+{
+	this->Clear();
+	this->addTriangles(positions, stride, vertexCount, indices, nullptr, triangleCount);
+	this->buildTree(pool);
+}
+
+void mTriangleBVH::addMesh(SPODMesh & mesh)
+{
+	const PVRTuint8 * positions = mesh.pInterleaved ? mesh.pInterleaved + (size_t)mesh.sVertex.pData : mesh.sVertex.pData;
+	if (positions == nullptr || mesh.sVertex.eType != EPODDataFloat) return;
+	const PVRTuint16 * indices = nullptr;
+	const PVRTuint32 * indices32 = nullptr;
+	if (mesh.sFaces.pData){
+		if (mesh.sFaces.eType == EPODDataUnsignedShort) indices = (const PVRTuint16*)mesh.sFaces.pData;
+		else if (mesh.sFaces.eType == EPODDataUnsignedInt) indices32 = (const PVRTuint32*)mesh.sFaces.pData;
+		else return;
+	}
+
+	if (mesh.nNumStrips == 0){
+		this->addTriangles(positions, mesh.sVertex.nStride, mesh.nNumVertex, indices, indices32, mesh.nNumFaces);
+		return;
+	}
+
+	// strips are unrolled into a list, winding does not matter for ray hits
+	vector<PVRTuint32> list;
+	unsigned int offset = 0;
+	for (unsigned int s = 0; s < mesh.nNumStrips; ++s){
+		for (unsigned int t = 0; t < mesh.pnStripLength[s]; ++t){
+			for (unsigned int k = 0; k < 3; ++k){
+				unsigned int i = offset + t + k;
+				list.push_back(indices ? indices[i] : (indices32 ? indices32[i] : i));
+			}
+		}
+		offset += mesh.pnStripLength[s] + 2;
+	}
+	if (!list.empty()) this->addTriangles(positions, mesh.sVertex.nStride, mesh.nNumVertex, nullptr, &list[0], (unsigned int)list.size() / 3);
+}
+
+void mTriangleBVH::addTriangles(const PVRTuint8 * positions, unsigned int stride, unsigned int vertexCount,
+	const PVRTuint16 * indices, const PVRTuint32 * indices32, unsigned int triangleCount)
+{
+	this->Vertices.reserve(this->Vertices.size() + triangleCount * 3);
+	for (unsigned int t = 0; t < triangleCount; ++t){
+		unsigned int corner[3];
+		for (unsigned int k = 0; k < 3; ++k){
+			unsigned int i = 3 * t + k;
+			corner[k] = indices ? indices[i] : (indices32 ? indices32[i] : i);
+		}
+		if (corner[0] >= vertexCount || corner[1] >= vertexCount || corner[2] >= vertexCount) continue;
+		for (unsigned int k = 0; k < 3; ++k){
+			const float * p = (const float*)(positions + corner[k] * stride);
+			this->Vertices.push_back(PVRTVec3(p[0], p[1], p[2]));
+		}
+	}
+}
+
+void mTriangleBVH::buildTree(mWorkerPool * pool)
+{
+	unsigned int count = (unsigned int)this->Vertices.size() / 3;
+	vector<PVRTVec3> triangleMin(count), triangleMax(count);
+	for (unsigned int t = 0; t < count; ++t){
+		PVRTVec3 & a = this->Vertices[3 * t];
+		PVRTVec3 & b = this->Vertices[3 * t + 1];
+		PVRTVec3 & c = this->Vertices[3 * t + 2];
+		triangleMin[t] = PVRTVec3(PVRT_MIN(a.x, PVRT_MIN(b.x, c.x)), PVRT_MIN(a.y, PVRT_MIN(b.y, c.y)), PVRT_MIN(a.z, PVRT_MIN(b.z, c.z)));
+		triangleMax[t] = PVRTVec3(PVRT_MAX(a.x, PVRT_MAX(b.x, c.x)), PVRT_MAX(a.y, PVRT_MAX(b.y, c.y)), PVRT_MAX(a.z, PVRT_MAX(b.z, c.z)));
+	}
+	this->Builder.Build(triangleMin, triangleMax, this->Nodes, this->TriangleIndex, pool);
+
+	vector<PVRTVec3> ordered(this->Vertices.size());
+	for (unsigned int i = 0; i < count; ++i){
+		PVRTuint32 t = this->TriangleIndex[i];
+		ordered[3 * i] = this->Vertices[3 * t];
+		ordered[3 * i + 1] = this->Vertices[3 * t + 1];
+		ordered[3 * i + 2] = this->Vertices[3 * t + 2];
+	}
+	this->Vertices.swap(ordered);
+}
+
+/*!****************************************************************************
+@Function		intersectTriangle
+@Description	Moller-Trumbore, both faces are hit.
+******************************************************************************/
+bool mTriangleBVH::intersectTriangle(unsigned int triangle, PVRTVec3 & origin, PVRTVec3 & direction, float maxDistance, float & hitDistance)
+{
+	PVRTVec3 & v0 = this->Vertices[3 * triangle];
+	PVRTVec3 edge1 = this->Vertices[3 * triangle + 1] - v0;
+	PVRTVec3 edge2 = this->Vertices[3 * triangle + 2] - v0;
+	PVRTVec3 p = direction.cross(edge2);
+	float det = edge1.dot(p);
+	if (fabs(det) < 1e-12f) return false;
+	float invDet = 1.0f / det;
+	PVRTVec3 s = origin - v0;
+	float u = s.dot(p) * invDet;
+	if (u < 0.0f || u > 1.0f) return false;
+	PVRTVec3 q = s.cross(edge1);
+	float v = direction.dot(q) * invDet;
+	if (v < 0.0f || u + v > 1.0f) return false;
+	float t = edge2.dot(q) * invDet;
+	if (t < 0.0f || t > maxDistance) return false;
+	hitDistance = t;
+	return true;
+}
+
+/*!****************************************************************************
+@Function		RayCast
+@Input			origin			in mesh space
+@Input			direction		in mesh space, the distance is measured in its length
+@Output		hitDistance		nearest hit, only set on a hit
+@Output		triangle		optional, triangle number in the order it was added
+@Return		bool			true when a triangle is hit before maxDistance
+******************************************************************************/
+bool mTriangleBVH::RayCast(PVRTVec3 origin, PVRTVec3 direction, float maxDistance, float & hitDistance, unsigned int * triangle)
+{
+	this->RayNodeTests = 0;
+	this->RayTriangleTests = 0;
+	if (this->Nodes.empty()) return false;
+
+	PVRTVec3 invDirection;
+	for (int a = 0; a < 3; ++a){
+		float d = (&direction.x)[a];
+		(&invDirection.x)[a] = 1.0f / (fabs(d) > 1e-20f ? d : (d < 0.0f ? -1e-20f : 1e-20f));
+	}
+
+	bool hit = false;
+	float nearest = maxDistance;
+	int stack[c_iTriangleBVHStackSize];
+	float stackDistance[c_iTriangleBVHStackSize];
+	int top = 0;
+	float entry;
+	this->RayNodeTests++;
+	if (!mBVH::IntersectBox(this->Nodes[0].Min, this->Nodes[0].Max, origin, invDirection, nearest, entry)) return false;
+	stack[top] = 0;
+	stackDistance[top++] = entry;
+	while (top > 0){
+		--top;
+		if (stackDistance[top] > nearest) continue;
+		BVHNode & node = this->Nodes[stack[top]];
+		if (node.Left < 0){
+			for (PVRTuint32 i = node.First; i < node.First + node.Count; ++i){
+				this->RayTriangleTests++;
+				float distance;
+				if (!this->intersectTriangle(i, origin, direction, nearest, distance)) continue;
+				nearest = distance;
+				hit = true;
+				if (triangle) *triangle = this->TriangleIndex[i];
+			}
+			continue;
+		}
+
+		float leftEntry, rightEntry;
+		this->RayNodeTests += 2;
+		bool leftHit = mBVH::IntersectBox(this->Nodes[node.Left].Min, this->Nodes[node.Left].Max, origin, invDirection, nearest, leftEntry);
+		bool rightHit = mBVH::IntersectBox(this->Nodes[node.Left + 1].Min, this->Nodes[node.Left + 1].Max, origin, invDirection, nearest, rightEntry);
+		if (leftHit && rightHit && leftEntry < rightEntry){
+			stack[top] = node.Left + 1;
+			stackDistance[top++] = rightEntry;
+			rightHit = false;
+		}
+		if (leftHit){
+			stack[top] = node.Left;
+			stackDistance[top++] = leftEntry;
+		}
+		if (rightHit){
+			stack[top] = node.Left + 1;
+			stackDistance[top++] = rightEntry;
+		}
+	}
+	if (hit) hitDistance = nearest;
+	return hit;
+}
+
+void mTriangleBVH::Clear()
+{
+	this->Nodes.clear();
+	this->Vertices.clear();
+	this->TriangleIndex.clear();
+	this->RayNodeTests = 0;
+	this->RayTriangleTests = 0;
+}
+
+unsigned int mTriangleBVH::TriangleCount()
+{
+	return (unsigned int)this->Vertices.size() / 3;
+}
@@ -0,0 +1,224 @@
+#include "..\Include\mWaterClipmap.h"
+#include <chrono>
+#include <math.h>
+#include <string.h>
+
+mWaterClipmap::mWaterClipmap()
+{
+	for (int i = 0; i < eNumRanges; ++i) this->Ranges[i].First = this->Ranges[i].Count = this->Ranges[i].Vertices = 0;
+}
+
+mWaterClipmap::~mWaterClipmap()
+{
+}
+
+/*!****************************************************************************
+@Function		Generate
+@Input			gridSize		quads per level side, multiple of 4
+@Input			levels			number of nested levels
+@Input			spacing			quad size of the finest level
+@Return		bool			false when the grid does not fit 16 bit indices
+@Description	Builds the shared vertex grid and the index ranges on the CPU
+and records the time it took in GenerateMs. The grid is in quad units
+around the origin, the level matrices scale it to the level's spacing.
+******************************************************************************/
+bool mWaterClipmap::Generate(int gridSize, int levels, float spacing)
+{
+	if (gridSize < 8 || gridSize % 4 != 0 || (gridSize + 1) * (gridSize + 1) > 65536) return false;
+	if (levels < 1 || levels > c_iClipmapMaxLevels || spacing <= 0.0f) return false;
+
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+
+	this->GridSize = gridSize;
+	this->LevelCount = levels;
+	this->Spacing = spacing;
+
+	int n = gridSize, half = gridSize / 2, quarter = gridSize / 4;
+	this->Vertices.resize((n + 1) * (n + 1) * c_uiClipmapVertexFloats);
+	GLfloat * v = &this->Vertices[0];
+	for (int z = 0; z <= n; ++z){
+		for (int x = 0; x <= n; ++x){
+			GLfloat vertex[c_uiClipmapVertexFloats] = {
+				(GLfloat)(x - half), 0.0f, (GLfloat)(z - half),
+				0.0f, 1.0f, 0.0f,
+				1.0f, 0.0f, 0.0f,
+				0.0f, 0.0f, 1.0f,
+				(GLfloat)x / n, (GLfloat)z / n };
+			memcpy(v, vertex, sizeof(vertex));
+			v += c_uiClipmapVertexFloats;
+		}
+	}
+
+	// quads are addressed by their lowest corner, the inner level sits on
+	// quads [quarter + d, 3 * quarter + d) with d 0 or 1 on each axis
+	this->Indices.clear();
+	this->beginRange(eFull);
+	for (int z = 0; z < n; ++z){
+		for (int x = 0; x < n; ++x) this->emitQuad(x, z);
+	}
+	this->endRange(eFull);
+
+	this->beginRange(eRing);
+	for (int z = 0; z < n; ++z){
+		for (int x = 0; x < n; ++x){
+			if (x >= quarter && x <= 3 * quarter && z >= quarter && z <= 3 * quarter) continue;
+			this->emitQuad(x, z);
+		}
+	}
+	this->endRange(eRing);
+
+	for (int t = 0; t < 4; ++t){
+		int dx = t & 1, dz = t >> 1;
+		this->beginRange(eTrim + t);
+		for (int z = quarter; z <= 3 * quarter; ++z){
+			for (int x = quarter; x <= 3 * quarter; ++x){
+				if (x >= quarter + dx && x < 3 * quarter + dx && z >= quarter + dz && z < 3 * quarter + dz) continue;
+				this->emitQuad(x, z);
+			}
+		}
+		this->endRange(eTrim + t);
+	}
+
+	this->GenerateMs = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+	return true;
+}
+
+void mWaterClipmap::beginRange(int range)
+{
+	this->Ranges[range].First = (PVRTuint32)this->Indices.size();
+}
+
+void mWaterClipmap::endRange(int range)
+{
+	ClipmapRange & r = this->Ranges[range];
+	r.Count = (PVRTuint32)this->Indices.size() - r.First;
+	vector<bool> used((this->GridSize + 1) * (this->GridSize + 1), false);
+	r.Vertices = 0;
+	for (PVRTuint32 i = r.First; i < r.First + r.Count; ++i){
+		if (!used[this->Indices[i]]){
+			used[this->Indices[i]] = true;
+			++r.Vertices;
+		}
+	}
+}
+
+PVRTuint16 mWaterClipmap::vertexIndex(int x, int z)
+{
+	return (PVRTuint16)(z * (this->GridSize + 1) + x);
+}
+
+/*!****************************************************************************
+@Function		snapEdge
+@Description	Moves odd vertices of the outer edge onto the next outer level's
+vertices, towards the nearer end of the edge.
+******************************************************************************/
+void mWaterClipmap::snapEdge(int & x, int & z)
+{
+	int n = this->GridSize;
+	if ((x == 0 || x == n) && (z & 1)) z += (2 * z < n) ? -1 : 1;
+	if ((z == 0 || z == n) && (x & 1)) x += (2 * x < n) ? -1 : 1;
+}
+
+/*!****************************************************************************
+@Function		emitQuad
+@Description	Two triangles of quad (x, z), facing up. Triangles collapsed by
+snapEdge are dropped.
+******************************************************************************/
+void mWaterClipmap::emitQuad(int x, int z)
+{
+	PVRTuint16 corner[4];
+	for (int c = 0; c < 4; ++c){
+		int cx = x + (c & 1), cz = z + (c >> 1);
+		this->snapEdge(cx, cz);
+		corner[c] = this->vertexIndex(cx, cz);
+	}
+	// corners 0 (x, z), 1 (x+1, z), 2 (x, z+1), 3 (x+1, z+1)
+	PVRTuint16 triangles[6] = { corner[0], corner[2], corner[1], corner[1], corner[2], corner[3] };
+	for (int t = 0; t < 2; ++t){
+		PVRTuint16 * v = &triangles[3 * t];
+		if (v[0] == v[1] || v[1] == v[2] || v[0] == v[2]) continue;
+		this->Indices.insert(this->Indices.end(), v, v + 3);
+	}
+}
+
+void mWaterClipmap::LoadVBO()
+{
+	if (this->Vertices.empty()) return;
+	glGenBuffers(1, &this->VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+	glBufferData(GL_ARRAY_BUFFER, this->Vertices.size() * sizeof(GLfloat), &this->Vertices[0], GL_STATIC_DRAW);
+	glGenBuffers(1, &this->IndexVBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->IndexVBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->Indices.size() * sizeof(PVRTuint16), &this->Indices[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void mWaterClipmap::DeleteVBOs()
+{
+	if (this->VBO) glDeleteBuffers(1, &this->VBO);
+	if (this->IndexVBO) glDeleteBuffers(1, &this->IndexVBO);
+	this->VBO = this->IndexVBO = 0;
+}
+
+/*!****************************************************************************
+@Function		Update
+@Input			eye			camera position, only XZ is used
+@Description	Snaps every level to the camera and fills Draws, finest level
+first. The level centers only move in steps of two of their quads, so
+the water does not swim under the camera.
+******************************************************************************/
+void mWaterClipmap::Update(PVRTVec3 eye)
+{
+	this->Draws.clear();
+	this->FrameVertices = this->FrameTriangles = 0;
+	if (this->LevelCount == 0) return;
+
+	float innerX = 0.0f, innerZ = 0.0f;
+	for (int l = 0; l < this->LevelCount; ++l){
+		float spacing = this->Spacing * (float)(1 << l);
+		float centerX = floor(eye.x / (2.0f * spacing)) * 2.0f * spacing;
+		float centerZ = floor(eye.z / (2.0f * spacing)) * 2.0f * spacing;
+
+		ClipmapDraw draw;
+		draw.Level = l;
+		draw.Model = PVRTMat4::Translation(centerX, 0.0f, centerZ) * PVRTMat4::Scale(spacing, 1.0f, spacing);
+		if (l == 0){
+			draw.Range = eFull;
+			this->Draws.push_back(draw);
+		}
+		else{
+			draw.Range = eRing;
+			this->Draws.push_back(draw);
+			int dx = (innerX - centerX > 0.5f * spacing) ? 1 : 0;
+			int dz = (innerZ - centerZ > 0.5f * spacing) ? 1 : 0;
+			draw.Range = eTrim + dx + 2 * dz;
+			this->Draws.push_back(draw);
+		}
+		innerX = centerX;
+		innerZ = centerZ;
+	}
+
+	for (unsigned int i = 0; i < this->Draws.size(); ++i){
+		this->FrameVertices += this->Ranges[this->Draws[i].Range].Vertices;
+		this->FrameTriangles += this->Ranges[this->Draws[i].Range].Count / 3;
+	}
+}
+
+/*!****************************************************************************
+@Function		Extent
+@Return		float		distance from the camera to the water's edge
+******************************************************************************/
+float mWaterClipmap::Extent()
+{
+	return this->Spacing * (float)(1 << (this->LevelCount - 1)) * (this->GridSize / 2 - 2);
+}
+
+void mWaterClipmap::Destroy()
+{
+	this->DeleteVBOs();
+	this->Vertices.clear();
+	this->Indices.clear();
+	this->Draws.clear();
+	this->LevelCount = 0;
+}
@@ -0,0 +1,376 @@
+#include "..\Include\mWaterLOD.h"
+#include <algorithm>
+#include <climits>
+
+mWaterLOD::mWaterLOD()
+{
+	for (int i = 0; i < c_iWaterMaxLevels; ++i) this->TilesPerLevel[i] = 0;
+}
+
+mWaterLOD::~mWaterLOD()
+{
+}
+
+/*!****************************************************************************
+@Function		AddLevel
+@Input			modelPOD		regular grid mesh, first mesh only
+@Return		bool			false when the mesh is not a square grid of quads
+@Description	Must be called before Build. The POD stays owned by the caller.
+******************************************************************************/
+bool mWaterLOD::AddLevel(CPVRTModelPOD * modelPOD)
+{
+	if (modelPOD == nullptr || modelPOD->nNumMesh == 0) return false;
+	WaterLODLevel level;
+	level.POD = modelPOD;
+	level.VBO = 0;
+	level.InteriorFirst = level.InteriorCount = 0;
+	for (int i = 0; i < c_iWaterStitchCombinations; ++i) level.RingFirst[i] = level.RingCount[i] = 0;
+	if (!this->mapGrid(level)) return false;
+	this->Levels.push_back(level);
+	return true;
+}
+
+/*!****************************************************************************
+@Function		mapGrid
+@Description	Finds the grid point of every vertex from its XZ position.
+******************************************************************************/
+bool mWaterLOD::mapGrid(WaterLODLevel & level)
+{
+	SPODMesh & mesh = level.POD->pMesh[0];
+	// 0xFFFF marks an unmapped grid point, so it cannot be a vertex index
+	if (mesh.sVertex.eType != EPODDataFloat || mesh.nNumVertex > 0xFFFF) return false;
+	int resolution = (int)(sqrt((double)mesh.nNumVertex) + 0.5) - 1;
+	if (resolution < 2 || (PVRTuint32)((resolution + 1) * (resolution + 1)) != mesh.nNumVertex) return false;
+
+	const PVRTuint8 * positions = mesh.pInterleaved ? mesh.pInterleaved + (size_t)mesh.sVertex.pData : mesh.sVertex.pData;
+	PVRTVec3 boxMin, boxMax;
+	mBoundsEngine::ComputeAABB(positions, mesh.sVertex.nStride, mesh.nNumVertex, boxMin, boxMax);
+	float size = boxMax.x - boxMin.x;
+	if (size <= 0.0f || fabs((boxMax.z - boxMin.z) - size) > size * 1e-3f) return false;
+
+	float step = size / resolution;
+	level.Resolution = resolution;
+	level.MeshSize = size;
+	level.GridVertex.assign((resolution + 1) * (resolution + 1), 0xFFFF);
+	for (PVRTuint32 i = 0; i < mesh.nNumVertex; ++i){
+		const float * p = (const float*)(positions + i * mesh.sVertex.nStride);
+		int x = (int)floor((p[0] - boxMin.x) / step + 0.5f);
+		int z = (int)floor((p[2] - boxMin.z) / step + 0.5f);
+		if (x < 0 || x > resolution || z < 0 || z > resolution) return false;
+		level.GridVertex[z * (resolution + 1) + x] = (PVRTuint16)i;
+	}
+	for (unsigned int i = 0; i < level.GridVertex.size(); ++i){
+		if (level.GridVertex[i] == 0xFFFF) return false;
+	}
+	return true;
+}
+
+/*!****************************************************************************
+@Function		Build
+@Input			tileSize		world space distance between two tile centers
+@Return		bool			false when no level is left
+@Description	Sorts the levels finest first and drops every level whose
+resolution does not divide the one before, then builds the indices.
+******************************************************************************/
+bool mWaterLOD::Build(float tileSize)
+{
+	sort(this->Levels.begin(), this->Levels.end(), [](const WaterLODLevel & a, const WaterLODLevel & b){ return a.Resolution > b.Resolution; });
+	vector<WaterLODLevel> chain;
+	for (unsigned int i = 0; i < this->Levels.size() && (int)chain.size() < c_iWaterMaxLevels; ++i){
+		if (!chain.empty() && chain.back().Resolution % this->Levels[i].Resolution != 0) continue;
+		chain.push_back(this->Levels[i]);
+	}
+	this->Levels.swap(chain);
+	this->TileSize = tileSize;
+	this->Indices.clear();
+	if (this->Levels.empty()) return false;
+
+	// keep the winding of the original faces
+	SPODMesh & mesh = this->Levels[0].POD->pMesh[0];
+	bool faceUp = true;
+	if (mesh.sFaces.pData && mesh.sFaces.eType == EPODDataUnsignedShort && mesh.nNumFaces > 0){
+		const PVRTuint16 * face = (const PVRTuint16*)mesh.sFaces.pData;
+		const PVRTuint8 * positions = mesh.pInterleaved ? mesh.pInterleaved + (size_t)mesh.sVertex.pData : mesh.sVertex.pData;
+		PVRTVec3 v0((const float*)(positions + face[0] * mesh.sVertex.nStride));
+		PVRTVec3 v1((const float*)(positions + face[1] * mesh.sVertex.nStride));
+		PVRTVec3 v2((const float*)(positions + face[2] * mesh.sVertex.nStride));
+		faceUp = (v1 - v0).cross(v2 - v0).y >= 0.0f;
+	}
+
+	for (unsigned int i = 0; i < this->Levels.size(); ++i){
+		WaterLODLevel & level = this->Levels[i];
+		level.Scale = tileSize / level.MeshSize;
+		int ratio = i + 1 < this->Levels.size() ? level.Resolution / this->Levels[i + 1].Resolution : 1;
+		this->buildIndices(level, ratio, faceUp);
+	}
+	return true;
+}
+
+void mWaterLOD::buildIndices(WaterLODLevel & level, int ratio, bool faceUp)
+{
+	int n = level.Resolution;
+	level.InteriorFirst = (PVRTuint32)this->Indices.size();
+	for (int z = 1; z < n - 1; ++z){
+		for (int x = 1; x < n - 1; ++x) this->emitQuad(level, x, z, 0, 1, faceUp);
+	}
+	level.InteriorCount = (PVRTuint32)this->Indices.size() - level.InteriorFirst;
+
+	for (int stitch = 0; stitch < c_iWaterStitchCombinations; ++stitch){
+		level.RingFirst[stitch] = (PVRTuint32)this->Indices.size();
+		for (int z = 0; z < n; ++z){
+			for (int x = 0; x < n; ++x){
+				if (x != 0 && x != n - 1 && z != 0 && z != n - 1) continue;
+				this->emitQuad(level, x, z, stitch, ratio, faceUp);
+			}
+		}
+		level.RingCount[stitch] = (PVRTuint32)this->Indices.size() - level.RingFirst[stitch];
+	}
+}
+
+/*!****************************************************************************
+@Function		snapToCoarse
+@Description	Nearest multiple of ratio, ties go towards the nearer end of
+the edge so the two corner quads collapse instead of folding over.
+******************************************************************************/
+static int snapToCoarse(int i, int n, int ratio)
+{
+	int down = i - i % ratio;
+	if (down == i) return i;
+	int offset = i - down;
+	if (2 * offset < ratio || (2 * offset == ratio && 2 * i < n)) return down;
+	return down + ratio;
+}
+
+/*!****************************************************************************
+@Function		emitQuad
+@Description	Two triangles of quad (x, z). Vertices on a stitched edge move
+to the nearest vertex the coarser neighbor has; triangles that collapse
+are dropped, the others keep their winding.
+******************************************************************************/
+void mWaterLOD::emitQuad(WaterLODLevel & level, int x, int z, int stitch, int ratio, bool faceUp)
+{
+	int n = level.Resolution;
+	PVRTuint16 corner[4];
+	for (int c = 0; c < 4; ++c){
+		int cx = x + (c & 1), cz = z + (c >> 1);
+		if ((cx == 0 && (stitch & c_iWaterStitchMinX)) || (cx == n && (stitch & c_iWaterStitchMaxX))) cz = snapToCoarse(cz, n, ratio);
+		if ((cz == 0 && (stitch & c_iWaterStitchMinZ)) || (cz == n && (stitch & c_iWaterStitchMaxZ))) cx = snapToCoarse(cx, n, ratio);
+		corner[c] = level.GridVertex[cz * (n + 1) + cx];
+	}
+	// corners 0 (x, z), 1 (x+1, z), 2 (x, z+1), 3 (x+1, z+1)
+	PVRTuint16 triangles[6] = { corner[0], corner[2], corner[1], corner[1], corner[2], corner[3] };
+	for (int t = 0; t < 2; ++t){
+		PVRTuint16 * v = &triangles[3 * t];
+		if (v[0] == v[1] || v[1] == v[2] || v[0] == v[2]) continue;
+		this->Indices.push_back(v[0]);
+		this->Indices.push_back(faceUp ? v[1] : v[2]);
+		this->Indices.push_back(faceUp ? v[2] : v[1]);
+	}
+}
+
+void mWaterLOD::LoadVBO()
+{
+	for (unsigned int i = 0; i < this->Levels.size(); ++i){
+		SPODMesh & mesh = this->Levels[i].POD->pMesh[0];
+		glGenBuffers(1, &this->Levels[i].VBO);
+		glBindBuffer(GL_ARRAY_BUFFER, this->Levels[i].VBO);
+		glBufferData(GL_ARRAY_BUFFER, mesh.nNumVertex * mesh.sVertex.nStride, mesh.pInterleaved, GL_STATIC_DRAW);
+	}
+	if (!this->Indices.empty()){
+		glGenBuffers(1, &this->IndexVBO);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->IndexVBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->Indices.size() * sizeof(PVRTuint16), &this->Indices[0], GL_STATIC_DRAW);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void mWaterLOD::DeleteVBOs()
+{
+	for (unsigned int i = 0; i < this->Levels.size(); ++i){
+		if (this->Levels[i].VBO) glDeleteBuffers(1, &this->Levels[i].VBO);
+		this->Levels[i].VBO = 0;
+	}
+	if (this->IndexVBO) glDeleteBuffers(1, &this->IndexVBO);
+	this->IndexVBO = 0;
+}
+
+/*!****************************************************************************
+@Function		AddTile
+@Description	The tile's grid cell comes from its position, tiles must not
+move afterwards.
+******************************************************************************/
+void mWaterLOD::AddTile(mModel * model)
+{
+	if (this->TileIndex.find(model) != this->TileIndex.end()) return;
+	WaterLODTile tile;
+	tile.Model = model;
+	tile.GridX = tile.GridZ = 0;
+	tile.Level = 0;
+	tile.Stitch = 0;
+	this->TileIndex[model] = (int)this->Tiles.size();
+	this->Tiles.push_back(tile);
+	this->GridDirty = true;
+}
+
+void mWaterLOD::ClearTiles()
+{
+	this->Tiles.clear();
+	this->TileIndex.clear();
+	this->Grid.clear();
+	this->GridDirty = true;
+}
+
+void mWaterLOD::buildGrid()
+{
+	this->GridDirty = false;
+	this->Grid.clear();
+	if (this->Tiles.empty() || this->TileSize <= 0.0f) return;
+
+	// grid cells are relative to the first tile, layouts with half tile offsets still land on integers
+	PVRTVec3 origin = this->Tiles[0].Model->GetPosition();
+	int minX = INT_MAX, minZ = INT_MAX, maxX = INT_MIN, maxZ = INT_MIN;
+	for (unsigned int i = 0; i < this->Tiles.size(); ++i){
+		PVRTVec3 position = this->Tiles[i].Model->GetPosition();
+		WaterLODTile & tile = this->Tiles[i];
+		tile.GridX = (int)floor((position.x - origin.x) / this->TileSize + 0.5f);
+		tile.GridZ = (int)floor((position.z - origin.z) / this->TileSize + 0.5f);
+		minX = PVRT_MIN(minX, tile.GridX);
+		minZ = PVRT_MIN(minZ, tile.GridZ);
+		maxX = PVRT_MAX(maxX, tile.GridX);
+		maxZ = PVRT_MAX(maxZ, tile.GridZ);
+	}
+	this->GridMinX = minX;
+	this->GridMinZ = minZ;
+	this->GridWidth = maxX - minX + 1;
+	this->GridDepth = maxZ - minZ + 1;
+	this->Grid.assign(this->GridWidth * this->GridDepth, -1);
+	for (unsigned int i = 0; i < this->Tiles.size(); ++i){
+		this->Grid[(this->Tiles[i].GridZ - minZ) * this->GridWidth + this->Tiles[i].GridX - minX] = (int)i;
+	}
+}
+
+int mWaterLOD::neighbor(WaterLODTile & tile, int dx, int dz)
+{
+	int x = tile.GridX + dx - this->GridMinX, z = tile.GridZ + dz - this->GridMinZ;
+	if (x < 0 || z < 0 || x >= this->GridWidth || z >= this->GridDepth) return -1;
+	return this->Grid[z * this->GridWidth + x];
+}
+
+/*!****************************************************************************
+@Function		Select
+@Input			eye					camera position in world space
+@Input			projectionScale		viewport height / (2 tan(fovy / 2)),
+pixels per world unit at distance 1
+@Description	Picks the level and stitch of every tile. The error of a
+level is the projected size of its quads at the nearest point of the
+tile box.
+******************************************************************************/
+void mWaterLOD::Select(PVRTVec3 eye, float projectionScale)
+{
+	for (int i = 0; i < c_iWaterMaxLevels; ++i) this->TilesPerLevel[i] = 0;
+	if (this->Levels.empty()) return;
+	if (this->GridDirty) this->buildGrid();
+
+	int coarsest = (int)this->Levels.size() - 1;
+	for (unsigned int i = 0; i < this->Tiles.size(); ++i){
+		WaterLODTile & tile = this->Tiles[i];
+		PVRTVec3 boxMin, boxMax;
+		tile.Model->SurrondBox.GetBoxWorld(boxMin, boxMax);
+		PVRTVec3 nearest(PVRT_CLAMP(eye.x, boxMin.x, boxMax.x), PVRT_CLAMP(eye.y, boxMin.y, boxMax.y), PVRT_CLAMP(eye.z, boxMin.z, boxMax.z));
+		float distance = PVRT_MAX((nearest - eye).length(), 1e-3f);
+		tile.Level = 0;
+		for (int l = coarsest; l > 0; --l){
+			float quadSize = this->TileSize / this->Levels[l].Resolution;
+			if (quadSize * projectionScale / distance <= this->MaxPixelError){
+				tile.Level = l;
+				break;
+			}
+		}
+	}
+
+	// neighbors at most one level apart, only ever refines
+	const int offsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+	for (bool changed = true; changed;){
+		changed = false;
+		for (unsigned int i = 0; i < this->Tiles.size(); ++i){
+			WaterLODTile & tile = this->Tiles[i];
+			for (int side = 0; side < 4; ++side){
+				int n = this->neighbor(tile, offsets[side][0], offsets[side][1]);
+				if (n < 0 || tile.Level <= this->Tiles[n].Level + 1) continue;
+				tile.Level = this->Tiles[n].Level + 1;
+				changed = true;
+			}
+		}
+	}
+
+	const int stitchBits[4] = { c_iWaterStitchMinX, c_iWaterStitchMaxX, c_iWaterStitchMinZ, c_iWaterStitchMaxZ };
+	for (unsigned int i = 0; i < this->Tiles.size(); ++i){
+		WaterLODTile & tile = this->Tiles[i];
+		tile.Stitch = 0;
+		for (int side = 0; side < 4; ++side){
+			int n = this->neighbor(tile, offsets[side][0], offsets[side][1]);
+			if (n >= 0 && this->Tiles[n].Level > tile.Level) tile.Stitch |= stitchBits[side];
+		}
+		this->TilesPerLevel[tile.Level]++;
+	}
+}
+
+/*!****************************************************************************
+@Function		GetTile
+@Output		level		index into Levels
+@Output		stitch		ring to draw, c_iWaterStitch bits
+@Return		bool		false when the model was never added
+******************************************************************************/
+bool mWaterLOD::GetTile(mModel * model, int & level, int & stitch)
+{
+	unordered_map<mModel*, int>::iterator it = this->TileIndex.find(model);
+	if (it == this->TileIndex.end() || this->Levels.empty()) return false;
+	level = this->Tiles[it->second].Level;
+	stitch = this->Tiles[it->second].Stitch;
+	return true;
+}
+
+/*!****************************************************************************
+@Function		GetLevelMatrix
+@Description	Model matrix of the tile with the level mesh stretched in XZ.
+******************************************************************************/
+PVRTMat4 mWaterLOD::GetLevelMatrix(mModel * model, int level)
+{
+	float scale = this->Levels[level].Scale;
+	return model->GetModelMatrix() * PVRTMat4::Scale(scale, 1.0f, scale);
+}
+
+/*!****************************************************************************
+@Function		GetLevelTransform
+@Output			inverse		inverse of the returned transform
+@Description	GetLevelMatrix as an affine transform. The inverse comes from
+the one the tile caches, the stretch is undone by scaling its rows.
+******************************************************************************/
+mAffine mWaterLOD::GetLevelTransform(mModel * model, int level, mAffine & inverse)
+{
+	float scale = this->Levels[level].Scale;
+	inverse = model->GetInverseTransform();
+	for (int column = 0; column < 4; ++column){
+		inverse.Rows[0][column] /= scale;
+		inverse.Rows[2][column] /= scale;
+	}
+	mAffine transform = model->GetTransform();
+	for (int row = 0; row < 3; ++row){
+		transform.Rows[row][0] *= scale;
+		transform.Rows[row][2] *= scale;
+	}
+	return transform;
+}
+
+unsigned int mWaterLOD::LevelCount()
+{
+	return (unsigned int)this->Levels.size();
+}
+
+void mWaterLOD::Destroy()
+{
+	this->Levels.clear();
+	this->Indices.clear();
+	this->ClearTiles();
+}
@@ -0,0 +1,89 @@
+#include "..\Include\mWorkerPool.h"
+
+mWorkerPool::mWorkerPool()
+{
+}
+
+mWorkerPool::~mWorkerPool()
+{
+	this->Destroy();
+}
+
+/*!****************************************************************************
+@Function		Init
+@Input			threadCount		worker threads, -1 leaves one hardware thread
+for the caller, who also runs tasks
+******************************************************************************/
+void mWorkerPool::Init(int threadCount)
+{
+	this->Destroy();
+	if (threadCount < 0){
+		threadCount = (int)thread::hardware_concurrency() - 1;
+		if (threadCount < 0) threadCount = 0;
+	}
+	this->Quit = false;
+	for (int i = 0; i < threadCount; ++i){
+		this->Threads.push_back(thread(&mWorkerPool::workerLoop, this));
+	}
+}
+
+void mWorkerPool::Run(int taskCount, const function<void(int)> & task)
+{
+	if (this->Threads.empty()){
+		for (int i = 0; i < taskCount; ++i) task(i);
+		return;
+	}
+
+	unique_lock<mutex> lock(this->Mutex);
+	this->Task = &task;
+	this->TaskCount = taskCount;
+	this->NextTask = 0;
+	this->Pending = taskCount;
+	this->WakeUp.notify_all();
+
+	while (this->NextTask < this->TaskCount){
+		int index = this->NextTask++;
+		lock.unlock();
+		task(index);
+		lock.lock();
+		this->Pending--;
+	}
+	while (this->Pending > 0) this->Done.wait(lock);
+	this->Task = nullptr;
+	this->TaskCount = 0;
+	this->NextTask = 0;
+}
+
+int mWorkerPool::ThreadCount()
+{
+	return (int)this->Threads.size();
+}
+
+void mWorkerPool::Destroy()
+{
+	{
+		lock_guard<mutex> lock(this->Mutex);
+		this->Quit = true;
+	}
+	this->WakeUp.notify_all();
+	for (unsigned int i = 0; i < this->Threads.size(); ++i){
+		this->Threads[i].join();
+	}
+	this->Threads.clear();
+}
+
+void mWorkerPool::workerLoop()
+{
+	unique_lock<mutex> lock(this->Mutex);
+	while (true){
+		while (!this->Quit && this->NextTask >= this->TaskCount) this->WakeUp.wait(lock);
+		if (this->Quit) return;
+
+		int index = this->NextTask++;
+		const function<void(int)> * task = this->Task;
+		lock.unlock();
+		(*task)(index);
+		lock.lock();
+		if (--this->Pending == 0) this->Done.notify_all();
+	}
+}
@@ -5,6 +5,24 @@
 #include "Include\mModel.h"
 #include "Include\mSceneManager.h"
 #include "Include\mSuroundBox.h"
+#include "Include\mBoxCuller.h"
+#include "Include\mLinearQuadTree.h"
+#include "Include\mLooseQuadTree.h"
+#include "Include\mFrustum.h"
+#include "Include\mWorkerPool.h"
+#include "Include\mCullingService.h"
+#include "Include\mOcclusionCuller.h"
+#include "Include\mBVH.h"
+#include "Include\mTriangleBVH.h"
+#include "Include\mBounds.h"
+#include "Include\mWaterLOD.h"
+#include "Include\mWaterClipmap.h"
+#include "Include\mInstanceBatch.h"
+#include "Include\mAffine.h"
+#include "Include\mRenderQueue.h"
+#include "Include\mRenderTargetPool.h"
+#include "Include\mProfiler.h"
+#include "Include\mBenchmark.h"
 
 
 #endif
\ No newline at end of file